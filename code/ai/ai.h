@@ -553,6 +553,12 @@ void ai_object_init(object * obj, int ai_index);
 // Called once a frame
 void ai_process( object * obj, int ai_index, float frametime );
 
+// Called once a frame before any ship is processed, searches the nearest enemy of all ships in parallel
+void ai_enemy_search_all();
+
+// Called once a frame after all ships were processed, discards the enemy search results that weren't used
+void ai_enemy_search_clear();
+
 int get_wingnum(int objnum);
 
 void set_wingnum(int objnum, int wingnum);
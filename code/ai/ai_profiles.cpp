@@ -13,6 +13,7 @@
 #include "globalincs/pstypes.h"
 #include "localization/localize.h"
 #include "parse/parselo.h"
+#include "parse/table_cache.h"
 #include "ship/ship.h"
 #include "weapon/weapon.h"
 
@@ -523,29 +524,64 @@ void parse_ai_profiles_tbl(const char *filename)
 
 void ai_profiles_init()
 {
-	int temp;
-
 	if (Ai_profiles_initted)
 		return;
 
-	Num_ai_profiles = 0;
-	Default_ai_profile = 0;
-	Default_profile_name[0] = '\0';
-
-	// init retail entry first
-	parse_ai_profiles_tbl(NULL);
-
-	// now parse the supplied table (if any)
-	if (cf_exists_full("ai_profiles.tbl", CF_TYPE_TABLES))
-		parse_ai_profiles_tbl("ai_profiles.tbl");
-
-	// parse any modular tables
-	parse_modular_table("*-aip.tbm", parse_ai_profiles_tbl);
-
-	// set default if specified
-	temp = ai_profile_lookup(Default_profile_name);
-	if (temp >= 0)
-		Default_ai_profile = temp;
+	table_cache_info info;
+	info.name = "ai_profiles";
+	info.version = 1;
+	info.table = "ai_profiles.tbl";
+	info.default_table = "ai_profiles.tbl";
+	info.tbm_filter = "*-aip.tbm";
+
+	info.parse = []() {
+		Num_ai_profiles = 0;
+		Default_ai_profile = 0;
+		Default_profile_name[0] = '\0';
+
+		// init retail entry first
+		parse_ai_profiles_tbl(NULL);
+
+		// now parse the supplied table (if any)
+		if (cf_exists_full("ai_profiles.tbl", CF_TYPE_TABLES))
+			parse_ai_profiles_tbl("ai_profiles.tbl");
+
+		// parse any modular tables
+		parse_modular_table("*-aip.tbm", parse_ai_profiles_tbl);
+	};
+	info.save = [](table_cache_writer& writer) {
+		writer.write((uint)sizeof(ai_profile_t));
+		writer.write(Num_ai_profiles);
+		writer.write(Default_profile_name);
+		writer.write_bytes(Ai_profiles, sizeof(ai_profile_t) * Num_ai_profiles);
+	};
+	info.load = [](table_cache_reader& reader) {
+		uint size = 0;
+		int num = 0;
+		if (!reader.read(size) || (size != sizeof(ai_profile_t)) || !reader.read(num) || (num < 0) || (num > MAX_AI_PROFILES))
+			return false;
+
+		if (!reader.read(Default_profile_name) || !reader.read_bytes(Ai_profiles, sizeof(ai_profile_t) * num))
+			return false;
+
+		Num_ai_profiles = num;
+		Default_ai_profile = 0;
+		return true;
+	};
+	info.loaded_file = [](const char* filename) {
+		// add tbl/tbm to multiplayer validation list, like parse_ai_profiles_tbl() does
+		extern void fs2netd_add_table_validation(const char *tblname);
+		fs2netd_add_table_validation(filename);
+	};
+
+	info.finish = []() {
+		// set default if specified
+		int temp = ai_profile_lookup(Default_profile_name);
+		if (temp >= 0)
+			Default_ai_profile = temp;
+	};
+
+	table_cache_parse(info);
 
 	Ai_profiles_initted = 1;
 }
@@ -24,6 +24,7 @@
 #include "ai/aiinternal.h"
 #include "asteroid/asteroid.h"
 #include "autopilot/autopilot.h"
+#include "cmdline/cmdline.h"
 #include "cmeasure/cmeasure.h"
 #include "debugconsole/console.h"
 #include "freespace.h"
@@ -53,6 +54,7 @@
 #include "object/object.h"
 #include "object/objectdock.h"
 #include "object/objectshield.h"
+#include "object/objectspatial.h"
 #include "object/waypoint.h"
 #include "parse/parselo.h"
 #include "physics/physics.h"
@@ -63,6 +65,8 @@
 #include "ship/ship.h"
 #include "ship/shipfx.h"
 #include "ship/shiphit.h"
+#include "tracing/tracing.h"
+#include "utils/WorkerPool.h"
 #include "weapon/beam.h"
 #include "weapon/flak.h"
 #include "weapon/swarm.h"
@@ -190,6 +194,9 @@ object *En_objp;
 #define	STEALTH_MAX_VIEW_DIST	400		// dist at which 1) stealth no longer visible 2) firing inaccuracy is greatest
 #define	STEALTH_VIEW_CONE_DOT	0.707		// (half angle of 45 degrees)
 
+// vm_vec_dist_quick() may be up to 10% shorter than the real distance so spatial queries use a slightly larger range
+#define	QUICK_DIST_QUERY_SCALE	1.25f
+
 ai_class *Ai_classes = NULL;
 int	Ai_firing_enabled = 1;
 int	Num_ai_classes;
@@ -199,6 +206,20 @@ int	AI_FrameCount = 0;
 int	AI_watch_object = 0; // Debugging, object to spew debug info for.
 int	Mission_all_attack = 0;					//	!0 means all teams attack all teams.
 
+// Result of the enemy search done for a ship on the worker threads at the start of the frame
+typedef struct ai_enemy_search_result {
+	int		signature;			// signature of the ship the result was computed for, -1 if there is no result
+	int		enemy_team_mask;
+	int		enemy_wing;
+	int		max_attackers;
+	int		danger_weapon_signature;
+	int		nearest_objnum;
+	int		nearest_signature;
+} ai_enemy_search_result;
+
+static ai_enemy_search_result Ai_enemy_search_results[MAX_OBJECTS];
+static SCP_vector<int> Ai_enemy_search_objnums;
+
 //	Constant for flag,				Name of flag
 ai_flag_name Ai_flag_names[] = {
 	{AI::AI_Flags::No_dynamic,				"no-dynamic",			},
@@ -876,6 +897,10 @@ void ai_level_init()
 	ai_init_secondary_info();
 
 	Ai_last_arrive_path=0;
+
+	for (i = 0; i < MAX_OBJECTS; i++)
+		Ai_enemy_search_results[i].signature = -1;
+	Ai_enemy_search_objnums.clear();
 }
 
 // BEGIN STEALTH
@@ -2045,7 +2070,7 @@ int get_nearest_objnum(int objnum, int enemy_team_mask, int enemy_wing, float ra
 {
 	object	*danger_weapon_objp;
 	ai_info	*aip;
-	ship_obj	*so;
+	SCP_vector<int> candidates;
 
 	// initialize eno struct
 	eval_nearest_objnum eno;
@@ -2059,9 +2084,11 @@ int get_nearest_objnum(int objnum, int enemy_team_mask, int enemy_wing, float ra
 	eno.nearest_objnum = -1;
 	eno.check_danger_weapon_objnum = 0;
 
-	// go through the list of all ships and evaluate as potential targets
-	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-		eno.trial_objp = &Objects[so->objnum];
+	// go through all ships in range and evaluate them as potential targets
+	// fighters and bombers count as half as far away so the range has to be doubled here
+	obj_spatial_query_range(ObjSpatialSet::Ships, &Objects[objnum].pos, 2.0f * range * QUICK_DIST_QUERY_SCALE, enemy_team_mask, candidates);
+	for (auto candidate : candidates) {
+		eno.trial_objp = &Objects[candidate];
 		evaluate_object_as_nearest_objnum(&eno);
 	}
 
@@ -2110,15 +2137,16 @@ int find_nearby_threat(int objnum, int enemy_team_mask, float range, int *count)
 	int		nearest_objnum;
 	float		nearest_dist;
 	object	*objp;
-	ship_obj	*so;
+	SCP_vector<int> candidates;
 
 	nearest_objnum = -1;
 	nearest_dist = range;
 
 	*count = 0;
 
-	for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-		objp = &Objects[so->objnum];
+	obj_spatial_query_range(ObjSpatialSet::Ships, &Objects[objnum].pos, range * QUICK_DIST_QUERY_SCALE, enemy_team_mask, candidates);
+	for (auto candidate : candidates) {
+		objp = &Objects[candidate];
 
 		if ( OBJ_INDEX(objp) != objnum ) {
 			if (Ships[objp->instance].flags[Ship::Ship_Flags::Dying])
@@ -2192,6 +2220,59 @@ int get_enemy_timestamp()
 	return (NUM_SKILL_LEVELS - Game_skill_level) * ( (myrand() % 500) + 500);
 }
 
+/**
+ * Tries to use the enemy found for objnum by ai_enemy_search_all() instead of searching for one again.
+ *
+ * The search ran against the state of the world at the start of the frame so the result is only used if it was
+ * computed with the same parameters and the chosen enemy is still a valid target. Each result is only used once.
+ *
+ * @return true if the search result was used, false if the caller needs to do the full search
+ */
+static bool ai_enemy_search_get_result(int objnum, int enemy_team_mask, int enemy_wing, float range, int max_attackers, int ship_info_index, int *enemy_objnum)
+{
+	ai_enemy_search_result *result = &Ai_enemy_search_results[objnum];
+
+	if (result->signature != Objects[objnum].signature) {
+		return false;
+	}
+	result->signature = -1;
+
+	if ((range != MAX_ENEMY_DISTANCE) || (ship_info_index >= 0)) {
+		return false;
+	}
+
+	ai_info *aip = &Ai_info[Ships[Objects[objnum].instance].ai_index];
+	if ((result->enemy_team_mask != enemy_team_mask) || (result->enemy_wing != enemy_wing) || (result->max_attackers != max_attackers)) {
+		return false;
+	}
+
+	int danger_weapon_signature = (aip->danger_weapon_objnum >= 0) ? aip->danger_weapon_signature : -1;
+	if (result->danger_weapon_signature != danger_weapon_signature) {
+		return false;
+	}
+
+	if (result->nearest_objnum >= 0) {
+		object *enemy_objp = &Objects[result->nearest_objnum];
+
+		if ((enemy_objp->signature != result->nearest_signature) || (enemy_objp->type != OBJ_SHIP)) {
+			return false;
+		}
+
+		ship *enemy_shipp = &Ships[enemy_objp->instance];
+		if (enemy_shipp->flags[Ship::Ship_Flags::Dying] || enemy_objp->flags[Object::Object_Flags::Should_be_dead]) {
+			return false;
+		}
+
+		// Ships that were processed earlier in this frame may have picked the same enemy
+		if (!Ship_info[enemy_shipp->ship_info_index].is_big_or_huge() && (num_enemies_attacking(result->nearest_objnum) >= max_attackers)) {
+			return false;
+		}
+	}
+
+	*enemy_objnum = result->nearest_objnum;
+	return true;
+}
+
 /**
  * Return objnum if enemy found, else return -1;
  *
@@ -2231,6 +2312,11 @@ int find_enemy(int objnum, float range, int max_attackers, int ship_info_index)
 			}
 		}
 		
+		int enemy_objnum;
+		if (ai_enemy_search_get_result(objnum, enemy_team_mask, aip->enemy_wing, range, max_attackers, ship_info_index, &enemy_objnum)) {
+			return enemy_objnum;
+		}
+
 		return get_nearest_objnum(objnum, enemy_team_mask, aip->enemy_wing, range, max_attackers, ship_info_index);
 		
 	} else {
@@ -5898,15 +5984,18 @@ void ai_select_secondary_weapon(object *objp, ship_weapon *swp, flagset<Weapon::
  */
 int compute_num_homing_objects(object *target_objp)
 {
-	object	*objp;
 	int		count = 0;
 
-	for ( objp = GET_FIRST(&obj_used_list); objp !=END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp) ) {
-		if (objp->type == OBJ_WEAPON) {
-			if (Weapon_info[Weapons[objp->instance].weapon_info_index].is_homing()) {
-				if (Weapons[objp->instance].homing_object == target_objp) {
-					count++;
-				}
+	for (auto objnum : obj_get_type_list(OBJ_WEAPON)) {
+		if (objnum < 0) {
+			continue;
+		}
+
+		weapon *wp = &Weapons[Objects[objnum].instance];
+
+		if (Weapon_info[wp->weapon_info_index].is_homing()) {
+			if (wp->homing_object == target_objp) {
+				count++;
 			}
 		}
 	}
@@ -9617,15 +9706,15 @@ void maybe_update_guard_object(object *hit_objp, object *hitter_objp)
 // return 1 if bomb is found (and targeted by guarding_objp), otherwise return 0
 int ai_guard_find_nearby_bomb(object *guarding_objp, object *guarded_objp)
 {	
-	missile_obj	*mo;
 	object		*bomb_objp, *closest_bomb_objp=NULL;
 	float			dist, dist_to_guarding_obj,closest_dist_to_guarding_obj=999999.0f;
 	weapon		*wp;
 	weapon_info	*wip;
+	SCP_vector<int> candidates;
 
-	for ( mo = GET_NEXT(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo) ) {
-		Assert(mo->objnum >= 0 && mo->objnum < MAX_OBJECTS);
-		bomb_objp = &Objects[mo->objnum];
+	obj_spatial_query_range(ObjSpatialSet::Missiles, &guarded_objp->pos, (MAX_GUARD_DIST + guarded_objp->radius) * 3 * QUICK_DIST_QUERY_SCALE, -1, candidates);
+	for (auto candidate : candidates) {
+		bomb_objp = &Objects[candidate];
 
 		wp = &Weapons[bomb_objp->instance];
 		wip = &Weapon_info[wp->weapon_info_index];
@@ -9668,13 +9757,15 @@ void ai_guard_find_nearby_ship(object *guarding_objp, object *guarded_objp)
 {
 	ship *guarding_shipp = &Ships[guarding_objp->instance];
 	ai_info	*guarding_aip = &Ai_info[guarding_shipp->ai_index];
-	ship_obj *so;
 	object *enemy_objp;
 	float dist;
+	SCP_vector<int> candidates;
 
-	for (so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so))
+	float query_range = MAX((MAX_GUARD_DIST + guarded_objp->radius) * 3, 3000.0f) * QUICK_DIST_QUERY_SCALE;
+	obj_spatial_query_range(ObjSpatialSet::Ships, &guarded_objp->pos, query_range, iff_get_attackee_mask(guarding_shipp->team), candidates);
+	for (auto candidate : candidates)
 	{
-		enemy_objp = &Objects[so->objnum];
+		enemy_objp = &Objects[candidate];
 
 		if (enemy_objp->instance < 0)
 		{
@@ -9712,24 +9803,28 @@ void ai_guard_find_nearby_asteroid(object *guarding_objp, object *guarded_objp)
 	object	*closest_asteroid_objp=NULL, *danger_asteroid_objp=NULL, *asteroid_objp;
 	float		dist_to_self, closest_danger_asteroid_dist=999999.0f, closest_asteroid_dist=999999.0f;
 
-	for ( asteroid_objp = GET_FIRST(&obj_used_list); asteroid_objp != END_OF_LIST(&obj_used_list); asteroid_objp = GET_NEXT(asteroid_objp) ) {
-		if ( asteroid_objp->type == OBJ_ASTEROID ) {
-			// Attack asteroid if near guarded ship
-			dist = vm_vec_dist_quick(&asteroid_objp->pos, &guarded_objp->pos);
-			if ( dist < (MAX_GUARD_DIST + guarded_objp->radius)*2) {
-				dist_to_self = vm_vec_dist_quick(&asteroid_objp->pos, &guarding_objp->pos);
-				if ( OBJ_INDEX(guarded_objp) == asteroid_collide_objnum(asteroid_objp) ) {
-					if( dist_to_self < closest_danger_asteroid_dist ) {
-						danger_asteroid_objp=asteroid_objp;
-						closest_danger_asteroid_dist=dist_to_self;
-					}
-				} 
-				if ( dist_to_self < closest_asteroid_dist ) {
-					// only attack if moving slower than own max speed
-					if ( vm_vec_mag_quick(&asteroid_objp->phys_info.vel) < guarding_objp->phys_info.max_vel.xyz.z ) {
-						closest_asteroid_dist = dist_to_self;
-						closest_asteroid_objp = asteroid_objp;
-					}
+	for (auto objnum : obj_get_type_list(OBJ_ASTEROID)) {
+		if (objnum < 0) {
+			continue;
+		}
+
+		asteroid_objp = &Objects[objnum];
+
+		// Attack asteroid if near guarded ship
+		dist = vm_vec_dist_quick(&asteroid_objp->pos, &guarded_objp->pos);
+		if ( dist < (MAX_GUARD_DIST + guarded_objp->radius)*2) {
+			dist_to_self = vm_vec_dist_quick(&asteroid_objp->pos, &guarding_objp->pos);
+			if ( OBJ_INDEX(guarded_objp) == asteroid_collide_objnum(asteroid_objp) ) {
+				if( dist_to_self < closest_danger_asteroid_dist ) {
+					danger_asteroid_objp=asteroid_objp;
+					closest_danger_asteroid_dist=dist_to_self;
+				}
+			} 
+			if ( dist_to_self < closest_asteroid_dist ) {
+				// only attack if moving slower than own max speed
+				if ( vm_vec_mag_quick(&asteroid_objp->phys_info.vel) < guarding_objp->phys_info.max_vel.xyz.z ) {
+					closest_asteroid_dist = dist_to_self;
+					closest_asteroid_objp = asteroid_objp;
 				}
 			}
 		}
@@ -14184,10 +14279,86 @@ static void ai_control_info_check(ai_info *aip)
 	}
 }
 
+/**
+ * Searches the nearest enemy of all ships which may look for a new enemy this frame.
+ *
+ * The search for a new enemy is the most expensive part of ai_frame() in large battles. It only reads the state of the
+ * world so it is done here for all ships at once, spread over the worker threads. Everything else of the AI still runs
+ * serially in ai_process(), which picks up the results in find_enemy() after validating them.
+ */
+void ai_enemy_search_all()
+{
+	Ai_enemy_search_objnums.clear();
+
+	if (!Cmdline_mt_ai_targeting || physics_paused || ai_paused || MULTIPLAYER_CLIENT) {
+		return;
+	}
+
+	TRACE_SCOPE(tracing::AIEnemySearch);
+
+	for (ship_obj *so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so)) {
+		object *objp = &Objects[so->objnum];
+		ship *shipp = &Ships[objp->instance];
+
+		if ((shipp->ai_index < 0) || objp->flags[Object::Object_Flags::Should_be_dead] || shipp->flags[Ship::Ship_Flags::Dying]) {
+			continue;
+		}
+
+		if (objp->flags[Object::Object_Flags::Player_ship] && !Player_use_ai) {
+			continue;
+		}
+
+		ai_info *aip = &Ai_info[shipp->ai_index];
+		if (!timestamp_elapsed(aip->choose_enemy_timestamp) || (aip->resume_goal_time != -1)) {
+			continue;
+		}
+
+		ship_info *sip = &Ship_info[shipp->ship_info_index];
+		if ((sip->class_type < 0) || !(Ship_types[sip->class_type].flags[Ship::Type_Info_Flags::AI_auto_attacks])) {
+			continue;
+		}
+
+		Ai_enemy_search_objnums.push_back(so->objnum);
+	}
+
+	int max_attackers = The_mission.ai_profile->max_attackers[Game_skill_level];
+
+	util::get_worker_pool().parallelFor(Ai_enemy_search_objnums.size(), 4, [max_attackers](size_t begin, size_t end, size_t) {
+		for (size_t i = begin; i < end; ++i) {
+			int objnum = Ai_enemy_search_objnums[i];
+			object *objp = &Objects[objnum];
+			ai_info *aip = &Ai_info[Ships[objp->instance].ai_index];
+			ai_enemy_search_result *result = &Ai_enemy_search_results[objnum];
+
+			result->enemy_team_mask = iff_get_attackee_mask(obj_team(objp));
+			result->enemy_wing = aip->enemy_wing;
+			result->max_attackers = max_attackers;
+			result->danger_weapon_signature = (aip->danger_weapon_objnum >= 0) ? aip->danger_weapon_signature : -1;
+			result->nearest_objnum = get_nearest_objnum(objnum, result->enemy_team_mask, result->enemy_wing, MAX_ENEMY_DISTANCE, max_attackers, -1);
+			result->nearest_signature = (result->nearest_objnum >= 0) ? Objects[result->nearest_objnum].signature : -1;
+			result->signature = objp->signature;
+		}
+	});
+}
+
+/**
+ * Discards the enemy search results that were not used by ai_process() this frame.
+ */
+void ai_enemy_search_clear()
+{
+	for (auto objnum : Ai_enemy_search_objnums) {
+		Ai_enemy_search_results[objnum].signature = -1;
+	}
+
+	Ai_enemy_search_objnums.clear();
+}
+
 int Last_ai_obj = -1;
 
 void ai_process( object * obj, int ai_index, float frametime )
 {
+	TRACE_SCOPE(tracing::AIProcess);
+
 	if (obj->flags[Object::Object_Flags::Should_be_dead])
 		return;
 
@@ -14699,6 +14870,7 @@ void maybe_process_friendly_hit(object *objp_hitter, object *objp_hit, object *o
 			ai_abort_rearm_request( Player_obj );
 
 			Player_ship->team = Iff_traitor;
+			obj_spatial_team_changed(OBJ_INDEX(Player_obj));
 
 		} else if ((damage > frand()) && (Missiontime - pp->last_warning_message_time > F1_0*4) && (pp->friendly_damage > FRIENDLY_DAMAGE_THRESHOLD)) {
 			// no closer than 4 sec intervals
@@ -14,10 +14,13 @@
 #include "network/multi.h"
 #include "network/multimsgs.h"
 #include "object/objectdock.h"
+#include "object/objectspatial.h"
 #include "scripting/scripting.h"
 #include "render/3d.h"
 #include "ship/ship.h"
 #include "ship/shipfx.h"
+#include "tracing/Monitor.h"
+#include "utils/RandomRange.h"
 #include "weapon/beam.h"
 #include "weapon/flak.h"
 #include "weapon/muzzleflash.h"
@@ -512,6 +515,15 @@ int valid_turret_enemy(object *objp, object *turret_parent)
 	return 0;
 }
 
+MONITOR(TurretTargetSearches)
+MONITOR(TurretRangeChecks)
+MONITOR(TurretFOVChecks)
+MONITOR(TurretCandidateTests)
+
+// Used for the stealth bypass below instead of frand() so that the candidates skipped by the batched target search
+// don't change the random numbers of everything else
+static util::UniformFloatRange Turret_stealth_find_rand(0.0f, 1.0f);
+
 extern int Player_attacking_enabled;
 void evaluate_obj_as_target(object *objp, eval_enemy_obj_struct *eeo)
 {
@@ -521,6 +533,8 @@ void evaluate_obj_as_target(object *objp, eval_enemy_obj_struct *eeo)
 	float dist, dist_comp;
 	bool turret_has_no_target = false;
 
+	MONITOR_INC(TurretCandidateTests, 1);
+
 	// Don't look for bombs when weapon system is not ok
 	if (objp->type == OBJ_WEAPON && !eeo->weapon_system_ok) {
 		return;
@@ -611,7 +625,7 @@ void evaluate_obj_as_target(object *objp, eval_enemy_obj_struct *eeo)
 			if ( is_object_stealth_ship(objp) ) {
 				float turret_stealth_find_chance = 0.5f;
 				float speed_mod = -0.1f + vm_vec_mag_quick(&objp->phys_info.vel) / 70.0f;
-				if (frand() > (turret_stealth_find_chance + speed_mod)) {
+				if (Turret_stealth_find_rand.next() > (turret_stealth_find_chance + speed_mod)) {
 					try_anyway = TRUE;
 				}
 			}
@@ -798,6 +812,277 @@ int is_target_beam_valid(ship_weapon *swp, object *objp)
 	return 1;
 }
 
+int Turret_batch_targeting = 1;
+DCF_BOOL(turret_batch_targeting, Turret_batch_targeting)
+
+// evaluate_obj_as_target() uses vm_vec_mag_quick() which may be up to 10% shorter than the real distance
+#define TURRET_QUICK_DIST_SCALE		1.125f
+// Margin for the rounding differences between the batched field of view check and object_in_turret_fov()
+#define TURRET_FOV_EPSILON			0.001f
+
+/**
+ * Potential targets for the turrets of one ship.
+ *
+ * Without this, every turret that looks for a new target goes through all objects on its own. The checks that only
+ * depend on the parent ship are done once when the first turret of a ship looks for a target in a frame and the other
+ * turrets of the ship reuse the result. The ships are kept in separate arrays so that the range check against a single
+ * turret is a simple loop the compiler can vectorize.
+ */
+typedef struct turret_target_candidates {
+	int parent_objnum = -1;
+	int parent_signature = 0;
+	fix mission_time = 0;
+
+	float ship_range = -1.0f;		// weapon range the ship candidates were gathered for, -1 if they weren't gathered yet
+	SCP_vector<int> ship_objnums;
+	SCP_vector<float> ship_x;
+	SCP_vector<float> ship_y;
+	SCP_vector<float> ship_z;
+	SCP_vector<float> ship_radius;
+	SCP_vector<uint8_t> ship_in_range;	// result of the last range and field of view check
+
+	bool bombs_gathered = false;
+	SCP_vector<int> bomb_objnums;
+
+	bool all_gathered = false;
+	SCP_vector<int> all_objnums;	// everything in obj_used_list that passes valid_turret_enemy()
+} turret_target_candidates;
+
+static turret_target_candidates Turret_candidates;
+static SCP_vector<int> Turret_query_objnums;
+
+/**
+ * Makes the candidate lists refer to the given ship in the current frame
+ */
+static turret_target_candidates *turret_get_candidates(int parent_objnum)
+{
+	auto tc = &Turret_candidates;
+	object *parent_objp = &Objects[parent_objnum];
+
+	if ((tc->parent_objnum != parent_objnum) || (tc->parent_signature != parent_objp->signature) || (tc->mission_time != Missiontime)) {
+		tc->parent_objnum = parent_objnum;
+		tc->parent_signature = parent_objp->signature;
+		tc->mission_time = Missiontime;
+
+		tc->ship_range = -1.0f;
+		tc->bombs_gathered = false;
+		tc->all_gathered = false;
+	}
+
+	return tc;
+}
+
+/**
+ * Gathers the enemy ships that may be within weapon_range of any turret of the ship
+ */
+static void turret_gather_ship_candidates(turret_target_candidates *tc, int enemy_team_mask, float weapon_range)
+{
+	if (weapon_range <= tc->ship_range) {
+		return;
+	}
+
+	object *parent_objp = &Objects[tc->parent_objnum];
+
+	tc->ship_range = weapon_range;
+	tc->ship_objnums.clear();
+	tc->ship_x.clear();
+	tc->ship_y.clear();
+	tc->ship_z.clear();
+	tc->ship_radius.clear();
+
+	// The turrets can be anywhere on the parent ship
+	float query_range = (weapon_range + parent_objp->radius) * TURRET_QUICK_DIST_SCALE;
+	obj_spatial_query_range(ObjSpatialSet::Ships, &parent_objp->pos, query_range, enemy_team_mask, Turret_query_objnums, TURRET_QUICK_DIST_SCALE);
+
+	for (auto objnum : Turret_query_objnums) {
+		object *objp = &Objects[objnum];
+
+		if (!valid_turret_enemy(objp, parent_objp)) {
+			continue;
+		}
+
+		tc->ship_objnums.push_back(objnum);
+		tc->ship_x.push_back(objp->pos.xyz.x);
+		tc->ship_y.push_back(objp->pos.xyz.y);
+		tc->ship_z.push_back(objp->pos.xyz.z);
+		tc->ship_radius.push_back(objp->radius);
+	}
+}
+
+/**
+ * Flags the ship candidates which may be in range of a turret at tpos and, if check_fov is set, in its field of view
+ *
+ * The checks are conservative, evaluate_obj_as_target() still does the exact ones.
+ */
+static void turret_check_ship_candidates_range(turret_target_candidates *tc, const vec3d *tpos, const vec3d *tvec, float weapon_range, ship_subsys *ss, bool check_fov)
+{
+	size_t count = tc->ship_objnums.size();
+
+	tc->ship_in_range.resize(count);
+
+	const float *xs = tc->ship_x.data();
+	const float *ys = tc->ship_y.data();
+	const float *zs = tc->ship_z.data();
+	const float *radii = tc->ship_radius.data();
+	uint8_t *in_range = tc->ship_in_range.data();
+
+	float tx = tpos->xyz.x;
+	float ty = tpos->xyz.y;
+	float tz = tpos->xyz.z;
+
+	for (size_t i = 0; i < count; ++i) {
+		float dx = xs[i] - tx;
+		float dy = ys[i] - ty;
+		float dz = zs[i] - tz;
+		float max_dist = (weapon_range + radii[i]) * TURRET_QUICK_DIST_SCALE;
+
+		in_range[i] = (dx * dx + dy * dy + dz * dz < max_dist * max_dist) ? 1 : 0;
+	}
+
+	MONITOR_INC(TurretRangeChecks, (int) count);
+
+	if (!check_fov) {
+		return;
+	}
+
+	float fov_min = ss->system_info->turret_fov - TURRET_FOV_EPSILON;
+	float fov_max = ss->system_info->turret_max_fov + TURRET_FOV_EPSILON;
+
+	float vx = tvec->xyz.x;
+	float vy = tvec->xyz.y;
+	float vz = tvec->xyz.z;
+
+	// object_in_turret_fov() widens the field of view by the angular size of the object, which is largest for the
+	// shortest distance vm_vec_mag_quick() may return
+	for (size_t i = 0; i < count; ++i) {
+		float dx = xs[i] - tx;
+		float dy = ys[i] - ty;
+		float dz = zs[i] - tz;
+		float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+		float radius = radii[i];
+
+		float dot = (dist > 0.0f) ? (dx * vx + dy * vy + dz * vz) / dist : fov_min;
+		float quick_dist = MAX(dist / TURRET_QUICK_DIST_SCALE - radius, 0.0f);
+		float size_mod = (radius > 0.0f) ? radius / (quick_dist + 2.0f * radius) : 0.0f;
+
+		in_range[i] &= ((dot + size_mod >= fov_min) && (dot - size_mod <= fov_max)) ? 1 : 0;
+	}
+
+	MONITOR_INC(TurretFOVChecks, (int) count);
+}
+
+/**
+ * Gathers the missiles the turrets of the ship may shoot down
+ */
+static void turret_gather_bomb_candidates(turret_target_candidates *tc)
+{
+	if (tc->bombs_gathered) {
+		return;
+	}
+
+	object *parent_objp = &Objects[tc->parent_objnum];
+
+	tc->bombs_gathered = true;
+	tc->bomb_objnums.clear();
+
+	for (missile_obj *mo = GET_FIRST(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo)) {
+		object *objp = &Objects[mo->objnum];
+
+		Assert(objp->type == OBJ_WEAPON);
+		weapon_info *wip = &Weapon_info[Weapons[objp->instance].weapon_info_index];
+
+		if (!(wip->wi_flags[Weapon::Info_Flags::Bomb]) && !(wip->wi_flags[Weapon::Info_Flags::Turret_Interceptable])) {
+			continue;
+		}
+
+		if (!valid_turret_enemy(objp, parent_objp)) {
+			continue;
+		}
+
+		tc->bomb_objnums.push_back(mo->objnum);
+	}
+}
+
+/**
+ * Gathers all objects the turrets of the ship may target, used by turrets with target priorities
+ */
+static void turret_gather_all_candidates(turret_target_candidates *tc)
+{
+	if (tc->all_gathered) {
+		return;
+	}
+
+	object *parent_objp = &Objects[tc->parent_objnum];
+
+	tc->all_gathered = true;
+	tc->all_objnums.clear();
+
+	for (object *objp = GET_FIRST(&obj_used_list); objp != END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp)) {
+		if (valid_turret_enemy(objp, parent_objp)) {
+			tc->all_objnums.push_back(OBJ_INDEX(objp));
+		}
+	}
+}
+
+/**
+ * Checks if an object belongs to a target priority group
+ */
+static bool turret_object_matches_priority(object *ptr, ai_target_priority *tt)
+{
+	bool found_something = false;
+
+	int n_types = (int)tt->ship_type.size();
+	int n_s_classes = (int)tt->ship_class.size();
+	int n_w_classes = (int)tt->weapon_class.size();
+
+	if(tt->obj_type > -1 && (ptr->type == tt->obj_type)) {
+		found_something = true;
+	}
+
+	if( ( n_types > 0 ) && ( ptr->type == OBJ_SHIP ) ) {
+		for (int j = 0; j < n_types; j++) {
+			if ( Ship_info[Ships[ptr->instance].ship_info_index].class_type == tt->ship_type[j] ) {
+				found_something = true;
+			}
+		}
+	}
+
+	if( ( n_s_classes > 0 ) && ( ptr->type == OBJ_SHIP ) ) {
+		for (int j = 0; j < n_s_classes; j++) {
+			if ( Ships[ptr->instance].ship_info_index == tt->ship_class[j] ) {
+				found_something = true;
+			}
+		}
+	}
+
+	if( ( n_w_classes > 0 ) && ( ptr->type == OBJ_WEAPON ) ) {
+		for (int j = 0; j < n_w_classes; j++) {
+			if ( Weapons[ptr->instance].weapon_info_index == tt->weapon_class[j] ) {
+				found_something = true;
+			}
+		}
+	}
+
+	if( (tt->wif_flags.any_set()) && (ptr->type == OBJ_WEAPON) ) {
+		if( ( (Weapon_info[Weapons[ptr->instance].weapon_info_index].wi_flags & tt->wif_flags ) == tt->wif_flags) ) {
+				found_something = true;
+		}
+	}
+
+	if( ( tt->sif_flags.any_set() && (ptr->type == OBJ_SHIP) ) ) {
+		if( (Ship_info[Ships[ptr->instance].ship_info_index].flags & tt->sif_flags) == tt->sif_flags)
+		{
+			found_something = true;
+		}
+	}
+
+	if ((tt->obj_flags.any_set()) && !((ptr->flags & tt->obj_flags) == tt->obj_flags)) {
+		found_something = true;
+	}
+
+	return found_something;
+}
+
 /**
  * Given an object and an enemy team, return the index of the nearest enemy object.
  *
@@ -881,6 +1166,10 @@ int get_nearest_turret_objnum(int turret_parent_objnum, ship_subsys *turret_subs
 	eeo.nearest_dist = 99999.0f;
 	eeo.nearest_objnum = -1;
 
+	MONITOR_INC(TurretTargetSearches, 1);
+
+	turret_target_candidates *tc = turret_get_candidates(turret_parent_objnum);
+
 	// here goes the new targeting priority setting
 	int n_tgt_priorities;
 	int priority_weapon_idx = -1;
@@ -911,73 +1200,21 @@ int get_nearest_turret_objnum(int turret_parent_objnum, ship_subsys *turret_subs
 			else
 				tt = &Ai_tp_list[Weapon_info[priority_weapon_idx].targeting_priorities[i]];
 
-			int n_types = (int)tt->ship_type.size();
-			int n_s_classes = (int)tt->ship_class.size();
-			int n_w_classes = (int)tt->weapon_class.size();
-			
-			bool found_something;
-			object *ptr = GET_FIRST(&obj_used_list);
-			
-			while (ptr != END_OF_LIST(&obj_used_list)) {
-				found_something = false;
-
-				if(tt->obj_type > -1 && (ptr->type == tt->obj_type)) {
-					found_something = true;
-				}
-
-				if( ( n_types > 0 ) && ( ptr->type == OBJ_SHIP ) ) {
-					for (int j = 0; j < n_types; j++) {
-						if ( Ship_info[Ships[ptr->instance].ship_info_index].class_type == tt->ship_type[j] ) {
-							found_something = true;
-						}
-					}
-				}
-
-				if( ( n_s_classes > 0 ) && ( ptr->type == OBJ_SHIP ) ) {
-					for (int j = 0; j < n_s_classes; j++) {
-						if ( Ships[ptr->instance].ship_info_index == tt->ship_class[j] ) {
-							found_something = true;
-						}
-					}
-				}
-
-				if( ( n_w_classes > 0 ) && ( ptr->type == OBJ_WEAPON ) ) {
-					for (int j = 0; j < n_w_classes; j++) {
-						if ( Weapons[ptr->instance].weapon_info_index == tt->weapon_class[j] ) {
-							found_something = true;
-						}
-					}
-				}
+			if (Turret_batch_targeting) {
+				turret_gather_all_candidates(tc);
 
-				if( (tt->wif_flags.any_set()) && (ptr->type == OBJ_WEAPON) ) {
-					if( ( (Weapon_info[Weapons[ptr->instance].weapon_info_index].wi_flags & tt->wif_flags ) == tt->wif_flags) ) {
-							found_something = true;
+				for (auto objnum : tc->all_objnums) {
+					if (turret_object_matches_priority(&Objects[objnum], tt)) {
+						evaluate_obj_as_target(&Objects[objnum], &eeo);
 					}
 				}
-
-				if( ( tt->sif_flags.any_set() && (ptr->type == OBJ_SHIP) ) ) {
-					if( (Ship_info[Ships[ptr->instance].ship_info_index].flags & tt->sif_flags) == tt->sif_flags)
-	                {
-    					found_something = true;
+			} else {
+				for (object *ptr = GET_FIRST(&obj_used_list); ptr != END_OF_LIST(&obj_used_list); ptr = GET_NEXT(ptr)) {
+					// only evaluate the objects within this priority group
+					if (turret_object_matches_priority(ptr, tt)) {
+						evaluate_obj_as_target(ptr, &eeo);
 					}
 				}
-
-                if ((tt->obj_flags.any_set()) && !((ptr->flags & tt->obj_flags) == tt->obj_flags)) {
-					found_something = true;
-				}
-
-				if(!(found_something)) {
-					//we didnt find this object within this priority group
-					//skip to next without evaluating the object as target
-					ptr = GET_NEXT(ptr);
-
-					continue;
-				}
-
-
-				evaluate_obj_as_target(ptr, &eeo);
-
-				ptr = GET_NEXT(ptr);
 			}
 
 			//homing weapon entry...
@@ -1046,14 +1283,22 @@ int get_nearest_turret_objnum(int turret_parent_objnum, ship_subsys *turret_subs
 					//don't fire anti capital ship turrets at bombs.
 					if ( !((aip->ai_profile_flags[AI::Profile_Flags::Huge_turret_weapons_ignore_bombs]) && big_only_flag) )
 					{
-						// Missile_obj_list
-						for( mo = GET_FIRST(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo) ) {
-							objp = &Objects[mo->objnum];
-							
-							Assert(objp->type == OBJ_WEAPON);
-							if ((Weapon_info[Weapons[objp->instance].weapon_info_index].wi_flags[Weapon::Info_Flags::Bomb]) || (Weapon_info[Weapons[objp->instance].weapon_info_index].wi_flags[Weapon::Info_Flags::Turret_Interceptable]))
-							{
-								evaluate_obj_as_target(objp, &eeo);
+						if (Turret_batch_targeting) {
+							turret_gather_bomb_candidates(tc);
+
+							for (auto objnum : tc->bomb_objnums) {
+								evaluate_obj_as_target(&Objects[objnum], &eeo);
+							}
+						} else {
+							// Missile_obj_list
+							for( mo = GET_FIRST(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo) ) {
+								objp = &Objects[mo->objnum];
+
+								Assert(objp->type == OBJ_WEAPON);
+								if ((Weapon_info[Weapons[objp->instance].weapon_info_index].wi_flags[Weapon::Info_Flags::Bomb]) || (Weapon_info[Weapons[objp->instance].weapon_info_index].wi_flags[Weapon::Info_Flags::Turret_Interceptable]))
+								{
+									evaluate_obj_as_target(objp, &eeo);
+								}
 							}
 						}
 						// highest priority
@@ -1067,10 +1312,25 @@ int get_nearest_turret_objnum(int turret_parent_objnum, ship_subsys *turret_subs
 
 				case 1:
 					//Return if a ship is found
-					// Ship_used_list
-					for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
-						objp = &Objects[so->objnum];
-						evaluate_obj_as_target(objp, &eeo);
+					if (Turret_batch_targeting) {
+						// Ships out of range are never picked as attackers so they don't need to be evaluated. Unless the turret
+						// has no target and doesn't require one in its field of view, the same goes for ships outside of it.
+						bool check_fov = (turret_subsys->flags[Ship::Subsystem_Flags::FOV_Required]) || (current_enemy != -1);
+
+						turret_gather_ship_candidates(tc, enemy_team_mask, eeo.weapon_travel_dist);
+						turret_check_ship_candidates_range(tc, tpos, tvec, eeo.weapon_travel_dist, turret_subsys, check_fov);
+
+						for (size_t j = 0; j < tc->ship_objnums.size(); ++j) {
+							if (tc->ship_in_range[j]) {
+								evaluate_obj_as_target(&Objects[tc->ship_objnums[j]], &eeo);
+							}
+						}
+					} else {
+						// Ship_used_list
+						for ( so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so) ) {
+							objp = &Objects[so->objnum];
+							evaluate_obj_as_target(objp, &eeo);
+						}
 					}
 
 					Assert(eeo.nearest_attacker_objnum < 0 || is_target_beam_valid(swp, &Objects[eeo.nearest_attacker_objnum]));
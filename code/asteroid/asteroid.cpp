@@ -2006,18 +2006,19 @@ static void asteroid_parse_tbl()
  */
 static int count_incident_asteroids()
 {
-	object	*asteroid_objp;
 	int		count;
 
 	count = 0;
 
-	for ( asteroid_objp = GET_FIRST(&obj_used_list); asteroid_objp !=END_OF_LIST(&obj_used_list); asteroid_objp = GET_NEXT(asteroid_objp) ) {
-		if (asteroid_objp->type == OBJ_ASTEROID ) {
-			asteroid *asp = &Asteroids[asteroid_objp->instance];
+	for (auto objnum : obj_get_type_list(OBJ_ASTEROID)) {
+		if (objnum < 0) {
+			continue;
+		}
 
-			if ( asp->target_objnum >= 0 ) {
-				count++;
-			}
+		asteroid *asp = &Asteroids[Objects[objnum].instance];
+
+		if ( asp->target_objnum >= 0 ) {
+			count++;
 		}
 	}
 
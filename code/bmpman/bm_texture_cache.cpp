@@ -0,0 +1,390 @@
+#include "bmpman/bm_texture_cache.h"
+
+#include "cfile/cfile.h"
+#include "debugconsole/console.h"
+
+#include <md5.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+extern bool Cmdline_texture_cache;
+
+namespace {
+
+const char* const CACHE_PREFIX = "bm_tex-";
+const char* const CACHE_EXT = "btc";
+
+const uint CACHE_MAGIC = 0x43544d42; // "BMTC"
+const uint CACHE_VERSION = 2;
+
+// The last access times of the entries, uses a different extension so it isn't taken for an entry
+const char* const ACCESS_FILE_NAME = "bm_tex-access.bta";
+const uint ACCESS_MAGIC = 0x41544d42; // "BMTA"
+const uint ACCESS_VERSION = 1;
+
+const uint32_t CACHE_LOCATION = CF_LOCATION_ROOT_USER | CF_LOCATION_ROOT_GAME | CF_LOCATION_TYPE_ROOT;
+
+// Maximum size of all cache files together in bytes
+size_t Texture_cache_budget = (size_t)1024 * 1024 * 1024;
+
+// When each entry was last read or written, in milliseconds since the epoch. Loaded from the access file on first use
+// and saved whenever entries are evicted.
+std::mutex Texture_cache_mutex;
+SCP_unordered_map<SCP_string, std::int64_t> Texture_cache_last_access;
+bool Texture_cache_access_loaded = false;
+
+std::atomic<size_t> Texture_cache_hits(0);
+std::atomic<size_t> Texture_cache_misses(0);
+std::atomic<size_t> Texture_cache_bytes_written(0);
+
+SCP_string cache_file_name(const SCP_string& key) { return CACHE_PREFIX + key + "." + CACHE_EXT; }
+
+std::int64_t access_time_now() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+	    .count();
+}
+
+// Must be called with Texture_cache_mutex held
+void load_access_times() {
+	if (Texture_cache_access_loaded) {
+		return;
+	}
+	Texture_cache_access_loaded = true;
+
+	auto cfp = cfopen(ACCESS_FILE_NAME, "rb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		return;
+	}
+
+	if (cfread_uint(cfp) == ACCESS_MAGIC && cfread_uint(cfp) == ACCESS_VERSION) {
+		auto count = cfread_uint(cfp);
+
+		for (uint i = 0; i < count && !cfeof(cfp); ++i) {
+			auto key = cfread_string_len(cfp);
+			auto high = (std::int64_t)cfread_uint(cfp);
+			auto low = (std::int64_t)cfread_uint(cfp);
+
+			// Accesses of this session are newer than anything in the file
+			auto& time = Texture_cache_last_access[key];
+			time = std::max(time, (high << 32) | low);
+		}
+	}
+
+	cfclose(cfp);
+}
+
+// Must be called with Texture_cache_mutex held
+void save_access_times() {
+	auto cfp = cfopen(ACCESS_FILE_NAME, "wb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		mprintf(("Could not open texture cache file %s!\n", ACCESS_FILE_NAME));
+		return;
+	}
+
+	cfwrite_uint(ACCESS_MAGIC, cfp);
+	cfwrite_uint(ACCESS_VERSION, cfp);
+	cfwrite_uint((uint)Texture_cache_last_access.size(), cfp);
+
+	for (auto& entry : Texture_cache_last_access) {
+		cfwrite_string_len(entry.first.c_str(), cfp);
+		cfwrite_uint((uint)((std::uint64_t)entry.second >> 32), cfp);
+		cfwrite_uint((uint)((std::uint64_t)entry.second & 0xFFFFFFFF), cfp);
+	}
+
+	cfclose(cfp);
+}
+
+// Must be called with Texture_cache_mutex held
+void touch_entry(const SCP_string& key) {
+	load_access_times();
+
+	Texture_cache_last_access[key] = access_time_now();
+}
+
+// Hashes where the source image is found, its size and its modification time together with everything that changes
+// the decoded data. This only needs the file index so a cache hit never reads the source image.
+bool compute_key(const char* real_filename, const char* ext, int dir_type, int w, int h, size_t size, int bpp,
+                 SCP_string& key) {
+	char filename[MAX_FILENAME_LEN];
+
+	strcpy_s(filename, real_filename);
+	char* p = strchr(filename, '.');
+	if (p) *p = 0;
+	strcat_s(filename, ext);
+
+	auto location = cf_find_file_location(filename, dir_type);
+	if (!location.found) {
+		return false;
+	}
+
+	MD5 md5;
+	md5.update(location.full_name.c_str(), (MD5::size_type)location.full_name.size());
+
+	std::uint64_t params[] = {CACHE_VERSION,     (std::uint64_t)location.offset, (std::uint64_t)location.size,
+	                          (std::uint64_t)location.write_time, (std::uint64_t)w, (std::uint64_t)h,
+	                          (std::uint64_t)size, (std::uint64_t)bpp};
+	md5.update(reinterpret_cast<const char*>(params), (MD5::size_type)sizeof(params));
+
+	md5.finalize();
+
+	key = md5.hexdigest();
+	return true;
+}
+
+bool read_entry(const SCP_string& key, int w, int h, ubyte* data, size_t size, int* bpp) {
+	auto cfp = cfopen(cache_file_name(key).c_str(), "rb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		return false;
+	}
+
+	auto magic = cfread_uint(cfp);
+	auto version = cfread_uint(cfp);
+	auto entry_w = cfread_int(cfp);
+	auto entry_h = cfread_int(cfp);
+	auto entry_bpp = cfread_int(cfp);
+	auto entry_size = cfread_uint(cfp);
+
+	// A file which was only written halfway is caught by the size check
+	bool valid = (magic == CACHE_MAGIC) && (version == CACHE_VERSION) && (entry_w == w) && (entry_h == h) &&
+	             (entry_size == size) && (cfilelength(cfp) - cftell(cfp) == (int)size);
+
+	if (valid) {
+		valid = cfread(data, 1, (int)size, cfp) == (int)size;
+	}
+
+	cfclose(cfp);
+
+	if (!valid) {
+		nprintf(("TextureCache", "Cache entry %s is invalid.\n", key.c_str()));
+		return false;
+	}
+
+	*bpp = entry_bpp;
+	return true;
+}
+
+void write_entry(const SCP_string& key, int w, int h, const ubyte* data, size_t size, int bpp) {
+	// Identical images may be decoded by two threads at the same time
+	std::lock_guard<std::mutex> guard(Texture_cache_mutex);
+
+	auto name = cache_file_name(key);
+
+	auto cfp = cfopen(name.c_str(), "wb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		mprintf(("Could not open texture cache file %s!\n", name.c_str()));
+		return;
+	}
+
+	cfwrite_uint(CACHE_MAGIC, cfp);
+	cfwrite_uint(CACHE_VERSION, cfp);
+	cfwrite_int(w, cfp);
+	cfwrite_int(h, cfp);
+	cfwrite_int(bpp, cfp);
+	cfwrite_uint((uint)size, cfp);
+	auto written = cfwrite(data, 1, (int)size, cfp);
+
+	cfclose(cfp);
+
+	if (written != (int)size) {
+		mprintf(("Failed to write texture cache file %s!\n", name.c_str()));
+		cf_delete(name.c_str(), CF_TYPE_CACHE, CACHE_LOCATION);
+		return;
+	}
+
+	touch_entry(key);
+	Texture_cache_bytes_written += size;
+}
+
+struct cache_file {
+	SCP_string name;
+	SCP_string key;
+	std::int64_t last_access;
+	size_t size;
+};
+
+SCP_vector<cache_file> get_cache_files() {
+	SCP_string filter = SCP_string("*.") + CACHE_EXT;
+	const SCP_string prefix(CACHE_PREFIX);
+
+	SCP_vector<SCP_string> names;
+	SCP_vector<file_list_info> file_info;
+	cf_get_file_list(names, CF_TYPE_CACHE, filter.c_str(), CF_SORT_NONE, &file_info, CACHE_LOCATION);
+
+	Assertion(names.size() == file_info.size(),
+	          "cf_get_file_list returned different sizes for file names and file informations!");
+
+	SCP_vector<cache_file> files;
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (names[i].compare(0, prefix.size(), prefix) != 0) {
+			// Not a texture cache file
+			continue;
+		}
+
+		cache_file file;
+		file.name = names[i] + "." + CACHE_EXT;
+		file.key = names[i].substr(prefix.size());
+
+		// Entries written before the access times were recorded count as accessed when they were written
+		auto iter = Texture_cache_last_access.find(file.key);
+		file.last_access = (iter != Texture_cache_last_access.end()) ? iter->second : (std::int64_t)file_info[i].write_time * 1000;
+
+		auto cfp = cfopen(file.name.c_str(), "rb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+		if (cfp == nullptr) {
+			continue;
+		}
+		file.size = (size_t)cfilelength(cfp);
+		cfclose(cfp);
+
+		files.push_back(file);
+	}
+
+	return files;
+}
+
+} // namespace
+
+bool bm_texture_cache_enabled() { return Cmdline_texture_cache; }
+
+void bm_texture_cache_set_budget(size_t budget) {
+	std::lock_guard<std::mutex> guard(Texture_cache_mutex);
+	Texture_cache_budget = budget;
+}
+
+void bm_texture_cache_evict() {
+	if (!bm_texture_cache_enabled()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(Texture_cache_mutex);
+
+	load_access_times();
+
+	auto files = get_cache_files();
+
+	size_t total = 0;
+	for (auto& file : files) {
+		total += file.size;
+	}
+
+	// Forget the entries whose files are gone
+	SCP_unordered_map<SCP_string, std::int64_t> last_access;
+	for (auto& file : files) {
+		last_access[file.key] = file.last_access;
+	}
+	Texture_cache_last_access = std::move(last_access);
+
+	int removed = 0;
+	if (total > Texture_cache_budget) {
+		// The entries which were not used for the longest time go first
+		std::sort(files.begin(), files.end(), [](const cache_file& left, const cache_file& right) {
+			return left.last_access < right.last_access;
+		});
+
+		for (auto& file : files) {
+			if (total <= Texture_cache_budget) {
+				break;
+			}
+
+			if (cf_delete(file.name.c_str(), CF_TYPE_CACHE, CACHE_LOCATION)) {
+				total -= file.size;
+				Texture_cache_last_access.erase(file.key);
+				++removed;
+			}
+		}
+
+		mprintf(("Texture cache: Evicted %d entries, %.1f MB left.\n", removed, total / (1024.0 * 1024.0)));
+	}
+
+	save_access_times();
+}
+
+int bm_texture_cache_purge() {
+	std::lock_guard<std::mutex> guard(Texture_cache_mutex);
+
+	int removed = 0;
+	for (auto& file : get_cache_files()) {
+		if (cf_delete(file.name.c_str(), CF_TYPE_CACHE, CACHE_LOCATION)) {
+			++removed;
+		}
+	}
+
+	Texture_cache_last_access.clear();
+	Texture_cache_access_loaded = true;
+	cf_delete(ACCESS_FILE_NAME, CF_TYPE_CACHE, CACHE_LOCATION);
+
+	return removed;
+}
+
+bool bm_texture_cache_load(const char* filename, const char* ext, int dir_type, int w, int h, ubyte* data, size_t size,
+                           int* bpp, const std::function<bool(int* bpp)>& decode) {
+	SCP_string key;
+
+	if (!bm_texture_cache_enabled() || !compute_key(filename, ext, dir_type, w, h, size, *bpp, key)) {
+		return decode(bpp);
+	}
+
+	if (read_entry(key, w, h, data, size, bpp)) {
+		++Texture_cache_hits;
+
+		std::lock_guard<std::mutex> guard(Texture_cache_mutex);
+		touch_entry(key);
+		return true;
+	}
+
+	++Texture_cache_misses;
+
+	if (!decode(bpp)) {
+		return false;
+	}
+
+	write_entry(key, w, h, data, size, *bpp);
+	return true;
+}
+
+DCF(texture_cache, "Shows or changes the on-disk texture cache (-texture_cache)") {
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: texture_cache [purge | evict | budget <MB>]\n");
+		dc_printf("Without arguments the cache statistics of this session are shown.\n");
+		dc_printf("\tpurge: Deletes all cache files\n");
+		dc_printf("\tevict: Deletes old cache files until the cache fits into its budget\n");
+		dc_printf("\tbudget: Sets the maximum size of the cache in MB\n");
+		return;
+	}
+
+	if (dc_optional_string("purge")) {
+		dc_printf("Deleted %d texture cache files.\n", bm_texture_cache_purge());
+		return;
+	}
+
+	if (!bm_texture_cache_enabled()) {
+		dc_printf("Only available with -texture_cache.\n");
+		return;
+	}
+
+	if (dc_optional_string("evict")) {
+		bm_texture_cache_evict();
+		dc_printf("Evicted old texture cache entries, see the log for details.\n");
+		return;
+	}
+
+	if (dc_optional_string("budget")) {
+		int budget;
+		dc_stuff_int(&budget);
+
+		if (budget <= 0) {
+			dc_printf("The budget must be positive.\n");
+			return;
+		}
+
+		bm_texture_cache_set_budget((size_t)budget * 1024 * 1024);
+		dc_printf("Texture cache budget set to %d MB.\n", budget);
+		return;
+	}
+
+	dc_printf("Texture cache: %d hits, %d misses, %.1f MB written, budget %.1f MB\n", (int)Texture_cache_hits,
+	          (int)Texture_cache_misses, Texture_cache_bytes_written / (1024.0 * 1024.0),
+	          Texture_cache_budget / (1024.0 * 1024.0));
+}
@@ -0,0 +1,69 @@
+#ifndef _BM_TEXTURE_CACHE_H
+#define _BM_TEXTURE_CACHE_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+#include <functional>
+
+/** @file
+ *  On-disk cache for the decoded pixel data of PNG, JPG and TGA images (enabled with -texture_cache)
+ *
+ *  The cache files are stored in data/cache next to the shader binary cache. Every file is named after the MD5 hash of
+ *  the location, size and modification time of the source image and the requested output format so a modified image
+ *  never hits an old entry and a hit does not have to read the source image. The file contains a small header and the
+ *  raw pixel data exactly as the decoder wrote it which allows loading it straight into the bitmap memory.
+ *
+ *  The total size of the cache is limited to a budget. Every hit and every new entry records the time of the access in
+ *  a small file next to the entries. When the budget is exceeded the entries which have not been used for the longest
+ *  time are removed first.
+ */
+
+/**
+ * @brief Checks if the texture cache is enabled
+ */
+bool bm_texture_cache_enabled();
+
+/**
+ * @brief Sets the maximum size of all cache files together
+ *
+ * @param budget The budget in bytes, the default is 1 GB
+ */
+void bm_texture_cache_set_budget(size_t budget);
+
+/**
+ * @brief Removes the least recently used entries until the cache fits into its budget again
+ *
+ * Called when bmpman is initialized and after a level was paged in.
+ */
+void bm_texture_cache_evict();
+
+/**
+ * @brief Removes all entries from the cache
+ *
+ * @return The number of files which were deleted
+ */
+int bm_texture_cache_purge();
+
+/**
+ * @brief Loads the decoded pixel data of an image from the cache or decodes it and adds it to the cache
+ *
+ * If the cache is disabled this just calls the decoder. This may be called from multiple threads at the same time.
+ *
+ * @param filename The file name of the source image
+ * @param ext The extension of the source image (e.g. ".png"), replaces the one in filename like the decoders do it
+ * @param dir_type The CF_TYPE the source image is loaded from
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param data Where the decoded pixel data goes
+ * @param size The size of data in bytes
+ * @param bpp Bits per pixel of the decoded data. The decoder may change it, a cache hit restores the value the decoder
+ * set when the entry was created.
+ * @param decode Decodes the image into data and updates bpp, returns false on errors
+ *
+ * @return @c true if data contains the image, @c false if it could not be decoded
+ */
+bool bm_texture_cache_load(const char* filename, const char* ext, int dir_type, int w, int h, ubyte* data, size_t size,
+                           int* bpp, const std::function<bool(int* bpp)>& decode);
+
+#endif // _BM_TEXTURE_CACHE_H
@@ -19,6 +19,7 @@
 #include "anim/animplay.h"
 #include "anim/packunpack.h"
 #include "bmpman/bm_internal.h"
+#include "bmpman/bm_texture_cache.h"
 #include "ddsutils/ddsutils.h"
 #include "debugconsole/console.h"
 #include "globalincs/systemvars.h"
@@ -35,6 +36,7 @@
 #include "tgautils/tgautils.h"
 #include "tracing/Monitor.h"
 #include "tracing/tracing.h"
+#include "utils/WorkerPool.h"
 
 #include <cctype>
 #include <climits>
@@ -85,6 +87,7 @@ void(*bm_set_components_32)(ubyte *pixel, ubyte *r, ubyte *g, ubyte *b, ubyte *a
 // --------------------------------------------------------------------------------------------------------------------
 // Declaration of protected variables (defined in cmdline.cpp).
 extern int Cmdline_cache_bitmaps;
+extern bool Cmdline_mt_page_in;
 
 // --------------------------------------------------------------------------------------------------------------------
 // Definition of public variables (declared as extern in bm_internal.h).
@@ -108,6 +111,62 @@ static int Bm_max_ram = 0;
 static int Bm_ignore_duplicates = 0;
 static int Bm_ignore_load_count = 0;
 
+/**
+ * Upper limit for the memory of the bitmaps that are decoded by the worker threads before they are uploaded. The main
+ * thread uploads one batch before the next one is decoded.
+ */
+#define BM_PAGE_IN_BATCH_MEMORY		(128 * 1024 * 1024)
+
+namespace {
+
+enum PageInDecoder {
+	PAGE_IN_PNG,
+	PAGE_IN_JPG,
+	PAGE_IN_TGA,
+	PAGE_IN_DDS,
+
+	NUM_PAGE_IN_DECODERS
+};
+
+const char *Page_in_decoder_names[NUM_PAGE_IN_DECODERS] = { "PNG", "JPG", "TGA", "DDS" };
+
+// A bitmap which is decoded by a worker thread during bm_page_in_stop()
+struct page_in_job {
+	int handle;
+	PageInDecoder decoder;
+	char filename[MAX_FILENAME_LEN];
+	int dir_type;
+	int w;
+	int h;
+	size_t size;				// size of data
+	int bpp;					// bits per pixel of the decoded data
+
+	ubyte *data = nullptr;
+	bool success = false;
+	std::uint64_t time_us = 0;
+	size_t thread_index = 0;
+};
+
+// Load time statistics of the last bm_page_in_stop() with -mt_page_in
+struct page_in_report {
+	size_t bitmaps[NUM_PAGE_IN_DECODERS] = {};
+	size_t bytes[NUM_PAGE_IN_DECODERS] = {};
+	std::uint64_t time_us[NUM_PAGE_IN_DECODERS] = {};
+	size_t failed = 0;
+
+	SCP_vector<size_t> thread_bitmaps;
+	SCP_vector<std::uint64_t> thread_time_us;
+
+	size_t batches = 0;
+	size_t main_thread_bitmaps = 0;		// bitmaps which had to be loaded by bm_lock()
+	std::uint64_t decode_time_us = 0;	// time the main thread waited for the worker threads
+	std::uint64_t total_time_us = 0;
+};
+
+page_in_report Page_in_report;
+
+}
+
 // This needs to be declared somewhere and bm_internal.h has no own source file
 gr_bitmap_info::~gr_bitmap_info() = default;
 
@@ -997,6 +1056,8 @@ void bm_init() {
 	// Allocate one block by default
 	allocate_new_block();
 
+	bm_texture_cache_evict();
+
 	bm_inited = true;
 }
 
@@ -2245,7 +2306,6 @@ void bm_lock_dds(int handle, bitmap_slot *bs, bitmap *bmp, int /*bpp*/, ubyte /*
 void bm_lock_jpg(int handle, bitmap_slot *bs, bitmap *bmp, int bpp, ubyte /*flags*/) {
 	ubyte *data = NULL;
 	int d_size = 0;
-	int jpg_error = JPEG_ERROR_INVALID;
 	char filename[MAX_FILENAME_LEN];
 
 	auto be = &bs->entry;
@@ -2277,9 +2337,12 @@ void bm_lock_jpg(int handle, bitmap_slot *bs, bitmap *bmp, int bpp, ubyte /*flag
 	// this will populate filename[] whether it's EFF or not
 	EFF_FILENAME_CHECK;
 
-	jpg_error = jpeg_read_bitmap(filename, data, NULL, d_size, be->dir_type);
+	bool success = bm_texture_cache_load(filename, ".jpg", be->dir_type, bmp->w, bmp->h, data, be->mem_taken, &bmp->bpp,
+		[&](int* /*out_bpp*/) {
+			return jpeg_read_bitmap(filename, data, NULL, d_size, be->dir_type) == JPEG_ERROR_NONE;
+		});
 
-	if (jpg_error != JPEG_ERROR_NONE) {
+	if (!success) {
 		bm_free_data(bs);
 		return;
 	}
@@ -2338,7 +2401,6 @@ void bm_lock_png(int handle, bitmap_slot *bs, bitmap *bmp, int /*bpp*/, ubyte /*
 	ubyte *data = NULL;
 	//assume 32 bit - libpng should expand everything
 	int d_size;
-	int png_error = PNG_ERROR_INVALID;
 	char filename[MAX_FILENAME_LEN];
 
 	auto be = &bs->entry;
@@ -2367,9 +2429,12 @@ void bm_lock_png(int handle, bitmap_slot *bs, bitmap *bmp, int /*bpp*/, ubyte /*
 	EFF_FILENAME_CHECK;
 
 	//bmp->bpp gets set correctly in here after reading into memory
-	png_error = png_read_bitmap(filename, data, &bmp->bpp, d_size, be->dir_type);
+	bool success = bm_texture_cache_load(filename, ".png", be->dir_type, bmp->w, bmp->h, data,
+		static_cast<size_t>(bmp->w * bmp->h * d_size), &bmp->bpp, [&](int* out_bpp) {
+			return png_read_bitmap(filename, data, out_bpp, d_size, be->dir_type) == PNG_ERROR_NONE;
+		});
 
-	if (png_error != PNG_ERROR_NONE) {
+	if (!success) {
 		bm_free_data(bs);
 		return;
 	}
@@ -2420,15 +2485,16 @@ void bm_lock_tga(int handle, bitmap_slot *bs, bitmap *bmp, int bpp, ubyte flags)
 	Assert(be->data_size > 0);
 #endif
 
-	int tga_error;
-
 	// make sure we are using the correct filename in the case of an EFF.
 	// this will populate filename[] whether it's EFF or not
 	EFF_FILENAME_CHECK;
 
-	tga_error = targa_read_bitmap(filename, data, nullptr, byte_size, be->dir_type);
+	bool success = bm_texture_cache_load(filename, ".tga", be->dir_type, bmp->w, bmp->h, data,
+		static_cast<size_t>(bmp->w * bmp->h * byte_size), &bmp->bpp, [&](int* /*out_bpp*/) {
+			return targa_read_bitmap(filename, data, nullptr, byte_size, be->dir_type) == TARGA_ERROR_NONE;
+		});
 
-	if (tga_error != TARGA_ERROR_NONE) {
+	if (!success) {
 		bm_free_data(bs);
 		return;
 	}
@@ -2578,6 +2644,247 @@ void bm_page_in_aabitmap(int handle, int nframes) {
 	}
 }
 
+// Checks if a bitmap can be decoded by a worker thread and fills in the job for it
+static bool bm_page_in_job_setup(bitmap_entry *be, page_in_job& job) {
+	auto bmp = &be->bm;
+
+	// Bitmaps which are used as transparent textures or anti-aliased bitmaps need format conversions in bm_lock()
+	if ((be->preloaded != 1) || (bmp->data != 0) || Is_standalone) {
+		return false;
+	}
+
+	BM_TYPE c_type = (be->type == BM_TYPE_EFF) ? be->info.ani.eff.type : be->type;
+
+	switch (c_type) {
+	case BM_TYPE_PNG:
+		if (be->info.ani.apng.is_apng) {
+			return false;
+		}
+		job.decoder = PAGE_IN_PNG;
+		job.bpp = 32;
+		job.size = static_cast<size_t>(bmp->w * bmp->h * 4);
+		break;
+
+	case BM_TYPE_JPG:
+		job.decoder = PAGE_IN_JPG;
+		job.bpp = 24;
+		job.size = be->mem_taken;
+		break;
+
+	case BM_TYPE_TGA:
+		// 16 bit images are packed with bm_set_components() which depends on the texture format the main thread selects
+		if ((bmp->true_bpp != 24) && (bmp->true_bpp != 32)) {
+			return false;
+		}
+		job.decoder = PAGE_IN_TGA;
+		job.bpp = bmp->true_bpp;
+		job.size = static_cast<size_t>(bmp->w * bmp->h * (job.bpp >> 3));
+		break;
+
+#if BYTE_ORDER != BIG_ENDIAN
+	// bm_lock_dds() has to byte swap uncompressed images on big endian systems
+	case BM_TYPE_DDS:
+	case BM_TYPE_DXT1:
+	case BM_TYPE_DXT3:
+	case BM_TYPE_DXT5:
+	case BM_TYPE_CUBEMAP_DDS:
+	case BM_TYPE_CUBEMAP_DXT1:
+	case BM_TYPE_CUBEMAP_DXT3:
+	case BM_TYPE_CUBEMAP_DXT5:
+		job.decoder = PAGE_IN_DDS;
+		job.bpp = 0;
+		job.size = be->mem_taken;
+		break;
+#endif
+
+	default:
+		return false;
+	}
+
+	if (job.size == 0) {
+		return false;
+	}
+
+	char filename[MAX_FILENAME_LEN];
+	EFF_FILENAME_CHECK;
+
+	job.handle = be->handle;
+	job.w = bmp->w;
+	job.h = bmp->h;
+	strcpy_s(job.filename, filename);
+	job.dir_type = be->dir_type;
+
+	return true;
+}
+
+// Reads and decodes the image of a job. This runs on the worker threads so it must not touch any bmpman data.
+static void bm_page_in_decode(page_in_job& job) {
+	auto start = timer_get_microseconds();
+
+	job.data = (ubyte*)vm_malloc(job.size, memory::quiet_alloc);
+
+	if (job.data != nullptr) {
+		memset(job.data, 0, job.size);
+
+		switch (job.decoder) {
+		case PAGE_IN_PNG:
+			job.success = bm_texture_cache_load(job.filename, ".png", job.dir_type, job.w, job.h, job.data, job.size,
+				&job.bpp, [&job](int* out_bpp) {
+					return png_read_bitmap(job.filename, job.data, out_bpp, 4, job.dir_type) == PNG_ERROR_NONE;
+				});
+			break;
+
+		case PAGE_IN_JPG:
+			job.success = bm_texture_cache_load(job.filename, ".jpg", job.dir_type, job.w, job.h, job.data, job.size,
+				&job.bpp, [&job](int* /*out_bpp*/) {
+					return jpeg_read_bitmap(job.filename, job.data, nullptr, 3, job.dir_type) == JPEG_ERROR_NONE;
+				});
+			break;
+
+		case PAGE_IN_TGA:
+			job.success = bm_texture_cache_load(job.filename, ".tga", job.dir_type, job.w, job.h, job.data, job.size,
+				&job.bpp, [&job](int* /*out_bpp*/) {
+					return targa_read_bitmap(job.filename, job.data, nullptr, job.bpp >> 3, job.dir_type) ==
+					       TARGA_ERROR_NONE;
+				});
+			break;
+
+		case PAGE_IN_DDS: {
+			ubyte dds_bpp = 0;
+			job.success = dds_read_bitmap(job.filename, job.data, &dds_bpp, job.dir_type) == DDS_ERROR_NONE;
+			job.bpp = dds_bpp;
+			break;
+		}
+
+		default:
+			UNREACHABLE("Unhandled page in decoder %d!", job.decoder);
+			break;
+		}
+	}
+
+	job.time_us = timer_get_microseconds() - start;
+}
+
+// Hands the decoded data of a job to its bitmap, the same way the bm_lock_* functions do it
+static void bm_page_in_install(page_in_job& job) {
+	auto be = bm_get_entry(job.handle);
+	auto bmp = &be->bm;
+
+	auto& report = Page_in_report;
+	report.bitmaps[job.decoder]++;
+	report.time_us[job.decoder] += job.time_us;
+	report.thread_bitmaps[job.thread_index]++;
+	report.thread_time_us[job.thread_index] += job.time_us;
+
+	if (!job.success || (bmp->data != 0)) {
+		// bm_lock() will try again and report the error
+		report.failed++;
+
+		if (job.data != nullptr) {
+			vm_free(job.data);
+		}
+		return;
+	}
+
+	report.bytes[job.decoder] += job.size;
+
+	bm_update_memory_used(job.handle, job.size);
+
+	bmp->bpp = (ubyte)job.bpp;
+	bmp->data = (ptr_u)job.data;
+	bmp->palette = nullptr;
+
+	if ((job.decoder == PAGE_IN_TGA) || (job.decoder == PAGE_IN_DDS)) {
+		bmp->flags = 0;
+	}
+}
+
+// Decodes the bitmaps of the next batch of entries on the worker threads. Returns the end of the batch.
+static size_t bm_page_in_decode_batch(const SCP_vector<bitmap_entry*>& entries, size_t begin) {
+	SCP_vector<page_in_job> jobs;
+	size_t batch_memory = 0;
+	size_t end = begin;
+
+	for (; end < entries.size(); ++end) {
+		page_in_job job;
+
+		if (!bm_page_in_job_setup(entries[end], job)) {
+			continue;
+		}
+
+		if (!jobs.empty() && (batch_memory + job.size > BM_PAGE_IN_BATCH_MEMORY)) {
+			break;
+		}
+
+		batch_memory += job.size;
+		jobs.push_back(job);
+	}
+
+	if (jobs.empty()) {
+		return end;
+	}
+
+	TRACE_SCOPE(tracing::PageInDecode);
+
+	auto start = timer_get_microseconds();
+
+	util::get_worker_pool().parallelFor(jobs.size(), 1, [&jobs](size_t job_begin, size_t job_end, size_t thread_index) {
+		for (auto i = job_begin; i < job_end; ++i) {
+			jobs[i].thread_index = thread_index;
+			bm_page_in_decode(jobs[i]);
+		}
+	});
+
+	Page_in_report.decode_time_us += timer_get_microseconds() - start;
+	Page_in_report.batches++;
+
+	for (auto& job : jobs) {
+		bm_page_in_install(job);
+	}
+
+	return end;
+}
+
+static void bm_page_in_print_report() {
+	auto& report = Page_in_report;
+
+	mprintf(("BMPMAN: Page in took %.3f s in %d batches, %.3f s of it were spent waiting for the decoding threads.\n",
+		report.total_time_us / 1000000.0, (int)report.batches, report.decode_time_us / 1000000.0));
+
+	for (int i = 0; i < NUM_PAGE_IN_DECODERS; ++i) {
+		if (report.bitmaps[i] == 0) {
+			continue;
+		}
+
+		mprintf(("BMPMAN:   %s: %d bitmaps, %.1f MB, %.3f s decoding\n", Page_in_decoder_names[i], (int)report.bitmaps[i],
+			report.bytes[i] / (1024.0 * 1024.0), report.time_us[i] / 1000000.0));
+	}
+
+	for (size_t i = 0; i < report.thread_bitmaps.size(); ++i) {
+		mprintf(("BMPMAN:   Thread %d: %d bitmaps, %.3f s decoding\n", (int)i, (int)report.thread_bitmaps[i],
+			report.thread_time_us[i] / 1000000.0));
+	}
+
+	mprintf(("BMPMAN:   %d bitmaps failed to decode, %d bitmaps were loaded by the main thread.\n", (int)report.failed,
+		(int)report.main_thread_bitmaps));
+}
+
+DCF(bm_page_in_report, "Shows how long the last level page in took with -mt_page_in") {
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: bm_page_in_report\n");
+		dc_printf("Writes the load times of the last level page in to the log, broken down by decoder and thread.\n");
+		return;
+	}
+
+	if (!Cmdline_mt_page_in) {
+		dc_printf("Only available with -mt_page_in.\n");
+		return;
+	}
+
+	bm_page_in_print_report();
+	dc_printf("Report written to the log.\n");
+}
+
 void bm_page_in_start() {
 	Bm_paging = 1;
 
@@ -2612,6 +2919,8 @@ void bm_page_in_stop() {
 
 	int bm_preloading = 1;
 
+	SCP_vector<bitmap_entry*> used_entries;
+
 	for (auto& block : bm_blocks) {
 		for (auto& slot : block) {
 			auto& entry = slot.entry;
@@ -2619,45 +2928,82 @@ void bm_page_in_stop() {
 			if ((entry.type != BM_TYPE_NONE) && (entry.type != BM_TYPE_RENDER_TARGET_DYNAMIC)
 				&& (entry.type != BM_TYPE_RENDER_TARGET_STATIC)) {
 				if (entry.preloaded) {
-					TRACE_SCOPE(tracing::PageInSingleBitmap);
-					if (bm_preloading) {
-						if (!gr_preload(entry.handle, (entry.preloaded == 2))) {
-							mprintf(("Out of VRAM.  Done preloading.\n"));
-							bm_preloading = 0;
-						}
-					} else {
-						bm_lock(entry.handle, (entry.used_flags == BMP_AABITMAP) ? 8 : 16, entry.used_flags);
-						if (entry.ref_count >= 1) {
-							bm_unlock(entry.handle);
-						}
-					}
+					used_entries.push_back(&entry);
+				} else {
+					bm_unload_fast(entry.handle);
+				}
+			}
+		}
+	}
 
-					n++;
+	auto start = timer_get_microseconds();
+	size_t decoded_end = 0;
+
+	if (Cmdline_mt_page_in) {
+		auto num_threads = util::get_worker_pool().getNumThreads();
+
+		Page_in_report = page_in_report();
+		Page_in_report.thread_bitmaps.resize(num_threads, 0);
+		Page_in_report.thread_time_us.resize(num_threads, 0);
+	}
+
+	for (size_t i = 0; i < used_entries.size(); ++i) {
+		// Decode the bitmaps of the next batch in parallel, the main thread only needs to upload them
+		if (Cmdline_mt_page_in && (i == decoded_end)) {
+			decoded_end = bm_page_in_decode_batch(used_entries, i);
+		}
 
-					multi_send_anti_timeout_ping();
+		auto& entry = *used_entries[i];
 
-					if ((entry.info.ani.first_frame == 0) || (entry.info.ani.first_frame == entry.handle)) {
+		{
+			TRACE_SCOPE(tracing::PageInSingleBitmap);
+
+			if (Cmdline_mt_page_in && (entry.bm.data == 0)) {
+				Page_in_report.main_thread_bitmaps++;
+			}
+
+			if (bm_preloading) {
+				if (!gr_preload(entry.handle, (entry.preloaded == 2))) {
+					mprintf(("Out of VRAM.  Done preloading.\n"));
+					bm_preloading = 0;
+				}
+			} else {
+				bm_lock(entry.handle, (entry.used_flags == BMP_AABITMAP) ? 8 : 16, entry.used_flags);
+				if (entry.ref_count >= 1) {
+					bm_unlock(entry.handle);
+				}
+			}
+		}
+
+		n++;
+
+		multi_send_anti_timeout_ping();
+
+		if ((entry.info.ani.first_frame == 0) || (entry.info.ani.first_frame == entry.handle)) {
 #ifndef NDEBUG
-						memset(busy_text, 0, sizeof(busy_text));
+			memset(busy_text, 0, sizeof(busy_text));
 
-						strcat_s(busy_text, "** BmpMan: ");
-						strcat_s(busy_text, entry.filename);
-						strcat_s(busy_text, " **");
+			strcat_s(busy_text, "** BmpMan: ");
+			strcat_s(busy_text, entry.filename);
+			strcat_s(busy_text, " **");
 
-						game_busy(busy_text);
+			game_busy(busy_text);
 #else
-						game_busy();
+			game_busy();
 #endif
-					}
-				} else {
-					bm_unload_fast(entry.handle);
-				}
-			}
 		}
 	}
 
+	if (Cmdline_mt_page_in) {
+		Page_in_report.total_time_us = timer_get_microseconds() - start;
+		bm_page_in_print_report();
+	}
+
 	nprintf(("BmpInfo", "BMPMAN: Loaded %d bitmaps that are marked as used for this level.\n", n));
 
+	// The level may have added new entries to the texture cache
+	bm_texture_cache_evict();
+
 #ifndef NDEBUG
 	int total_bitmaps = 0;
 	int total_slots = 0;
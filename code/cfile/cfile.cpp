@@ -37,6 +37,7 @@
 
 
 #include <limits>
+#include <mutex>
 
 char Cfile_root_dir[CFILE_ROOT_DIRECTORY_LEN] = "";
 char Cfile_user_dir[CFILE_ROOT_DIRECTORY_LEN] = "";
@@ -97,6 +98,10 @@ cf_pathtype Pathtypes[CF_MAX_PATH_TYPES]  = {
 #define CFILE_STACK_MAX	8
 
 int cfile_inited = 0;
+
+// Protects the allocation of Cfile_block_list entries so that files may be opened and closed by worker threads
+static std::mutex Cfile_block_mutex;
+
 static int Cfile_stack_pos = 0;
 
 static char Cfile_stack[CFILE_STACK_MAX][CFILE_ROOT_DIRECTORY_LEN];
@@ -247,6 +252,9 @@ int cfile_init(const char *exe_dir, const char *cdrom_dir)
 // stored in packfiles and on the cdrom.
 void cfile_refresh()
 {
+	// The pack files are mapped again while the list is rebuilt
+	cf_unmap_root_packs();
+
 	cf_build_secondary_filelist(Cfile_cdrom_dir);
 }
 
@@ -767,6 +775,11 @@ CFILE* _cfopen(const char* source, int line, const char* file_path, const char*
 		nprintf(("CFileDebug", "Requested file %s found at: %s\n", file_path, find_res.full_name.c_str()));
 
 		if ( type & CFILE_MEMORY_MAPPED ) {
+
+			// Files from memory mapped pack files are already in memory
+			if ( find_res.offset != 0 && find_res.data_ptr != nullptr ) {
+				return cf_open_memory_fill_cfblock(source, line, find_res.data_ptr, find_res.size, dir_type);
+			}
 		
 			// Can't open memory mapped files out of pack or memory files
 			if ( find_res.offset == 0 && find_res.data_ptr != nullptr )	{
@@ -880,6 +893,8 @@ static int cfget_cfile_block()
 	int i;
 	Cfile_block *cb;
 
+	std::lock_guard<std::mutex> guard(Cfile_block_mutex);
+
 	for ( i = 0; i < MAX_CFILE_BLOCKS; i++ ) {
 		cb = &Cfile_block_list[i];
 		if ( cb->type == CFILE_BLOCK_UNUSED ) {
@@ -945,7 +960,10 @@ int cfclose( CFILE * cfile )
 		// VP  do nothing
 	}
 
-	cb->type = CFILE_BLOCK_UNUSED;
+	{
+		std::lock_guard<std::mutex> guard(Cfile_block_mutex);
+		cb->type = CFILE_BLOCK_UNUSED;
+	}
 	return result;
 }
 
@@ -1168,6 +1186,24 @@ const void *cf_returndata(CFILE *cfile)
 	return cb->data;
 }
 
+const void *cf_get_data_view(CFILE *cfile, size_t *size)
+{
+	Assert(cfile != NULL);
+	Assert(size != NULL);
+	Cfile_block *cb;
+	Assert(cfile->id >= 0 && cfile->id < MAX_CFILE_BLOCKS);
+	cb = &Cfile_block_list[cfile->id];
+
+	// Files which were mapped by cfopen() with CFILE_MEMORY_MAPPED report a size of 0 and can't be handled here
+	if (cb->data == nullptr || cb->mem_mapped) {
+		*size = 0;
+		return nullptr;
+	}
+
+	*size = cb->size;
+	return cb->data;
+}
+
 
 
 // version number of opened file.  Will be 0 unless you put something else here after you
@@ -1676,9 +1712,9 @@ static uint CRCTable[256];
 #define CF_CHKSUM_SAMPLE_SIZE				512
 
 // update cur_chksum with the chksum of the new_data of size new_data_size
-ushort cf_add_chksum_short(ushort seed, ubyte *buffer, int size)
+ushort cf_add_chksum_short(ushort seed, const ubyte *buffer, int size)
 {
-	ubyte *ptr = buffer;
+	const ubyte *ptr = buffer;
 	uint sum1, sum2;
 
 	sum1 = sum2 = (int)(seed);
@@ -1694,10 +1730,10 @@ ushort cf_add_chksum_short(ushort seed, ubyte *buffer, int size)
 }
 
 // update cur_chksum with the chksum of the new_data of size new_data_size
-uint cf_add_chksum_long(uint seed, ubyte *buffer, size_t size)
+uint cf_add_chksum_long(uint seed, const ubyte *buffer, size_t size)
 {
 	uint crc;
-	ubyte *p;
+	const ubyte *p;
 
 	p = buffer;
 	crc = seed;	
@@ -1763,8 +1799,14 @@ static int cf_chksum_do(CFILE *cfile, ushort *chk_short, uint *chk_long, int max
 			read_size = max_size - cf_total;
 		}
 
-		// read in some buffer
-		cf_len = cfread(cf_buffer, 1, read_size, cfile);
+		// read in some buffer, files which are already in memory don't need to be copied
+		auto data = reinterpret_cast<const ubyte*>(cfread_view((size_t)read_size, cfile));
+		if (data != nullptr) {
+			cf_len = read_size;
+		} else {
+			cf_len = cfread(cf_buffer, 1, read_size, cfile);
+			data = cf_buffer;
+		}
 
 		// total we've read so far
 		cf_total += cf_len;
@@ -1773,9 +1815,9 @@ static int cf_chksum_do(CFILE *cfile, ushort *chk_short, uint *chk_long, int max
 		if(cf_len > 0){
 			// do the proper short or long checksum
 			if(is_long){
-				*chk_long = cf_add_chksum_long(*chk_long, cf_buffer, cf_len);
+				*chk_long = cf_add_chksum_long(*chk_long, data, cf_len);
 			} else {
-				*chk_short = cf_add_chksum_short(*chk_short, cf_buffer, cf_len);
+				*chk_short = cf_add_chksum_short(*chk_short, data, cf_len);
 			}
 		}
 	} while((cf_len > 0) && (cf_total < max_size));
@@ -243,6 +243,12 @@ int cfilelength(CFILE *fp);
 // Reads data
 int cfread(void *buf, int elsize, int nelem, CFILE *fp);
 
+// Reads data without copying it. Only works for files which are already in memory (embedded files and files from
+// memory mapped VP files, see -mmap_vps). Returns a pointer to the next size bytes of the file and advances the read
+// position or returns NULL if the file is not in memory or there are less than size bytes left. The data is read-only
+// and stays valid until cfile is shut down.
+const void *cfread_view(size_t size, CFILE *cfile);
+
 // cfwrite() writes to the file
 int cfwrite(const void *buf, int elsize, int nelem, CFILE *cfile);
 
@@ -274,6 +280,10 @@ int cfeof(CFILE *cfile);
 // Return the data pointer associated with the CFILE structure (for memory mapped files)
 const void *cf_returndata(CFILE *cfile);
 
+// Returns a read-only pointer to the whole contents of the file and stores its size in size if the file is already in
+// memory, otherwise returns NULL. Unlike cf_returndata() this may be used on any file.
+const void *cf_get_data_view(CFILE *cfile, size_t *size);
+
 // get the 2 byte checksum of the passed filename - return 0 if operation failed, 1 if succeeded
 int cf_chksum_short(const char *filename, ushort *chksum, int max_size = -1, int cf_type = CF_TYPE_ANY );
 
@@ -293,10 +303,10 @@ int cf_chksum_pack(const char *filename, uint *chk_long, bool full = false);
 // convenient for misc checksumming purposes ------------------------------------------
 
 // update cur_chksum with the chksum of the new_data of size new_data_size
-ushort cf_add_chksum_short(ushort seed, ubyte *buffer, int size);
+ushort cf_add_chksum_short(ushort seed, const ubyte *buffer, int size);
 
 // update cur_chksum with the chksum of the new_data of size new_data_size
-uint cf_add_chksum_long(uint seed, ubyte *buffer, size_t size);
+uint cf_add_chksum_long(uint seed, const ubyte *buffer, size_t size);
 
 // convenient for misc checksumming purposes ------------------------------------------
 
@@ -389,6 +399,7 @@ struct CFileLocation {
 	SCP_string full_name;
 	size_t size          = 0;
 	size_t offset        = 0;
+	time_t write_time    = 0;
 	const void* data_ptr = nullptr;
 
 	explicit CFileLocation(bool found_in = false) : found(found_in) {}
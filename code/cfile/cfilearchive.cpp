@@ -238,6 +238,41 @@ int cfread(void *buf, int elsize, int nelem, CFILE *cfile)
 
 }
 
+// cfread_view() returns a pointer to the next size bytes of a file which is in memory
+//
+// returns:   success ==> pointer to the data
+//            error   ==> NULL
+//
+const void *cfread_view(size_t size, CFILE *cfile)
+{
+	if(!cf_is_valid(cfile))
+		return NULL;
+
+	Cfile_block *cb = &Cfile_block_list[cfile->id];
+
+	if (cb->data == nullptr || cb->mem_mapped) {
+		return NULL;
+	}
+
+	if ( (cb->raw_position+size) > cb->size ) {
+		return NULL;
+	}
+
+	if (cb->max_read_len) {
+		if ( cb->raw_position+size > cb->max_read_len ) {
+			std::ostringstream s_buf;
+			s_buf << "Attempted to read " << size << "-byte(s) beyond length limit";
+
+			throw cfile::max_read_length(s_buf.str());
+		}
+	}
+
+	auto data = reinterpret_cast<const char*>(cb->data) + cb->raw_position;
+	cb->raw_position += size;
+
+	return data;
+}
+
 int cfread_lua_number(double *buf, CFILE *cfile)
 {
 	if(!cf_is_valid(cfile))
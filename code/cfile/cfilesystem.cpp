@@ -15,6 +15,7 @@
 #include <cerrno>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
 
 #ifdef _WIN32
 #include <io.h>
@@ -25,6 +26,7 @@
 
 #ifdef SCP_UNIX
 #include <glob.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <dirent.h>
 #include <fnmatch.h>
@@ -36,8 +38,10 @@
 #include "cfile/cfile.h"
 #include "cfile/cfilesystem.h"
 #include "cmdline/cmdline.h"
+#include "debugconsole/console.h"
 #include "globalincs/pstypes.h"
 #include "def_files/def_files.h"
+#include "io/timer.h"
 #include "localization/localize.h"
 #include "osapi/osapi.h"
 #include "parse/parselo.h"
@@ -57,6 +61,8 @@ typedef struct cf_root {
 	char	path[CF_MAX_PATHNAME_LENGTH];	// Contains something like c:\projects\freespace or c:\projects\freespace\freespace.vp
 	int		roottype;						// CF_ROOTTYPE_PATH  = Path, CF_ROOTTYPE_PACK =Pack file, CF_ROOTTYPE_MEMORY=In memory
 	uint32_t location_flags;
+	const void*	mapped_data;				// For memory mapped pack files, the contents of the whole file. NULL otherwise.
+	size_t	mapped_size;
 } cf_root;
 
 // convenient type for sorting (see cf_build_pack_list())
@@ -129,6 +135,76 @@ cf_file *cf_create_file()
 	return &File_blocks[block]->files[offset];
 }
 
+// Index of all files by their lower case name. The indices of the files with the same name are stored in the same order
+// as in the file list, so the first match is still the one from the root with the highest priority.
+static SCP_unordered_map<SCP_string, SCP_vector<uint>> File_name_index;
+
+// Can be turned off to compare the lookup times with a linear search through the file list
+static bool Cf_use_file_index = true;
+
+static std::atomic<std::uint64_t> Cf_lookup_count(0);
+static std::atomic<std::uint64_t> Cf_lookup_time(0);
+
+static SCP_string cf_file_index_key(const char *name)
+{
+	SCP_string key(name);
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+	return key;
+}
+
+static void cf_build_file_index()
+{
+	File_name_index.clear();
+	File_name_index.reserve(Num_files);
+
+	for (uint i = 0; i < Num_files; i++) {
+		File_name_index[cf_file_index_key(cf_get_file(i)->name_ext)].push_back(i);
+	}
+}
+
+// Returns the indices of all files with this name or nullptr if there are none
+static const SCP_vector<uint> *cf_find_file_index_entries(const char *name)
+{
+	auto iter = File_name_index.find(cf_file_index_key(name));
+
+	if (iter == File_name_index.end()) {
+		return nullptr;
+	}
+
+	return &iter->second;
+}
+
+namespace {
+// Adds the time from construction to destruction to the lookup statistics
+class cf_lookup_timer {
+	std::uint64_t start;
+
+  public:
+	cf_lookup_timer() : start(timer_get_microseconds()) {}
+	~cf_lookup_timer()
+	{
+		Cf_lookup_count++;
+		Cf_lookup_time += timer_get_microseconds() - start;
+	}
+};
+}
+
+cf_lookup_stats cf_get_lookup_stats()
+{
+	cf_lookup_stats stats;
+	stats.lookups = Cf_lookup_count;
+	stats.time_us = Cf_lookup_time;
+
+	return stats;
+}
+
+void cf_reset_lookup_stats()
+{
+	Cf_lookup_count = 0;
+	Cf_lookup_time = 0;
+}
+
 extern int cfile_inited;
 
 // Create a new root and return a pointer to it.  The structure is assumed unitialized.
@@ -157,7 +233,11 @@ cf_root *cf_create_root()
 
 	Num_roots++;
 
-	return &Root_blocks[block]->roots[offset];
+	cf_root *root = &Root_blocks[block]->roots[offset];
+	root->mapped_data = nullptr;
+	root->mapped_size = 0;
+
+	return root;
 }
 
 // return the # of packfiles which exist
@@ -753,6 +833,58 @@ typedef struct VP_FILE {
 	_fs_time_t write_time;
 } VP_FILE;
 
+// Maps the whole pack file into memory so that the files in it can be read without copying them
+static void cf_map_root_pack(cf_root *root, FILE *fp)
+{
+	auto size = (size_t)filelength(fileno(fp));
+
+#ifdef _WIN32
+	HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(fp));
+	HANDLE mapping_handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (mapping_handle == NULL) {
+		mprintf(("Could not create file mapping for pack file '%s'.\n", root->path));
+		return;
+	}
+
+	// The view keeps the mapping alive so the handle is not needed anymore
+	void *data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping_handle);
+
+	if (data == NULL) {
+		mprintf(("Could not map pack file '%s' into memory.\n", root->path));
+		return;
+	}
+#else
+	void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+
+	if (data == MAP_FAILED) {
+		mprintf(("Could not map pack file '%s' into memory: %s\n", root->path, strerror(errno)));
+		return;
+	}
+#endif
+
+	root->mapped_data = data;
+	root->mapped_size = size;
+}
+
+static void cf_unmap_root_pack(cf_root *root)
+{
+	if (root->mapped_data == nullptr) {
+		return;
+	}
+
+	// The const_casts are safe since the pointer returned by the mapping functions was also non-const
+#ifdef _WIN32
+	UnmapViewOfFile(const_cast<void*>(root->mapped_data));
+#else
+	munmap(const_cast<void*>(root->mapped_data), root->mapped_size);
+#endif
+
+	root->mapped_data = nullptr;
+	root->mapped_size = 0;
+}
+
 void cf_search_root_pack(int root_index)
 {
 	int num_files = 0;
@@ -788,6 +920,10 @@ void cf_search_root_pack(int root_index)
 
 	mprintf(( "Searching root pack '%s' ... ", root->path ));
 
+	if (Cmdline_mmap_vps) {
+		cf_map_root_pack(root, fp);
+	}
+
 	// Read index info
 	fseek(fp, VP_header.index_offset, SEEK_SET);
 
@@ -920,6 +1056,7 @@ void cf_build_file_list()
 		}
 	}
 
+	cf_build_file_index();
 }
 
 
@@ -952,10 +1089,19 @@ void cf_build_secondary_filelist(const char *cdrom_dir)
 	mprintf(( "Found %d roots and %d files.\n", Num_roots, Num_files ));
 }
 
+void cf_unmap_root_packs()
+{
+	for (int i=0; i<Num_roots; i++ )	{
+		cf_unmap_root_pack(cf_get_root(i));
+	}
+}
+
 void cf_free_secondary_filelist()
 {
 	int i;
 
+	cf_unmap_root_packs();
+
 	// Free the root blocks
 	for (i=0; i<CF_MAX_ROOT_BLOCKS; i++ )	{
 		if ( Root_blocks[i] )	{
@@ -981,6 +1127,135 @@ void cf_free_secondary_filelist()
 		}
 	}
 	Num_files = 0;
+
+	File_name_index.clear();
+}
+
+// Fills in where a file from the file list can be found
+static void cf_set_file_location(CFileLocation& res, const cf_file *f)
+{
+	res.size = static_cast<size_t>(f->size);
+	res.offset = (size_t)f->pack_offset;
+	res.write_time = f->write_time;
+	res.data_ptr = f->data;
+
+	if (f->data != nullptr) {
+		// This is an in-memory file so we just copy the pathtype name + file name
+		res.full_name = Pathtypes[f->pathtype_index].path;
+		res.full_name += DIR_SEPARATOR_STR;
+		res.full_name += f->name_ext;
+	} else if (f->pack_offset < 1) {
+		// This is a real file, return the actual file path
+		res.full_name = f->real_name;
+	} else {
+		// File is in a pack file
+		cf_root *r = cf_get_root(f->root_index);
+
+		res.full_name = r->path;
+
+		if (r->mapped_data != nullptr && (size_t)f->pack_offset + (size_t)f->size <= r->mapped_size) {
+			// The pack file is mapped so the file can be read straight from memory
+			res.data_ptr = reinterpret_cast<const ubyte*>(r->mapped_data) + f->pack_offset;
+		}
+	}
+}
+
+// Returns the index of the first file in the file list with this name which is in the right path and location or -1
+static int cf_find_first_file(const char *name, int pathtype, uint32_t location_flags)
+{
+	auto matches = [&](const cf_file *f) {
+		// only search paths we're supposed to...
+		if ( (pathtype != CF_TYPE_ANY) && (pathtype != f->pathtype_index) )
+			return false;
+
+		if (location_flags != CF_LOCATION_ALL) {
+			// If a location flag was specified we need to check if the root of this file satisfies the request
+			auto root = cf_get_root(f->root_index);
+
+			if (!cf_check_location_flags(root->location_flags, location_flags)) {
+				// Root does not satisfy location flags
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	if (Cf_use_file_index) {
+		auto entries = cf_find_file_index_entries(name);
+
+		if (entries != nullptr) {
+			for (auto index : *entries) {
+				if (matches(cf_get_file(index))) {
+					return (int)index;
+				}
+			}
+		}
+	} else {
+		for (uint ui = 0; ui < Num_files; ui++) {
+			cf_file *f = cf_get_file(ui);
+
+			if (matches(f) && !stricmp(name, f->name_ext)) {
+				return (int)ui;
+			}
+		}
+	}
+
+	return -1;
+}
+
+DCF(cf_lookup_stats, "Shows the number of file lookups and the time spent in them (cfile)")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: cf_lookup_stats [reset]\n");
+		dc_printf("Shows how many files were looked up since the last reset and how long it took.\n");
+		dc_printf("The counters are reset at the start of every level load.\n");
+		return;
+	}
+
+	auto stats = cf_get_lookup_stats();
+	dc_printf("%llu lookups in %.3f ms\n", (unsigned long long)stats.lookups, stats.time_us / 1000.0);
+
+	if (dc_optional_string("reset")) {
+		cf_reset_lookup_stats();
+	}
+}
+
+DCF(cf_lookup_bench, "Times looking up every file in the file list with and without the hash index (cfile)")
+{
+	int rounds = 1;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: cf_lookup_bench [rounds]\n");
+		dc_printf("Looks up the name of every known file, once using the hash index and once by searching through the\n");
+		dc_printf("whole file list. Defaults to 1 round.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&rounds);
+	rounds = MAX(rounds, 1);
+
+	bool use_index = Cf_use_file_index;
+	std::uint64_t times[2];
+
+	for (int mode = 0; mode < 2; mode++) {
+		Cf_use_file_index = (mode == 0);
+
+		auto start = timer_get_microseconds();
+		for (int round = 0; round < rounds; round++) {
+			for (uint i = 0; i < Num_files; i++) {
+				cf_file *f = cf_get_file(i);
+				cf_find_first_file(f->name_ext, f->pathtype_index, CF_LOCATION_ALL);
+			}
+		}
+		times[mode] = timer_get_microseconds() - start;
+	}
+
+	Cf_use_file_index = use_index;
+
+	dc_printf("%llu lookups\n", (unsigned long long)rounds * Num_files);
+	dc_printf("  hash index:  %.3f ms\n", times[0] / 1000.0);
+	dc_printf("  linear scan: %.3f ms\n", times[1] / 1000.0);
 }
 
 /**
@@ -1004,6 +1279,8 @@ CFileLocation cf_find_file_location(const char* filespec, int pathtype, bool loc
 
 	Assert( (filespec != NULL) && (strlen(filespec) > 0) ); //-V805
 
+	cf_lookup_timer timer;
+
 	// see if we have something other than just a filename
 	// our current rules say that any file that specifies a direct
 	// path will try to be opened on that path.  If that open
@@ -1104,80 +1381,29 @@ CFileLocation cf_find_file_location(const char* filespec, int pathtype, bool loc
 	}
 
 	// Search the pak files and CD-ROM.
-	for (ui = 0; ui < Num_files; ui++ )	{
-		cf_file *f = cf_get_file(ui);
+	int file_index = cf_find_first_file(filespec, pathtype, location_flags);
 
-		// only search paths we're supposed to...
-		if ( (pathtype != CF_TYPE_ANY) && (pathtype != f->pathtype_index) )
-			continue;
+	if (localize) {
+		// create localized filespec
+		strncpy(longname, filespec, MAX_PATH_LEN - 1);
 
-		if (location_flags != CF_LOCATION_ALL) {
-			// If a location flag was specified we need to check if the root of this file satisfies the request
-			auto root = cf_get_root(f->root_index);
+		if ( lcl_add_dir_to_path_with_filename(longname, MAX_PATH_LEN - 1) ) {
+			// the localized version wins unless the unlocalized one comes from a location with a higher priority
+			int localized_index = cf_find_first_file(longname, pathtype, location_flags);
 
-			if (!cf_check_location_flags(root->location_flags, location_flags)) {
-				// Root does not satisfy location flags
-				continue;
+			if ( (localized_index >= 0) && ((file_index < 0) || (localized_index < file_index)) ) {
+				file_index = localized_index;
 			}
 		}
+	}
 
-		if (localize) {
-			// create localized filespec
-			strncpy(longname, filespec, MAX_PATH_LEN - 1);
-
-			if ( lcl_add_dir_to_path_with_filename(longname, MAX_PATH_LEN - 1) ) {
-				if ( !stricmp(longname, f->name_ext) ) {
-					CFileLocation res(true);
-					res.size = static_cast<size_t>(f->size);
-					res.offset = (size_t)f->pack_offset;
-					res.data_ptr = f->data;
-
-					if (f->data != nullptr) {
-						// This is an in-memory file so we just copy the pathtype name + file name
-						res.full_name = Pathtypes[f->pathtype_index].path;
-						res.full_name += DIR_SEPARATOR_STR;
-						res.full_name += f->name_ext;
-					} else if (f->pack_offset < 1) {
-						// This is a real file, return the actual file path
-						res.full_name = f->real_name;
-					} else {
-						// File is in a pack file
-						cf_root *r = cf_get_root(f->root_index);
-
-						res.full_name = r->path;
-					}
-
-					return res;
-				}
-			}
-		}
-
-		// file either not localized or localized version not found
-		if ( !stricmp(filespec, f->name_ext) ) {
-			CFileLocation res(true);
-			res.size = static_cast<size_t>(f->size);
-			res.offset = (size_t)f->pack_offset;
-			res.data_ptr = f->data;
-
-			if (f->data != nullptr) {
-				// This is an in-memory file so we just copy the pathtype name + file name
-				res.full_name = Pathtypes[f->pathtype_index].path;
-				res.full_name += DIR_SEPARATOR_STR;
-				res.full_name += f->name_ext;
-			} else if (f->pack_offset < 1) {
-				// This is a real file, return the actual file path
-				res.full_name = f->real_name;
-			} else {
-				// File is in a pack file
-				cf_root *r = cf_get_root(f->root_index);
-
-				res.full_name = r->path;
-			}
+	if (file_index >= 0) {
+		CFileLocation res(true);
+		cf_set_file_location(res, cf_get_file(file_index));
 
-			return res;
-		}
+		return res;
 	}
-		
+
 	return CFileLocation();
 }
 
@@ -1212,6 +1438,8 @@ CFileLocationExt cf_find_file_location_ext( const char *filename, const int ext_
 	Assert( (ext_list != NULL) && (ext_num > 1) );	// if we are searching for just one ext
 													// then this is the wrong function to use
 
+	cf_lookup_timer timer;
+
 
 	// if we have a full path already then fail.  this function if for searching via filter only!
 #ifdef SCP_UNIX
@@ -1335,8 +1563,32 @@ CFileLocationExt cf_find_file_location_ext( const char *filename, const int ext_
 	file_list_index.reserve( MIN(ext_num * 4, (int)Num_files) );
 
 	// next, run though and pick out base matches
-	for (ui = 0; ui < Num_files; ui++) {
-		cf_file *f = cf_get_file(ui);
+	SCP_vector<uint> candidates;
+
+	if (Cf_use_file_index) {
+		// only the files named like one of our extensions can match, so look those up and put them back into the
+		// order of the file list
+		SCP_string name;
+
+		for (cur_ext = 0; cur_ext < ext_num; cur_ext++) {
+			name = filespec;
+			name += ext_list[cur_ext];
+
+			auto entries = cf_find_file_index_entries(name.c_str());
+
+			if (entries != nullptr) {
+				candidates.insert(candidates.end(), entries->begin(), entries->end());
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	}
+
+	uint num_candidates = Cf_use_file_index ? (uint)candidates.size() : Num_files;
+
+	for (ui = 0; ui < num_candidates; ui++) {
+		cf_file *f = cf_get_file(Cf_use_file_index ? candidates[ui] : ui);
 
 		// ... only search paths that we're supposed to
 		if ( (num_search_dirs == 1) && (pathtype != f->pathtype_index) )
@@ -1392,25 +1644,7 @@ CFileLocationExt cf_find_file_location_ext( const char *filename, const int ext_
 				if ( lcl_add_dir_to_path_with_filename(longname, MAX_PATH_LEN - 1) ) {
 					if ( !stricmp(longname, f->name_ext) ) {
 						CFileLocationExt res(cur_ext);
-						res.found = true;
-						res.size = static_cast<size_t>(f->size);
-						res.offset = (size_t)f->pack_offset;
-						res.data_ptr = f->data;
-
-						if (f->data != nullptr) {
-							// This is an in-memory file so we just copy the pathtype name + file name
-							res.full_name = Pathtypes[f->pathtype_index].path;
-							res.full_name += DIR_SEPARATOR_STR;
-							res.full_name += f->name_ext;
-						} else if (f->pack_offset < 1) {
-							// This is a real file, return the actual file path
-							res.full_name = f->real_name;
-						} else {
-							// File is in a pack file
-							cf_root *r = cf_get_root(f->root_index);
-
-							res.full_name = r->path;
-						}
+						cf_set_file_location(res, f);
 
 						// found it, so cleanup and return
 						file_list_index.clear();
@@ -1423,25 +1657,7 @@ CFileLocationExt cf_find_file_location_ext( const char *filename, const int ext_
 			// file either not localized or localized version not found
 			if ( !stricmp(filespec, f->name_ext) ) {
 				CFileLocationExt res(cur_ext);
-				res.found = true;
-				res.size = static_cast<size_t>(f->size);
-				res.offset = (size_t)f->pack_offset;
-				res.data_ptr = f->data;
-
-				if (f->data != nullptr) {
-					// This is an in-memory file so we just copy the pathtype name + file name
-					res.full_name = Pathtypes[f->pathtype_index].path;
-					res.full_name += DIR_SEPARATOR_STR;
-					res.full_name += f->name_ext;
-				} else if (f->pack_offset < 1) {
-					// This is a real file, return the actual file path
-					res.full_name = f->real_name;
-				} else {
-					// File is in a pack file
-					cf_root *r = cf_get_root(f->root_index);
-
-					res.full_name = r->path;
-				}
+				cf_set_file_location(res, f);
 
 				// found it, so cleanup and return
 				file_list_index.clear();
@@ -18,6 +18,18 @@
 void cf_build_secondary_filelist( const char *cdrom_path );
 void cf_free_secondary_filelist();
 
+// Releases the memory mappings of the pack files, any data pointers into them become invalid
+void cf_unmap_root_packs();
+
+// Counters for the file lookups of cf_find_file_location() and cf_find_file_location_ext()
+typedef struct cf_lookup_stats {
+	std::uint64_t lookups;			// Number of lookups
+	std::uint64_t time_us;			// Time spent in the lookups, including the searches on disk
+} cf_lookup_stats;
+
+cf_lookup_stats cf_get_lookup_stats();
+void cf_reset_lookup_stats();
+
 // Internal stuff
 typedef struct cf_pathtype {
 	int			index;					// To verify that the CF_TYPE define is correctly indexed into this array
@@ -234,6 +234,19 @@ Flag exe_params[] =
 	{ "-tablecrcs",			"Dump table CRCs for multi validation",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-tablecrcs", },
 	{ "-missioncrcs",		"Dump mission CRCs for multi validation",	true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-missioncrcs", },
 	{ "-dis_collisions",	"Disable collisions",						true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-dis_collisions", },
+	{ "-collision_grid",	"Use grid-based collision detection",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_collisions",	"Multi-threaded collision checks",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_ai_targeting",	"Multi-threaded AI target search",			true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-batch_physics",	"Batched physics integration",				true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-compile_sexps",	"Precompute SEXP data at mission load",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_page_in",		"Decode level bitmaps on worker threads",	true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-texture_cache",		"Cache decoded textures on disk",			true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_parse",			"Preprocess tables on worker threads",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-table_cache",		"Cache AI profile and fireball tables",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_model_load",		"Build model data on worker threads",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-model_cache",		"Cache derived model data on disk",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mt_particles",		"Update particles on worker threads",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
+	{ "-mmap_vps",			"Read VP files through memory maps",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
 	{ "-dis_weapons",		"Disable weapon rendering",					true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-dis_weapons", },
 	{ "-output_sexps",		"Output SEXPs to sexps.html",				true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-output_sexps", },
 	{ "-output_scripting",	"Output scripting to scripting.html",		true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-output_scripting", },
@@ -246,6 +259,7 @@ Flag exe_params[] =
 	{ "-noninteractive",	"Disables interactive dialogs",				true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-noninteractive", },
 	{ "-json_profiling",	"Generate JSON profiling output",			true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-json_profiling", },
 	{ "-profile_frame_time","Profile engine subsystems",				true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-profile_frame_timings", },
+	{ "-profile_mission",	"Write subsystem statistics per mission",	true,	0,					EASY_DEFAULT,		"Dev Tool",		"", },
 	{ "-debug_window",		"Enable the debug window",					true,	0,					EASY_DEFAULT,		"Dev Tool",		"http://www.hard-light.net/wiki/index.php/Command-Line_Reference#-debug_window", },
 };
 
@@ -465,6 +479,20 @@ bool Cmdline_alternate_registry_path = false;
 cmdline_parm start_mission_arg("-start_mission", "Skip mainhall and run this mission", AT_STRING);	// Cmdline_start_mission
 cmdline_parm dis_collisions("-dis_collisions", NULL, AT_NONE);	// Cmdline_dis_collisions
 cmdline_parm dis_weapons("-dis_weapons", NULL, AT_NONE);		// Cmdline_dis_weapons
+cmdline_parm collision_grid_arg("-collision_grid", NULL, AT_NONE);	// Cmdline_collision_grid
+cmdline_parm mt_collisions_arg("-mt_collisions", NULL, AT_NONE);	// Cmdline_mt_collisions
+cmdline_parm mt_ai_targeting_arg("-mt_ai_targeting", NULL, AT_NONE);	// Cmdline_mt_ai_targeting
+cmdline_parm batch_physics_arg("-batch_physics", NULL, AT_NONE);	// Cmdline_batch_physics
+cmdline_parm compile_sexps_arg("-compile_sexps", NULL, AT_NONE);	// Cmdline_compile_sexps
+cmdline_parm mt_page_in_arg("-mt_page_in", NULL, AT_NONE);	// Cmdline_mt_page_in
+cmdline_parm texture_cache_arg("-texture_cache", NULL, AT_NONE);	// Cmdline_texture_cache
+cmdline_parm mt_parse_arg("-mt_parse", NULL, AT_NONE);	// Cmdline_mt_parse
+cmdline_parm table_cache_arg("-table_cache", NULL, AT_NONE);	// Cmdline_table_cache
+cmdline_parm mt_model_load_arg("-mt_model_load", NULL, AT_NONE);	// Cmdline_mt_model_load
+cmdline_parm model_cache_arg("-model_cache", NULL, AT_NONE);	// Cmdline_model_cache
+cmdline_parm mt_particles_arg("-mt_particles", NULL, AT_NONE);	// Cmdline_mt_particles
+cmdline_parm mmap_vps_arg("-mmap_vps", NULL, AT_NONE);	// Cmdline_mmap_vps
+cmdline_parm worker_threads_arg("-worker_threads", "Number of worker threads (0 disables them)", AT_INT);	// Cmdline_worker_threads
 cmdline_parm noparseerrors_arg("-noparseerrors", NULL, AT_NONE);	// Cmdline_noparseerrors  -- turns off parsing errors -C
 cmdline_parm extra_warn_arg("-extra_warn", "Enable 'extra' warnings", AT_NONE);	// Cmdline_extra_warn
 cmdline_parm fps_arg("-fps", NULL, AT_NONE);					// Cmdline_show_fps
@@ -486,12 +514,27 @@ cmdline_parm noninteractive_arg("-noninteractive", NULL, AT_NONE); //Cmdline_non
 cmdline_parm json_profiling("-json_profiling", NULL, AT_NONE); //Cmdline_json_profiling
 cmdline_parm show_video_info("-show_video_info", NULL, AT_NONE); //Cmdline_show_video_info
 cmdline_parm frame_profile_arg("-profile_frame_time", NULL, AT_NONE); //Cmdline_frame_profile
+cmdline_parm mission_profile_arg("-profile_mission", NULL, AT_NONE); //Cmdline_mission_profile
 cmdline_parm debug_window_arg("-debug_window", NULL, AT_NONE);	// Cmdline_debug_window
 
 
 char *Cmdline_start_mission = NULL;
 int Cmdline_dis_collisions = 0;
 int Cmdline_dis_weapons = 0;
+bool Cmdline_collision_grid = false;
+bool Cmdline_mt_collisions = false;
+bool Cmdline_mt_ai_targeting = false;
+bool Cmdline_batch_physics = false;
+bool Cmdline_compile_sexps = false;
+bool Cmdline_mt_page_in = false;
+bool Cmdline_texture_cache = false;
+bool Cmdline_mt_parse = false;
+bool Cmdline_table_cache = false;
+bool Cmdline_mt_model_load = false;
+bool Cmdline_model_cache = false;
+bool Cmdline_mt_particles = false;
+bool Cmdline_mmap_vps = false;
+int Cmdline_worker_threads = -1;
 bool Cmdline_output_sexp_info = false;
 int Cmdline_noparseerrors = 0;
 #ifdef Allow_NoWarn
@@ -514,6 +557,7 @@ bool Cmdline_benchmark_mode = false;
 bool Cmdline_noninteractive = false;
 bool Cmdline_json_profiling = false;
 bool Cmdline_frame_profile = false;
+bool Cmdline_mission_profile = false;
 bool Cmdline_show_video_info = false;
 bool Cmdline_debug_window = false;
 
@@ -1961,6 +2005,53 @@ bool SetCmdlineParams()
 	if(dis_weapons.found())
 		Cmdline_dis_weapons = 1;
 
+	if (collision_grid_arg.found())
+		Cmdline_collision_grid = true;
+
+	if (mt_collisions_arg.found())
+		Cmdline_mt_collisions = true;
+
+	if (mt_ai_targeting_arg.found())
+		Cmdline_mt_ai_targeting = true;
+
+	if (batch_physics_arg.found())
+		Cmdline_batch_physics = true;
+
+	if (compile_sexps_arg.found())
+		Cmdline_compile_sexps = true;
+
+	if (mt_page_in_arg.found())
+		Cmdline_mt_page_in = true;
+
+	if (texture_cache_arg.found())
+		Cmdline_texture_cache = true;
+
+	if (mt_parse_arg.found())
+		Cmdline_mt_parse = true;
+
+	if (table_cache_arg.found())
+		Cmdline_table_cache = true;
+
+	if (mt_model_load_arg.found())
+		Cmdline_mt_model_load = true;
+
+	if (model_cache_arg.found())
+		Cmdline_model_cache = true;
+
+	if (mt_particles_arg.found())
+		Cmdline_mt_particles = true;
+
+	if (mmap_vps_arg.found())
+		Cmdline_mmap_vps = true;
+
+	if (worker_threads_arg.found()) {
+		Cmdline_worker_threads = worker_threads_arg.get_int();
+
+		if (Cmdline_worker_threads < 0) {
+			Cmdline_worker_threads = 0;
+		}
+	}
+
 	if ( no_fbo_arg.found() ) {
 		Cmdline_no_fbo = 1;
 	}
@@ -2082,6 +2173,11 @@ bool SetCmdlineParams()
 		Cmdline_frame_profile = true;
 	}
 
+	if (mission_profile_arg.found())
+	{
+		Cmdline_mission_profile = true;
+	}
+
 	if (debug_window_arg.found()) {
 		Cmdline_debug_window = true;
 	}
@@ -141,6 +141,20 @@ extern bool Cmdline_alternate_registry_path;
 extern char *Cmdline_start_mission;
 extern int Cmdline_dis_collisions;
 extern int Cmdline_dis_weapons;
+extern bool Cmdline_collision_grid;
+extern bool Cmdline_mt_collisions;
+extern bool Cmdline_mt_ai_targeting;
+extern bool Cmdline_batch_physics;
+extern bool Cmdline_compile_sexps;
+extern bool Cmdline_mt_page_in;
+extern bool Cmdline_texture_cache;
+extern bool Cmdline_mt_parse;
+extern bool Cmdline_table_cache;
+extern bool Cmdline_mt_model_load;
+extern bool Cmdline_model_cache;
+extern bool Cmdline_mt_particles;
+extern bool Cmdline_mmap_vps;
+extern int Cmdline_worker_threads;
 extern bool Cmdline_output_sexp_info;
 extern int Cmdline_noparseerrors;
 extern int Cmdline_extra_warn;
@@ -156,6 +170,7 @@ extern bool Cmdline_benchmark_mode;
 extern bool Cmdline_noninteractive;
 extern bool Cmdline_json_profiling;
 extern bool Cmdline_frame_profile;
+extern bool Cmdline_mission_profile;
 extern bool Cmdline_show_video_info;
 extern bool Cmdline_debug_window;
 
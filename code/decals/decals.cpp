@@ -1,7 +1,10 @@
 #include <nebula/neb.h>
+#include <algorithm>
+#include <cmath>
 #include <utility>
 #include "decals/decals.h"
 
+#include "debugconsole/console.h"
 #include "graphics/2d.h"
 #include "graphics/decal_draw_list.h"
 #include "graphics/util/uniform_structs.h"
@@ -223,24 +226,23 @@ void parse_decals_table(const char* filename) {
 	}
 }
 
-struct Decal {
-	int definition_handle = -1;
+// All decals on one submodel of a host share the validity checks and the world transform of the submodel
+struct DecalBucket {
 	object_h object;
 	int orig_obj_type = OBJ_NONE;
 	int submodel = -1;
 
-	float creation_time = -1.0f; //!< The mission time at which this decal was created
-	float lifetime = -1.0f; //!< The time this decal is active. When negative it never expires
+	// The world transform of the submodel which was used for the cached transforms of the decals
+	vec3d submodel_pos = vmd_zero_vector;
+	matrix submodel_orient = vmd_identity_matrix;
+	bool transform_valid = false;
+	uint32_t transform_version = 0; //!< Incremented every time the submodel has moved
 
-	vec3d position = vmd_zero_vector;
-	vec3d scale;
-	matrix orientation = vmd_identity_matrix;
+	SCP_vector<int> decals; //!< Indices into the decal pool
 
-	Decal() {
-		vm_vec_make(&scale, 1.f, 1.f, 1.f);
-	}
+	bool in_use = false;
 
-	bool isValid() {
+	bool isValid() const {
 		if (!object.IsValid()) {
 			return false;
 		}
@@ -251,13 +253,6 @@ struct Decal {
 			return false;
 		}
 
-		if (lifetime > 0.0f) {
-			if (f2fl(Missiontime) >= creation_time + lifetime) {
-				// Decal has expired
-				return false;
-			}
-		}
-
 		auto objp = object.objp;
 		if (objp->type == OBJ_SHIP) {
 			auto shipp = &Ships[objp->instance];
@@ -276,7 +271,233 @@ struct Decal {
 	}
 };
 
-SCP_vector<Decal> active_decals;
+struct Decal {
+	int definition_handle = -1;
+	int bucket = -1;
+	size_t bucket_index = 0; //!< The position of this decal in the decal list of its bucket
+
+	float creation_time = -1.0f; //!< The mission time at which this decal was created
+	float lifetime = -1.0f; //!< The time this decal is active. When negative it never expires
+
+	vec3d position = vmd_zero_vector;
+	vec3d scale;
+	matrix orientation = vmd_identity_matrix;
+
+	matrix4 transform; //!< The world transform, only valid if transform_version matches the version of the bucket
+	uint32_t transform_version = 0;
+
+	// The list of decals ordered by the time they were last drawn, the first one is evicted if the budget is exceeded
+	int lru_prev = -1;
+	int lru_next = -1;
+
+	uint32_t generation = 0; //!< Incremented when the decal is removed so stale expiry entries can be detected
+	bool in_use = false;
+
+	Decal() {
+		vm_vec_make(&scale, 1.f, 1.f, 1.f);
+	}
+
+	bool hasExpired(float mission_time) const {
+		return lifetime > 0.0f && mission_time >= creation_time + lifetime;
+	}
+};
+
+struct expiry_entry {
+	int decal;
+	uint32_t generation;
+};
+
+// Decals with a lifetime are put into the slot of the tick in which they expire. Slot i holds the ticks congruent to i
+// so the entries of later revolutions stay in their slot until the ring comes around again. Only ticks which have
+// completely passed are processed, which means every decal in them has expired.
+const float EXPIRY_TICK_LENGTH = 0.25f;
+const int EXPIRY_RING_SIZE = 256;
+
+SCP_vector<expiry_entry> expiry_ring[EXPIRY_RING_SIZE];
+int64_t last_expiry_tick = -1; //!< The last tick which has been processed
+
+SCP_vector<Decal> decal_pool;
+SCP_vector<int> free_decals;
+size_t num_active_decals = 0;
+
+int lru_first = -1;
+int lru_last = -1;
+
+SCP_vector<DecalBucket> buckets;
+SCP_vector<int> free_buckets;
+SCP_unordered_map<uint64_t, int> bucket_lookup;
+
+int Decal_memory_budget = 4096; //!< The maximum memory used by the active decals in KB
+
+uint64_t bucket_key(const object_h& host, int submodel) {
+	return ((uint64_t)(uint32_t)host.sig << 32) | (uint32_t)submodel;
+}
+
+// Each decal also has an entry in its bucket and in the expiry ring
+size_t max_active_decals() {
+	auto decal_size = sizeof(Decal) + sizeof(int) + sizeof(expiry_entry);
+
+	return std::max((size_t)Decal_memory_budget * 1024 / decal_size, (size_t)1);
+}
+
+void lru_unlink(int index) {
+	auto& decal = decal_pool[index];
+
+	if (decal.lru_prev >= 0) {
+		decal_pool[decal.lru_prev].lru_next = decal.lru_next;
+	} else {
+		lru_first = decal.lru_next;
+	}
+	if (decal.lru_next >= 0) {
+		decal_pool[decal.lru_next].lru_prev = decal.lru_prev;
+	} else {
+		lru_last = decal.lru_prev;
+	}
+
+	decal.lru_prev = -1;
+	decal.lru_next = -1;
+}
+
+void lru_append(int index) {
+	auto& decal = decal_pool[index];
+
+	decal.lru_prev = lru_last;
+	decal.lru_next = -1;
+
+	if (lru_last >= 0) {
+		decal_pool[lru_last].lru_next = index;
+	} else {
+		lru_first = index;
+	}
+	lru_last = index;
+}
+
+void lru_touch(int index) {
+	if (lru_last == index) {
+		return;
+	}
+
+	lru_unlink(index);
+	lru_append(index);
+}
+
+void free_bucket(int index) {
+	auto& bucket = buckets[index];
+
+	bucket_lookup.erase(bucket_key(bucket.object, bucket.submodel));
+
+	bucket.decals.clear();
+	bucket.object = object_h();
+	bucket.in_use = false;
+
+	free_buckets.push_back(index);
+}
+
+int find_or_create_bucket(object* host, int submodel) {
+	object_h host_h(host);
+	auto key = bucket_key(host_h, submodel);
+
+	auto iter = bucket_lookup.find(key);
+	if (iter != bucket_lookup.end()) {
+		return iter->second;
+	}
+
+	int index;
+	if (!free_buckets.empty()) {
+		index = free_buckets.back();
+		free_buckets.pop_back();
+	} else {
+		index = (int)buckets.size();
+		buckets.emplace_back();
+	}
+
+	auto& bucket = buckets[index];
+	bucket.object = host_h;
+	bucket.orig_obj_type = host->type;
+	bucket.submodel = submodel;
+	bucket.transform_valid = false;
+	bucket.in_use = true;
+
+	bucket_lookup.insert(std::make_pair(key, index));
+
+	return index;
+}
+
+void remove_decal(int index) {
+	auto& decal = decal_pool[index];
+	Assertion(decal.in_use, "Tried to remove a decal which is not active!");
+
+	// Swap the last decal of the bucket into the slot of this one
+	auto& bucket_decals = buckets[decal.bucket].decals;
+	auto last = bucket_decals.back();
+	bucket_decals[decal.bucket_index] = last;
+	decal_pool[last].bucket_index = decal.bucket_index;
+	bucket_decals.pop_back();
+
+	if (bucket_decals.empty()) {
+		free_bucket(decal.bucket);
+	}
+
+	lru_unlink(index);
+
+	decal.in_use = false;
+	decal.bucket = -1;
+	++decal.generation;
+
+	free_decals.push_back(index);
+	--num_active_decals;
+}
+
+void remove_bucket(int index) {
+	// Removing the last decal frees the bucket
+	while (buckets[index].in_use) {
+		remove_decal(buckets[index].decals.back());
+	}
+}
+
+int64_t expiry_tick(float time) {
+	return (int64_t)std::floor(time / EXPIRY_TICK_LENGTH);
+}
+
+void schedule_expiry(int index) {
+	auto& decal = decal_pool[index];
+
+	// A tick which has been processed already won't be looked at again so use the next one
+	auto tick = std::max(expiry_tick(decal.creation_time + decal.lifetime), last_expiry_tick + 1);
+
+	expiry_ring[tick % EXPIRY_RING_SIZE].push_back({index, decal.generation});
+}
+
+void process_expired_decals(float mission_time) {
+	auto current_tick = expiry_tick(mission_time);
+
+	// Only the ticks before the current one have completely passed. There is no need to look at a slot more than once.
+	auto first_tick = std::max(last_expiry_tick + 1, current_tick - EXPIRY_RING_SIZE);
+	for (auto tick = first_tick; tick < current_tick; ++tick) {
+		auto& slot = expiry_ring[tick % EXPIRY_RING_SIZE];
+
+		for (size_t i = 0; i < slot.size();) {
+			auto& entry = slot[i];
+			auto& decal = decal_pool[entry.decal];
+
+			auto stale = !decal.in_use || decal.generation != entry.generation;
+			if (!stale && !decal.hasExpired(mission_time)) {
+				// Expires in a later revolution of the ring
+				++i;
+				continue;
+			}
+
+			if (!stale) {
+				remove_decal(entry.decal);
+			}
+
+			slot[i] = slot.back();
+			slot.pop_back();
+		}
+	}
+
+	last_expiry_tick = std::max(last_expiry_tick, current_tick - 1);
+}
 
 bool required_string_if_new(const char* token, bool new_entry) {
 	if (!new_entry) {
@@ -393,36 +614,70 @@ void pageInDecal(const creation_info& info) {
 }
 
 void initializeMission() {
-	active_decals.clear();
+	decal_pool.clear();
+	free_decals.clear();
+	num_active_decals = 0;
+
+	lru_first = -1;
+	lru_last = -1;
+
+	buckets.clear();
+	free_buckets.clear();
+	bucket_lookup.clear();
+
+	for (auto& slot : expiry_ring) {
+		slot.clear();
+	}
+	last_expiry_tick = -1;
 }
 
-matrix4 getDecalTransform(Decal& decal) {
-	Assertion(decal.object.objp->type == OBJ_SHIP, "Only ships are currently supported for decals!");
+/**
+ * @brief Updates the cached world transform of the submodel of a bucket
+ * @return @c true if the submodel has moved since the last update
+ */
+bool updateBucketTransform(DecalBucket& bucket) {
+	Assertion(bucket.object.objp->type == OBJ_SHIP, "Only ships are currently supported for decals!");
 
-	auto objp = decal.object.objp;
+	auto objp = bucket.object.objp;
 	auto ship = &Ships[objp->instance];
 
+	vec3d pos;
+	vec3d origin = vmd_zero_vector;
+	model_instance_find_world_point(&pos, &origin, ship->model_instance_num, bucket.submodel, &objp->orient,
+	                                &objp->pos);
+
+	vec3d rvec = vmd_x_vector;
+	vec3d uvec = vmd_y_vector;
+	vec3d fvec = vmd_z_vector;
+
+	matrix orient;
+	model_instance_find_world_dir(&orient.vec.rvec, &rvec, ship->model_instance_num, bucket.submodel, &objp->orient);
+	model_instance_find_world_dir(&orient.vec.uvec, &uvec, ship->model_instance_num, bucket.submodel, &objp->orient);
+	model_instance_find_world_dir(&orient.vec.fvec, &fvec, ship->model_instance_num, bucket.submodel, &objp->orient);
+
+	if (bucket.transform_valid && vm_vec_same(&pos, &bucket.submodel_pos)
+		&& vm_matrix_same(&orient, &bucket.submodel_orient)) {
+		return false;
+	}
+
+	bucket.submodel_pos = pos;
+	bucket.submodel_orient = orient;
+	bucket.transform_valid = true;
+	++bucket.transform_version;
+
+	return true;
+}
+
+matrix4 getDecalTransform(const Decal& decal, const DecalBucket& bucket) {
 	vec3d worldPos;
-	model_instance_find_world_point(&worldPos,
-									&decal.position,
-									ship->model_instance_num,
-									decal.submodel,
-									&objp->orient,
-									&objp->pos);
+	vm_vec_unrotate(&worldPos, &decal.position, &bucket.submodel_orient);
+	vm_vec_add2(&worldPos, &bucket.submodel_pos);
 
 	vec3d worldDir;
-	model_instance_find_world_dir(&worldDir,
-								  &decal.orientation.vec.fvec,
-								  ship->model_instance_num,
-								  decal.submodel,
-								  &objp->orient);
+	vm_vec_unrotate(&worldDir, &decal.orientation.vec.fvec, &bucket.submodel_orient);
 
 	vec3d worldUp;
-	model_instance_find_world_dir(&worldUp,
-								  &decal.orientation.vec.fvec,
-								  ship->model_instance_num,
-								  decal.submodel,
-								  &objp->orient);
+	vm_vec_unrotate(&worldUp, &decal.orientation.vec.fvec, &bucket.submodel_orient);
 
 	matrix worldOrient;
 	vm_vector_2_matrix(&worldOrient, &worldDir, &worldUp);
@@ -444,68 +699,93 @@ matrix4 getDecalTransform(Decal& decal) {
 	return mat4;
 }
 
+bool isHostVisible(const object* host) {
+	return host->flags[Object::Object_Flags::Was_rendered];
+}
+
 void renderAll() {
 	if (!decal_system_active) {
 		return;
 	}
 
-	// Clear out any invalid decals
-	for (auto iter = active_decals.begin(); iter != active_decals.end(); ++iter) {
-		if (!iter->isValid()) {
-			// if we're sitting on the very last element, popping-back will invalidate the iterator!
-			if (iter + 1 == active_decals.end()) {
-				active_decals.pop_back();
-				break;
-			}
+	auto mission_time = f2fl(Missiontime);
 
-			*iter = active_decals.back();
-			active_decals.pop_back();
-			continue;
+	process_expired_decals(mission_time);
+
+	// The validity of the host is the same for all decals of a bucket
+	for (int i = 0; i < (int)buckets.size(); ++i) {
+		if (buckets[i].in_use && !buckets[i].isValid()) {
+			remove_bucket(i);
 		}
 	}
 
-	if (active_decals.empty()) {
+	if (num_active_decals == 0) {
 		return;
 	}
 
-
 	graphics::decal_draw_list draw_list;
-	auto mission_time = f2fl(Missiontime);
 
-	for (auto& decal : active_decals) {
-		int diffuse_bm = -1;
-		int glow_bm = -1;
-		int normal_bm = -1;
+	for (auto& bucket : buckets) {
+		if (!bucket.in_use) {
+			continue;
+		}
 
-		Assertion(decal.definition_handle >= 0 && decal.definition_handle < (int) decalDefinitions.size(),
-				  "Invalid decal handle detected!");
-		auto& decalDef = decalDefinitions[decal.definition_handle];
+		if (!isHostVisible(bucket.object.objp)) {
+			// The host is not visible so there is nothing the decals could be drawn on
+			continue;
+		}
 
-		auto decal_time = mission_time - decal.creation_time;
-		auto progress = decal_time / decal.lifetime;
+		updateBucketTransform(bucket);
 
-		float alpha = 1.0f;
-		if (progress > 0.8) {
-			// Fade the decal out for the last 20% of its lifetime
-			alpha = 1.0f - smoothstep(0.8f, 1.0f, progress);
-		}
+		for (auto index : bucket.decals) {
+			auto& decal = decal_pool[index];
 
-		if (decalDef.getDiffuseBitmap() >= 0) {
-			diffuse_bm = decalDef.getDiffuseBitmap()
-				+ bm_get_anim_frame(decalDef.getDiffuseBitmap(), decal_time, 0.0f, decalDef.isDiffuseLooping());
-		}
+			if (decal.hasExpired(mission_time)) {
+				// Will be removed once its tick of the expiry ring has passed
+				continue;
+			}
 
-		if (decalDef.getGlowBitmap() >= 0) {
-			glow_bm = decalDef.getGlowBitmap()
-				+ bm_get_anim_frame(decalDef.getGlowBitmap(), decal_time, 0.0f, decalDef.isGlowLooping());
-		}
+			if (decal.transform_version != bucket.transform_version) {
+				decal.transform = getDecalTransform(decal, bucket);
+				decal.transform_version = bucket.transform_version;
+			}
 
-		if (decalDef.getNormalBitmap() >= 0) {
-			normal_bm = decalDef.getNormalBitmap()
-				+ bm_get_anim_frame(decalDef.getNormalBitmap(), decal_time, 0.0f, decalDef.isNormalLooping());
-		}
+			lru_touch(index);
+
+			int diffuse_bm = -1;
+			int glow_bm = -1;
+			int normal_bm = -1;
+
+			Assertion(decal.definition_handle >= 0 && decal.definition_handle < (int) decalDefinitions.size(),
+					  "Invalid decal handle detected!");
+			auto& decalDef = decalDefinitions[decal.definition_handle];
+
+			auto decal_time = mission_time - decal.creation_time;
+			auto progress = decal_time / decal.lifetime;
+
+			float alpha = 1.0f;
+			if (progress > 0.8) {
+				// Fade the decal out for the last 20% of its lifetime
+				alpha = 1.0f - smoothstep(0.8f, 1.0f, progress);
+			}
+
+			if (decalDef.getDiffuseBitmap() >= 0) {
+				diffuse_bm = decalDef.getDiffuseBitmap()
+					+ bm_get_anim_frame(decalDef.getDiffuseBitmap(), decal_time, 0.0f, decalDef.isDiffuseLooping());
+			}
+
+			if (decalDef.getGlowBitmap() >= 0) {
+				glow_bm = decalDef.getGlowBitmap()
+					+ bm_get_anim_frame(decalDef.getGlowBitmap(), decal_time, 0.0f, decalDef.isGlowLooping());
+			}
+
+			if (decalDef.getNormalBitmap() >= 0) {
+				normal_bm = decalDef.getNormalBitmap()
+					+ bm_get_anim_frame(decalDef.getNormalBitmap(), decal_time, 0.0f, decalDef.isNormalLooping());
+			}
 
-		draw_list.add_decal(diffuse_bm, glow_bm, normal_bm, decal_time, getDecalTransform(decal), alpha);
+			draw_list.add_decal(diffuse_bm, glow_bm, normal_bm, decal_time, decal.transform, alpha);
+		}
 	}
 
 	draw_list.render();
@@ -529,11 +809,28 @@ addDecal(creation_info& info, object* host, int submodel, const vec3d& local_pos
 		def.loadBitmaps();
 	}
 
-	Decal newDecal;
+	// Make room by removing the decals which haven't been drawn for the longest time
+	auto max_decals = max_active_decals();
+	while (num_active_decals >= max_decals) {
+		remove_decal(lru_first);
+	}
+
+	int index;
+	if (!free_decals.empty()) {
+		index = free_decals.back();
+		free_decals.pop_back();
+	} else {
+		index = (int)decal_pool.size();
+		decal_pool.emplace_back();
+	}
+
+	auto bucket_index = find_or_create_bucket(host, submodel);
+	auto& bucket = buckets[bucket_index];
+
+	auto& newDecal = decal_pool[index];
 	newDecal.definition_handle = info.definition_handle;
-	newDecal.object = object_h(host);
-	newDecal.orig_obj_type     = host->type;
-	newDecal.submodel = submodel;
+	newDecal.bucket = bucket_index;
+	newDecal.bucket_index = bucket.decals.size();
 	newDecal.creation_time = f2fl(Missiontime);
 	newDecal.lifetime = info.lifetime.next();
 
@@ -543,7 +840,42 @@ addDecal(creation_info& info, object* host, int submodel, const vec3d& local_pos
 	newDecal.scale.xyz.y = info.radius;
 	newDecal.scale.xyz.z = info.radius;
 
-	active_decals.push_back(newDecal);
+	newDecal.transform_version = 0;
+	newDecal.in_use = true;
+
+	bucket.decals.push_back(index);
+	lru_append(index);
+	++num_active_decals;
+
+	if (newDecal.lifetime > 0.0f) {
+		schedule_expiry(index);
+	}
 }
 
 }
+
+DCF(decals, "Shows or changes the state of the decal system") {
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: decals [budget <KB>]\n");
+		dc_printf("Without arguments the number of active decals is shown.\n");
+		dc_printf("\tbudget: Sets the maximum memory of the active decals in KB\n");
+		return;
+	}
+
+	if (dc_optional_string("budget")) {
+		int budget;
+		dc_stuff_int(&budget);
+
+		if (budget <= 0) {
+			dc_printf("The budget must be positive.\n");
+			return;
+		}
+
+		Decal_memory_budget = budget;
+		dc_printf("Decal budget set to %d KB (%d decals).\n", Decal_memory_budget, (int)max_active_decals());
+		return;
+	}
+
+	dc_printf("Decals: %d active on %d submodels, at most %d (%d KB)\n", (int)num_active_decals,
+	          (int)bucket_lookup.size(), (int)max_active_decals(), Decal_memory_budget);
+}
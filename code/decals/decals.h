@@ -68,9 +68,22 @@ void initializeMission();
  */
 void renderAll();
 
+/**
+ * @brief Checks if the decals on an object need to be drawn this frame
+ *
+ * Decals are only drawn on hosts which were rendered this frame, including ships drawn with a shader effect.
+ *
+ * @param host The object the decals are attached to
+ * @return true if the host was rendered this frame
+ */
+bool isHostVisible(const object* host);
+
 /**
  * @brief Creates a new decal on the specified object at the specified location
  *
+ * If the memory budget of the decal system is exhausted the decal which has not been drawn for the longest time is
+ * removed.
+ *
  * @param info The decal to create
  * @param host The object host on which to create this decal. Must be a ship.
  * @param submodel The submodel of the object model on which to create the decal.
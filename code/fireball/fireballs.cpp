@@ -18,6 +18,7 @@
 #include "model/model.h"
 #include "object/object.h"
 #include "parse/parselo.h"
+#include "parse/table_cache.h"
 #include "render/3d.h"
 #include "render/batching.h"
 #include "ship/ship.h"
@@ -368,21 +369,52 @@ void fireball_parse_tbl()
 	if (fireballs_parsed)
 		return;
 
-	// every newly parsed fireball_info will get cleared before being added
-	// must do this outside of parse_fireball_tbl because it's called twice
-	Num_fireball_types = 0;
-
-	parse_fireball_tbl("fireball.tbl");
-
-	// look for any modular tables
-	parse_modular_table(NOX("*-fbl.tbm"), parse_fireball_tbl);
+	table_cache_info info;
+	info.name = "fireball";
+	info.version = 1;
+	info.table = "fireball.tbl";
+	info.default_table = nullptr;
+	info.tbm_filter = NOX("*-fbl.tbm");
+
+	info.parse = []() {
+		// every newly parsed fireball_info will get cleared before being added
+		// must do this outside of parse_fireball_tbl because it's called twice
+		Num_fireball_types = 0;
+
+		parse_fireball_tbl("fireball.tbl");
+
+		// look for any modular tables
+		parse_modular_table(NOX("*-fbl.tbm"), parse_fireball_tbl);
+	};
+	// The bitmap and model handles are only set by fireball_load_data() so they can be cached with the rest
+	info.save = [](table_cache_writer& writer) {
+		writer.write((uint)sizeof(fireball_info));
+		writer.write(Num_fireball_types);
+		writer.write_bytes(Fireball_info, sizeof(fireball_info) * Num_fireball_types);
+	};
+	info.load = [](table_cache_reader& reader) {
+		uint size = 0;
+		int num = 0;
+		if (!reader.read(size) || (size != sizeof(fireball_info)) || !reader.read(num) || (num < 0) || (num > MAX_FIREBALL_TYPES))
+			return false;
+
+		if (!reader.read_bytes(Fireball_info, sizeof(fireball_info) * num))
+			return false;
+
+		Num_fireball_types = num;
+		return true;
+	};
+
+	info.finish = []() {
+		// fill in extra LOD filenames
+		for (int i = 0; i < Num_fireball_types; i++)
+		{
+			for (int j = 1; j < Fireball_info[i].lod_count; j++)
+				sprintf( Fireball_info[i].lod[j].filename, "%s_%d", Fireball_info[i].lod[0].filename, j);
+		}
+	};
 
-	// fill in extra LOD filenames
-	for (int i = 0; i < Num_fireball_types; i++)
-	{
-		for (int j = 1; j < Fireball_info[i].lod_count; j++)
-			sprintf( Fireball_info[i].lod[j].filename, "%s_%d", Fireball_info[i].lod[0].filename, j);
-	}
+	table_cache_parse(info);
 
 	fireballs_parsed = true;
 }
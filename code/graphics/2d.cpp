@@ -1959,7 +1959,8 @@ void poly_list::calculate_tangent()
 	}
 }
 
-static poly_list buffer_list_internal;
+// Scratch space of make_index_buffer(), the vertex data of several models may be generated in parallel
+static thread_local poly_list buffer_list_internal;
 
 void poly_list::make_index_buffer(SCP_vector<int> &vertex_list)
 {
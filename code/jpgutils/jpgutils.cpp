@@ -46,19 +46,21 @@ typedef struct {
 } cfile_source_mgr;
 
 typedef cfile_source_mgr *cfile_src_ptr;
-struct jpeg_decompress_struct jpeg_info;
-struct jpeg_error_mgr jpeg_err;
+
+// the decoder state is per thread since bitmaps may be decoded by worker threads during level page in
+static thread_local struct jpeg_decompress_struct jpeg_info;
+static thread_local struct jpeg_error_mgr jpeg_err;
 
 #define INPUT_BUF_SIZE  4096	// choose an efficiently read'able size
 
-static int jpeg_error_code;
+static thread_local int jpeg_error_code;
 
 // set current error
 #define Jpeg_Set_Error(x)	{ jpeg_error_code = x; }
 
 // error handler stuff, rather than the default, which will screw us
 //
-jmp_buf FSJpegError;
+static thread_local jmp_buf FSJpegError;
 
 // error (exit) handler
 void jpg_error_exit(j_common_ptr cinfo)
@@ -5851,6 +5851,9 @@ void post_process_mission()
 					nprintf(("Warning", "%s", error_msg.c_str()));
 					Warning(LOCATION, "%s", error_msg.c_str());
 				}
+			} else if (Cmdline_compile_sexps && !Fred_running) {
+				// resolve whatever doesn't have to be looked up every time the sexp is evaluated
+				sexp_compile(i);
 			}
 		}
 	}
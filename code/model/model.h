@@ -228,6 +228,9 @@ struct bsp_collision_node {
 	int front;
 
 	int leaf;
+
+	int tri_block_start;	// first block in bsp_collision_tree::tri_block_list with the triangles of the leaf polygons
+	int n_tri_blocks;
 };
 
 struct bsp_collision_leaf {
@@ -241,10 +244,28 @@ struct bsp_collision_leaf {
 	int next;
 };
 
+// The polygons of a leaf split into triangle fans and stored four triangles at a time so that model_collide can test a
+// ray against all of them at once. Every lane holds the plane of its polygon, the first vertex of the triangle and the
+// coefficients which map a point relative to that vertex to the barycentric coordinates used by fvi_point_face().
+// Unused lanes have a zero normal and a leaf index of -1.
+struct bsp_collision_tri_block {
+	float plane_pnt[3][4];
+	float plane_norm[3][4];
+
+	float origin[3][4];
+	float alpha[3][4];
+	float beta[3][4];
+
+	int leaf[4];		// index into bsp_collision_tree::leaf_list of the polygon the triangle belongs to
+};
+
 struct bsp_collision_tree {
 	bsp_collision_node *node_list;
 	int n_nodes;
 
+	bsp_collision_tri_block *tri_block_list;
+	int n_tri_blocks;
+
 	bsp_collision_leaf *leaf_list;
 	int n_leaves;
 
@@ -1321,6 +1342,8 @@ void model_draw_bay_paths(int model_num);
 void model_draw_bay_paths_htl(int model_num);
 
 bool model_interp_config_buffer(indexed_vertex_source *vert_src, vertex_buffer *vb, bool update_ibuffer_only);
+// Allocates the vertex and index lists of the source, model_interp_pack_buffer() does that on its own if necessary
+bool model_interp_allocate_buffers(indexed_vertex_source *vert_src);
 bool model_interp_pack_buffer(indexed_vertex_source *vert_src, vertex_buffer *vb);
 void model_interp_submit_buffers(indexed_vertex_source *vert_src, size_t vertex_stride);
 void model_allocate_interp_data(int n_verts = 0, int n_norms = 0);
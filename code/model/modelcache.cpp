@@ -0,0 +1,819 @@
+#define MODEL_LIB
+
+#include "model/modelcache.h"
+
+#include "cfile/cfile.h"
+#include "cmdline/cmdline.h"
+#include "debugconsole/console.h"
+#include "globalincs/systemvars.h"
+#include "globalincs/version.h"
+#include "model/model.h"
+#include "model/modelsinc.h"
+
+#include <md5.h>
+
+#include <algorithm>
+#include <memory>
+
+extern bool Cmdline_model_cache;
+
+void interp_generate_vertex_buffers(polymodel*, int);
+
+namespace {
+
+const char* const CACHE_PREFIX = "mdl_cache-";
+const char* const CACHE_EXT = "bin";
+
+const uint CACHE_MAGIC = 0x43444f4d; // "MODC"
+const uint CACHE_VERSION = 2;
+
+const uint32_t CACHE_LOCATION = CF_LOCATION_ROOT_USER | CF_LOCATION_ROOT_GAME | CF_LOCATION_TYPE_ROOT;
+
+// Older models get the center and radius of their polygons recomputed by model_octant_create() so the BSP data changes
+// while the octants are created
+const int MIN_CACHE_POF_VERSION = 2003;
+
+bool Model_cache_validate = false;
+
+int Model_cache_hits = 0;
+int Model_cache_misses = 0;
+int Model_cache_mismatches = 0;
+
+SCP_string cache_file_name(const SCP_string& key) { return CACHE_PREFIX + key + "." + CACHE_EXT; }
+
+// Hashes the POF file together with everything that changes the layout of the cached data
+bool compute_key(const polymodel* pm, SCP_string& key) {
+	auto cfp = cfopen(pm->filename, "rb", CFILE_NORMAL, CF_TYPE_MODELS);
+	if (cfp == nullptr) {
+		return false;
+	}
+
+	MD5 md5;
+
+	size_t length = 0;
+	auto view = cf_get_data_view(cfp, &length);
+	if (view != nullptr) {
+		md5.update(static_cast<const char*>(view), (MD5::size_type)length);
+	} else {
+		SCP_vector<char> buffer((size_t)cfilelength(cfp));
+		if (!buffer.empty() && cfread(buffer.data(), 1, (int)buffer.size(), cfp) != (int)buffer.size()) {
+			cfclose(cfp);
+			return false;
+		}
+		md5.update(buffer.data(), (MD5::size_type)buffer.size());
+	}
+
+	cfclose(cfp);
+
+	uint params[] = {CACHE_VERSION, (uint)sizeof(bsp_collision_node), (uint)sizeof(bsp_collision_leaf),
+	                 (uint)sizeof(bsp_collision_tri_block), (uint)sizeof(model_tmap_vert), (uint)sizeof(vec3d),
+	                 (uint)sizeof(vertex), (uint)sizeof(tsb_t)};
+	md5.update(reinterpret_cast<const char*>(params), (MD5::size_type)sizeof(params));
+
+	auto engine_version = gameversion::get_version_string();
+	md5.update(engine_version.c_str(), (MD5::size_type)engine_version.size());
+
+	md5.finalize();
+
+	key = md5.hexdigest();
+	return true;
+}
+
+bool cache_supported(const polymodel* pm) {
+	return (pm->version >= MIN_CACHE_POF_VERSION) && (pm->n_models > 0) && (pm->detail[0] >= 0) &&
+	       (pm->detail[0] < pm->n_models);
+}
+
+// The vertex list of a tree is not counted anywhere, the leaves reference ranges of it
+int tree_vert_list_size(const bsp_collision_tree* tree) {
+	int size = 0;
+
+	for (int i = 0; i < tree->n_leaves; ++i) {
+		size = std::max(size, tree->leaf_list[i].vert_start + (int)tree->leaf_list[i].num_verts);
+	}
+
+	return size;
+}
+
+void free_tree(bsp_collision_tree* tree) {
+	vm_free(tree->node_list);
+	vm_free(tree->leaf_list);
+	vm_free(tree->point_list);
+	vm_free(tree->vert_list);
+	vm_free(tree->tri_block_list);
+
+	tree->node_list = nullptr;
+	tree->leaf_list = nullptr;
+	tree->point_list = nullptr;
+	tree->vert_list = nullptr;
+	tree->tri_block_list = nullptr;
+}
+
+void free_octant(model_octant* oct) {
+	vm_free(oct->verts);
+	vm_free(oct->shield_tris);
+
+	oct->verts = nullptr;
+	oct->shield_tris = nullptr;
+}
+
+// The data interp_generate_vertex_buffers() creates for a submodel
+struct submodel_vertex_data {
+	poly_list* model_list = nullptr;
+	int flags = 0;
+	SCP_vector<buffer_data> tex_buf;
+	vertex* outline_buffer = nullptr;
+	uint n_verts_outline = 0;
+
+	submodel_vertex_data() = default;
+	submodel_vertex_data(const submodel_vertex_data&) = delete;
+	submodel_vertex_data& operator=(const submodel_vertex_data&) = delete;
+
+	~submodel_vertex_data() {
+		delete model_list;
+		vm_free(outline_buffer);
+	}
+
+	// Exchanges the data with the one of the submodel
+	void swap(bsp_info* sm) {
+		std::swap(model_list, sm->buffer.model_list);
+		std::swap(flags, sm->buffer.flags);
+		std::swap(tex_buf, sm->buffer.tex_buf);
+		std::swap(outline_buffer, sm->outline_buffer);
+		std::swap(n_verts_outline, sm->n_verts_outline);
+	}
+};
+
+// Vertex data is only generated for models which are rendered, the tangents only with -normal
+int vertex_data_flags() {
+	return (Is_standalone ? 0 : 1) | (Cmdline_normal ? 2 : 0);
+}
+
+class cache_writer {
+	SCP_vector<ubyte> _data;
+
+  public:
+	void write_bytes(const void* data, size_t size) {
+		if (size == 0) {
+			return;
+		}
+
+		auto pos = _data.size();
+		_data.resize(pos + size);
+		memcpy(&_data[pos], data, size);
+	}
+
+	template <typename T>
+	void write(const T& value) {
+		write_bytes(&value, sizeof(T));
+	}
+
+	const SCP_vector<ubyte>& data() const { return _data; }
+};
+
+class cache_reader {
+	const ubyte* _data;
+	size_t _size;
+	size_t _pos = 0;
+
+  public:
+	cache_reader(const ubyte* data, size_t size) : _data(data), _size(size) {}
+
+	bool read_bytes(void* data, size_t size) {
+		if (_size - _pos < size) {
+			return false;
+		}
+
+		if (size > 0) {
+			memcpy(data, _data + _pos, size);
+		}
+		_pos += size;
+		return true;
+	}
+
+	template <typename T>
+	bool read(T& value) {
+		return read_bytes(&value, sizeof(T));
+	}
+
+	// Allocates an array of count elements with vm_malloc and reads it
+	template <typename T>
+	bool read_array(T*& array, int count) {
+		array = nullptr;
+
+		if (count < 0 || (_size - _pos) / sizeof(T) < (size_t)count) {
+			return false;
+		}
+
+		if (count == 0) {
+			return true;
+		}
+
+		array = (T*)vm_malloc(sizeof(T) * count);
+		return read_bytes(array, sizeof(T) * count);
+	}
+
+	bool at_end() const { return _pos == _size; }
+};
+
+// The cached data of a model before it is moved into the model
+struct cache_data {
+	model_octant octants[8];
+	SCP_vector<bsp_collision_tree> trees;
+	std::unique_ptr<submodel_vertex_data[]> vertex_data;
+
+	cache_data() { memset(octants, 0, sizeof(octants)); }
+
+	~cache_data() {
+		for (auto& oct : octants) {
+			free_octant(&oct);
+		}
+
+		for (auto& tree : trees) {
+			free_tree(&tree);
+		}
+	}
+};
+
+bool write_model(const polymodel* pm, cache_writer& writer) {
+	auto detail0 = &pm->submodel[pm->detail[0]];
+
+	writer.write(CACHE_MAGIC);
+	writer.write(CACHE_VERSION);
+	writer.write(pm->n_models);
+	writer.write(pm->shield.ntris);
+	writer.write(detail0->bsp_data_size);
+	writer.write(vertex_data_flags());
+
+	for (auto& oct : pm->octants) {
+		writer.write(oct.min);
+		writer.write(oct.max);
+		writer.write(oct.nverts);
+		writer.write(oct.nshield_tris);
+
+		for (int i = 0; i < oct.nverts; ++i) {
+			auto offset = reinterpret_cast<const ubyte*>(oct.verts[i]) - detail0->bsp_data;
+
+			if (offset < 0 || offset + (ptrdiff_t)sizeof(vec3d) > detail0->bsp_data_size) {
+				return false;
+			}
+
+			writer.write((int)offset);
+		}
+
+		for (int i = 0; i < oct.nshield_tris; ++i) {
+			writer.write((int)(oct.shield_tris[i] - pm->shield.tris));
+		}
+	}
+
+	for (int i = 0; i < pm->n_models; ++i) {
+		auto tree_index = pm->submodel[i].collision_tree_index;
+		writer.write((int)(tree_index >= 0));
+
+		if (tree_index < 0) {
+			continue;
+		}
+
+		auto tree = model_get_bsp_collision_tree(tree_index);
+		auto vert_list_size = tree_vert_list_size(tree);
+
+		writer.write(tree->n_nodes);
+		writer.write(tree->n_tri_blocks);
+		writer.write(tree->n_leaves);
+		writer.write(tree->n_verts);
+		writer.write(vert_list_size);
+
+		writer.write_bytes(tree->node_list, sizeof(bsp_collision_node) * tree->n_nodes);
+		writer.write_bytes(tree->tri_block_list, sizeof(bsp_collision_tri_block) * tree->n_tri_blocks);
+		writer.write_bytes(tree->leaf_list, sizeof(bsp_collision_leaf) * tree->n_leaves);
+		writer.write_bytes(tree->point_list, sizeof(vec3d) * tree->n_verts);
+		writer.write_bytes(tree->vert_list, sizeof(model_tmap_vert) * vert_list_size);
+	}
+
+	if (Is_standalone) {
+		return true;
+	}
+
+	for (int i = 0; i < pm->n_models; ++i) {
+		auto sm = &pm->submodel[i];
+
+		writer.write(sm->n_verts_outline);
+		writer.write_bytes(sm->outline_buffer, sizeof(vertex) * sm->n_verts_outline);
+
+		auto model_list = sm->buffer.model_list;
+		writer.write((int)(model_list != nullptr));
+
+		if (model_list == nullptr) {
+			continue;
+		}
+
+		writer.write(model_list->n_verts);
+		writer.write_bytes(model_list->vert, sizeof(vertex) * model_list->n_verts);
+		writer.write_bytes(model_list->norm, sizeof(vec3d) * model_list->n_verts);
+		if (Cmdline_normal) {
+			writer.write_bytes(model_list->tsb, sizeof(tsb_t) * model_list->n_verts);
+		}
+		writer.write_bytes(model_list->submodels, sizeof(int) * model_list->n_verts);
+
+		writer.write(sm->buffer.flags);
+		writer.write((int)sm->buffer.tex_buf.size());
+
+		for (auto& bd : sm->buffer.tex_buf) {
+			writer.write(bd.texture);
+			writer.write(bd.flags);
+			writer.write((int)bd.n_verts);
+			writer.write_bytes(bd.get_index(), sizeof(uint) * bd.n_verts);
+		}
+	}
+
+	return true;
+}
+
+bool read_vertex_data(cache_reader& reader, submodel_vertex_data& data) {
+	if (!reader.read(data.n_verts_outline) || (int)data.n_verts_outline < 0 ||
+	    !reader.read_array(data.outline_buffer, (int)data.n_verts_outline)) {
+		return false;
+	}
+
+	int has_model_list = 0;
+	if (!reader.read(has_model_list)) {
+		return false;
+	}
+
+	if (!has_model_list) {
+		return true;
+	}
+
+	int n_verts = 0;
+	if (!reader.read(n_verts) || n_verts <= 0) {
+		return false;
+	}
+
+	data.model_list = new poly_list;
+	data.model_list->allocate(n_verts);
+
+	if (!reader.read_bytes(data.model_list->vert, sizeof(vertex) * n_verts) ||
+	    !reader.read_bytes(data.model_list->norm, sizeof(vec3d) * n_verts) ||
+	    (Cmdline_normal && !reader.read_bytes(data.model_list->tsb, sizeof(tsb_t) * n_verts)) ||
+	    !reader.read_bytes(data.model_list->submodels, sizeof(int) * n_verts)) {
+		return false;
+	}
+	data.model_list->n_verts = n_verts;
+
+	int num_tex_buf = 0;
+	if (!reader.read(data.flags) || !reader.read(num_tex_buf) || num_tex_buf < 0 || num_tex_buf > MAX_MODEL_TEXTURES) {
+		return false;
+	}
+
+	for (int i = 0; i < num_tex_buf; ++i) {
+		int texture = 0, flags = 0, n_indices = 0;
+		if (!reader.read(texture) || !reader.read(flags) || !reader.read(n_indices) || n_indices <= 0) {
+			return false;
+		}
+
+		uint* indices = nullptr;
+		if (!reader.read_array(indices, n_indices)) {
+			return false;
+		}
+
+		// assign() also restores the index range of the buffer
+		buffer_data bd((size_t)n_indices);
+		for (int j = 0; j < n_indices; ++j) {
+			bd.assign((size_t)j, indices[j]);
+		}
+		vm_free(indices);
+
+		bd.texture = texture;
+		bd.flags = flags;
+
+		data.tex_buf.push_back(bd);
+	}
+
+	return true;
+}
+
+bool read_model(const polymodel* pm, cache_reader& reader, cache_data& data) {
+	auto detail0 = &pm->submodel[pm->detail[0]];
+
+	uint magic = 0, version = 0;
+	int n_models = 0, shield_ntris = 0, bsp_data_size = 0, vertex_flags = 0;
+
+	if (!reader.read(magic) || !reader.read(version) || !reader.read(n_models) || !reader.read(shield_ntris) ||
+	    !reader.read(bsp_data_size) || !reader.read(vertex_flags)) {
+		return false;
+	}
+
+	// An entry written by a standalone server or without -normal lacks parts of the vertex data
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION || n_models != pm->n_models ||
+	    shield_ntris != pm->shield.ntris || bsp_data_size != detail0->bsp_data_size ||
+	    vertex_flags != vertex_data_flags()) {
+		return false;
+	}
+
+	for (auto& oct : data.octants) {
+		if (!reader.read(oct.min) || !reader.read(oct.max) || !reader.read(oct.nverts) ||
+		    !reader.read(oct.nshield_tris)) {
+			return false;
+		}
+
+		int* offsets = nullptr;
+		int* indices = nullptr;
+		bool valid = reader.read_array(offsets, oct.nverts) && reader.read_array(indices, oct.nshield_tris);
+
+		if (valid && oct.nverts > 0) {
+			oct.verts = (vec3d**)vm_malloc(sizeof(vec3d*) * oct.nverts);
+
+			for (int i = 0; i < oct.nverts && valid; ++i) {
+				valid = offsets[i] >= 0 && offsets[i] + (int)sizeof(vec3d) <= bsp_data_size;
+				oct.verts[i] = valid ? reinterpret_cast<vec3d*>(detail0->bsp_data + offsets[i]) : nullptr;
+			}
+		}
+
+		if (valid && oct.nshield_tris > 0) {
+			oct.shield_tris = (shield_tri**)vm_malloc(sizeof(shield_tri*) * oct.nshield_tris);
+
+			for (int i = 0; i < oct.nshield_tris && valid; ++i) {
+				valid = indices[i] >= 0 && indices[i] < shield_ntris;
+				oct.shield_tris[i] = valid ? &pm->shield.tris[indices[i]] : nullptr;
+			}
+		}
+
+		vm_free(offsets);
+		vm_free(indices);
+
+		if (!valid) {
+			return false;
+		}
+	}
+
+	data.trees.resize(pm->n_models);
+	memset(data.trees.data(), 0, sizeof(bsp_collision_tree) * data.trees.size());
+
+	for (int i = 0; i < pm->n_models; ++i) {
+		int has_tree = 0;
+		if (!reader.read(has_tree) || has_tree != (int)(pm->submodel[i].collision_tree_index >= 0)) {
+			return false;
+		}
+
+		if (!has_tree) {
+			continue;
+		}
+
+		auto& tree = data.trees[i];
+		int vert_list_size = 0;
+
+		if (!reader.read(tree.n_nodes) || !reader.read(tree.n_tri_blocks) || !reader.read(tree.n_leaves) ||
+		    !reader.read(tree.n_verts) || !reader.read(vert_list_size)) {
+			return false;
+		}
+
+		if (!reader.read_array(tree.node_list, tree.n_nodes) ||
+		    !reader.read_array(tree.tri_block_list, tree.n_tri_blocks) ||
+		    !reader.read_array(tree.leaf_list, tree.n_leaves) || !reader.read_array(tree.point_list, tree.n_verts) ||
+		    !reader.read_array(tree.vert_list, vert_list_size)) {
+			return false;
+		}
+
+		tree.used = true;
+	}
+
+	if (!Is_standalone) {
+		data.vertex_data.reset(new submodel_vertex_data[pm->n_models]);
+
+		for (int i = 0; i < pm->n_models; ++i) {
+			if (!read_vertex_data(reader, data.vertex_data[i])) {
+				return false;
+			}
+		}
+	}
+
+	return reader.at_end();
+}
+
+bool read_entry(const SCP_string& key, const polymodel* pm, cache_data& data) {
+	auto cfp = cfopen(cache_file_name(key).c_str(), "rb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		return false;
+	}
+
+	// Use the data in place if cfile already has it in memory, otherwise the file is read with a single call
+	size_t length = 0;
+	auto view = static_cast<const ubyte*>(cf_get_data_view(cfp, &length));
+
+	SCP_vector<ubyte> buffer;
+	if (view == nullptr) {
+		buffer.resize((size_t)cfilelength(cfp));
+		if (!buffer.empty() && cfread(buffer.data(), 1, (int)buffer.size(), cfp) != (int)buffer.size()) {
+			cfclose(cfp);
+			return false;
+		}
+
+		view = buffer.data();
+		length = buffer.size();
+	}
+
+	cache_reader reader(view, length);
+	auto valid = read_model(pm, reader, data);
+
+	cfclose(cfp);
+
+	return valid;
+}
+
+bool octants_equal(const model_octant& left, const model_octant& right) {
+	if (memcmp(&left.min, &right.min, sizeof(vec3d)) != 0 || memcmp(&left.max, &right.max, sizeof(vec3d)) != 0) {
+		return false;
+	}
+
+	if (left.nverts != right.nverts || left.nshield_tris != right.nshield_tris) {
+		return false;
+	}
+
+	return std::equal(left.verts, left.verts + left.nverts, right.verts) &&
+	       std::equal(left.shield_tris, left.shield_tris + left.nshield_tris, right.shield_tris);
+}
+
+bool trees_equal(const bsp_collision_tree* left, const bsp_collision_tree* right) {
+	if (left->n_nodes != right->n_nodes || left->n_tri_blocks != right->n_tri_blocks ||
+	    left->n_leaves != right->n_leaves || left->n_verts != right->n_verts) {
+		return false;
+	}
+
+	auto vert_list_size = tree_vert_list_size(left);
+	if (vert_list_size != tree_vert_list_size(right)) {
+		return false;
+	}
+
+	// The leaves contain padding so they are compared field by field
+	for (int i = 0; i < left->n_leaves; ++i) {
+		auto& l = left->leaf_list[i];
+		auto& r = right->leaf_list[i];
+
+		if (memcmp(&l.plane_pnt, &r.plane_pnt, sizeof(vec3d)) != 0 ||
+		    memcmp(&l.plane_norm, &r.plane_norm, sizeof(vec3d)) != 0 ||
+		    memcmp(&l.face_rad, &r.face_rad, sizeof(float)) != 0 || l.vert_start != r.vert_start ||
+		    l.num_verts != r.num_verts || l.tmap_num != r.tmap_num || l.next != r.next) {
+			return false;
+		}
+	}
+
+	auto array_equal = [](const void* l, const void* r, size_t size) { return size == 0 || memcmp(l, r, size) == 0; };
+
+	return array_equal(left->node_list, right->node_list, sizeof(bsp_collision_node) * left->n_nodes) &&
+	       array_equal(left->tri_block_list, right->tri_block_list,
+	                   sizeof(bsp_collision_tri_block) * left->n_tri_blocks) &&
+	       array_equal(left->point_list, right->point_list, sizeof(vec3d) * left->n_verts) &&
+	       array_equal(left->vert_list, right->vert_list, sizeof(model_tmap_vert) * vert_list_size);
+}
+
+bool vertex_data_equal(const submodel_vertex_data& left, const bsp_info* right) {
+	// Only the fields the vertex data generation sets are compared, the rest of the vertices is not initialized
+	auto vertex_equal = [](const vertex& l, const vertex& r) {
+		return memcmp(&l.world, &r.world, sizeof(vec3d)) == 0 &&
+		       memcmp(&l.texture_position, &r.texture_position, sizeof(uv_pair)) == 0;
+	};
+
+	if (left.n_verts_outline != right->n_verts_outline ||
+	    !std::equal(left.outline_buffer, left.outline_buffer + left.n_verts_outline, right->outline_buffer,
+	                [](const vertex& l, const vertex& r) { return memcmp(&l.world, &r.world, sizeof(vec3d)) == 0; })) {
+		return false;
+	}
+
+	auto l_list = left.model_list;
+	auto r_list = right->buffer.model_list;
+
+	if ((l_list == nullptr) || (r_list == nullptr)) {
+		return l_list == r_list;
+	}
+
+	auto n = l_list->n_verts;
+	if (n != r_list->n_verts || !std::equal(l_list->vert, l_list->vert + n, r_list->vert, vertex_equal) ||
+	    memcmp(l_list->norm, r_list->norm, sizeof(vec3d) * n) != 0 ||
+	    (Cmdline_normal && memcmp(l_list->tsb, r_list->tsb, sizeof(tsb_t) * n) != 0) ||
+	    memcmp(l_list->submodels, r_list->submodels, sizeof(int) * n) != 0) {
+		return false;
+	}
+
+	if (left.flags != right->buffer.flags || left.tex_buf.size() != right->buffer.tex_buf.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < left.tex_buf.size(); ++i) {
+		auto& l = left.tex_buf[i];
+		auto& r = right->buffer.tex_buf[i];
+
+		if (l.texture != r.texture || l.flags != r.flags || l.n_verts != r.n_verts ||
+		    memcmp(l.get_index(), r.get_index(), sizeof(uint) * l.n_verts) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+SCP_vector<SCP_string> get_cache_files() {
+	SCP_string filter = SCP_string("*.") + CACHE_EXT;
+	const SCP_string prefix(CACHE_PREFIX);
+
+	SCP_vector<SCP_string> names;
+	cf_get_file_list(names, CF_TYPE_CACHE, filter.c_str(), CF_SORT_NONE, nullptr, CACHE_LOCATION);
+
+	SCP_vector<SCP_string> files;
+	for (auto& name : names) {
+		if (name.compare(0, prefix.size(), prefix) == 0) {
+			files.push_back(name + "." + CACHE_EXT);
+		}
+	}
+
+	return files;
+}
+
+} // namespace
+
+bool model_cache_enabled() { return Cmdline_model_cache; }
+
+bool model_cache_validating() { return Model_cache_validate; }
+
+void model_cache_set_validating(bool validate) { Model_cache_validate = validate; }
+
+model_cache_stats model_cache_get_stats() {
+	model_cache_stats stats;
+	stats.hits = Model_cache_hits;
+	stats.misses = Model_cache_misses;
+	stats.mismatches = Model_cache_mismatches;
+	return stats;
+}
+
+bool model_cache_load(polymodel* pm, SCP_string& key) {
+	key.clear();
+
+	if (!model_cache_enabled() || !cache_supported(pm) || !compute_key(pm, key)) {
+		key.clear();
+		return false;
+	}
+
+	cache_data data;
+	if (!read_entry(key, pm, data)) {
+		++Model_cache_misses;
+		return false;
+	}
+
+	++Model_cache_hits;
+
+	// The model owns the arrays from now on
+	memcpy(pm->octants, data.octants, sizeof(data.octants));
+	memset(data.octants, 0, sizeof(data.octants));
+
+	for (int i = 0; i < pm->n_models; ++i) {
+		if (pm->submodel[i].collision_tree_index >= 0) {
+			*model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index) = data.trees[i];
+			memset(&data.trees[i], 0, sizeof(bsp_collision_tree));
+		}
+
+		if (data.vertex_data) {
+			data.vertex_data[i].swap(&pm->submodel[i]);
+		}
+	}
+
+	return true;
+}
+
+void model_cache_save(polymodel* pm, const SCP_string& key) {
+	if (key.empty()) {
+		return;
+	}
+
+	cache_writer writer;
+	if (!write_model(pm, writer)) {
+		mprintf(("Model cache: Could not store the data of %s.\n", pm->filename));
+		return;
+	}
+
+	auto name = cache_file_name(key);
+	auto& blob = writer.data();
+
+	auto cfp = cfopen(name.c_str(), "wb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		mprintf(("Could not open model cache file %s!\n", name.c_str()));
+		return;
+	}
+
+	auto written = cfwrite(blob.data(), 1, (int)blob.size(), cfp);
+
+	cfclose(cfp);
+
+	if (written != (int)blob.size()) {
+		mprintf(("Failed to write model cache file %s!\n", name.c_str()));
+		cf_delete(name.c_str(), CF_TYPE_CACHE, CACHE_LOCATION);
+	}
+}
+
+bool model_cache_validate(polymodel* pm, const SCP_string& key) {
+	bool match = true;
+
+	// Recompute the octants, the cached ones are freed afterwards
+	model_octant cached_octants[8];
+	memcpy(cached_octants, pm->octants, sizeof(cached_octants));
+	memset(pm->octants, 0, sizeof(pm->octants));
+
+	model_octant_create(pm);
+
+	for (int i = 0; i < 8; ++i) {
+		if (!octants_equal(cached_octants[i], pm->octants[i])) {
+			mprintf(("Model cache: Octant %d of %s does not match.\n", i, pm->filename));
+			match = false;
+		}
+
+		free_octant(&cached_octants[i]);
+	}
+
+	for (int i = 0; i < pm->n_models; ++i) {
+		auto tree_index = pm->submodel[i].collision_tree_index;
+		if (tree_index < 0) {
+			continue;
+		}
+
+		bsp_collision_tree fresh;
+		memset(&fresh, 0, sizeof(fresh));
+		model_collide_parse_bsp(&fresh, pm->submodel[i].bsp_data, pm->version);
+		fresh.used = true;
+
+		auto tree = model_get_bsp_collision_tree(tree_index);
+		if (!trees_equal(tree, &fresh)) {
+			mprintf(("Model cache: Collision tree of submodel %s of %s does not match.\n", pm->submodel[i].name,
+			         pm->filename));
+			match = false;
+		}
+
+		free_tree(tree);
+		*tree = fresh;
+	}
+
+	if (!Is_standalone) {
+		for (int i = 0; i < pm->n_models; ++i) {
+			// The cached data is moved out of the submodel and freed with it
+			submodel_vertex_data cached;
+			cached.swap(&pm->submodel[i]);
+
+			interp_generate_vertex_buffers(pm, i);
+
+			if (!vertex_data_equal(cached, &pm->submodel[i])) {
+				mprintf(("Model cache: Vertex data of submodel %s of %s does not match.\n", pm->submodel[i].name,
+				         pm->filename));
+				match = false;
+			}
+		}
+	}
+
+	if (!match) {
+		++Model_cache_mismatches;
+
+		if (!key.empty()) {
+			cf_delete(cache_file_name(key).c_str(), CF_TYPE_CACHE, CACHE_LOCATION);
+		}
+
+		Warning(LOCATION, "The cached data of model %s does not match the data computed from the model file. See the log for details.", pm->filename);
+	}
+
+	return match;
+}
+
+int model_cache_purge() {
+	int removed = 0;
+	for (auto& file : get_cache_files()) {
+		if (cf_delete(file.c_str(), CF_TYPE_CACHE, CACHE_LOCATION)) {
+			++removed;
+		}
+	}
+
+	return removed;
+}
+
+DCF(model_cache, "Shows or changes the on-disk model cache (-model_cache)") {
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: model_cache [purge | validate]\n");
+		dc_printf("Without arguments the cache statistics of this session are shown.\n");
+		dc_printf("\tpurge: Deletes all cache files\n");
+		dc_printf("\tvalidate: Toggles comparing every cache hit with freshly computed data\n");
+		return;
+	}
+
+	if (dc_optional_string("purge")) {
+		dc_printf("Deleted %d model cache files.\n", model_cache_purge());
+		return;
+	}
+
+	if (!model_cache_enabled()) {
+		dc_printf("Only available with -model_cache.\n");
+		return;
+	}
+
+	if (dc_optional_string("validate")) {
+		model_cache_set_validating(!model_cache_validating());
+		dc_printf("Model cache validation is %s.\n", Model_cache_validate ? "on" : "off");
+		return;
+	}
+
+	dc_printf("Model cache: %d hits, %d misses, %d mismatches, validation %s\n", Model_cache_hits, Model_cache_misses,
+	          Model_cache_mismatches, Model_cache_validate ? "on" : "off");
+}
@@ -0,0 +1,93 @@
+#ifndef _MODELCACHE_H
+#define _MODELCACHE_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+class polymodel;
+
+/** @file
+ *  On-disk cache for the data model_load() derives from the BSP data of a POF file (enabled with -model_cache)
+ *
+ *  The cache stores the collision trees and the vertex and index data of the submodels and the octants of the model.
+ *  Each entry is named after the MD5 hash of the POF file. It uses a flat layout which only contains counts, offsets
+ *  and indices, no pointers, so the arrays can be copied straight out of the file. The octant vertices are stored as
+ *  offsets into the BSP data of the detail 0 submodel and the shield triangles as indices into the shield mesh.
+ *
+ *  The shield mesh and the bounding boxes are read straight from the POF file. Only the GPU buffer of the shield and
+ *  the eight box corners are derived from them so there is nothing worth caching. Packing the vertex data into the
+ *  model buffers is left to create_vertex_buffer() since it needs the graphics API.
+ *
+ *  In validation mode every cache hit is compared with freshly computed data. Mismatches are reported and the fresh
+ *  data is used.
+ */
+
+/**
+ * @brief Checks if the model cache is enabled
+ */
+bool model_cache_enabled();
+
+/**
+ * @brief Checks if cache hits are compared with freshly computed data
+ */
+bool model_cache_validating();
+
+/**
+ * @brief Turns comparing cache hits with freshly computed data on or off
+ */
+void model_cache_set_validating(bool validate);
+
+/**
+ * @brief Counts of the cache lookups of this session
+ */
+struct model_cache_stats {
+	int hits = 0;       //!< Models whose data came from the cache
+	int misses = 0;     //!< Models which could be cached but had no entry
+	int mismatches = 0; //!< Validated cache hits which did not match the fresh data
+};
+
+/**
+ * @brief Gets the counts of the cache lookups of this session
+ */
+model_cache_stats model_cache_get_stats();
+
+/**
+ * @brief Loads the octants, collision trees and vertex data of a model from the cache
+ *
+ * The collision tree slots of the collidable submodels have to exist already.
+ *
+ * @param pm The model
+ * @param key Set to the key of the cache entry of the model, empty if the model can not be cached
+ *
+ * @return @c true if the data was loaded, @c false if it has to be computed
+ */
+bool model_cache_load(polymodel* pm, SCP_string& key);
+
+/**
+ * @brief Writes the octants, collision trees and vertex data of a model to the cache
+ *
+ * @param pm The model
+ * @param key The key model_cache_load() returned for the model
+ */
+void model_cache_save(polymodel* pm, const SCP_string& key);
+
+/**
+ * @brief Compares the cached data of a model with freshly computed data
+ *
+ * Replaces the cached data with the fresh data and removes the cache entry if they differ.
+ *
+ * @param pm The model
+ * @param key The key model_cache_load() returned for the model
+ *
+ * @return @c true if the data matched
+ */
+bool model_cache_validate(polymodel* pm, const SCP_string& key);
+
+/**
+ * @brief Removes all entries from the cache
+ *
+ * @return The number of files which were deleted
+ */
+int model_cache_purge();
+
+#endif // _MODELCACHE_H
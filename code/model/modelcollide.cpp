@@ -12,52 +12,62 @@
 
 #define MODEL_LIB
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MC_TRI_BLOCK_SSE
+	#include <emmintrin.h>
+#endif
+
 #include "cmdline/cmdline.h"
+#include "debugconsole/console.h"
 #include "graphics/tmapper.h"
+#include "io/timer.h"
 #include "math/fvi.h"
+#include "math/staticrand.h"
 #include "math/vecmat.h"
 #include "model/model.h"
 #include "model/modelsinc.h"
 #include "tracing/tracing.h"
 #include "tracing/Monitor.h"
+#include "utils/WorkerPool.h"
 
 
 
 #define TOL		1E-4
 #define DIST_TOL	1.0
 
+// Tolerance of the triangle block check. It only decides which polygons get the exact check so it may be generous.
+#define TRI_BLOCK_TOL	1E-3f
+
+extern polymodel *Polygon_models[MAX_POLYGON_MODELS];
+
 // Some global variables that get set by model_collide and are used internally for
 // checking a collision rather than passing a bunch of parameters around. These are
-// not persistant between calls to model_collide
+// not persistant between calls to model_collide. They are thread local so that
+// model_collide can be used by multiple threads at once (see -mt_collisions).
 
-static mc_info		*Mc;				// The mc_info passed into model_collide
+static thread_local mc_info		*Mc;				// The mc_info passed into model_collide
 	
-static polymodel	*Mc_pm;			// The polygon model we're checking
-static int			Mc_submodel;	// The current submodel we're checking
+static thread_local polymodel	*Mc_pm;			// The polygon model we're checking
+static thread_local int			Mc_submodel;	// The current submodel we're checking
 
-static polymodel_instance *Mc_pmi;
+static thread_local polymodel_instance *Mc_pmi;
 
-static matrix		Mc_orient;		// A matrix to rotate a world point into the current
+static thread_local matrix		Mc_orient;		// A matrix to rotate a world point into the current
 											// submodel's frame of reference.
-static vec3d		Mc_base;			// A point used along with Mc_orient.
+static thread_local vec3d		Mc_base;			// A point used along with Mc_orient.
 
-static vec3d		Mc_p0;			// The ray origin rotated into the current submodel's frame of reference
-static vec3d		Mc_p1;			// The ray end rotated into the current submodel's frame of reference
-static float		Mc_mag;			// The length of the ray
-static vec3d		Mc_direction;	// A vector from the ray's origin to its end, in the current submodel's frame of reference
+static thread_local vec3d		Mc_p0;			// The ray origin rotated into the current submodel's frame of reference
+static thread_local vec3d		Mc_p1;			// The ray end rotated into the current submodel's frame of reference
+static thread_local float		Mc_mag;			// The length of the ray
+static thread_local vec3d		Mc_direction;	// A vector from the ray's origin to its end, in the current submodel's frame of reference
 
-static vec3d 		**Mc_point_list = NULL;		// A pointer to the current submodel's vertex list
+// The current submodel's vertex list (only used while loading), released by the thread_local destructor
+static thread_local SCP_vector<vec3d*> Mc_point_list;
 
-static float		Mc_edge_time;
+static thread_local float		Mc_edge_time;
 
+static bool Mc_use_tri_blocks = true;		// Use the triangle blocks for ray checks (only changed by model_collide_bench)
 
-void model_collide_free_point_list()
-{
-	if (Mc_point_list != NULL) {
-		vm_free(Mc_point_list);
-		Mc_point_list = NULL;
-	}
-}
 
 // allocate the point list
 // NOTE: SHOULD ONLY EVER BE CALLED FROM model_allocate_interp_data()!!!
@@ -65,14 +75,8 @@ void model_collide_allocate_point_list(int n_points)
 {
 	Assert( n_points > 0 );
 
-	if (Mc_point_list != NULL) {
-		vm_free(Mc_point_list);
-		Mc_point_list = NULL;
-	}
-
-	Mc_point_list = (vec3d**) vm_malloc( sizeof(vec3d *) * n_points );
-
-	Verify( Mc_point_list != NULL );
+	// the list is per thread since the collision trees of a model are built on the worker threads
+	Mc_point_list.resize(n_points);
 }
 
 // Returns non-zero if vector from p0 to pdir 
@@ -361,7 +365,9 @@ void model_collide_defpoints(ubyte * p)
 	ubyte * normcount = p+20;
 	vec3d *src = vp(p+offset);
 	
-	Assert( Mc_point_list != NULL );
+	if ( Mc_point_list.size() < (size_t)nverts ) {
+		Mc_point_list.resize(nverts);
+	}
 
 	for (n=0; n<nverts; n++ ) {
 		Mc_point_list[n] = src;
@@ -381,7 +387,7 @@ int model_collide_parse_bsp_defpoints(ubyte * p)
 
 	model_collide_allocate_point_list(nverts);
 
-	Assert( Mc_point_list != NULL );
+	Assert( Mc_point_list.size() >= (size_t)nverts );
 
 	for (n=0; n<nverts; n++ ) {
 		Mc_point_list[n] = src;
@@ -570,55 +576,211 @@ int model_collide_sub(void *model_ptr )
 	return 1;
 }
 
-void model_collide_bsp_poly(bsp_collision_tree *tree, int leaf_index)
+// Don't check invisible polygons unless MC_CHECK_INVISIBLE_FACES or $collide_invisible is set
+static bool mc_leaf_is_invisible(const bsp_collision_leaf *leaf)
+{
+	if ( leaf->tmap_num >= MAX_MODEL_TEXTURES ) {
+		return false;
+	}
+
+	if ( (Mc->flags & MC_CHECK_INVISIBLE_FACES) || (Mc_pm->maps[leaf->tmap_num].textures[TM_BASE_TYPE].GetTexture() >= 0) ) {
+		return false;
+	}
+
+	//SUSHI: Unless $collide_invisible is set.
+	return !Mc_pm->submodel[Mc_submodel].collide_invisible;
+}
+
+// Checks a single polygon of a collision tree
+static void model_collide_bsp_leaf(bsp_collision_tree *tree, int leaf_index)
 {
 	int i;
-	int tested_leaf = leaf_index;
 	uv_pair uvlist[TMAP_MAX_VERTS];
 	vec3d *points[TMAP_MAX_VERTS];
 
+	bsp_collision_leaf *leaf = &tree->leaf_list[leaf_index];
+
+	bool flat_poly = leaf->tmap_num >= MAX_MODEL_TEXTURES;
+	int vert_start = leaf->vert_start;
+	int nv = leaf->num_verts;
+
+	int vert_num;
+	for ( i = 0; i < nv; ++i ) {
+		vert_num = tree->vert_list[vert_start+i].vertnum;
+		points[i] = &tree->point_list[vert_num];
+
+		uvlist[i].u = tree->vert_list[vert_start+i].u;
+		uvlist[i].v = tree->vert_list[vert_start+i].v;
+	}
+
+	if ( flat_poly ) {
+		if ( Mc->flags & MC_CHECK_SPHERELINE ) {
+			mc_check_sphereline_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1, NULL, leaf);
+		} else {
+			mc_check_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1, NULL, leaf);
+		}
+	} else {
+		if ( Mc->flags & MC_CHECK_SPHERELINE ) {
+			mc_check_sphereline_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist, leaf->tmap_num, NULL, leaf);
+		} else {
+			mc_check_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist, leaf->tmap_num, NULL, leaf);
+		}
+	}
+}
+
+void model_collide_bsp_poly(bsp_collision_tree *tree, int leaf_index)
+{
+	int tested_leaf = leaf_index;
+
 	while ( tested_leaf >= 0 ) {
 		bsp_collision_leaf *leaf = &tree->leaf_list[tested_leaf];
 
-		bool flat_poly = false;
-		int vert_start = leaf->vert_start;
-		int nv = leaf->num_verts;
+		if ( mc_leaf_is_invisible(leaf) ) {
+			return;
+		}
 
-		if ( leaf->tmap_num < MAX_MODEL_TEXTURES ) {
-			if ( (!(Mc->flags & MC_CHECK_INVISIBLE_FACES)) && (Mc_pm->maps[leaf->tmap_num].textures[TM_BASE_TYPE].GetTexture() < 0) )	{
-				// Don't check invisible polygons.
-				//SUSHI: Unless $collide_invisible is set.
-				if (!(Mc_pm->submodel[Mc_submodel].collide_invisible))
-					return;
-			}
-		} else {
-			flat_poly = true;
+		model_collide_bsp_leaf(tree, tested_leaf);
+
+		tested_leaf = leaf->next;
+	}
+}
+
+// Tests the current ray against the four triangles of a block. This is a conservative version of the checks done by
+// mc_check_face() so every triangle it rejects would have been rejected by mc_check_face() too. Returns a bit mask of
+// the lanes that may be hit.
+static int mc_ray_tri_block(const bsp_collision_tri_block *block)
+{
+	float max_dist = FLT_MAX;
+
+	if ( !(Mc->flags & MC_CHECK_RAY) ) {
+		max_dist = 1.0f;
+	}
+
+	if ( Mc->num_hits && (Mc->hit_dist < max_dist) ) {
+		max_dist = Mc->hit_dist;
+	}
+
+	max_dist += fl_abs(max_dist) * TRI_BLOCK_TOL + TRI_BLOCK_TOL;
+
+#ifdef MC_TRI_BLOCK_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 min_value = _mm_set1_ps(-TRI_BLOCK_TOL);
+	const __m128 max_bary = _mm_set1_ps(1.0f + TRI_BLOCK_TOL);
+
+	__m128 nx = _mm_loadu_ps(block->plane_norm[0]);
+	__m128 ny = _mm_loadu_ps(block->plane_norm[1]);
+	__m128 nz = _mm_loadu_ps(block->plane_norm[2]);
+
+	__m128 px = _mm_set1_ps(Mc_p0.xyz.x);
+	__m128 py = _mm_set1_ps(Mc_p0.xyz.y);
+	__m128 pz = _mm_set1_ps(Mc_p0.xyz.z);
+
+	__m128 dx = _mm_set1_ps(Mc_direction.xyz.x);
+	__m128 dy = _mm_set1_ps(Mc_direction.xyz.y);
+	__m128 dz = _mm_set1_ps(Mc_direction.xyz.z);
+
+	// Same as mc_check_face() and fvi_ray_plane(): skip back faces and find the distance to the plane
+	__m128 den = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy)), _mm_mul_ps(nz, dz));
+	__m128 mask = _mm_cmplt_ps(den, zero);
+
+	__m128 wx = _mm_sub_ps(px, _mm_loadu_ps(block->plane_pnt[0]));
+	__m128 wy = _mm_sub_ps(py, _mm_loadu_ps(block->plane_pnt[1]));
+	__m128 wz = _mm_sub_ps(pz, _mm_loadu_ps(block->plane_pnt[2]));
+	__m128 num = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, wx), _mm_mul_ps(ny, wy)), _mm_mul_ps(nz, wz));
+
+	__m128 dist = _mm_div_ps(num, _mm_sub_ps(zero, den));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(dist, min_value));
+	mask = _mm_and_ps(mask, _mm_cmple_ps(dist, _mm_set1_ps(max_dist)));
+
+	if ( _mm_movemask_ps(mask) == 0 ) {
+		return 0;
+	}
+
+	// Hit point relative to the first vertex of the triangle
+	__m128 hx = _mm_sub_ps(_mm_add_ps(px, _mm_mul_ps(dx, dist)), _mm_loadu_ps(block->origin[0]));
+	__m128 hy = _mm_sub_ps(_mm_add_ps(py, _mm_mul_ps(dy, dist)), _mm_loadu_ps(block->origin[1]));
+	__m128 hz = _mm_sub_ps(_mm_add_ps(pz, _mm_mul_ps(dz, dist)), _mm_loadu_ps(block->origin[2]));
+
+	__m128 alpha = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(block->alpha[0]), hx),
+		_mm_mul_ps(_mm_loadu_ps(block->alpha[1]), hy)), _mm_mul_ps(_mm_loadu_ps(block->alpha[2]), hz));
+	__m128 beta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(block->beta[0]), hx),
+		_mm_mul_ps(_mm_loadu_ps(block->beta[1]), hy)), _mm_mul_ps(_mm_loadu_ps(block->beta[2]), hz));
+
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(alpha, min_value));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(beta, min_value));
+	mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(alpha, beta), max_bary));
+
+	return _mm_movemask_ps(mask);
+#else
+	int mask = 0;
+
+	for ( int lane = 0; lane < 4; ++lane ) {
+		float den = block->plane_norm[0][lane] * Mc_direction.xyz.x + block->plane_norm[1][lane] * Mc_direction.xyz.y
+			+ block->plane_norm[2][lane] * Mc_direction.xyz.z;
+
+		if ( den >= 0.0f ) {
+			continue;
 		}
 
-		int vert_num;
-		for ( i = 0; i < nv; ++i ) {
-			vert_num = tree->vert_list[vert_start+i].vertnum;
-			points[i] = &tree->point_list[vert_num];
+		float num = block->plane_norm[0][lane] * (Mc_p0.xyz.x - block->plane_pnt[0][lane])
+			+ block->plane_norm[1][lane] * (Mc_p0.xyz.y - block->plane_pnt[1][lane])
+			+ block->plane_norm[2][lane] * (Mc_p0.xyz.z - block->plane_pnt[2][lane]);
+		float dist = num / -den;
 
-			uvlist[i].u = tree->vert_list[vert_start+i].u;
-			uvlist[i].v = tree->vert_list[vert_start+i].v;
+		if ( (dist < -TRI_BLOCK_TOL) || (dist > max_dist) ) {
+			continue;
 		}
 
-		if ( flat_poly ) {
-			if ( Mc->flags & MC_CHECK_SPHERELINE ) {
-				mc_check_sphereline_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1, NULL, leaf);
-			} else {
-				mc_check_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, NULL, -1, NULL, leaf);
+		float hx = Mc_p0.xyz.x + Mc_direction.xyz.x * dist - block->origin[0][lane];
+		float hy = Mc_p0.xyz.y + Mc_direction.xyz.y * dist - block->origin[1][lane];
+		float hz = Mc_p0.xyz.z + Mc_direction.xyz.z * dist - block->origin[2][lane];
+
+		float alpha = block->alpha[0][lane] * hx + block->alpha[1][lane] * hy + block->alpha[2][lane] * hz;
+		float beta = block->beta[0][lane] * hx + block->beta[1][lane] * hy + block->beta[2][lane] * hz;
+
+		if ( (alpha >= -TRI_BLOCK_TOL) && (beta >= -TRI_BLOCK_TOL) && (alpha + beta <= 1.0f + TRI_BLOCK_TOL) ) {
+			mask |= 1 << lane;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+// Same as model_collide_bsp_poly() but only does the exact check for the polygons which the triangle blocks of the node
+// could not rule out. Only used for ray checks.
+static void model_collide_bsp_tri_blocks(bsp_collision_tree *tree, bsp_collision_node *node)
+{
+	int last_checked = -1;
+	int visible_end = node->leaf;	// the polygons of the leaf before this one are known to be visible
+
+	for ( int i = 0; i < node->n_tri_blocks; ++i ) {
+		const bsp_collision_tri_block *block = &tree->tri_block_list[node->tri_block_start + i];
+
+		int lanes = mc_ray_tri_block(block);
+
+		for ( int lane = 0; lanes != 0; ++lane, lanes >>= 1 ) {
+			if ( !(lanes & 1) ) {
+				continue;
 			}
-		} else {
-			if ( Mc->flags & MC_CHECK_SPHERELINE ) {
-				mc_check_sphereline_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist, leaf->tmap_num, NULL, leaf);
-			} else {
-				mc_check_face(nv, points, &leaf->plane_pnt, &leaf->plane_norm, uvlist, leaf->tmap_num, NULL, leaf);
+
+			int leaf_index = block->leaf[lane];
+
+			// The triangles of a polygon are stored next to each other
+			if ( leaf_index == last_checked ) {
+				continue;
 			}
-		}
 
-		tested_leaf = leaf->next;
+			// model_collide_bsp_poly() stops at the first invisible polygon of a leaf so do the same here
+			for ( ; visible_end <= leaf_index; ++visible_end ) {
+				if ( mc_leaf_is_invisible(&tree->leaf_list[visible_end]) ) {
+					return;
+				}
+			}
+
+			model_collide_bsp_leaf(tree, leaf_index);
+			last_checked = leaf_index;
+		}
 	}
 }
 
@@ -639,7 +801,11 @@ void model_collide_bsp(bsp_collision_tree *tree, int node_index)
 		}
 
 		if ( node->leaf >= 0 ) {
-			model_collide_bsp_poly(tree, node->leaf);
+			if ( Mc_use_tri_blocks && (node->n_tri_blocks > 0) && !(Mc->flags & MC_CHECK_SPHERELINE) ) {
+				model_collide_bsp_tri_blocks(tree, node);
+			} else {
+				model_collide_bsp_poly(tree, node->leaf);
+			}
 		} else {
 			if ( node->back >= 0 ) model_collide_bsp(tree, node->back);
 			if ( node->front >= 0 ) model_collide_bsp(tree, node->front);
@@ -730,10 +896,156 @@ void model_collide_parse_bsp_flatpoly(bsp_collision_leaf *leaf, SCP_vector<model
 	}
 }
 
-void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int version)
+// Sorts the nodes of a collision tree into depth first order with the back child first
+static void model_collide_order_bsp_nodes(SCP_vector<bsp_collision_node> *nodes)
 {
-	TRACE_SCOPE(tracing::ModelParseBSPTree);
+	SCP_vector<bsp_collision_node> ordered;
+	SCP_vector<int> new_index(nodes->size(), -1);
+	SCP_vector<int> stack;
 
+	ordered.reserve(nodes->size());
+	stack.push_back(0);
+
+	while ( !stack.empty() ) {
+		int node_index = stack.back();
+		stack.pop_back();
+
+		bsp_collision_node *node = &(*nodes)[node_index];
+
+		new_index[node_index] = (int)ordered.size();
+		ordered.push_back(*node);
+
+		if ( node->front >= 0 ) {
+			stack.push_back(node->front);
+		}
+
+		if ( node->back >= 0 ) {
+			stack.push_back(node->back);
+		}
+	}
+
+	for ( auto &node : ordered ) {
+		if ( node.front >= 0 ) {
+			node.front = new_index[node.front];
+		}
+
+		if ( node.back >= 0 ) {
+			node.back = new_index[node.back];
+		}
+	}
+
+	nodes->swap(ordered);
+}
+
+// Splits the polygons of every leaf of a collision tree into triangle fans and stores them in the triangle blocks which
+// are used for ray checks. Leaves with malformed polygons get no blocks and are always checked with the regular code.
+static void model_collide_build_tri_blocks(bsp_collision_tree *tree)
+{
+	SCP_vector<bsp_collision_tri_block> block_buffer;
+
+	for ( int n = 0; n < tree->n_nodes; ++n ) {
+		bsp_collision_node *node = &tree->node_list[n];
+
+		node->tri_block_start = (int)block_buffer.size();
+		node->n_tri_blocks = 0;
+
+		if ( node->leaf < 0 ) {
+			continue;
+		}
+
+		bool valid = true;
+		for ( int leaf_index = node->leaf; leaf_index >= 0; leaf_index = tree->leaf_list[leaf_index].next ) {
+			int nv = tree->leaf_list[leaf_index].num_verts;
+
+			if ( (nv < 3) || (nv > TMAP_MAX_VERTS) ) {
+				valid = false;
+				break;
+			}
+		}
+
+		if ( !valid ) {
+			continue;
+		}
+
+		int lane = 4;
+
+		for ( int leaf_index = node->leaf; leaf_index >= 0; leaf_index = tree->leaf_list[leaf_index].next ) {
+			bsp_collision_leaf *leaf = &tree->leaf_list[leaf_index];
+			const float *norm = leaf->plane_norm.a1d;
+
+			// Project the polygon onto the same plane as fvi_point_face() does
+			int i0;
+			if ( fl_abs(norm[0]) > fl_abs(norm[1]) ) {
+				i0 = (fl_abs(norm[0]) > fl_abs(norm[2])) ? 0 : 2;
+			} else {
+				i0 = (fl_abs(norm[1]) > fl_abs(norm[2])) ? 1 : 2;
+			}
+
+			int i1 = (i0 + 1) % 3;
+			int i2 = (i0 + 2) % 3;
+
+			const float *p0 = tree->point_list[tree->vert_list[leaf->vert_start].vertnum].a1d;
+
+			for ( int v = 2; v < leaf->num_verts; ++v ) {
+				const float *pa = tree->point_list[tree->vert_list[leaf->vert_start + v - 1].vertnum].a1d;
+				const float *pb = tree->point_list[tree->vert_list[leaf->vert_start + v].vertnum].a1d;
+
+				if ( lane == 4 ) {
+					bsp_collision_tri_block block;
+					memset(&block, 0, sizeof(block));
+
+					for ( int l = 0; l < 4; ++l ) {
+						block.leaf[l] = -1;
+					}
+
+					block_buffer.push_back(block);
+					++node->n_tri_blocks;
+					lane = 0;
+				}
+
+				bsp_collision_tri_block *block = &block_buffer.back();
+
+				for ( int axis = 0; axis < 3; ++axis ) {
+					block->plane_pnt[axis][lane] = leaf->plane_pnt.a1d[axis];
+					block->plane_norm[axis][lane] = norm[axis];
+					block->origin[axis][lane] = p0[axis];
+					block->alpha[axis][lane] = 0.0f;
+					block->beta[axis][lane] = 0.0f;
+				}
+
+				float u1 = pa[i1] - p0[i1];
+				float v1 = pa[i2] - p0[i2];
+				float u2 = pb[i1] - p0[i1];
+				float v2 = pb[i2] - p0[i2];
+				float det = u1 * v2 - u2 * v1;
+
+				// Slivers are left with all coefficients at zero so they pass the check if their plane is hit
+				if ( fl_abs(det) > TRI_BLOCK_TOL * (u1 * u1 + v1 * v1 + u2 * u2 + v2 * v2) ) {
+					block->alpha[i1][lane] = v2 / det;
+					block->alpha[i2][lane] = -u2 / det;
+					block->beta[i1][lane] = -v1 / det;
+					block->beta[i2][lane] = u1 / det;
+				}
+
+				block->leaf[lane] = leaf_index;
+				++lane;
+			}
+		}
+	}
+
+	tree->n_tri_blocks = (int)block_buffer.size();
+
+	if ( block_buffer.empty() ) {
+		tree->tri_block_list = NULL;
+		return;
+	}
+
+	tree->tri_block_list = (bsp_collision_tri_block*)vm_malloc(sizeof(bsp_collision_tri_block) * block_buffer.size());
+	memcpy(tree->tri_block_list, &block_buffer[0], sizeof(bsp_collision_tri_block) * block_buffer.size());
+}
+
+void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int version)
+{
 	ubyte *p = (ubyte *)model_ptr;
 	ubyte *next_p;
 
@@ -760,6 +1072,9 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 		// finally copy the vert list.
 		tree->vert_list = NULL;
 
+		tree->n_tri_blocks = 0;
+		tree->tri_block_list = NULL;
+
 		return;
 	}
 
@@ -893,7 +1208,9 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 
 	tree->n_verts = n_verts;
 
-	// copy node info. this might be a good time to organize the nodes into a cache efficient tree layout.
+	// copy node info. The nodes are stored in the order in which model_collide_bsp() visits them.
+	model_collide_order_bsp_nodes(&node_buffer);
+
 	tree->n_nodes = (int)node_buffer.size();
 	tree->node_list = (bsp_collision_node*)vm_malloc(sizeof(bsp_collision_node) * node_buffer.size());
 	memcpy(tree->node_list, &node_buffer[0], sizeof(bsp_collision_node) * node_buffer.size());
@@ -909,6 +1226,8 @@ void model_collide_parse_bsp(bsp_collision_tree *tree, void *model_ptr, int vers
 	tree->vert_list = (model_tmap_vert*)vm_malloc(sizeof(model_tmap_vert) * vert_buffer.size());
 	memcpy(tree->vert_list, &vert_buffer[0], sizeof(model_tmap_vert) * vert_buffer.size());
 	vert_buffer.clear();
+
+	model_collide_build_tri_blocks(tree);
 }
 
 bool mc_shield_check_common(shield_tri	*tri)
@@ -1232,7 +1551,10 @@ int model_collide(mc_info *mc_info_obj)
 {
 	Mc = mc_info_obj;
 
-	MONITOR_INC(NumFVI,1);
+	// The tracing system may only be used by the main thread
+	if (!util::is_worker_thread()) {
+		MONITOR_INC(NumFVI,1);
+	}
 
 	Mc->num_hits = 0;				// How many collisions were found
 	Mc->shield_hit_tri = -1;	// Assume we won't hit any shield polygons
@@ -1407,3 +1729,99 @@ void model_collide_preprocess(matrix *orient, int model_instance_num, int detail
 
 	model_collide_preprocess_subobj(&current_pos, &current_orient, pm, pmi, pm->detail[detail_num]);
 }
+
+DCF(model_collide_bench, "Measures the speed of ray checks against all loaded models")
+{
+	int num_rays = 10000;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: model_collide_bench [rays]\n");
+		dc_printf("Fires [rays] random rays (default 10000) at every loaded model, once with and once without the\n");
+		dc_printf("triangle blocks of the collision trees, and prints the number of rays per second.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&num_rays);
+
+	if (num_rays <= 0) {
+		dc_printf("The number of rays must be greater than zero.\n");
+		return;
+	}
+
+	SCP_vector<vec3d> ray_start(num_rays);
+	SCP_vector<vec3d> ray_end(num_rays);
+	SCP_vector<float> hit_dist(num_rays);
+
+	std::uint64_t total_time[2] = { 0, 0 };
+	int total_rays = 0;
+
+	for (auto pm : Polygon_models) {
+		if (pm == NULL) {
+			continue;
+		}
+
+		// Rays from a sphere around the model to a point within its bounding box
+		for (int i = 0; i < num_rays; ++i) {
+			vec3d dir;
+			static_randvec(i * 7, &dir);
+			vm_vec_copy_scale(&ray_start[i], &dir, pm->rad * 2.0f);
+
+			ray_end[i].xyz.x = static_randf_range(i * 7 + 3, pm->mins.xyz.x, pm->maxs.xyz.x);
+			ray_end[i].xyz.y = static_randf_range(i * 7 + 4, pm->mins.xyz.y, pm->maxs.xyz.y);
+			ray_end[i].xyz.z = static_randf_range(i * 7 + 5, pm->mins.xyz.z, pm->maxs.xyz.z);
+		}
+
+		std::uint64_t time[2];
+		int hits = 0;
+		int mismatches = 0;
+
+		// Pass 0 uses the triangle blocks, pass 1 the per polygon checks
+		for (int pass = 0; pass < 2; ++pass) {
+			Mc_use_tri_blocks = (pass == 0);
+
+			auto start = timer_get_microseconds();
+
+			for (int i = 0; i < num_rays; ++i) {
+				mc_info mc;
+				mc_info_init(&mc);
+
+				mc.model_num = pm->id;
+				mc.orient = &vmd_identity_matrix;
+				mc.pos = &vmd_zero_vector;
+				mc.p0 = &ray_start[i];
+				mc.p1 = &ray_end[i];
+				mc.flags = MC_CHECK_MODEL;
+
+				float dist = model_collide(&mc) ? mc.hit_dist : -1.0f;
+
+				if (pass == 0) {
+					hit_dist[i] = dist;
+					hits += (dist >= 0.0f) ? 1 : 0;
+				} else if (hit_dist[i] != dist) {
+					++mismatches;
+				}
+			}
+
+			time[pass] = timer_get_microseconds() - start;
+			total_time[pass] += time[pass];
+		}
+
+		Mc_use_tri_blocks = true;
+		total_rays += num_rays;
+
+		dc_printf("%s: %d hits, %.0f rays/s with triangle blocks, %.0f rays/s without\n", pm->filename, hits,
+			num_rays * 1000000.0 / MAX(time[0], (std::uint64_t) 1), num_rays * 1000000.0 / MAX(time[1], (std::uint64_t) 1));
+
+		if (mismatches > 0) {
+			dc_printf("  WARNING: %d rays had different results!\n", mismatches);
+		}
+	}
+
+	if (total_rays == 0) {
+		dc_printf("No models are loaded.\n");
+		return;
+	}
+
+	dc_printf("Total: %.0f rays/s with triangle blocks, %.0f rays/s without\n",
+		total_rays * 1000000.0 / MAX(total_time[0], (std::uint64_t) 1), total_rays * 1000000.0 / MAX(total_time[1], (std::uint64_t) 1));
+}
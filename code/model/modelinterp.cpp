@@ -37,6 +37,7 @@
 #include "tracing/Monitor.h"
 #include "tracing/tracing.h"
 
+#include <atomic>
 #include <climits>
 
 
@@ -241,7 +242,6 @@ void model_deallocate_interp_data()
 }
 
 extern void model_collide_allocate_point_list(int n_points);
-extern void model_collide_free_point_list();
 
 void model_allocate_interp_data(int n_verts, int n_norms)
 {
@@ -249,7 +249,6 @@ void model_allocate_interp_data(int n_verts, int n_norms)
 
 	if (!dealloc) {
 		atexit(model_deallocate_interp_data);
-		atexit(model_collide_free_point_list);
 		dealloc = 1;
 	}
 
@@ -1735,8 +1734,9 @@ void model_page_out_textures(int model_num, bool release)
 
 
 //**********vertex buffer stuff**********//
-int tri_count[MAX_MODEL_TEXTURES];
-poly_list polygon_list[MAX_MODEL_TEXTURES];
+// per thread since the vertex data of the submodels may be generated on the worker threads
+thread_local int tri_count[MAX_MODEL_TEXTURES];
+thread_local poly_list polygon_list[MAX_MODEL_TEXTURES];
 
 void parse_defpoint(int off, ubyte *bsp_data)
 {
@@ -1782,7 +1782,7 @@ int check_values(vec3d *N)
 	return 0;
 }
 
-int Parse_normal_problem_count = 0;
+std::atomic<int> Parse_normal_problem_count(0);
 
 void parse_tmap(int offset, ubyte *bsp_data)
 {
@@ -2037,16 +2037,8 @@ void model_interp_submit_buffers(indexed_vertex_source *vert_src, size_t vertex_
 	}
 }
 
-bool model_interp_pack_buffer(indexed_vertex_source *vert_src, vertex_buffer *vb)
+bool model_interp_allocate_buffers(indexed_vertex_source *vert_src)
 {
-	if ( vert_src == NULL ) {
-		return false;
-	}
-
-	Assertion(vb != nullptr, "Invalid vertex buffer specified!");
-
-	int i, n_verts = 0;
-	size_t j;
 	if ( vert_src->Vertex_list == NULL ) {
 		vert_src->Vertex_list = vm_malloc(vert_src->Vertex_list_size);
 
@@ -2069,6 +2061,23 @@ bool model_interp_pack_buffer(indexed_vertex_source *vert_src, vertex_buffer *vb
 		memset(vert_src->Index_list, 0, vert_src->Index_list_size);
 	}
 
+	return true;
+}
+
+bool model_interp_pack_buffer(indexed_vertex_source *vert_src, vertex_buffer *vb)
+{
+	if ( vert_src == NULL ) {
+		return false;
+	}
+
+	Assertion(vb != nullptr, "Invalid vertex buffer specified!");
+
+	int i, n_verts = 0;
+	size_t j;
+	if ( !model_interp_allocate_buffers(vert_src) ) {
+		return false;
+	}
+
 	// bump to our index in the array
 	auto array = reinterpret_cast<interp_vertex*>(static_cast<uint8_t*>(vert_src->Vertex_list) + (vb->vertex_offset));
 
@@ -2229,10 +2238,10 @@ bool model_interp_config_buffer(indexed_vertex_source *vert_src, vertex_buffer *
 	return true;
 }
 
-void interp_configure_vertex_buffers(polymodel *pm, int mn)
+// Generates the vertex and index data of a submodel. This only changes the submodel itself so it may run on a worker
+// thread, the space in the buffers of the model is assigned afterwards by interp_configure_vertex_buffers().
+void interp_generate_vertex_buffers(polymodel *pm, int mn)
 {
-	TRACE_SCOPE(tracing::ModelConfigureVertexBuffers);
-
 	int i, j, first_index;
 	uint total_verts = 0;
 	SCP_vector<int> vertex_list;
@@ -2246,8 +2255,6 @@ void interp_configure_vertex_buffers(polymodel *pm, int mn)
 		tri_count[i] = 0;
 	}
 
-	int milliseconds = timer_get_milliseconds();
-
 	bsp_polygon_data *bsp_polies = new bsp_polygon_data(model->bsp_data);
 
 	for (i = 0; i < MAX_MODEL_TEXTURES; i++) {
@@ -2284,10 +2291,6 @@ void interp_configure_vertex_buffers(polymodel *pm, int mn)
 	// done with the bsp now that we have the vertex data
 	delete bsp_polies;
 
-	int time_elapsed = timer_get_milliseconds() - milliseconds;
-
-	nprintf(("Model", "BSP Parse took %d milliseconds.\n", time_elapsed));
-
 	if (total_verts < 1) {
 		return;
 	}
@@ -2367,6 +2370,18 @@ void interp_configure_vertex_buffers(polymodel *pm, int mn)
 
 		model->buffer.tex_buf.push_back( new_buffer );
 	}
+}
+
+void interp_configure_vertex_buffers(polymodel *pm, int mn)
+{
+	Assert( (mn >= 0) && (mn < pm->n_models) );
+
+	bsp_info *model = &pm->submodel[mn];
+
+	// nothing was generated for submodels without polygons
+	if ( !model->buffer.model_list ) {
+		return;
+	}
 
 	bool rval = model_interp_config_buffer(&pm->vert_source, &model->buffer, false);
 
@@ -31,14 +31,17 @@
 #include "math/fvi.h"
 #include "math/vecmat.h"
 #include "model/model.h"
+#include "model/modelcache.h"
 #include "model/modelsinc.h"
 #include "parse/parselo.h"
 #include "render/3dinternal.h"
 #include "ship/ship.h"
 #include "weapon/weapon.h"
 #include "tracing/tracing.h"
+#include "utils/WorkerPool.h"
 
 #include <algorithm>
+#include <atomic>
 
 flag_def_list model_render_flags[] =
 {
@@ -82,6 +85,7 @@ static uint Global_checksum = 0;
 
 static int Model_signature = 0;
 
+void interp_generate_vertex_buffers(polymodel*, int);
 void interp_configure_vertex_buffers(polymodel*, int);
 void interp_pack_vertex_buffers(polymodel* pm, int mn);
 void interp_create_detail_index_buffer(polymodel *pm, int detail);
@@ -878,6 +882,98 @@ void create_family_tree(polymodel *obj)
 	}
 }
 
+// Runs func for every item in [0, count), on the worker threads if -mt_model_load is enabled. func must not use
+// anything that is not thread safe, see util::WorkerPool.
+static void model_load_parallel_for(size_t count, const std::function<void(size_t)>& func)
+{
+	if (Cmdline_mt_model_load && (count > 1)) {
+		util::get_worker_pool().parallelFor(count, 1, [&func](size_t begin, size_t end, size_t /*thread_index*/) {
+			for (auto i = begin; i < end; ++i) {
+				func(i);
+			}
+		});
+	} else {
+		for (size_t i = 0; i < count; ++i) {
+			func(i);
+		}
+	}
+}
+
+// The work of model_build_submodel_data(). The tasks are independent of each other.
+struct model_build_task {
+	enum task_type {
+		OCTANTS,
+		VERTEX_DATA,
+		COLLISION_TREE
+	};
+
+	task_type type;
+	int submodel;
+};
+
+// Builds the data which is derived from the BSP data of the submodels: the vertex and index data of every submodel,
+// the collision trees and the octants. These only read the BSP data and every task writes to its own submodel, tree or
+// to the octants so they may run in parallel. Everything which needs bmpman or the graphics API is left to
+// create_vertex_buffer(). All of it may come from the model cache instead.
+void model_build_submodel_data(polymodel *pm)
+{
+	TRACE_SCOPE(tracing::ModelBuildSubmodelData);
+
+	int i;
+
+	// the slots for the trees are created up front since that changes the list of trees
+	for (i = 0; i < pm->n_models; ++i) {
+		bsp_info *sm = &pm->submodel[i];
+
+		if ( !(sm->nocollide_this_only || sm->no_collisions) ) {
+			sm->collision_tree_index = model_create_bsp_collision_tree();
+		}
+	}
+
+	SCP_string cache_key;
+	bool cached = model_cache_load(pm, cache_key);
+
+	SCP_vector<model_build_task> tasks;
+
+	// the octants are the largest single task so they go first
+	if ( !cached ) {
+		tasks.push_back({model_build_task::OCTANTS, -1});
+	}
+
+	for (i = 0; i < pm->n_models; ++i) {
+		if ( !cached && !Is_standalone ) {
+			tasks.push_back({model_build_task::VERTEX_DATA, i});
+		}
+
+		if ( !cached && (pm->submodel[i].collision_tree_index >= 0) ) {
+			tasks.push_back({model_build_task::COLLISION_TREE, i});
+		}
+	}
+
+	model_load_parallel_for(tasks.size(), [pm, &tasks](size_t index) {
+		auto& task = tasks[index];
+
+		switch (task.type) {
+		case model_build_task::OCTANTS:
+			model_octant_create(pm);
+			break;
+		case model_build_task::VERTEX_DATA:
+			interp_generate_vertex_buffers(pm, task.submodel);
+			break;
+		case model_build_task::COLLISION_TREE:
+			model_collide_parse_bsp(model_get_bsp_collision_tree(pm->submodel[task.submodel].collision_tree_index),
+				pm->submodel[task.submodel].bsp_data, pm->version);
+			break;
+		}
+	});
+
+	if ( !cached ) {
+		model_cache_save(pm, cache_key);
+	} else if ( model_cache_validating() ) {
+		model_cache_validate(pm, cache_key);
+	}
+}
+
 void create_vertex_buffer(polymodel *pm)
 {
 	if (Is_standalone) {
@@ -888,9 +984,13 @@ void create_vertex_buffer(polymodel *pm)
 
 	int i;
 
-	// determine the size and configuration of each buffer segment
-	for (i = 0; i < pm->n_models; i++) {
-		interp_configure_vertex_buffers(pm, i);
+	// determine the size and configuration of each buffer segment, the data was generated by model_build_submodel_data()
+	{
+		TRACE_SCOPE(tracing::ModelConfigureVertexBuffers);
+
+		for (i = 0; i < pm->n_models; i++) {
+			interp_configure_vertex_buffers(pm, i);
+		}
 	}
 
 	// figure out which vertices are transparent
@@ -920,13 +1020,18 @@ void create_vertex_buffer(polymodel *pm)
 	}
 
 	// now actually fill the buffer with our info ...
-	for (i = 0; i < pm->n_models; i++) {
-		interp_pack_vertex_buffers(pm, i);
+	// every submodel writes to its own part of the buffers so they are allocated up front and filled in parallel
+	if ( (pm->vert_source.Vertex_list_size > 0) && !model_interp_allocate_buffers(&pm->vert_source) ) {
+		Error( LOCATION, "Unable to allocate vertex buffer for '%s'\n", pm->filename );
+	}
+
+	model_load_parallel_for(pm->n_models, [pm](size_t submodel) {
+		interp_pack_vertex_buffers(pm, (int)submodel);
 
 		// release temporary memory
-		pm->submodel[i].buffer.release();
-		pm->submodel[i].trans_buffer.release();
-	}
+		pm->submodel[submodel].buffer.release();
+		pm->submodel[submodel].trans_buffer.release();
+	});
 
 	// pack the merged index buffers to the vbo.
 	for ( i = 0; i < pm->n_detail_levels; ++i ) {
@@ -2664,7 +2769,7 @@ int model_load(const  char *filename, int n_subsystems, model_subsystem *subsyst
 	pm->id = Model_signature + num;
 	Assert( (pm->id % MAX_POLYGON_MODELS) == num );
 
-	extern int Parse_normal_problem_count;
+	extern std::atomic<int> Parse_normal_problem_count;
 	Parse_normal_problem_count = 0;
 
 	pm->used_this_mission = 0;
@@ -2695,7 +2800,7 @@ int model_load(const  char *filename, int n_subsystems, model_subsystem *subsyst
 	{
 		char buffer[100];
 		sprintf(buffer,"Serious problem loading model %s, %d normals capped to zero",
-			filename, Parse_normal_problem_count);
+			filename, Parse_normal_problem_count.load());
 		os::dialogs::Message(os::dialogs::MESSAGEBOX_ERROR, buffer);
 	}
 #endif
@@ -2745,6 +2850,9 @@ int model_load(const  char *filename, int n_subsystems, model_subsystem *subsyst
 
 	create_family_tree(pm);
 
+	// octants, collision trees and the vertex data, in parallel with -mt_model_load
+	model_build_submodel_data(pm);
+
 	// maybe generate vertex buffers
 	create_vertex_buffer(pm);
 
@@ -2850,18 +2958,6 @@ int model_load(const  char *filename, int n_subsystems, model_subsystem *subsyst
 	}
 
 
-	model_octant_create( pm );
-
-	TRACE_SCOPE(tracing::ModelParseAllBSPTrees);
-
-	for (i = 0; i < pm->n_models; ++i) {
-		if (!(pm->submodel[i].nocollide_this_only || pm->submodel[i].no_collisions)) {
-			pm->submodel[i].collision_tree_index = model_create_bsp_collision_tree();
-			bsp_collision_tree* tree             = model_get_bsp_collision_tree(pm->submodel[i].collision_tree_index);
-			model_collide_parse_bsp(tree, pm->submodel[i].bsp_data, pm->version);
-		}
-	}
-
 	// Find the core_radius... the minimum of 
 	float rx, ry, rz;
 	rx = fl_abs( pm->submodel[pm->detail[0]].max.xyz.x - pm->submodel[pm->detail[0]].min.xyz.x );
@@ -5216,15 +5312,18 @@ int model_create_bsp_collision_tree()
 		}
 	}
 
+	// slots are handed out empty so a tree which was never filled can still be removed
+	bsp_collision_tree tree;
+
+	memset(&tree, 0, sizeof(tree));
+	tree.used = true;
+
 	if ( slot_found ) {
-		Bsp_collision_tree_list[i].used = true;
+		Bsp_collision_tree_list[i] = tree;
 
 		return (int)i;
 	}
 
-	bsp_collision_tree tree;
-
-	tree.used = true;
 	Bsp_collision_tree_list.push_back(tree);
 
 	return (int)(Bsp_collision_tree_list.size() - 1);
@@ -5257,6 +5356,10 @@ void model_remove_bsp_collision_tree(int tree_index)
 	if ( Bsp_collision_tree_list[tree_index].vert_list ) {
 		vm_free( Bsp_collision_tree_list[tree_index].vert_list);
 	}
+
+	if ( Bsp_collision_tree_list[tree_index].tri_block_list ) {
+		vm_free( Bsp_collision_tree_list[tree_index].tri_block_list );
+	}
 }
 
 #if BYTE_ORDER == BIG_ENDIAN
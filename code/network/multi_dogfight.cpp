@@ -15,6 +15,7 @@
 #include "network/multiutil.h"
 #include "network/multi_log.h"
 #include "object/object.h"
+#include "object/objectspatial.h"
 #include "ship/ship.h"
 #include "freespace.h"
 #include "io/key.h"
@@ -146,6 +147,7 @@ void multi_df_level_pre_enter()
 	for(idx=0; idx<MAX_PLAYERS; idx++){
 		if(MULTI_CONNECTED(Net_players[idx]) && !MULTI_STANDALONE(Net_players[idx]) && !MULTI_OBSERVER(Net_players[idx]) && (Net_players[idx].m_player != NULL) && (Net_players[idx].m_player->objnum >= 0) && (Objects[Net_players[idx].m_player->objnum].type == OBJ_SHIP)){
 			Ships[Objects[Net_players[idx].m_player->objnum].instance].team = Iff_traitor;
+			obj_spatial_team_changed(Net_players[idx].m_player->objnum);
 		}
 	}
 
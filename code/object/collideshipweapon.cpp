@@ -22,10 +22,15 @@
 #include "ship/ship.h"
 #include "ship/shipfx.h"
 #include "ship/shiphit.h"
+#include "tracing/Monitor.h"
+#include "tracing/tracing.h"
+#include "utils/WorkerPool.h"
 #include "weapon/weapon.h"
 
 
 extern float ai_endangered_time(object *ship_objp, object *weapon_objp);
+static bool use_inside_radius_check(object *ship, object *weapon_obj);
+static float inside_radius_limit_time(object *ship, object *weapon_obj, float *time_to_max_error);
 static int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pair *pair );
 extern float flFrametime;
 
@@ -127,49 +132,91 @@ static void ship_weapon_do_hit_stuff(object *pship_obj, object *weapon_obj, vec3
 	}
 }
 
-extern int Framecount;
-
-static int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float time_limit = 0.0f, int *next_hit = NULL)
-{
-	mc_info mc, mc_shield, mc_hull;
-	ship	*shipp;
-	ship_info *sip;
-	weapon	*wp;
-	weapon_info	*wip;
-
-	Assert( ship_objp != NULL );
-	Assert( ship_objp->type == OBJ_SHIP );
-	Assert( ship_objp->instance >= 0 );
+/**
+ * The results of the model collision checks of a ship:weapon pair and the state they were computed from.
+ */
+struct ship_weapon_collision_result {
+	int ship_objnum;
+	int ship_signature;
+	int weapon_objnum;
+	int weapon_signature;
+	float time_limit;
+
+	vec3d ship_pos;
+	matrix ship_orient;
+	vec3d weapon_pos;
+	vec3d weapon_last_pos;
+	vec3d weapon_vel;
+	bool no_shields;
 
-	shipp = &Ships[ship_objp->instance];
-	sip = &Ship_info[shipp->ship_info_index];
+	vec3d weapon_end_pos;
 
-	Assert( weapon_objp != NULL );
-	Assert( weapon_objp->type == OBJ_WEAPON );
-	Assert( weapon_objp->instance >= 0 );
+	mc_info mc_shield;
+	mc_info mc_hull;
+	int shield_collision;
+	int hull_collision;
+};
 
-	wp = &Weapons[weapon_objp->instance];
-	wip = &Weapon_info[wp->weapon_info_index];
+// Results computed by collide_ship_weapon_prefetch() for the current frame
+static SCP_vector<ship_weapon_collision_result> Prefetched_results;
+static SCP_unordered_map<uint, size_t> Prefetched_result_lookup;
 
+static uint ship_weapon_prefetch_key(object *ship_objp, object *weapon_objp)
+{
+	return (OBJ_INDEX(ship_objp) << 12) + OBJ_INDEX(weapon_objp);
+}
 
-	Assert( shipp->objnum == OBJ_INDEX(ship_objp));
+/**
+ * Checks if the objects are still in the state a collision result was computed from
+ */
+static bool ship_weapon_result_matches(const ship_weapon_collision_result *result, object *ship_objp, object *weapon_objp, float time_limit)
+{
+	return result->ship_objnum == OBJ_INDEX(ship_objp)
+		&& result->ship_signature == ship_objp->signature
+		&& result->weapon_objnum == OBJ_INDEX(weapon_objp)
+		&& result->weapon_signature == weapon_objp->signature
+		&& result->time_limit == time_limit
+		&& result->no_shields == ship_objp->flags[Object::Object_Flags::No_shields]
+		&& !memcmp(&result->ship_pos, &ship_objp->pos, sizeof(vec3d))
+		&& !memcmp(&result->ship_orient, &ship_objp->orient, sizeof(matrix))
+		&& !memcmp(&result->weapon_pos, &weapon_objp->pos, sizeof(vec3d))
+		&& !memcmp(&result->weapon_last_pos, &weapon_objp->last_pos, sizeof(vec3d))
+		&& !memcmp(&result->weapon_vel, &weapon_objp->phys_info.vel, sizeof(vec3d));
+}
 
-	// Make ships that are warping in not get collision detection done
-	if ( shipp->is_arriving() ) return 0;
-	
-	//	Return information for AI to detect incoming fire.
-	//	Could perhaps be done elsewhere at lower cost --MK, 11/7/97
-	float	dist = vm_vec_dist_quick(&ship_objp->pos, &weapon_objp->pos);
-	if (dist < weapon_objp->phys_info.speed) {
-		update_danger_weapon(ship_objp, weapon_objp);
-	}
+/**
+ * Does the model collision checks of a ship:weapon pair.
+ *
+ * This only reads the state of the two objects so it may be called from a worker thread.
+ */
+static void ship_weapon_query_collision(object *ship_objp, object *weapon_objp, float time_limit, ship_weapon_collision_result *result)
+{
+	mc_info mc;
+	mc_info& mc_shield = result->mc_shield;
+	mc_info& mc_hull = result->mc_hull;
+
+	ship *shipp = &Ships[ship_objp->instance];
+	ship_info *sip = &Ship_info[shipp->ship_info_index];
+	weapon *wp = &Weapons[weapon_objp->instance];
+
+	result->ship_objnum = OBJ_INDEX(ship_objp);
+	result->ship_signature = ship_objp->signature;
+	result->weapon_objnum = OBJ_INDEX(weapon_objp);
+	result->weapon_signature = weapon_objp->signature;
+	result->time_limit = time_limit;
+	result->ship_pos = ship_objp->pos;
+	result->ship_orient = ship_objp->orient;
+	result->weapon_pos = weapon_objp->pos;
+	result->weapon_last_pos = weapon_objp->last_pos;
+	result->weapon_vel = weapon_objp->phys_info.vel;
+	result->no_shields = ship_objp->flags[Object::Object_Flags::No_shields];
 
-	int	valid_hit_occurred = 0;				// If this is set, then hitpos is set
-	int	quadrant_num = -1;
 	polymodel *pm = model_get(sip->model_num);
 
+	// The collision structs point to this so it has to be stored in the result
+	vec3d& weapon_end_pos = result->weapon_end_pos;
+
 	//	total time is flFrametime + time_limit (time_limit used to predict collisions into the future)
-	vec3d weapon_end_pos;
 	vm_vec_scale_add( &weapon_end_pos, &weapon_objp->pos, &weapon_objp->phys_info.vel, time_limit );
 
 
@@ -208,8 +255,11 @@ static int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, f
 	// Someone should make one.
 
 	// check both kinds of collisions
-	int shield_collision = 0;
-	int hull_collision = 0;
+	int& shield_collision = result->shield_collision;
+	int& hull_collision = result->hull_collision;
+
+	shield_collision = 0;
+	hull_collision = 0;
 
 	// check shields for impact
 	if (!(ship_objp->flags[Object::Object_Flags::No_shields])) {
@@ -352,6 +402,59 @@ static int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, f
 		mc_hull.flags = MC_CHECK_MODEL;
 		hull_collision = model_collide(&mc_hull);
 	}
+}
+
+extern int Framecount;
+
+static int ship_weapon_check_collision(object *ship_objp, object *weapon_objp, float time_limit = 0.0f, int *next_hit = NULL)
+{
+	mc_info mc;
+	ship	*shipp;
+	ship_info *sip;
+	weapon	*wp;
+	weapon_info	*wip;
+
+	Assert( ship_objp != NULL );
+	Assert( ship_objp->type == OBJ_SHIP );
+	Assert( ship_objp->instance >= 0 );
+
+	shipp = &Ships[ship_objp->instance];
+	sip = &Ship_info[shipp->ship_info_index];
+
+	Assert( weapon_objp != NULL );
+	Assert( weapon_objp->type == OBJ_WEAPON );
+	Assert( weapon_objp->instance >= 0 );
+
+	wp = &Weapons[weapon_objp->instance];
+	wip = &Weapon_info[wp->weapon_info_index];
+
+
+	Assert( shipp->objnum == OBJ_INDEX(ship_objp));
+
+	// Make ships that are warping in not get collision detection done
+	if ( shipp->is_arriving() ) return 0;
+	
+	float	dist = collide_ship_weapon_update_danger(ship_objp, weapon_objp);
+
+	int	valid_hit_occurred = 0;				// If this is set, then hitpos is set
+	int	quadrant_num = -1;
+	ship_weapon_collision_result local_result;
+	const ship_weapon_collision_result *result = nullptr;
+
+	auto iter = Prefetched_result_lookup.find(ship_weapon_prefetch_key(ship_objp, weapon_objp));
+	if (iter != Prefetched_result_lookup.end() && ship_weapon_result_matches(&Prefetched_results[iter->second], ship_objp, weapon_objp, time_limit)) {
+		result = &Prefetched_results[iter->second];
+	} else {
+		// Not prefetched or one of the objects was moved by an earlier collision in this frame
+		ship_weapon_query_collision(ship_objp, weapon_objp, time_limit, &local_result);
+		result = &local_result;
+	}
+
+	// The code below may modify these
+	mc_info mc_shield = result->mc_shield;
+	mc_info mc_hull = result->mc_hull;
+	int shield_collision = result->shield_collision;
+	int hull_collision = result->hull_collision;
 
 	if (shield_collision) {
 		// pick out the shield quadrant
@@ -484,8 +587,6 @@ int collide_ship_weapon( obj_pair * pair )
 	Assert( ship->type == OBJ_SHIP );
 	Assert( weapon_obj->type == OBJ_WEAPON );
 
-	ship_info *sip = &Ship_info[Ships[ship->instance].ship_info_index];
-
 	// Don't check collisions for player if past first warpout stage.
 	if ( Player->control_mode > PCM_WARPOUT_STAGE1)	{
 		if ( ship == Player_obj )
@@ -499,15 +600,8 @@ int collide_ship_weapon( obj_pair * pair )
 	// If it does hit, don't check the pair until about 200 ms before collision.  
 	// If it does not hit and is within error tolerance, cull the pair.
 
-	if ( (sip->is_big_or_huge()) && (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index].subtype == WP_LASER) ) {
-		// Check when within ~1.1 radii.  
-		// This allows good transition between sphere checking (leaving the laser about 200 ms from radius) and checking
-		// within the sphere with little time between.  There may be some time for "small" big ships
-		// Note: culling ships with auto spread shields seems to waste more performance than it saves,
-		// so we're not doing that here
-		if ( !(sip->flags[Ship::Info_Flags::Auto_spread_shields]) && vm_vec_dist_squared(&ship->pos, &weapon_obj->pos) < (1.2f*ship->radius*ship->radius) ) {
-			return check_inside_radius_for_big_ships( ship, weapon_obj, pair );
-		}
+	if ( use_inside_radius_check(ship, weapon_obj) ) {
+		return check_inside_radius_for_big_ships( ship, weapon_obj, pair );
 	}
 
 	did_hit = ship_weapon_check_collision( ship, weapon_obj );
@@ -521,6 +615,133 @@ int collide_ship_weapon( obj_pair * pair )
 	return 0;
 }
 
+MONITOR(NumPrefetchedCollisions)
+
+void collide_ship_weapon_prefetch(const SCP_vector<std::pair<object*, object*>>& pairs)
+{
+	TRACE_SCOPE(tracing::PrefetchShipWeaponCollisions);
+
+	collide_ship_weapon_prefetch_clear();
+
+	// Skip the pairs that collide_ship_weapon() will reject before checking the models
+	for (auto& pair : pairs) {
+		object *ship = pair.first;
+		object *weapon_obj = pair.second;
+
+		Assert( ship->type == OBJ_SHIP );
+		Assert( weapon_obj->type == OBJ_WEAPON );
+
+		if ( (Player->control_mode > PCM_WARPOUT_STAGE1) && (ship == Player_obj) )
+			continue;
+
+		if (reject_due_collision_groups(ship, weapon_obj))
+			continue;
+
+		if (Ships[ship->instance].is_arriving())
+			continue;
+
+		float time_limit = 0.0f;
+		if ( use_inside_radius_check(ship, weapon_obj) ) {
+			float time_to_max_error;
+			time_limit = inside_radius_limit_time(ship, weapon_obj, &time_to_max_error);
+		}
+
+		auto key = ship_weapon_prefetch_key(ship, weapon_obj);
+		if (Prefetched_result_lookup.find(key) != Prefetched_result_lookup.end())
+			continue;
+
+		ship_weapon_collision_result result;
+		result.ship_objnum = OBJ_INDEX(ship);
+		result.weapon_objnum = OBJ_INDEX(weapon_obj);
+		result.time_limit = time_limit;
+
+		Prefetched_result_lookup.insert(std::make_pair(key, Prefetched_results.size()));
+		Prefetched_results.push_back(result);
+	}
+
+	MONITOR_INC(NumPrefetchedCollisions, (int) Prefetched_results.size());
+
+	// The results must not be moved after this point since the collision structs point into them
+	util::get_worker_pool().parallelFor(Prefetched_results.size(), 4, [](size_t begin, size_t end, size_t) {
+		for (auto i = begin; i < end; ++i) {
+			auto& result = Prefetched_results[i];
+
+			ship_weapon_query_collision(&Objects[result.ship_objnum], &Objects[result.weapon_objnum], result.time_limit, &result);
+		}
+	});
+}
+
+void collide_ship_weapon_prefetch_clear()
+{
+	Prefetched_results.clear();
+	Prefetched_result_lookup.clear();
+}
+
+float collide_ship_weapon_update_danger(object *ship_objp, object *weapon_objp)
+{
+	//	Return information for AI to detect incoming fire.
+	//	Could perhaps be done elsewhere at lower cost --MK, 11/7/97
+	float	dist = vm_vec_dist_quick(&ship_objp->pos, &weapon_objp->pos);
+	if (dist < weapon_objp->phys_info.speed) {
+		update_danger_weapon(ship_objp, weapon_objp);
+	}
+
+	return dist;
+}
+
+void collide_ship_weapon_get_separation(object *ship, object *weapon_obj, collision_separation *sep)
+{
+	Assert( ship->type == OBJ_SHIP );
+	Assert( weapon_obj->type == OBJ_WEAPON );
+
+	ship_info *sip = &Ship_info[Ships[ship->instance].ship_info_index];
+	polymodel *pm = model_get(sip->model_num);
+
+	sep->dist = 0.0f;
+
+	// model_collide() never reports a hit for a path which doesn't touch the bounding box of the whole model so the
+	// distance to that box is how far the objects have to move
+	vec3d local_pos, tempv;
+	vm_vec_sub(&tempv, &weapon_obj->pos, &ship->pos);
+	vm_vec_rotate(&local_pos, &tempv, &ship->orient);
+
+	float dist_squared = 0.0f;
+	float rotation_radius_squared = 0.0f;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		float delta = 0.0f;
+
+		if (local_pos.a1d[axis] < pm->mins.a1d[axis]) {
+			delta = pm->mins.a1d[axis] - local_pos.a1d[axis];
+		} else if (local_pos.a1d[axis] > pm->maxs.a1d[axis]) {
+			delta = local_pos.a1d[axis] - pm->maxs.a1d[axis];
+		}
+
+		dist_squared += delta * delta;
+
+		float extent = MAX(fl_abs(pm->mins.a1d[axis]), fl_abs(pm->maxs.a1d[axis]));
+		rotation_radius_squared += extent * extent;
+	}
+
+	float dist = fl_sqrt(dist_squared);
+
+	// Auto spread shields are checked with a sphere instead of a ray
+	if (sip->flags[Ship::Info_Flags::Auto_spread_shields]) {
+		dist -= sip->auto_shield_spread;
+	}
+
+	if (dist <= 0.0f) {
+		return;
+	}
+
+	sep->pos_a = ship->pos;
+	sep->orient_a = ship->orient;
+	sep->pos_b = weapon_obj->pos;
+	sep->radius_a = ship->radius;
+	sep->rotation_radius = fl_sqrt(rotation_radius_squared);
+	sep->dist = dist;
+}
+
 /**
  * Upper limit estimate ship speed at end of time
  */
@@ -548,15 +769,35 @@ static float estimate_ship_speed_upper_limit( object *ship, float time )
 #define ERROR_STD	2	
 
 /**
- * When inside radius of big ship, check if we can cull collision pair determine the time when pair should next be checked
- * @return 1 if pair can be culled
- * @return 0 if pair can not be culled
+ * Lasers inside the radius of big ships are checked for collisions further into the future so the pair can be culled
  */
-static int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pair *pair )
+static bool use_inside_radius_check(object *ship, object *weapon_obj)
+{
+	ship_info *sip = &Ship_info[Ships[ship->instance].ship_info_index];
+
+	if ( (sip->is_big_or_huge()) && (Weapon_info[Weapons[weapon_obj->instance].weapon_info_index].subtype == WP_LASER) ) {
+		// Check when within ~1.1 radii.  
+		// This allows good transition between sphere checking (leaving the laser about 200 ms from radius) and checking
+		// within the sphere with little time between.  There may be some time for "small" big ships
+		// Note: culling ships with auto spread shields seems to waste more performance than it saves,
+		// so we're not doing that here
+		if ( !(sip->flags[Ship::Info_Flags::Auto_spread_shields]) && vm_vec_dist_squared(&ship->pos, &weapon_obj->pos) < (1.2f*ship->radius*ship->radius) ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Determines how far into the future a laser inside the radius of a big ship should be checked
+ * @return The furthest time to check (either the lifetime of the laser or the time it exits the sphere)
+ */
+static float inside_radius_limit_time(object *ship, object *weapon_obj, float *time_to_max_error)
 {
 	vec3d error_vel;		// vel perpendicular to laser
 	float error_vel_mag;	// magnitude of error_vel
-	float time_to_max_error, time_to_exit_sphere;
+	float time_to_exit_sphere;
 	float ship_speed_at_exit_sphere, error_at_exit_sphere;	
 	float max_error = (float) ERROR_STD / 150.0f * ship->radius;
 	if (max_error < 2)
@@ -571,7 +812,7 @@ static int check_inside_radius_for_big_ships( object *ship, object *weapon_obj,
 	error_vel_mag += 0.5f * (ship->phys_info.max_vel.xyz.z - error_vel_mag)*(time_to_exit_sphere/ship->phys_info.forward_accel_time_const);
 	// error_vel_mag is now average velocity over period
 	error_at_exit_sphere = error_vel_mag * time_to_exit_sphere;
-	time_to_max_error = max_error / error_at_exit_sphere * time_to_exit_sphere;
+	*time_to_max_error = max_error / error_at_exit_sphere * time_to_exit_sphere;
 
 	// find the minimum time we can safely check into the future.
 	// limited by (1) time to exit sphere (2) time to weapon expires
@@ -584,6 +825,19 @@ static int check_inside_radius_for_big_ships( object *ship, object *weapon_obj,
 		limit_time = Weapons[weapon_obj->instance].lifeleft;
 	}
 
+	return limit_time;
+}
+
+/**
+ * When inside radius of big ship, check if we can cull collision pair determine the time when pair should next be checked
+ * @return 1 if pair can be culled
+ * @return 0 if pair can not be culled
+ */
+static int check_inside_radius_for_big_ships( object *ship, object *weapon_obj, obj_pair *pair )
+{
+	float time_to_max_error;
+	float limit_time = inside_radius_limit_time(ship, weapon_obj, &time_to_max_error);
+
 	// Note:  when estimated hit time is less than 200 ms, look at every frame
 	int hit_time;	// estimated time of hit in ms
 
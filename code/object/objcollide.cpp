@@ -9,9 +9,11 @@
 
 
 
+#include "cmdline/cmdline.h"
 #include "globalincs/linklist.h"
 #include "io/timer.h"
 #include "object/objcollide.h"
+#include "object/objcollidegrid.h"
 #include "object/object.h"
 #include "object/objectdock.h"
 #include "ship/ship.h"
@@ -38,6 +40,13 @@ int pairs_not_created = 0;
 
 int Num_pairs_hwm = 0;
 
+// number of candidate pairs the broadphase found in the current frame
+static int Num_broadphase_pairs = 0;
+
+// if set, the pairs found by the broadphase are collected and collided afterwards (see -mt_collisions)
+static bool Collision_defer_pairs = false;
+static SCP_vector<std::pair<object*, object*>> Collision_deferred_pairs;
+
 obj_pair *Obj_pairs = NULL;
 
 obj_pair pair_used_list;
@@ -54,12 +63,15 @@ public:
 	int signature_b;
 	int next_check_time;
 	bool initialized;
+	collision_separation separation;
 
 	// we need to define a constructor because the hash map can
 	// implicitly insert an object when we use the [] operator
 	collider_pair()
 		: a(NULL), b(NULL), signature_a(-1), signature_b(-1), next_check_time(-1), initialized(false)
-	{}
+	{
+		separation.dist = 0.0f;
+	}
 };
 
 SCP_unordered_map<uint, collider_pair> Collision_cached_pairs;
@@ -458,6 +470,7 @@ void obj_add_pair( object *A, object *B, int check_time, int add_to_end )
 
 MONITOR(NumPairs)
 MONITOR(NumPairsChecked)
+MONITOR(NumSeparatedPairs)
 
 //#define PAIR_STATS
 
@@ -998,6 +1011,10 @@ void obj_add_collider(int obj_index)
 
 	Collision_sort_list.push_back(obj_index);
 
+	if (Cmdline_collision_grid) {
+		collide_grid_add(obj_index);
+	}
+
 	objp->flags.remove(Object::Object_Flags::Not_in_coll);
 }
 
@@ -1017,6 +1034,10 @@ void obj_remove_collider(int obj_index)
 		}
 	}
 
+	if (Cmdline_collision_grid) {
+		collide_grid_remove(obj_index);
+	}
+
 	Objects[obj_index].flags.set(Object::Object_Flags::Not_in_coll);
 }
 
@@ -1024,6 +1045,8 @@ void obj_reset_colliders()
 {
 	Collision_sort_list.clear();
 	Collision_cached_pairs.clear();
+
+	collide_grid_reset();
 }
 
 void obj_collide_retime_cached_pairs(int checkdly)
@@ -1035,14 +1058,60 @@ void obj_collide_retime_cached_pairs(int checkdly)
 	}
 }
 
-void obj_sort_and_collide()
+// Returns true if the objects of a pair can't have moved far enough since the pair was last checked to touch each other
+static bool obj_collide_pair_is_separated(object *A, object *B, const collision_separation *sep)
 {
-	if (Cmdline_dis_collisions)
-		return;
+	if ( sep->dist <= 0.0f || A->radius != sep->radius_a )
+		return false;
+
+	// Every point of A has moved at most this far. The rotation part uses the Frobenius norm of the change of the
+	// orientation which is an upper bound of how far it can rotate a point at unit distance.
+	float rotation = 0.0f;
+	for ( int i = 0; i < 9; ++i ) {
+		float delta = A->orient.a1d[i] - sep->orient_a.a1d[i];
+		rotation += delta * delta;
+	}
 
-	if ( !(Game_detail_flags & DETAIL_FLAG_COLLISION) )
-		return;
+	float motion = vm_vec_dist(&A->pos, &sep->pos_a) + sep->rotation_radius * fl_sqrt(rotation);
 
+	// B is checked along the path from its last position to its current one
+	motion += MAX(vm_vec_dist(&B->pos, &sep->pos_b), vm_vec_dist(&B->last_pos, &sep->pos_b));
+
+	return motion < sep->dist;
+}
+
+// Checks if obj_collide_pair() would call the collision function of a pair this frame. This only covers the basic
+// rejection tests and the timestamp of an already known pair; the collision function itself may reject more pairs.
+static bool obj_collide_pair_is_due(object *A, object *B)
+{
+	if ( !(A->flags[Object::Object_Flags::Collides]) || !(B->flags[Object::Object_Flags::Collides]) )
+		return false;
+
+	if ( reject_obj_pair_on_parent(A, B) )
+		return false;
+
+	uint key = (OBJ_INDEX(A) << 12) + OBJ_INDEX(B);
+	auto iter = Collision_cached_pairs.find(key);
+
+	if ( iter == Collision_cached_pairs.end() )
+		return true;
+
+	auto& collision_info = iter->second;
+	if ( !collision_info.initialized || collision_info.signature_a != A->signature || collision_info.signature_b != B->signature )
+		return true;
+
+	if ( collision_info.next_check_time == -1 )
+		return false;
+
+	if ( !timestamp_elapsed(collision_info.next_check_time) )
+		return false;
+
+	return !obj_collide_pair_is_separated(A, B, &collision_info.separation);
+}
+
+// Runs the sort-and-sweep over all colliders and passes every overlapping pair on to obj_collide_candidate_pair()
+static void obj_sweep_colliders()
+{
 	SCP_vector<int> sort_list_y;
 	SCP_vector<int> sort_list_z;
 
@@ -1068,6 +1137,74 @@ void obj_sort_and_collide()
 	obj_find_overlap_colliders(&sort_list_y, &sort_list_z, 2, true);
 }
 
+// Collides all pairs found by the broadphase in the order in which they were found. The model checks of ship:weapon
+// pairs are done on the worker threads first so the serial pass only has to apply the results.
+static void obj_collide_deferred_pairs()
+{
+	SCP_vector<std::pair<object*, object*>> ship_weapon_pairs;
+
+	for (auto& pair : Collision_deferred_pairs) {
+		object *A = pair.first;
+		object *B = pair.second;
+
+		if (A->type == OBJ_WEAPON && B->type == OBJ_SHIP) {
+			std::swap(A, B);
+		} else if (A->type != OBJ_SHIP || B->type != OBJ_WEAPON) {
+			continue;
+		}
+
+		if (obj_collide_pair_is_due(A, B)) {
+			ship_weapon_pairs.emplace_back(A, B);
+		}
+	}
+
+	collide_ship_weapon_prefetch(ship_weapon_pairs);
+
+	for (auto& pair : Collision_deferred_pairs) {
+		obj_collide_pair(pair.first, pair.second);
+	}
+
+	collide_ship_weapon_prefetch_clear();
+	Collision_deferred_pairs.clear();
+}
+
+void obj_sort_and_collide()
+{
+	if (Cmdline_dis_collisions)
+		return;
+
+	if ( !(Game_detail_flags & DETAIL_FLAG_COLLISION) )
+		return;
+
+	Collision_defer_pairs = Cmdline_mt_collisions;
+	Num_broadphase_pairs = 0;
+
+	if (Cmdline_collision_grid) {
+		collide_grid_update_and_collide(Collision_sort_list);
+	} else {
+		obj_sweep_colliders();
+	}
+
+	Num_pairs_checked += Num_broadphase_pairs;
+	mon_NumPairs = Num_broadphase_pairs;
+
+	if (Collision_defer_pairs) {
+		Collision_defer_pairs = false;
+		obj_collide_deferred_pairs();
+	}
+}
+
+void obj_collide_candidate_pair(object *A, object *B)
+{
+	++Num_broadphase_pairs;
+
+	if (Collision_defer_pairs) {
+		Collision_deferred_pairs.emplace_back(A, B);
+	} else {
+		obj_collide_pair(A, B);
+	}
+}
+
 void obj_find_overlap_colliders(SCP_vector<int> *overlap_list_out, SCP_vector<int> *list, int axis, bool collide)
 {
 	TRACE_SCOPE(tracing::FindOverlapColliders);
@@ -1098,7 +1235,7 @@ void obj_find_overlap_colliders(SCP_vector<int> *overlap_list_out, SCP_vector<in
 				}
 				
 				if ( collide ) {
-					obj_collide_pair(&Objects[(*list)[i]], &Objects[overlappers[j]]);
+					obj_collide_candidate_pair(&Objects[(*list)[i]], &Objects[overlappers[j]]);
 				}
 			} else {
 				overlappers[j] = overlappers.back();
@@ -1390,6 +1527,7 @@ void obj_collide_pair(object *A, object *B)
 			collision_info->signature_a = A->signature;
 			collision_info->signature_b = B->signature;
 			collision_info->next_check_time = timestamp(0);
+			collision_info->separation.dist = 0.0f;
 		}
 	} else {
 		collision_info->a = A;
@@ -1398,6 +1536,7 @@ void obj_collide_pair(object *A, object *B)
 		collision_info->signature_b = B->signature;
 		collision_info->initialized = true;
 		collision_info->next_check_time = timestamp(0);
+		collision_info->separation.dist = 0.0f;
 	}
 
 	if ( valid &&  A->type != OBJ_BEAM ) {
@@ -1409,6 +1548,17 @@ void obj_collide_pair(object *A, object *B)
 				return;
 			}
 		}
+
+		// the objects were too far apart the last time to have reached each other by now
+		if ( obj_collide_pair_is_separated(A, B, &collision_info->separation) ) {
+			// The AI still has to know about weapons that are about to reach the ship
+			if ( (check_collision == collide_ship_weapon) && !Ships[A->instance].is_arriving() ) {
+				collide_ship_weapon_update_danger(A, B);
+			}
+
+			MONITOR_INC(NumSeparatedPairs, 1);
+			return;
+		}
 	} else {
 		//if ( A->type == OBJ_BEAM ) {
 			//if(beam_collide_early_out(A, B)){
@@ -1488,5 +1638,11 @@ void obj_collide_pair(object *A, object *B)
 		collision_info->next_check_time = -1;
 	} else {
 		collision_info->next_check_time = new_pair.next_check_time;
+
+		if ( check_collision == collide_ship_weapon ) {
+			collide_ship_weapon_get_separation(A, B, &collision_info->separation);
+		} else {
+			collision_info->separation.dist = 0.0f;
+		}
 	}
 }
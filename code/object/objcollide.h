@@ -60,6 +60,18 @@ typedef struct obj_pair	{
 } obj_pair;
 
 
+// Remembers how far apart the objects of a pair were when the pair was last checked without a hit so that the pair
+// can be skipped until the objects could have moved far enough to touch. Object A may move and rotate, object B is
+// treated as a point moving from its last_pos to its pos.
+typedef struct collision_separation {
+	vec3d	pos_a;				// position and orientation of A when the separation was determined
+	matrix	orient_a;
+	vec3d	pos_b;				// position of B when the separation was determined
+	float	radius_a;			// radius of A, if it changes (e.g. a new ship class) the separation is invalid
+	float	rotation_radius;	// how far the collision bounds of A reach from its center
+	float	dist;				// how far the objects have to move before they can collide, <= 0 if unknown
+} collision_separation;
+
 #define COLLISION_OF(a,b) (((a)<<8)|(b))
 
 #define SUBMODEL_NO_ROT_HIT	0
@@ -78,6 +90,9 @@ void obj_find_overlap_colliders(SCP_vector<int> *overlap_list_out, SCP_vector<in
 float obj_get_collider_endpoint(int obj_num, int axis, bool min);
 void obj_collide_pair(object *A, object *B);
 
+// Called by the broadphase for every pair of colliders with overlapping bounding boxes
+void obj_collide_candidate_pair(object *A, object *B);
+
 // retimes all collision pairs to be checked (in 25ms by default)
 void obj_collide_retime_cached_pairs(int checkdly=25);
 
@@ -108,6 +123,24 @@ int collide_weapon_weapon( obj_pair * pair );
 // CODE is locatated in CollideShipWeapon.cpp
 int collide_ship_weapon( obj_pair * pair );
 
+// Does the model collision checks of the given ship:weapon pairs on the worker threads so that collide_ship_weapon()
+// only has to apply the results. The ship is the first object of each pair. Results are discarded if one of the
+// objects moves before collide_ship_weapon() is called for the pair.
+// CODE is locatated in CollideShipWeapon.cpp
+void collide_ship_weapon_prefetch(const SCP_vector<std::pair<object*, object*>>& pairs);
+
+// Discards all results of collide_ship_weapon_prefetch()
+void collide_ship_weapon_prefetch_clear();
+
+// Tells the AI of the ship about the weapon if it is less than a second away and returns the distance between them.
+// Also needed for pairs which are skipped without calling collide_ship_weapon()
+// CODE is locatated in CollideShipWeapon.cpp
+float collide_ship_weapon_update_danger(object *ship_objp, object *weapon_objp);
+
+// Determines how far a weapon that just missed a ship is from the bounding box of the ship model
+// CODE is locatated in CollideShipWeapon.cpp
+void collide_ship_weapon_get_separation(object *ship, object *weapon_obj, collision_separation *sep);
+
 // Checks debris-weapon collisions.  pair->a is debris and pair->b is weapon.
 // Returns 1 if all future collisions between these can be ignored
 // CODE is locatated in CollideDebrisWeapon.cpp
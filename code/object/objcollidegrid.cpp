@@ -0,0 +1,305 @@
+#include "object/objcollidegrid.h"
+#include "object/objcollide.h"
+#include "object/object.h"
+#include "tracing/tracing.h"
+
+// Edge length of a single grid cell in meters. Fighters and most weapons only ever touch a handful of cells.
+#define COLLIDE_GRID_CELL_SIZE		200.0f
+// Objects which span more cells than this along any axis are not put into the grid but are checked against everything
+#define COLLIDE_GRID_MAX_CELL_SPAN	4
+
+// The cell coordinates are packed into a 64-bit key with this many bits per axis
+#define COLLIDE_GRID_KEY_BITS		21
+#define COLLIDE_GRID_KEY_OFFSET		(1 << (COLLIDE_GRID_KEY_BITS - 1))
+
+namespace {
+
+struct grid_entry {
+	bool placed = false;		// true if the object has been put into the grid (or the oversized list)
+	bool oversized = false;		// true if the object is in Collide_grid_oversized instead of the grid cells
+
+	float min[3];
+	float max[3];
+
+	int cell_min[3];
+	int cell_max[3];
+};
+
+grid_entry Collide_grid_entries[MAX_OBJECTS];
+
+SCP_unordered_map<uint64_t, SCP_vector<int>> Collide_grid_cells;
+SCP_vector<int> Collide_grid_oversized;
+
+// Copies of the collider and oversized lists for one collision pass, the originals may change during the pass
+SCP_vector<int> Collide_grid_pass_colliders;
+SCP_vector<int> Collide_grid_pass_oversized;
+
+int grid_cell_coord(float val)
+{
+	float cell = floorf(val / COLLIDE_GRID_CELL_SIZE);
+
+	CLAMP(cell, (float) (-COLLIDE_GRID_KEY_OFFSET + 1), (float) (COLLIDE_GRID_KEY_OFFSET - 1));
+
+	return (int) cell;
+}
+
+uint64_t grid_cell_key(int x, int y, int z)
+{
+	return ((uint64_t) (x + COLLIDE_GRID_KEY_OFFSET) << (2 * COLLIDE_GRID_KEY_BITS))
+		| ((uint64_t) (y + COLLIDE_GRID_KEY_OFFSET) << COLLIDE_GRID_KEY_BITS)
+		| (uint64_t) (z + COLLIDE_GRID_KEY_OFFSET);
+}
+
+void remove_from_list(SCP_vector<int>& list, int objnum)
+{
+	for (size_t i = 0; i < list.size(); ++i) {
+		if (list[i] == objnum) {
+			list[i] = list.back();
+			list.pop_back();
+			return;
+		}
+	}
+}
+
+void grid_unlink(int objnum)
+{
+	auto& entry = Collide_grid_entries[objnum];
+
+	if (!entry.placed) {
+		return;
+	}
+
+	if (entry.oversized) {
+		remove_from_list(Collide_grid_oversized, objnum);
+	} else {
+		for (int x = entry.cell_min[0]; x <= entry.cell_max[0]; ++x) {
+			for (int y = entry.cell_min[1]; y <= entry.cell_max[1]; ++y) {
+				for (int z = entry.cell_min[2]; z <= entry.cell_max[2]; ++z) {
+					auto iter = Collide_grid_cells.find(grid_cell_key(x, y, z));
+
+					if (iter == Collide_grid_cells.end()) {
+						continue;
+					}
+
+					remove_from_list(iter->second, objnum);
+
+					if (iter->second.empty()) {
+						Collide_grid_cells.erase(iter);
+					}
+				}
+			}
+		}
+	}
+
+	entry.placed = false;
+	entry.oversized = false;
+}
+
+void grid_link(int objnum)
+{
+	auto& entry = Collide_grid_entries[objnum];
+
+	Assertion(!entry.placed, "Object %d was linked into the collision grid twice!", objnum);
+
+	if (entry.oversized) {
+		Collide_grid_oversized.push_back(objnum);
+	} else {
+		for (int x = entry.cell_min[0]; x <= entry.cell_max[0]; ++x) {
+			for (int y = entry.cell_min[1]; y <= entry.cell_max[1]; ++y) {
+				for (int z = entry.cell_min[2]; z <= entry.cell_max[2]; ++z) {
+					Collide_grid_cells[grid_cell_key(x, y, z)].push_back(objnum);
+				}
+			}
+		}
+	}
+
+	entry.placed = true;
+}
+
+// Recomputes the bounds of the object and moves it to its new cells if they changed
+void grid_update_entry(int objnum)
+{
+	auto& entry = Collide_grid_entries[objnum];
+
+	int cell_min[3];
+	int cell_max[3];
+	bool oversized = false;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		entry.min[axis] = obj_get_collider_endpoint(objnum, axis, true);
+		entry.max[axis] = obj_get_collider_endpoint(objnum, axis, false);
+
+		cell_min[axis] = grid_cell_coord(entry.min[axis]);
+		cell_max[axis] = grid_cell_coord(entry.max[axis]);
+
+		if (cell_max[axis] - cell_min[axis] >= COLLIDE_GRID_MAX_CELL_SPAN) {
+			oversized = true;
+		}
+	}
+
+	if (entry.placed && entry.oversized == oversized) {
+		if (oversized) {
+			// The oversized list doesn't care about cells
+			return;
+		}
+
+		bool same_cells = true;
+		for (int axis = 0; axis < 3; ++axis) {
+			if (cell_min[axis] != entry.cell_min[axis] || cell_max[axis] != entry.cell_max[axis]) {
+				same_cells = false;
+				break;
+			}
+		}
+
+		if (same_cells) {
+			return;
+		}
+	}
+
+	grid_unlink(objnum);
+
+	entry.oversized = oversized;
+	for (int axis = 0; axis < 3; ++axis) {
+		entry.cell_min[axis] = cell_min[axis];
+		entry.cell_max[axis] = cell_max[axis];
+	}
+
+	grid_link(objnum);
+}
+
+bool grid_entries_overlap(const grid_entry& a, const grid_entry& b)
+{
+	for (int axis = 0; axis < 3; ++axis) {
+		if (a.min[axis] > b.max[axis] || b.min[axis] > a.max[axis]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+void collide_grid_add(int objnum)
+{
+	Assert(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	// The actual cells are computed on the next update since the object may not have a valid position yet
+	grid_unlink(objnum);
+}
+
+void collide_grid_remove(int objnum)
+{
+	Assert(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	grid_unlink(objnum);
+}
+
+void collide_grid_reset()
+{
+	Collide_grid_cells.clear();
+	Collide_grid_oversized.clear();
+
+	for (auto& entry : Collide_grid_entries) {
+		entry.placed = false;
+		entry.oversized = false;
+	}
+}
+
+void collide_grid_update_and_collide(const SCP_vector<int>& colliders)
+{
+	{
+		TRACE_SCOPE(tracing::CollisionGridUpdate);
+
+		for (auto objnum : colliders) {
+			grid_update_entry(objnum);
+		}
+	}
+
+	TRACE_SCOPE(tracing::FindOverlapColliders);
+
+	// The collision functions may create or remove colliders. Removing one moves another entry of the list so the pass
+	// works on copies of the lists and every entry is checked again before it is used.
+	Collide_grid_pass_colliders.assign(colliders.begin(), colliders.end());
+	Collide_grid_pass_oversized.assign(Collide_grid_oversized.begin(), Collide_grid_oversized.end());
+
+	for (auto objnum_a : Collide_grid_pass_colliders) {
+		auto& entry_a = Collide_grid_entries[objnum_a];
+
+		if (!entry_a.placed || entry_a.oversized) {
+			continue;
+		}
+
+		for (int x = entry_a.cell_min[0]; x <= entry_a.cell_max[0]; ++x) {
+			for (int y = entry_a.cell_min[1]; y <= entry_a.cell_max[1]; ++y) {
+				for (int z = entry_a.cell_min[2]; z <= entry_a.cell_max[2]; ++z) {
+					auto iter = Collide_grid_cells.find(grid_cell_key(x, y, z));
+
+					if (iter == Collide_grid_cells.end()) {
+						continue;
+					}
+
+					auto cell = &iter->second;
+					for (size_t j = 0; j < cell->size(); ++j) {
+						int objnum_b = (*cell)[j];
+
+						// Every pair is only handled by the object with the lower index...
+						if (objnum_b <= objnum_a) {
+							continue;
+						}
+
+						auto& entry_b = Collide_grid_entries[objnum_b];
+
+						// ...and only in the first cell both objects share
+						if (x != MAX(entry_a.cell_min[0], entry_b.cell_min[0])
+							|| y != MAX(entry_a.cell_min[1], entry_b.cell_min[1])
+							|| z != MAX(entry_a.cell_min[2], entry_b.cell_min[2])) {
+							continue;
+						}
+
+						if (!grid_entries_overlap(entry_a, entry_b)) {
+							continue;
+						}
+
+						obj_collide_candidate_pair(&Objects[objnum_a], &Objects[objnum_b]);
+
+						// The collision may have invalidated the cell
+						iter = Collide_grid_cells.find(grid_cell_key(x, y, z));
+						if (iter == Collide_grid_cells.end()) {
+							break;
+						}
+						cell = &iter->second;
+					}
+				}
+			}
+		}
+	}
+
+	for (auto objnum_a : Collide_grid_pass_oversized) {
+		auto& entry_a = Collide_grid_entries[objnum_a];
+
+		for (auto objnum_b : Collide_grid_pass_colliders) {
+			// The collision of the previous pair may have removed either object
+			if (!entry_a.placed || !entry_a.oversized) {
+				break;
+			}
+
+			auto& entry_b = Collide_grid_entries[objnum_b];
+
+			if (objnum_b == objnum_a || !entry_b.placed) {
+				continue;
+			}
+
+			// Pairs of two oversized objects are only handled once
+			if (entry_b.oversized && objnum_b < objnum_a) {
+				continue;
+			}
+
+			if (!grid_entries_overlap(entry_a, entry_b)) {
+				continue;
+			}
+
+			obj_collide_candidate_pair(&Objects[objnum_a], &Objects[objnum_b]);
+		}
+	}
+}
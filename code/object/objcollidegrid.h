@@ -0,0 +1,40 @@
+#ifndef _OBJCOLLIDEGRID_H
+#define _OBJCOLLIDEGRID_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+/** @file
+ *  Loose uniform grid broadphase for the object collision system.
+ *
+ *  This is an alternative to the sort-and-sweep in obj_sort_and_collide(). Instead of re-sorting all colliders on
+ *  every frame, every collider is kept in the cells of a uniform grid which are only updated when the bounding box of
+ *  the object moves into a different range of cells. Objects which are too large for the grid (mostly beams and big
+ *  capital ships) are kept in a separate list and are tested against everything else.
+ */
+
+/**
+ * @brief Adds an object to the collision grid
+ * @param objnum The index of the object in Objects
+ */
+void collide_grid_add(int objnum);
+
+/**
+ * @brief Removes an object from the collision grid
+ * @param objnum The index of the object in Objects
+ */
+void collide_grid_remove(int objnum);
+
+/**
+ * @brief Removes all objects from the collision grid
+ */
+void collide_grid_reset();
+
+/**
+ * @brief Updates the cells of all objects in the grid and passes every overlapping pair to obj_collide_candidate_pair()
+ *
+ * @param colliders The objects to check, in the order in which their pairs should be processed
+ */
+void collide_grid_update_and_collide(const SCP_vector<int>& colliders);
+
+#endif // _OBJCOLLIDEGRID_H
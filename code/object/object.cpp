@@ -11,6 +11,7 @@
 
 
 #include "asteroid/asteroid.h"
+#include "cmdline/cmdline.h"
 #include "cmeasure/cmeasure.h"
 #include "debris/debris.h"
 #include "debugconsole/console.h"
@@ -30,7 +31,9 @@
 #include "object/objectdock.h"
 #include "object/objectshield.h"
 #include "object/objectsnd.h"
+#include "object/objectspatial.h"
 #include "observer/observer.h"
+#include "physics/physics_batch.h"
 #include "scripting/scripting.h"
 #include "playerman/player.h"
 #include "radar/radar.h"
@@ -75,6 +78,20 @@ int Object_next_signature = 1;	//0 is bogus, start at 1
 int Object_inited = 0;
 int Show_waypoints = 0;
 
+// The objects in obj_used_list, one array per object type in the order of obj_used_list. Freed objects are replaced by
+// -1 and removed when the next objects are merged into obj_used_list. Obj_type_list_pos is the position of an object in
+// the array of Obj_type_list_type or -1 if the object is not in obj_used_list. Obj_used_list_order increases along
+// obj_used_list so the arrays of several types can be merged into the order of obj_used_list. An object which changes
+// its type is removed from its array right away and added to the array of its new type by the next merge, it is kept in
+// Obj_type_list_retyped until then.
+static SCP_vector<int> Obj_type_lists[MAX_OBJECT_TYPES];
+static SCP_vector<std::pair<int, int>> Obj_type_list_retyped;
+static int Obj_type_list_holes[MAX_OBJECT_TYPES];
+static int Obj_type_list_type[MAX_OBJECTS];
+static int Obj_type_list_pos[MAX_OBJECTS];
+static uint Obj_used_list_order[MAX_OBJECTS];
+static uint Obj_next_used_list_order = 0;
+
 //WMC - Made these prettier
 const char *Object_type_names[MAX_OBJECT_TYPES] = {
 //XSTR:OFF
@@ -157,6 +174,87 @@ void object::clear()
 	dock_free_dead_dock_list(this);
 }
 
+static void obj_type_list_add(int objnum)
+{
+	Assertion(Obj_type_list_pos[objnum] < 0, "Object %d was added to the type lists twice!", objnum);
+
+	int type = Objects[objnum].type;
+	Assertion(type >= 0 && type < MAX_OBJECT_TYPES, "Object %d has invalid type %d!", objnum, type);
+
+	auto& list = Obj_type_lists[type];
+
+	// Newly merged objects go to the end, only an object which changed its type has to be inserted in the middle
+	auto order = Obj_used_list_order[objnum];
+	auto pos = list.size();
+	while (pos > 0 && (list[pos - 1] < 0 || Obj_used_list_order[list[pos - 1]] > order)) {
+		--pos;
+	}
+
+	list.insert(list.begin() + pos, objnum);
+
+	Obj_type_list_type[objnum] = type;
+	for (auto i = pos; i < list.size(); ++i) {
+		if (list[i] >= 0) {
+			Obj_type_list_pos[list[i]] = (int) i;
+		}
+	}
+}
+
+static void obj_type_list_remove(int objnum)
+{
+	int pos = Obj_type_list_pos[objnum];
+
+	// Objects which are deleted before they are merged into the used list were never added
+	if (pos < 0) {
+		return;
+	}
+
+	auto type = Obj_type_list_type[objnum];
+	auto& list = Obj_type_lists[type];
+	Assert(list[pos] == objnum);
+
+	// Someone may be iterating the list so only mark the position as free
+	list[pos] = -1;
+	++Obj_type_list_holes[type];
+
+	Obj_type_list_pos[objnum] = -1;
+}
+
+// Removes the positions of the freed objects from the type lists
+static void obj_type_list_compact()
+{
+	for (int type = 0; type < MAX_OBJECT_TYPES; ++type) {
+		if (Obj_type_list_holes[type] == 0) {
+			continue;
+		}
+
+		auto& list = Obj_type_lists[type];
+		size_t used = 0;
+
+		for (auto objnum : list) {
+			if (objnum >= 0) {
+				Obj_type_list_pos[objnum] = (int) used;
+				list[used++] = objnum;
+			}
+		}
+
+		list.resize(used);
+		Obj_type_list_holes[type] = 0;
+	}
+}
+
+const SCP_vector<int>& obj_get_type_list(int type)
+{
+	Assertion(type >= 0 && type < MAX_OBJECT_TYPES, "Invalid object type %d!", type);
+
+	return Obj_type_lists[type];
+}
+
+uint obj_get_used_list_order(int objnum)
+{
+	return Obj_used_list_order[objnum];
+}
+
 /**
  * Scan the object list, freeing down to num_used objects
  *
@@ -165,107 +263,82 @@ void object::clear()
  */
 int free_object_slots(int num_used)
 {
-	int	i, olind, deleted_weapons;
-	int	obj_list[MAX_OBJECTS];
+	int	num_candidates, deleted_weapons;
 	int	num_already_free, num_to_free, original_num_to_free;
-	object *objp;
-
-	olind = 0;
 
-	// calc num_already_free by walking the obj_free_list
-	num_already_free = 0;
-	for ( objp = GET_FIRST(&obj_free_list); objp != END_OF_LIST(&obj_free_list); objp = GET_NEXT(objp) )
-		num_already_free++;
+	// every slot which is not counted in Num_objects is in obj_free_list
+	num_already_free = MAX_OBJECTS - Num_objects;
 
 	if (MAX_OBJECTS - num_already_free < num_used)
 		return 0;
 
-	for ( objp = GET_FIRST(&obj_used_list); objp != END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp) ) {
-		if (objp->flags[Object::Object_Flags::Should_be_dead]) {
-			num_already_free++;
-			if (MAX_OBJECTS - num_already_free < num_used)
-				return num_already_free;
-		} else
-			switch (objp->type) {
-				case OBJ_NONE:
-					num_already_free++;
-					if (MAX_OBJECTS - num_already_free < num_used)
-						return 0;
-					break;
-				case OBJ_FIREBALL:
-				case OBJ_WEAPON:
-				case OBJ_DEBRIS:
-//				case OBJ_CMEASURE:
-					obj_list[olind++] = OBJ_INDEX(objp);
-					break;
+	num_candidates = 0;
 
-				case OBJ_GHOST:
-				case OBJ_SHIP:
-				case OBJ_START:
-				case OBJ_WAYPOINT:
-				case OBJ_POINT:
-				case OBJ_SHOCKWAVE:
-				case OBJ_WING:
-				case OBJ_OBSERVER:
-				case OBJ_ASTEROID:
-				case OBJ_JUMP_NODE:				
-				case OBJ_BEAM:
-					break;
-				default:
-					Int3();	//	Hey, what kind of object is this?  Unknown!
-					break;
-			}
+	for (int type = 0; type < MAX_OBJECT_TYPES; type++) {
+		for (auto objnum : obj_get_type_list(type)) {
+			if (objnum < 0)
+				continue;
 
+			if (Objects[objnum].flags[Object::Object_Flags::Should_be_dead] || (type == OBJ_NONE)) {
+				num_already_free++;
+			} else if ((type == OBJ_FIREBALL) || (type == OBJ_WEAPON) || (type == OBJ_DEBRIS)) {
+				num_candidates++;
+			}
+		}
 	}
 
+	if (MAX_OBJECTS - num_already_free < num_used)
+		return num_already_free;
+
 	num_to_free = MAX_OBJECTS - num_used - num_already_free;
 	original_num_to_free = num_to_free;
 
-	if (num_to_free > olind) {
-		nprintf(("allender", "Warning: Asked to free %i objects, but can only free %i.\n", num_to_free, olind));
-		num_to_free = olind;
+	if (num_to_free > num_candidates) {
+		nprintf(("allender", "Warning: Asked to free %i objects, but can only free %i.\n", num_to_free, num_candidates));
 	}
 
-	for (i=0; i<num_to_free; i++)
-		if ( (Objects[obj_list[i]].type == OBJ_DEBRIS) && (Debris[Objects[obj_list[i]].instance].flags & DEBRIS_EXPIRE) ) {
+	// expired debris goes first, then fireballs which are only eye candy, then weapons
+	for (auto objnum : obj_get_type_list(OBJ_DEBRIS)) {
+		if (num_to_free <= 0)
+			return original_num_to_free;
+
+		if ( (objnum >= 0) && !Objects[objnum].flags[Object::Object_Flags::Should_be_dead] && (Debris[Objects[objnum].instance].flags & DEBRIS_EXPIRE) ) {
 			num_to_free--;
-			nprintf(("allender", "Freeing   DEBRIS object %3i\n", obj_list[i]));
-			Objects[obj_list[i]].flags.set(Object::Object_Flags::Should_be_dead);
+			nprintf(("allender", "Freeing   DEBRIS object %3i\n", objnum));
+			Objects[objnum].flags.set(Object::Object_Flags::Should_be_dead);
 		}
+	}
 
-	if (!num_to_free)
-		return original_num_to_free;
+	for (auto objnum : obj_get_type_list(OBJ_FIREBALL)) {
+		if (num_to_free <= 0)
+			return original_num_to_free;
 
-	for (i=0; i<num_to_free; i++)	{
-		object *tmp_obj = &Objects[obj_list[i]];
-		if ( (tmp_obj->type == OBJ_FIREBALL) && (fireball_is_perishable(tmp_obj)) ) {
+		if ( (objnum >= 0) && !Objects[objnum].flags[Object::Object_Flags::Should_be_dead] && fireball_is_perishable(&Objects[objnum]) ) {
 			num_to_free--;
-			nprintf(("allender", "Freeing FIREBALL object %3i\n", obj_list[i]));
-			tmp_obj->flags.set(Object::Object_Flags::Should_be_dead);
+			nprintf(("allender", "Freeing FIREBALL object %3i\n", objnum));
+			Objects[objnum].flags.set(Object::Object_Flags::Should_be_dead);
 		}
 	}
 
-	if (!num_to_free){
+	if (num_to_free <= 0)
 		return original_num_to_free;
-	}
 
 	deleted_weapons = collide_remove_weapons();
 
 	num_to_free -= deleted_weapons;
-	if ( !num_to_free ){
-		return original_num_to_free;
-	}
 
-	for (i=0; i<num_to_free; i++){
-		if ( Objects[obj_list[i]].type == OBJ_WEAPON ) {
+	for (auto objnum : obj_get_type_list(OBJ_WEAPON)) {
+		if (num_to_free <= 0)
+			return original_num_to_free;
+
+		if ( (objnum >= 0) && !Objects[objnum].flags[Object::Object_Flags::Should_be_dead] ) {
 			num_to_free--;
-			Objects[obj_list[i]].flags.set(Object::Object_Flags::Should_be_dead);
+			Objects[objnum].flags.set(Object::Object_Flags::Should_be_dead);
 		}
 	}
 
-	if (!num_to_free){
+	if (num_to_free <= 0)
 		return original_num_to_free;
-	}
 
 	return original_num_to_free - num_to_free;
 }
@@ -348,11 +421,24 @@ void obj_init()
 		objp++;
 	}
 
+	for (i = 0; i < MAX_OBJECT_TYPES; ++i) {
+		Obj_type_lists[i].clear();
+		Obj_type_list_holes[i] = 0;
+	}
+	Obj_type_list_retyped.clear();
+	for (i = 0; i < MAX_OBJECTS; ++i) {
+		Obj_type_list_type[i] = OBJ_NONE;
+		Obj_type_list_pos[i] = -1;
+		Obj_used_list_order[i] = 0;
+	}
+	Obj_next_used_list_order = 0;
+
 	Object_next_signature = 1;	//0 is invalid, others start at 1
 	Num_objects = 0;
 	Highest_object_index = 0;
 
 	obj_reset_colliders();
+	obj_spatial_reset();
 }
 
 void obj_shutdown()
@@ -448,6 +534,7 @@ void obj_free(int objnum)
 
 	// remove objp from the used list
 	list_remove( &obj_used_list, objp );
+	obj_type_list_remove(objnum);
 
 	// add objp to the end of the free
 	list_append( &obj_free_list, objp );
@@ -565,6 +652,12 @@ void obj_delete(int objnum)
 		if ((objp == Player_obj) && !Fred_running) {
 			objp->type = OBJ_GHOST;
             objp->flags.remove(Object::Object_Flags::Should_be_dead);
+
+			// the object stays in the used list but it's not a ship anymore, the next merge adds it to the ghosts
+			if (Obj_type_list_pos[objnum] >= 0) {
+				obj_type_list_remove(objnum);
+				Obj_type_list_retyped.emplace_back(objnum, objp->signature);
+			}
 			
 			// we have to traverse the ship_obj list and remove this guy from it as well
 			ship_obj *moveup = GET_FIRST(&Ship_obj_list);
@@ -672,6 +765,18 @@ void obj_merge_created_list(void)
 	// The old way just merged the two.   This code takes one out of the create list,
 	// creates object pairs for it, and then adds it to the used list.
 	//	OLD WAY: list_merge( &obj_used_list, &obj_create_list );
+	obj_type_list_compact();
+
+	// Objects which changed their type since the last merge and were not freed since
+	for (auto& retyped : Obj_type_list_retyped) {
+		auto& retyped_obj = Objects[retyped.first];
+		if (retyped_obj.type != OBJ_NONE && retyped_obj.signature == retyped.second &&
+			Obj_type_list_pos[retyped.first] < 0) {
+			obj_type_list_add(retyped.first);
+		}
+	}
+	Obj_type_list_retyped.clear();
+
 	object *objp = GET_FIRST(&obj_create_list);
 	while( objp !=END_OF_LIST(&obj_create_list) )	{
 		list_remove( obj_create_list, objp );
@@ -681,6 +786,8 @@ void obj_merge_created_list(void)
 
 		// Then add it to the object used list
 		list_append( &obj_used_list, objp );
+		Obj_used_list_order[OBJ_INDEX(objp)] = Obj_next_used_list_order++;
+		obj_type_list_add(OBJ_INDEX(objp));
 
 		objp = GET_FIRST(&obj_create_list);
 	}
@@ -793,12 +900,13 @@ void obj_player_fire_stuff( object *objp, control_info ci )
 	
 }
 
-void obj_move_call_physics(object *objp, float frametime)
+/**
+ * Everything obj_move_call_physics() does before the object is simulated
+ *
+ * @return true if physics_sim() needs to be called for the object
+ */
+static bool obj_physics_prepare(object *objp, float frametime)
 {
-	TRACE_SCOPE(tracing::Physics);
-
-	int has_fired = -1;	//stop fireing stuff-Bobboau
-
 	//	Do physics for objects with OF_PHYSICS flag set and with some engine strength remaining.
 	if ( objp->flags[Object::Object_Flags::Physics] ) {
 		// only set phys info if ship is not dead
@@ -869,9 +977,7 @@ void obj_move_call_physics(object *objp, float frametime)
 		}
 
 		if (physics_paused)	{
-			if (objp==Player_obj){
-				physics_sim(&objp->pos, &objp->orient, &objp->phys_info, frametime );		// simulate the physics
-			}
+			return objp == Player_obj;
 		} else {
 			//	Hack for dock mode.
 			//	If docking with a ship, we don't obey the normal ship physics, we can slew about.
@@ -902,15 +1008,28 @@ void obj_move_call_physics(object *objp, float frametime)
 			// then reset the flag and don't move the object.
             if (MULTIPLAYER_MASTER && (objp->flags[Object::Object_Flags::Just_updated])) {
 				objp->flags.remove(Object::Object_Flags::Just_updated);
-				goto obj_maybe_fire;
+				return false;
 			}
 
-				physics_sim(&objp->pos, &objp->orient, &objp->phys_info, frametime );		// simulate the physics
+			return true;
+		}
+	}
+
+	return false;
+}
 
+/**
+ * Everything obj_move_call_physics() does after the object was simulated
+ */
+static void obj_physics_finish(object *objp)
+{
+	int has_fired = -1;	//stop fireing stuff-Bobboau
+
+	if ( objp->flags[Object::Object_Flags::Physics] ) {
+		if (!physics_paused) {
 			// if the object is the player object, do things that need to be done after the ship
 			// is moved (like firing weapons, etc).  This routine will get called either single
 			// or multiplayer.  We must find the player object to get to the control info field
-obj_maybe_fire:
 			if ( (objp->flags[Object::Object_Flags::Player_ship]) && (objp->type != OBJ_OBSERVER) && (objp == Player_obj)) {
 				player *pp;
 				if(Player != NULL){
@@ -955,6 +1074,17 @@ obj_maybe_fire:
 	}
 }
 
+void obj_move_call_physics(object *objp, float frametime)
+{
+	TRACE_SCOPE(tracing::Physics);
+
+	if (obj_physics_prepare(objp, frametime)) {
+		physics_sim(&objp->pos, &objp->orient, &objp->phys_info, frametime );		// simulate the physics
+	}
+
+	obj_physics_finish(objp);
+}
+
 
 #define IMPORTANT_FLAGS (OF_COLLIDES)
 
@@ -1401,6 +1531,80 @@ int Collisions_enabled = 1;
 DCF_BOOL( collisions, Collisions_enabled )
 
 MONITOR( NumObjects )
+MONITOR( NumBatchedPhysics )
+
+// Used by obj_move_all() with -batch_physics. The objects are moved in two passes. The first one does everything up to
+// the physics simulation for all objects, which includes the AI and the controls that set the desired velocities. The
+// physics of all objects which can be batched are then simulated together and the second pass does everything after
+// the simulation, in the order of obj_used_list like the first one.
+struct obj_batched_move {
+	int objnum;
+	int signature;
+	bool physics;		// obj_physics_finish() needs to be called for the object
+	bool batched;		// the physics of the object are simulated in the batch
+};
+
+static physics_batch Obj_physics_batch;
+static SCP_vector<obj_batched_move> Obj_batched_moves;
+
+// Checks if the physics of an object which passed obj_physics_prepare() can be simulated in the batch
+static bool obj_batch_physics_supported(object *objp)
+{
+	// The player's controls and docked objects are handled by the normal path
+	if ((objp == Player_obj) || (objp->type == OBJ_OBSERVER) || object_is_docked(objp)) {
+		return false;
+	}
+
+	return physics_batch_supported(&objp->phys_info);
+}
+
+// Simulates the physics of all objects collected by the first pass of obj_move_all()
+static void obj_batch_physics_sim(float frametime)
+{
+	TRACE_SCOPE(tracing::Physics);
+
+	int count = 0;
+
+	// The state is read here and not in the first pass since moving later objects may still have changed it
+	for (auto& move : Obj_batched_moves) {
+		auto objp = &Objects[move.objnum];
+
+		// an object may have been deleted right away while moving another one
+		if (move.batched && (objp->signature == move.signature)) {
+			physics_batch_add(&Obj_physics_batch, &objp->pos, &objp->orient, &objp->phys_info);
+			++count;
+		}
+	}
+
+	physics_batch_sim(&Obj_physics_batch, frametime);
+	physics_batch_clear(&Obj_physics_batch);
+
+	MONITOR_INC( NumBatchedPhysics, count );
+}
+
+// Everything obj_move_all() does for an object after it was moved
+static void obj_move_finish(object *objp, float frametime)
+{
+	// move post
+	obj_move_all_post(objp, frametime);
+
+	// Equipment script processing
+	if (objp->type == OBJ_SHIP) {
+		ship* shipp = &Ships[objp->instance];
+		object* target;
+
+		if (Ai_info[shipp->ai_index].target_objnum != -1)
+			target = &Objects[Ai_info[shipp->ai_index].target_objnum];
+		else
+			target = NULL;
+		if (objp == Player_obj && Player_ai->target_objnum != -1)
+			target = &Objects[Player_ai->target_objnum];
+
+		Script_system.SetHookObjects(2, "User", objp, "Target", target);
+		Script_system.RunCondition(CHA_ONWPEQUIPPED, objp);
+	}
+	Script_system.RemHookVars(2, "User", "Target");
+}
 
 /**
  * Move all objects for the current frame
@@ -1412,6 +1616,8 @@ void obj_move_all(float frametime)
 	object *objp;	
 	SCP_vector<object*> cmeasure_list;
 	const bool global_cmeasure_timer = (Cmeasures_homing_check > 0);
+	// The paused physics only move the player so there is nothing to batch
+	const bool batch_physics = Cmdline_batch_physics && !physics_paused;
 
 	Assertion(Cmeasures_homing_check >= 0, "Cmeasures_homing_check is %d in obj_move_all(); it should never be negative. Get a coder!\n", Cmeasures_homing_check);
 
@@ -1432,6 +1638,12 @@ void obj_move_all(float frametime)
 
 	MONITOR_INC( NumObjects, Num_objects );	
 
+	obj_spatial_build(frametime);
+
+	ai_enemy_search_all();
+
+	Obj_batched_moves.clear();
+
 	for (objp = GET_FIRST(&obj_used_list); objp != END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp)) {
 		// skip objects which should be dead
 		if (objp->flags[Object::Object_Flags::Should_be_dead]) {
@@ -1474,36 +1686,57 @@ void obj_move_all(float frametime)
 		objp->last_pos = cur_pos;
 		objp->last_orient = objp->orient;
 
+		bool physics_pending = false;
+		bool physics_batched = false;
+
 		// Goober5000 - skip objects which don't move, but only until they're destroyed
 		if (!(objp->flags[Object::Object_Flags::Immobile] && objp->hull_strength > 0.0f)) {
 			// if this is an object which should be interpolated in multiplayer, do so
 			if (multi_oo_is_interp_object(objp)) {
 				multi_oo_interp(objp);
+			} else if (batch_physics) {
+				TRACE_SCOPE(tracing::Physics);
+
+				// the batch and obj_physics_finish() run once all objects went through the first pass
+				if (obj_physics_prepare(objp, frametime)) {
+					if (obj_batch_physics_supported(objp)) {
+						physics_batched = true;
+					} else {
+						physics_sim(&objp->pos, &objp->orient, &objp->phys_info, frametime );
+					}
+				}
+				physics_pending = true;
 			} else {
 				// physics
 				obj_move_call_physics(objp, frametime);
 			}
 		}
 
-		// move post
-		obj_move_all_post(objp, frametime);
+		if (batch_physics) {
+			Obj_batched_moves.push_back({ OBJ_INDEX(objp), objp->signature, physics_pending, physics_batched });
+			continue;
+		}
+
+		obj_move_finish(objp, frametime);
+	}
 
-		// Equipment script processing
-		if (objp->type == OBJ_SHIP) {
-			ship* shipp = &Ships[objp->instance];
-			object* target;
+	if (batch_physics) {
+		obj_batch_physics_sim(frametime);
 
-			if (Ai_info[shipp->ai_index].target_objnum != -1)
-				target = &Objects[Ai_info[shipp->ai_index].target_objnum];
-			else
-				target = NULL;
-			if (objp == Player_obj && Player_ai->target_objnum != -1)
-				target = &Objects[Player_ai->target_objnum];
+		for (auto& move : Obj_batched_moves) {
+			objp = &Objects[move.objnum];
 
-			Script_system.SetHookObjects(2, "User", objp, "Target", target);
-			Script_system.RunCondition(CHA_ONWPEQUIPPED, objp);
+			// an object may have been deleted right away while moving another one
+			if (objp->signature != move.signature) {
+				continue;
+			}
+
+			if (move.physics) {
+				obj_physics_finish(objp);
+			}
+
+			obj_move_finish(objp, frametime);
 		}
-		Script_system.RemHookVars(2, "User", "Target");
 	}
 
 	// Now that we've moved all the objects, move all the models that use intrinsic rotations.  We do that here because we already handled the
@@ -1553,6 +1786,8 @@ void obj_move_all(float frametime)
 		objp = GET_NEXT(objp);
 	}
 
+	ai_enemy_search_clear();
+
 	if (!cmeasure_list.empty())
 		find_homing_object_cmeasures(cmeasure_list);	//	If any cmeasures are active, maybe steer away homing missiles
 
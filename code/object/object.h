@@ -20,6 +20,7 @@
 #include "utils/event.h"
 
 #include <functional>
+#include <initializer_list>
 
 /*
  *		CONSTANTS
@@ -251,6 +252,61 @@ void obj_delete_all();
 // should only be used by the editor!
 void obj_merge_created_list(void);
 
+// Returns the indices of all objects of the given type in obj_used_list, in the order of obj_used_list. Objects which
+// are flagged as Should_be_dead are included. Objects which were freed since the last obj_merge_created_list() are -1.
+// The array only grows in obj_merge_created_list() so it may be iterated while objects are created or freed. An object
+// which changes its type (a player ship becoming a ghost) is listed under its new type after the next merge.
+const SCP_vector<int>& obj_get_type_list(int type);
+
+// Returns a number which increases along obj_used_list, only valid for objects in obj_used_list
+uint obj_get_used_list_order(int objnum);
+
+// Calls func for all objects of the given types in the order of obj_used_list. Same as walking obj_used_list and
+// skipping the other types, but only touches the objects of these types.
+template <typename Func>
+void obj_for_each_of_types(std::initializer_list<int> types, Func func)
+{
+	const int MAX_LISTS = 4;
+	const SCP_vector<int>* lists[MAX_LISTS];
+	size_t pos[MAX_LISTS];
+	int num_lists = 0;
+
+	for (auto type : types) {
+		Assertion(num_lists < MAX_LISTS, "Too many object types for obj_for_each_of_types()!");
+		lists[num_lists] = &obj_get_type_list(type);
+		pos[num_lists] = 0;
+		++num_lists;
+	}
+
+	for (;;) {
+		// func may free objects so the next object of every list has to be looked up again
+		int best = -1;
+		uint best_order = 0;
+
+		for (int i = 0; i < num_lists; ++i) {
+			auto& list = *lists[i];
+
+			while (pos[i] < list.size() && list[pos[i]] < 0) {
+				++pos[i];
+			}
+
+			if (pos[i] < list.size()) {
+				auto order = obj_get_used_list_order(list[pos[i]]);
+				if (best < 0 || order < best_order) {
+					best = i;
+					best_order = order;
+				}
+			}
+		}
+
+		if (best < 0) {
+			return;
+		}
+
+		func(&Objects[(*lists[best])[pos[best]++]]);
+	}
+}
+
 // recalculate object pairs for an object
 #define OBJ_RECALC_PAIRS(obj_to_reset)		do {	obj_set_flags(obj_to_reset, obj_to_reset->flags - Object::Object_Flags::Collides); obj_set_flags(obj_to_reset, obj_to_reset->flags + Object::Object_Flags::Collides); } while(0);
 
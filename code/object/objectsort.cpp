@@ -358,12 +358,14 @@ void obj_render_queue_all()
 			}
 
 
+            objp->flags.set(Object::Object_Flags::Was_rendered);
+
+			// ships with an active shader effect are drawn separately after the scene
 			if ( (objp->type == OBJ_SHIP) && Ships[objp->instance].shader_effect_active ) {
 				effect_ships.push_back(objp);
 				continue;
 			}
 
-            objp->flags.set(Object::Object_Flags::Was_rendered);
 			obj_queue_render(objp, &scene);
 		}
 	}
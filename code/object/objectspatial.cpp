@@ -0,0 +1,357 @@
+#include "object/objectspatial.h"
+#include "globalincs/linklist.h"
+#include "iff_defs/iff_defs.h"
+#include "model/model.h"
+#include "object/object.h"
+#include "ship/ship.h"
+#include "tracing/tracing.h"
+#include "weapon/weapon.h"
+
+#include <algorithm>
+
+// Objects which reach farther than this are not put into the sorted lists since they would make every query
+// window wider. They are checked one by one instead.
+#define SPATIAL_LARGE_REACH		500.0f
+
+namespace {
+
+struct spatial_entry {
+	vec3d pos;
+	float reach;		// radius of the object plus the distance it may move while the index is used
+	int objnum;
+	int signature;
+	int order;			// position of the object in its object list
+};
+
+struct spatial_bucket {
+	SCP_vector<spatial_entry> sorted;	// sorted by pos.x
+	float max_reach = 0.0f;				// maximum reach of all entries in sorted
+	SCP_vector<spatial_entry> large;
+};
+
+struct spatial_set {
+	spatial_bucket teams[MAX_IFFS];
+	SCP_vector<spatial_entry> unsorted;	// objects created or changing their team after the index was built or without a valid team
+	int next_order = 0;
+};
+
+bool Spatial_valid = false;
+spatial_set Spatial_sets[2];
+
+// The signature of the object when it was added to the index, 0 if the object is not in the index
+int Spatial_signatures[MAX_OBJECTS];
+
+thread_local SCP_vector<std::pair<int, int>> Spatial_hits;
+
+spatial_set& get_set(ObjSpatialSet set)
+{
+	return Spatial_sets[set == ObjSpatialSet::Ships ? 0 : 1];
+}
+
+int object_type_of_set(ObjSpatialSet set)
+{
+	return set == ObjSpatialSet::Ships ? OBJ_SHIP : OBJ_WEAPON;
+}
+
+int object_team(object *objp)
+{
+	return objp->type == OBJ_SHIP ? Ships[objp->instance].team : Weapons[objp->instance].team;
+}
+
+// Distance from the center of the object to the farthest point a query may measure to
+float object_reach(object *objp)
+{
+	float reach = objp->radius;
+
+	if (objp->type == OBJ_SHIP) {
+		// The AI measures the distance to big ships from their bounding box whose corners may be outside of the radius
+		auto pm = model_get(Ship_info[Ships[objp->instance].ship_info_index].model_num);
+		vec3d corner;
+
+		corner.xyz.x = MAX(fl_abs(pm->mins.xyz.x), fl_abs(pm->maxs.xyz.x));
+		corner.xyz.y = MAX(fl_abs(pm->mins.xyz.y), fl_abs(pm->maxs.xyz.y));
+		corner.xyz.z = MAX(fl_abs(pm->mins.xyz.z), fl_abs(pm->maxs.xyz.z));
+
+		reach = MAX(reach, vm_vec_mag(&corner));
+	}
+
+	return reach;
+}
+
+// Upper bound for the speed of the object during the next frame
+float object_max_speed(object *objp)
+{
+	float speed = MAX(vm_vec_mag(&objp->phys_info.vel), vm_vec_mag(&objp->phys_info.max_vel));
+
+	if (objp->type == OBJ_SHIP) {
+		speed = MAX(speed, vm_vec_mag(&objp->phys_info.afterburner_max_vel));
+	}
+
+	return speed;
+}
+
+bool entry_is_valid(const spatial_entry& entry, int type)
+{
+	auto objp = &Objects[entry.objnum];
+
+	return objp->signature == entry.signature && objp->type == type;
+}
+
+bool entry_in_range(const spatial_entry& entry, const vec3d *pos, float range, float reach_scale)
+{
+	float max_dist = range + entry.reach * reach_scale;
+
+	return vm_vec_dist_squared(pos, &entry.pos) <= max_dist * max_dist;
+}
+
+void add_entry(spatial_set& set, int objnum, float frametime)
+{
+	auto objp = &Objects[objnum];
+
+	spatial_entry entry;
+	entry.pos = objp->pos;
+	// The index is used for the frame it was built in and possibly by a few queries before the next one is built so
+	// leave room for two frames of movement
+	entry.reach = object_reach(objp) + object_max_speed(objp) * frametime * 2.0f;
+	entry.objnum = objnum;
+	entry.signature = objp->signature;
+	entry.order = set.next_order++;
+
+	Spatial_signatures[objnum] = objp->signature;
+
+	int team = object_team(objp);
+	if (team < 0 || team >= Num_iffs) {
+		set.unsorted.push_back(entry);
+		return;
+	}
+
+	auto& bucket = set.teams[team];
+	if (entry.reach > SPATIAL_LARGE_REACH) {
+		bucket.large.push_back(entry);
+	} else {
+		bucket.sorted.push_back(entry);
+		bucket.max_reach = MAX(bucket.max_reach, entry.reach);
+	}
+}
+
+void query_bucket(const spatial_bucket& bucket, int type, const vec3d *pos, float range, float reach_scale, SCP_vector<std::pair<int, int>>& hits)
+{
+	float min_x = pos->xyz.x - range - bucket.max_reach * reach_scale;
+	float max_x = pos->xyz.x + range + bucket.max_reach * reach_scale;
+
+	auto iter = std::lower_bound(bucket.sorted.begin(), bucket.sorted.end(), min_x,
+		[](const spatial_entry& entry, float x) { return entry.pos.xyz.x < x; });
+
+	for (; iter != bucket.sorted.end() && iter->pos.xyz.x <= max_x; ++iter) {
+		if (entry_in_range(*iter, pos, range, reach_scale) && entry_is_valid(*iter, type)) {
+			hits.emplace_back(iter->order, iter->objnum);
+		}
+	}
+
+	for (auto& entry : bucket.large) {
+		if (entry_in_range(entry, pos, range, reach_scale) && entry_is_valid(entry, type)) {
+			hits.emplace_back(entry.order, entry.objnum);
+		}
+	}
+}
+
+// Checks an object which is not in the index at its current position
+bool object_in_range(object *objp, const vec3d *pos, float range, int team_mask, float reach_scale)
+{
+	int team = object_team(objp);
+	if (team_mask != -1 && (team < 0 || !iff_matches_mask(team, team_mask))) {
+		return false;
+	}
+
+	float max_dist = range + object_reach(objp) * reach_scale;
+
+	return vm_vec_dist_squared(pos, &objp->pos) <= max_dist * max_dist;
+}
+
+// Used when there is no index, e.g. before the first frame of a mission
+void scan_object_list(ObjSpatialSet set, const vec3d *pos, float range, int team_mask, float reach_scale, SCP_vector<int>& objnums)
+{
+	if (set == ObjSpatialSet::Ships) {
+		for (auto so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so)) {
+			if (object_in_range(&Objects[so->objnum], pos, range, team_mask, reach_scale)) {
+				objnums.push_back(so->objnum);
+			}
+		}
+	} else {
+		for (auto mo = GET_FIRST(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo)) {
+			if (object_in_range(&Objects[mo->objnum], pos, range, team_mask, reach_scale)) {
+				objnums.push_back(mo->objnum);
+			}
+		}
+	}
+}
+
+}
+
+void obj_spatial_build(float frametime)
+{
+	TRACE_SCOPE(tracing::SpatialIndexBuild);
+
+	obj_spatial_reset();
+
+	auto& ships = get_set(ObjSpatialSet::Ships);
+	for (auto so = GET_FIRST(&Ship_obj_list); so != END_OF_LIST(&Ship_obj_list); so = GET_NEXT(so)) {
+		add_entry(ships, so->objnum, frametime);
+	}
+
+	auto& missiles = get_set(ObjSpatialSet::Missiles);
+	for (auto mo = GET_FIRST(&Missile_obj_list); mo != END_OF_LIST(&Missile_obj_list); mo = GET_NEXT(mo)) {
+		add_entry(missiles, mo->objnum, frametime);
+	}
+
+	for (auto& set : Spatial_sets) {
+		for (auto& bucket : set.teams) {
+			std::sort(bucket.sorted.begin(), bucket.sorted.end(),
+				[](const spatial_entry& a, const spatial_entry& b) { return a.pos.xyz.x < b.pos.xyz.x; });
+		}
+	}
+
+	Spatial_valid = true;
+}
+
+void obj_spatial_reset()
+{
+	for (auto& set : Spatial_sets) {
+		for (auto& bucket : set.teams) {
+			for (auto& entry : bucket.sorted) {
+				Spatial_signatures[entry.objnum] = 0;
+			}
+			for (auto& entry : bucket.large) {
+				Spatial_signatures[entry.objnum] = 0;
+			}
+
+			bucket.sorted.clear();
+			bucket.large.clear();
+			bucket.max_reach = 0.0f;
+		}
+
+		for (auto& entry : set.unsorted) {
+			Spatial_signatures[entry.objnum] = 0;
+		}
+
+		set.unsorted.clear();
+		set.next_order = 0;
+	}
+
+	Spatial_valid = false;
+}
+
+void obj_spatial_add(int objnum)
+{
+	Assert(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	if (!Spatial_valid) {
+		return;
+	}
+
+	auto objp = &Objects[objnum];
+
+	// The list rebuild functions add objects again which are already in the index
+	if (Spatial_signatures[objnum] == objp->signature) {
+		return;
+	}
+
+	auto& set = get_set(objp->type == OBJ_SHIP ? ObjSpatialSet::Ships : ObjSpatialSet::Missiles);
+
+	// The team and position of a new object are usually not set up yet so these entries are checked when they are
+	// queried
+	spatial_entry entry;
+	entry.objnum = objnum;
+	entry.signature = objp->signature;
+	entry.order = set.next_order++;
+	set.unsorted.push_back(entry);
+
+	Spatial_signatures[objnum] = objp->signature;
+}
+
+void obj_spatial_team_changed(int objnum)
+{
+	Assert(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	auto objp = &Objects[objnum];
+
+	if (!Spatial_valid || Spatial_signatures[objnum] != objp->signature) {
+		return;
+	}
+
+	auto& set = get_set(objp->type == OBJ_SHIP ? ObjSpatialSet::Ships : ObjSpatialSet::Missiles);
+	auto is_object = [objnum](const spatial_entry& entry) { return entry.objnum == objnum; };
+
+	// The entry is still in the bucket of the old team. Entries in unsorted already check the team at query time.
+	for (auto& bucket : set.teams) {
+		for (auto list : { &bucket.sorted, &bucket.large }) {
+			auto iter = std::find_if(list->begin(), list->end(), is_object);
+
+			if (iter != list->end()) {
+				set.unsorted.push_back(*iter);
+				list->erase(iter);
+				return;
+			}
+		}
+	}
+}
+
+void obj_spatial_query_range(ObjSpatialSet set, const vec3d *pos, float range, int team_mask, SCP_vector<int>& objnums, float reach_scale)
+{
+	objnums.clear();
+
+	if (!Spatial_valid) {
+		scan_object_list(set, pos, range, team_mask, reach_scale, objnums);
+		return;
+	}
+
+	auto& index = get_set(set);
+	int type = object_type_of_set(set);
+	auto& hits = Spatial_hits;
+	hits.clear();
+
+	for (int team = 0; team < Num_iffs; ++team) {
+		if (team_mask == -1 || iff_matches_mask(team, team_mask)) {
+			query_bucket(index.teams[team], type, pos, range, reach_scale, hits);
+		}
+	}
+
+	for (auto& entry : index.unsorted) {
+		if (entry_is_valid(entry, type) && object_in_range(&Objects[entry.objnum], pos, range, team_mask, reach_scale)) {
+			hits.emplace_back(entry.order, entry.objnum);
+		}
+	}
+
+	// Keep the order of the object lists so that the results are the same as walking the list
+	std::sort(hits.begin(), hits.end());
+
+	objnums.reserve(hits.size());
+	for (auto& hit : hits) {
+		objnums.push_back(hit.second);
+	}
+}
+
+void obj_spatial_query_nearest(ObjSpatialSet set, const vec3d *pos, float range, int team_mask, size_t max_count, SCP_vector<int>& objnums)
+{
+	obj_spatial_query_range(set, pos, range, team_mask, objnums);
+
+	SCP_vector<std::pair<float, int>> nearest;
+	nearest.reserve(objnums.size());
+
+	for (auto objnum : objnums) {
+		auto objp = &Objects[objnum];
+		float dist = vm_vec_dist(pos, &objp->pos) - objp->radius;
+
+		if (dist <= range) {
+			nearest.emplace_back(dist, objnum);
+		}
+	}
+
+	auto count = std::min(max_count, nearest.size());
+	std::partial_sort(nearest.begin(), nearest.begin() + count, nearest.end());
+
+	objnums.clear();
+	for (size_t i = 0; i < count; ++i) {
+		objnums.push_back(nearest[i].second);
+	}
+}
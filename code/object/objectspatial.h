@@ -0,0 +1,83 @@
+#ifndef _OBJECTSPATIAL_H
+#define _OBJECTSPATIAL_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+/** @file
+ *  Spatial index of ships and missiles for proximity queries.
+ *
+ *  The AI needs to find nearby ships and missiles many times per frame. Instead of walking Ship_obj_list or
+ *  Missile_obj_list for every query, the positions of all ships and missiles are put into an index once per frame which
+ *  is split up by team and sorted along the x axis.
+ *
+ *  Objects keep moving after the index was built so every entry is padded by the distance the object can travel
+ *  during a frame. A query therefore returns a superset of the objects in range and the caller still has to do its own
+ *  distance checks. Objects created after the index was built or whose team changed since are always returned as
+ *  candidates.
+ *
+ *  The query functions only read the index and may be used from worker threads. Everything else is main thread only.
+ */
+
+/**
+ * @brief The object lists that are covered by the index
+ */
+enum class ObjSpatialSet {
+	Ships,		//!< The objects in Ship_obj_list
+	Missiles,	//!< The objects in Missile_obj_list
+};
+
+/**
+ * @brief Rebuilds the index from the current positions of all ships and missiles
+ * @param frametime The length of the frame during which the index will be used
+ */
+void obj_spatial_build(float frametime);
+
+/**
+ * @brief Discards the index. Queries fall back to walking the object lists until the next obj_spatial_build().
+ */
+void obj_spatial_reset();
+
+/**
+ * @brief Makes an object which was created after the last obj_spatial_build() visible to queries
+ * @param objnum The index of the new ship or missile in Objects
+ */
+void obj_spatial_add(int objnum);
+
+/**
+ * @brief Moves an object to the entries which are checked at query time after its team was changed
+ *
+ * The index is split up by team so this has to be called whenever the team of a ship or missile changes.
+ *
+ * @param objnum The index of the ship or missile in Objects
+ */
+void obj_spatial_team_changed(int objnum);
+
+/**
+ * @brief Finds the ships or missiles which may be within a given range of a point
+ *
+ * The range is measured to the edge of the objects. For ships, this includes the corners of their bounding box.
+ *
+ * @param set The objects to search
+ * @param pos The center of the query
+ * @param range The range of the query
+ * @param team_mask Only objects on a team matching this mask are returned. Use -1 to include all teams.
+ * @param[out] objnums The indices of the found objects, in the same order as in the object list
+ * @param reach_scale Scales the size of the objects, e.g. to make up for the error of vm_vec_dist_quick() when the caller
+ * 	measures the distance to the edge of an object with it.
+ */
+void obj_spatial_query_range(ObjSpatialSet set, const vec3d *pos, float range, int team_mask, SCP_vector<int>& objnums, float reach_scale = 1.0f);
+
+/**
+ * @brief Finds the objects which are closest to a point
+ *
+ * @param set The objects to search
+ * @param pos The center of the query
+ * @param range Objects farther away than this are not considered
+ * @param team_mask Only objects on a team matching this mask are returned. Use -1 to include all teams.
+ * @param max_count The maximum number of objects to return
+ * @param[out] objnums The indices of the found objects, nearest first
+ */
+void obj_spatial_query_nearest(ObjSpatialSet set, const vec3d *pos, float range, int team_mask, size_t max_count, SCP_vector<int>& objnums);
+
+#endif // _OBJECTSPATIAL_H
@@ -15,6 +15,8 @@
 #include <cstdarg>
 #include <cstring>
 #include <algorithm>
+#include <mutex>
+#include <thread>
 
 #ifdef WIN32
 #include <direct.h>
@@ -53,6 +55,24 @@ const char *FreeSpace_logfilename = NULL;
 
 std::unique_ptr<osapi::DebugWindow> debugWindow;
 
+// Worker threads log too (e.g. while bitmaps, tables and models are loaded in parallel) so outwnd_print() serializes
+// the access to the filters and the log file. It is recursive since outwnd_print() prints the missing filter warning
+// through itself.
+static std::recursive_mutex Outwnd_mutex;
+static std::thread::id Outwnd_main_thread;
+
+// The debug window is drawn by the main thread so the messages of worker threads wait here until the next frame
+static SCP_vector<std::pair<SCP_string, SCP_string>> Outwnd_pending_debug_messages;
+
+// Must be called by the main thread with Outwnd_mutex held
+static void outwnd_flush_pending_debug_messages()
+{
+	for (auto& message : Outwnd_pending_debug_messages) {
+		debugWindow->addDebugMessage(message.first.c_str(), message.second.c_str());
+	}
+	Outwnd_pending_debug_messages.clear();
+}
+
 void load_filter_info(void)
 {
 	FILE *fp = NULL;
@@ -188,6 +208,8 @@ void outwnd_print(const char *id, const char *tmp)
   	if ( !outwnd_inited )
   		return;
 
+	std::lock_guard<std::recursive_mutex> guard(Outwnd_mutex);
+
 	if (Outwnd_no_filter_file == 1) {
 		Outwnd_no_filter_file = 2;
 
@@ -225,7 +247,12 @@ void outwnd_print(const char *id, const char *tmp)
 	}
 
 	if (debugWindow) {
-		debugWindow->addDebugMessage(id, tmp);
+		if (std::this_thread::get_id() == Outwnd_main_thread) {
+			outwnd_flush_pending_debug_messages();
+			debugWindow->addDebugMessage(id, tmp);
+		} else {
+			Outwnd_pending_debug_messages.emplace_back(id, tmp);
+		}
 	}
 }
 
@@ -236,6 +263,8 @@ void outwnd_init()
 	if (outwnd_inited)
 		return;
 
+	Outwnd_main_thread = std::this_thread::get_id();
+
 	if (!running_unittests && Log_fp == NULL) {
 		char pathname[MAX_PATH_LEN];
 
@@ -279,6 +308,8 @@ void outwnd_init()
 
 void outwnd_close()
 {
+	std::lock_guard<std::recursive_mutex> guard(Outwnd_mutex);
+
 	if ( !running_unittests && Log_fp != NULL ) {
 		time_t timedate = time(NULL);
 		char datestr[50];
@@ -299,9 +330,17 @@ void outwnd_debug_window_init() {
 	debugWindow.reset(new osapi::DebugWindow());
 }
 void outwnd_debug_window_do_frame(float frametime) {
+	{
+		std::lock_guard<std::recursive_mutex> guard(Outwnd_mutex);
+		outwnd_flush_pending_debug_messages();
+	}
+
 	debugWindow->doFrame(frametime);
 }
 void outwnd_debug_window_deinit() {
+	std::lock_guard<std::recursive_mutex> guard(Outwnd_mutex);
+
+	Outwnd_pending_debug_messages.clear();
 	debugWindow.reset();
 }
 
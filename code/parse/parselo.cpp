@@ -15,7 +15,9 @@
 #include <csetjmp>
 
 #include <cctype>
+#include "debugconsole/console.h"
 #include "globalincs/version.h"
+#include "io/timer.h"
 #include "localization/fhash.h"
 #include "localization/localize.h"
 #include "mission/missionparse.h"
@@ -25,12 +27,19 @@
 #include "ship/ship.h"
 #include "weapon/weapon.h"
 #include "mod_table/mod_table.h"
+#include "tracing/tracing.h"
 
 #include "utils/encoding.h"
 #include "utils/unicode.h"
+#include "utils/WorkerPool.h"
 
 #include <utf8.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define PARSE_SCAN_SSE
+	#include <emmintrin.h>
+#endif
+
 
 #define	ERROR_LENGTH	64
 #define	RS_MAX_TRIES	5
@@ -41,23 +50,52 @@ bool	Parsing_modular_table = false;
 
 char		Current_filename[MAX_PATH_LEN];
 char		Current_filename_save[MAX_PATH_LEN];
-char		Current_filename_sub[MAX_PATH_LEN];	//Last attempted file to load, don't know if ex or not.
+thread_local char	Current_filename_sub[MAX_PATH_LEN];	//Last attempted file to load, don't know if ex or not.
 char		Error_str[ERROR_LENGTH];
 int		Warning_count, Error_count;
 int		Warning_count_save = 0, Error_count_save = 0;
 int		fred_parse_flag = 0;
 int		Token_found_flag;
 
-char 	*Parse_text = nullptr;
-char	*Parse_text_raw = nullptr;
+thread_local char	*Parse_text = nullptr;
+thread_local char	*Parse_text_raw = nullptr;
 char	*Mp = NULL, *Mp_save = NULL;
 const char	*token_found;
 
-static int Parsing_paused = 0;
+static thread_local int Parsing_paused = 0;
 
 // text allocation stuff
 void allocate_parse_text(size_t size);
-static size_t Parse_text_size = 0;
+static thread_local size_t Parse_text_size = 0;
+
+// Files which were read and preprocessed by parse_preload_files()
+struct preloaded_file {
+	SCP_string filename;
+	int mode;
+	bool valid = false;
+	SCP_string raw_text;
+	SCP_string processed_text;
+};
+
+static SCP_vector<preloaded_file> Preloaded_files;
+static SCP_unordered_map<SCP_string, size_t> Preloaded_file_index;
+
+// Set on the worker threads of parse_preload_files(). These must not report anything, files with errors or warnings
+// are left to the main thread which reads them again.
+static thread_local bool Parse_preloading = false;
+
+// Vectorized scanning of the text and the line index, see parse_set_fast_scan()
+static bool Parse_fast_scan = true;
+
+// Offsets of the first token of every line of the last processed text, i.e. where Mp ends up after
+// advance_to_eoln() and ignore_white_space(). Lets the skip_to_* functions jump from line to line.
+struct parse_line_index {
+	char *text = nullptr;
+	size_t length = 0;
+	SCP_vector<uint> line_starts;
+};
+
+static thread_local parse_line_index Parse_line_index;
 
 
 //	Return true if this character is white space, else false.
@@ -277,6 +315,7 @@ int get_line_num()
 //	!0 means it's an error message.
 //	Prints line number and other useful information.
 extern int Cmdline_noparseerrors;
+extern bool Cmdline_mt_parse;
 void error_display(int error_level, const char *format, ...)
 {
 	char type[8];
@@ -303,6 +342,133 @@ void error_display(int error_level, const char *format, ...)
 		Error(LOCATION, "%s(line %i):\n%s: %s", Current_filename, get_line_num(), type, error_text.c_str());
 }
 
+// Returns the number of characters at the start of [str, end) which are not one of the num_chars characters in chars
+// (at most 8 characters, may include '\0')
+static size_t scan_plain_chars(const char *str, const char *end, const char *chars, size_t num_chars)
+{
+	const char *p = str;
+
+	Assert(num_chars > 0 && num_chars <= 8);
+
+#ifdef PARSE_SCAN_SSE
+	if (Parse_fast_scan) {
+		__m128i sets[8];
+		for (size_t i = 0; i < num_chars; ++i)
+			sets[i] = _mm_set1_epi8(chars[i]);
+
+		while (end - p >= 16) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+			__m128i match = _mm_cmpeq_epi8(block, sets[0]);
+			for (size_t i = 1; i < num_chars; ++i)
+				match = _mm_or_si128(match, _mm_cmpeq_epi8(block, sets[i]));
+
+			int mask = _mm_movemask_epi8(match);
+			if (mask != 0) {
+				while (!(mask & 1)) {
+					mask >>= 1;
+					++p;
+				}
+				return (size_t)(p - str);
+			}
+
+			p += 16;
+		}
+	}
+#endif
+
+	while ((p < end) && (memchr(chars, *p, num_chars) == nullptr))
+		++p;
+
+	return (size_t)(p - str);
+}
+
+static size_t scan_plain_chars(const char *str, const char *end, const char *chars)
+{
+	return scan_plain_chars(str, end, chars, strlen(chars));
+}
+
+static void build_line_index(char *text)
+{
+	auto &index = Parse_line_index;
+
+	index.text = nullptr;
+	index.line_starts.clear();
+
+	if (!Parse_fast_scan)
+		return;
+
+	auto length = strlen(text);
+	const char *end = text + length;
+
+	// the offsets are stored as 32 bit values to keep the index small
+	if (length >= UINT_MAX)
+		return;
+
+	const char *p = text;
+	while (p < end) {
+		p += scan_plain_chars(p, end, "\n");
+		if (p == end)
+			break;
+
+		while ((p < end) && is_white_space(*p))
+			p++;
+
+		index.line_starts.push_back((uint)(p - text));
+	}
+
+	index.text = text;
+	index.length = length;
+}
+
+// Moves Mp to the first token of the next line like advance_to_eoln(NULL) followed by ignore_white_space() but uses
+// the line index if Mp points into the indexed text.
+class line_skipper {
+	const parse_line_index *_index = nullptr;
+	size_t _next = 0;
+
+ public:
+	line_skipper()
+	{
+		auto &index = Parse_line_index;
+
+		if (Parse_fast_scan && (index.text != nullptr) && (Mp >= index.text) && (Mp < index.text + index.length)) {
+			_index = &index;
+			auto offset = (uint)(Mp - index.text);
+			_next = std::upper_bound(index.line_starts.begin(), index.line_starts.end(), offset) - index.line_starts.begin();
+		}
+	}
+
+	void next()
+	{
+		if (_index != nullptr) {
+			char *target;
+			if (_next < _index->line_starts.size())
+				target = _index->text + _index->line_starts[_next++];
+			else
+				target = _index->text + _index->length;
+
+			// the text may have been replaced behind our back, in that case the index is useless
+			if ((target > Mp) && !is_white_space(*target) && is_white_space(target[-1])) {
+				Mp = target;
+				return;
+			}
+
+			_index = nullptr;
+			Parse_line_index.text = nullptr;
+		}
+
+		advance_to_eoln(NULL);
+		ignore_white_space();
+	}
+};
+
+void parse_set_fast_scan(bool enable)
+{
+	Parse_fast_scan = enable;
+	Parse_line_index.text = nullptr;
+}
+
 //	Advance Mp to the next eoln character.
 void advance_to_eoln(const char *more_terminators)
 {
@@ -310,6 +476,16 @@ void advance_to_eoln(const char *more_terminators)
 
 	Assert((more_terminators == NULL) || (strlen(more_terminators) < 125));
 
+	// the text may have been cut short since it was indexed so the end of the string stops the scan as well
+	static const char eoln_chars[] = { EOLN, '\0' };
+
+	auto &index = Parse_line_index;
+	if ((more_terminators == NULL) && Parse_fast_scan && (index.text != nullptr) && (Mp >= index.text) &&
+		(Mp < index.text + index.length)) {
+		Mp += scan_plain_chars(Mp, index.text + index.length, eoln_chars, sizeof(eoln_chars));
+		return;
+	}
+
 	terminators[0] = EOLN;
 	terminators[1] = 0;
 	if (more_terminators != NULL)
@@ -346,6 +522,7 @@ void advance_to_next_white()
 int skip_to_string(const char *pstr, const char *end)
 {
 	ignore_white_space();
+	line_skipper lines;
 	auto len = strlen(pstr);
 	size_t len2 = 0;
 
@@ -359,8 +536,7 @@ int skip_to_string(const char *pstr, const char *end)
 		if (end && !strnicmp(end, Mp, len2))
 			return -1;
 
-		advance_to_eoln(NULL);
-		ignore_white_space();
+		lines.next();
 	}
 
 	if (!Mp || *Mp == '\0')
@@ -375,6 +551,7 @@ int skip_to_string(const char *pstr, const char *end)
 int skip_to_start_of_string(const char *pstr, const char *end)
 {
 	ignore_white_space();
+	line_skipper lines;
 	auto len = strlen(pstr);
 	size_t endlen;
 	if(end)
@@ -389,8 +566,7 @@ int skip_to_start_of_string(const char *pstr, const char *end)
 		if (end && !strnicmp(end, Mp, endlen))
 			return 0;
 
-		advance_to_eoln(NULL);
-		ignore_white_space();
+		lines.next();
 	}
 
 	if (!Mp || *Mp == '\0')
@@ -405,6 +581,7 @@ int skip_to_start_of_string_either(const char *pstr1, const char *pstr2, const c
 	size_t len1, len2, endlen;
 
 	ignore_white_space();
+	line_skipper lines;
 	len1 = strlen(pstr1);
 	len2 = strlen(pstr2);
 	if(end)
@@ -419,8 +596,7 @@ int skip_to_start_of_string_either(const char *pstr1, const char *pstr2, const c
 		if (end && !strnicmp(end, Mp, endlen))
 			return 0;
 
-		advance_to_eoln(NULL);
-		ignore_white_space();
+		lines.next();
 	}
 
 	if (!Mp || *Mp == '\0')
@@ -1902,10 +2078,27 @@ void strip_comments(char *line, bool &in_quote, bool &in_multiline_comment_a, bo
 {
 	char *writep = line;
 	char *readp = line;
+	const char *end = line + strlen(line);
 
 	// copy all characters from read to write, unless they're commented
 	while (*readp != '\r' && *readp != '\n' && *readp != '\0')
 	{
+		// skip over characters which can neither start or end a comment nor a quote in one go
+		auto plain = scan_plain_chars(readp, end, "/!*;\"\r\n");
+		if (plain > 0)
+		{
+			if (!in_multiline_comment_a && !in_multiline_comment_b)
+			{
+				if (writep != readp)
+					memmove(writep, readp, plain);
+
+				writep += plain;
+			}
+
+			readp += plain;
+			continue;
+		}
+
 		// only check for comments if not quoting
 		if (!in_quote)
 		{
@@ -1993,31 +2186,84 @@ void strip_comments(char *line, bool &in_quote, bool &in_multiline_comment_a, bo
 
 int parse_get_line(char *lineout, int max_line_len, char *start, int max_size, char *cur)
 {
-	char * t = lineout;
-	int i, num_chars_read=0;
-	char c;
+	char *out = lineout;
+	char *out_end = lineout + max_line_len - 1;
+	const char *p = cur;
+	const char *end = start + max_size;
+
+	// copies everything up to and including the next newline, skipping carriage returns
+	while ( out < out_end ) {
+		if ( p >= end ) {
+			*out = 0;
+			if ( out > lineout ) {
+				return (int)(p - cur);
+			} else {
+				return 0;
+			}
+		}
 
+		auto avail = std::min((size_t)(out_end - out), (size_t)(end - p));
+		auto count = scan_plain_chars(p, p + avail, "\r\n");
 
-	for ( i = 0; i < max_line_len-1; i++ ) {
-		do {
-			if ( (cur - start) >= max_size ) {
-				*lineout = 0;
-				if ( lineout > t ) {
-					return num_chars_read;
-				} else {
-					return 0;
-				}
-			}
-			c = *cur++;
-			num_chars_read++;
-		} while ( c == 13 );
+		memcpy(out, p, count);
+		out += count;
+		p += count;
 
-		*lineout++ = c;
-		if ( c=='\n' ) break;
+		if ( count == avail ) {
+			continue;
+		}
+
+		if ( *p++ == '\n' ) {
+			*out++ = '\n';
+			break;
+		}
 	}
 
-	*lineout++ = 0;
-	return  num_chars_read;
+	*out = 0;
+	return (int)(p - cur);
+}
+
+static SCP_string preloaded_file_key(const char *filename)
+{
+	SCP_string key = filename;
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+	return key;
+}
+
+// Copies the text of a file from parse_preload_files() into the parse buffers. Returns false if the file was not
+// preloaded.
+static bool read_preloaded_file_text(const char *filename, int mode, char *processed_text, char *raw_text)
+{
+	if (Preloaded_files.empty() || Parse_preloading)
+		return false;
+
+	auto it = Preloaded_file_index.find(preloaded_file_key(filename));
+	if (it == Preloaded_file_index.end())
+		return false;
+
+	auto &file = Preloaded_files[it->second];
+	if (!file.valid || (file.mode != mode))
+		return false;
+
+	if (raw_text == NULL) {
+		allocate_parse_text(std::max(file.raw_text.size(), file.processed_text.size()) + 1);
+		raw_text = Parse_text_raw;
+	}
+
+	if (processed_text == NULL)
+		processed_text = Parse_text;
+
+	memcpy(raw_text, file.raw_text.c_str(), file.raw_text.size() + 1);
+	memcpy(processed_text, file.processed_text.c_str(), file.processed_text.size() + 1);
+	build_line_index(processed_text);
+
+	// A file which is read a second time may have been changed in the meantime
+	file.valid = false;
+	SCP_string().swap(file.raw_text);
+	SCP_string().swap(file.processed_text);
+
+	return true;
 }
 
 //	Read mission text, stripping comments.
@@ -2037,6 +2283,10 @@ void read_file_text(const char *filename, int mode, char *processed_text, char *
 		Error(LOCATION, "ERROR: Neither processed_text nor raw_text may be NULL when parsing is paused!!\n");
 	}
 
+	// maybe it was already read by parse_preload_files()
+	if (read_preloaded_file_text(filename, mode, processed_text, raw_text))
+		return;
+
 	// read the raw text
 	read_raw_file_text(filename, mode, raw_text);
 
@@ -2090,6 +2340,8 @@ void stop_parse()
 {
 	Assert( !Parsing_paused );
 
+	Parse_line_index.text = nullptr;
+
 	if (Parse_text != nullptr) {
 		vm_free(Parse_text);
 		Parse_text = nullptr;
@@ -2110,6 +2362,9 @@ void allocate_parse_text(size_t size)
 	// Make sure that there is space for the terminating null character
 	size += 1;
 
+	if (Parse_line_index.text == Parse_text)
+		Parse_line_index.text = nullptr;
+
 	if (size <= Parse_text_size) {
 		// Make sure that a new parsing session does not use uninitialized data.
 		memset( Parse_text, 0, sizeof(char) * Parse_text_size );
@@ -2119,7 +2374,8 @@ void allocate_parse_text(size_t size)
 
 	static ubyte parse_atexit = 0;
 
-	if (!parse_atexit) {
+	// the worker threads of parse_preload_files() free their text themselves
+	if (!parse_atexit && !Parse_preloading) {
 		atexit(stop_parse);
 		parse_atexit = 1;
 	}
@@ -2158,7 +2414,8 @@ void read_raw_file_text(const char *filename, int mode, char *raw_text)
 	mf = cfopen(filename, "rb", CFILE_NORMAL, mode);
 	if (mf == NULL)
 	{
-        nprintf(("Error", "Wokka!  Error opening file (%s)!\n", filename));
+		if (!Parse_preloading)
+			nprintf(("Error", "Wokka!  Error opening file (%s)!\n", filename));
         throw parse::ParseException("Failed to open file");
 	}
 
@@ -2166,7 +2423,9 @@ void read_raw_file_text(const char *filename, int mode, char *raw_text)
 	int file_len = cfilelength(mf);
 
 	if(!file_len) {
-        nprintf(("Error", "Oh noes!!  File is empty! (%s)!\n", filename));
+		cfclose(mf);
+		if (!Parse_preloading)
+			nprintf(("Error", "Oh noes!!  File is empty! (%s)!\n", filename));
         throw parse::ParseException("Failed to open file");
 	}
 
@@ -2185,6 +2444,17 @@ void read_raw_file_text(const char *filename, int mode, char *raw_text)
 	file_is_encrypted = is_encrypted(raw_text);
 	cfseek(mf, 0, CF_SEEK_SET);
 
+	if (Parse_preloading) {
+		// check_encoding_and_skip_bom() reports files in the wrong encoding, leave that to the main thread
+		SCP_string probe(raw_text, (size_t) MIN(file_len, 10));
+		auto expected = Unicode_text_mode ? util::Encoding::UTF8 : util::Encoding::ASCII;
+
+		if (util::guess_encoding(probe, Unicode_text_mode) != expected) {
+			cfclose(mf);
+			throw parse::ParseException("Unexpected encoding");
+		}
+	}
+
 	file_len = util::check_encoding_and_skip_bom(mf, filename);
 
 	if ( file_is_encrypted )
@@ -2211,6 +2481,12 @@ void read_raw_file_text(const char *filename, int mode, char *raw_text)
 		// Validate the UTF-8 encoding
 		auto invalid = utf8::find_invalid(raw_text, raw_text + file_len);
 		if (invalid != raw_text + file_len) {
+			if (Parse_preloading) {
+				// the main thread converts the file or warns about it
+				cfclose(mf);
+				throw parse::ParseException("Invalid UTF-8 encoding");
+			}
+
 			auto isLatin1 = util::guessLatin1Encoding(raw_text, (size_t) file_len);
 
 			// We do the additional can_reallocate check here since we need control over raw_text to reencode the file
@@ -2322,6 +2598,8 @@ void process_raw_file_text(char *processed_text, char *raw_text)
 
 	// Make sure the string is terminated properly
 	*mp = *mp_raw = '\0';
+
+	build_line_index(processed_text);
 /*
 	while (cfgets(outbuf, PARSE_BUF_SIZE, mf) != NULL) {
 		if (strlen(outbuf) >= PARSE_BUF_SIZE-1)
@@ -3393,6 +3671,10 @@ void reset_parse(char *text)
 		Mp = Parse_text;
 	}
 
+	// the line index only stays valid if the text which was just read is parsed
+	if (Mp != Parse_line_index.text)
+		Parse_line_index.text = nullptr;
+
 	Warning_count = 0;
 	Error_count = 0;
 
@@ -4326,3 +4608,164 @@ int parse_modular_table(const char *name_check, void (*parse_callback)(const cha
 
 	return num_files;
 }
+
+// Runs on the worker threads
+static void preload_file(preloaded_file &file)
+{
+	try {
+		read_raw_file_text(file.filename.c_str(), file.mode);
+		process_raw_file_text();
+
+		file.raw_text = Parse_text_raw;
+		file.processed_text = Parse_text;
+		file.valid = true;
+	} catch (const parse::ParseException&) {
+		// the main thread reads the file again and reports the problem
+	}
+}
+
+void parse_preload_files(const SCP_vector<SCP_string> &filenames, int mode)
+{
+	TRACE_SCOPE(tracing::ParsePreload);
+
+	parse_free_preloaded_files();
+
+	for (auto &filename : filenames) {
+		auto key = preloaded_file_key(filename.c_str());
+
+		if (Preloaded_file_index.find(key) != Preloaded_file_index.end())
+			continue;
+
+		Preloaded_file_index[key] = Preloaded_files.size();
+
+		preloaded_file file;
+		file.filename = filename;
+		file.mode = mode;
+		Preloaded_files.push_back(file);
+	}
+
+	auto start = timer_get_microseconds();
+
+	util::get_worker_pool().parallelFor(Preloaded_files.size(), 1, [](size_t begin, size_t end, size_t /*thread_index*/) {
+		// the calling thread takes part in the loop so its buffers are put aside while the files are read
+		auto text = Parse_text;
+		auto text_raw = Parse_text_raw;
+		auto text_size = Parse_text_size;
+
+		Parse_text = Parse_text_raw = nullptr;
+		Parse_text_size = 0;
+		Parse_preloading = true;
+
+		for (auto i = begin; i < end; ++i)
+			preload_file(Preloaded_files[i]);
+
+		// the text of the files has been copied, no need to keep the buffers around
+		if (Parse_text != nullptr)
+			vm_free(Parse_text);
+		if (Parse_text_raw != nullptr)
+			vm_free(Parse_text_raw);
+
+		Parse_text = text;
+		Parse_text_raw = text_raw;
+		Parse_text_size = text_size;
+		Parse_preloading = false;
+	});
+
+	size_t num_valid = 0;
+	size_t text_size = 0;
+	for (auto &file : Preloaded_files) {
+		if (file.valid) {
+			num_valid++;
+			text_size += file.raw_text.size() + file.processed_text.size();
+		}
+	}
+
+	mprintf(("PARSE: Preloaded " SIZE_T_ARG " of " SIZE_T_ARG " files (%.1f KB) in %.3f seconds.\n", num_valid,
+		Preloaded_files.size(), text_size / 1024.0, (timer_get_microseconds() - start) / 1000000.0));
+}
+
+void parse_preload_tables()
+{
+	if (!Cmdline_mt_parse)
+		return;
+
+	SCP_vector<SCP_string> filenames;
+	SCP_vector<SCP_string> modular_tables;
+
+	cf_get_file_list(filenames, CF_TYPE_TABLES, "*.tbl", CF_SORT_NONE);
+	for (auto &filename : filenames)
+		filename += ".tbl";
+
+	cf_get_file_list(modular_tables, CF_TYPE_TABLES, "*.tbm", CF_SORT_NONE);
+	for (auto &filename : modular_tables)
+		filenames.push_back(filename + ".tbm");
+
+	parse_preload_files(filenames, CF_TYPE_TABLES);
+}
+
+void parse_free_preloaded_files()
+{
+	Preloaded_files.clear();
+	Preloaded_file_index.clear();
+}
+
+DCF(parse_bench, "Measures the throughput of preprocessing and scanning a table with and without the fast path")
+{
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: parse_bench <table> [rounds]\n");
+		dc_printf("Preprocesses the table [rounds] times (default 10) and skips through all of its '$' tokens, once with the\n");
+		dc_printf("plain character loops and once with the vectorized scanning and the line index, and prints the throughput.\n");
+		return;
+	}
+
+	SCP_string filename;
+	dc_stuff_string_white(filename);
+
+	int rounds = 10;
+	dc_maybe_stuff_int(&rounds);
+	if (rounds <= 0)
+		rounds = 10;
+
+	try {
+		read_raw_file_text(filename.c_str(), CF_TYPE_TABLES);
+	} catch (const parse::ParseException &e) {
+		dc_printf("Could not read %s: %s\n", filename.c_str(), e.what());
+		return;
+	}
+
+	SCP_string raw = Parse_text_raw;
+	double megabytes = raw.size() * (double)rounds / (1024.0 * 1024.0);
+
+	for (auto fast : {false, true}) {
+		parse_set_fast_scan(fast);
+
+		SCP_vector<char> raw_text;
+		SCP_vector<char> processed_text(raw.size() * 2 + 2);
+		std::uint64_t process_time = 0;
+		std::uint64_t skip_time = 0;
+		int tokens = 0;
+
+		for (int i = 0; i < rounds; ++i) {
+			raw_text.assign(raw.begin(), raw.end());
+			raw_text.push_back('\0');
+
+			auto start = timer_get_microseconds();
+			process_raw_file_text(processed_text.data(), raw_text.data());
+			auto processed = timer_get_microseconds();
+
+			reset_parse(processed_text.data());
+			while (skip_to_string("$") == 1)
+				++tokens;
+
+			process_time += processed - start;
+			skip_time += timer_get_microseconds() - processed;
+		}
+
+		dc_printf("%s: preprocessing %.1f MB/s, skipping %.1f MB/s (%d tokens per round)\n", fast ? "Fast" : "Plain",
+			megabytes / std::max(process_time / 1000000.0, 0.000001), megabytes / std::max(skip_time / 1000000.0, 0.000001),
+			tokens / rounds);
+	}
+
+	parse_set_fast_scan(true);
+	reset_parse();
+}
@@ -23,8 +23,9 @@
 // NOTE: although the main game doesn't need this anymore, FRED2 still does
 #define	PARSE_TEXT_SIZE	1000000
 
-extern char	*Parse_text;
-extern char	*Parse_text_raw;
+// The text buffers are per thread so that files can be read and preprocessed on worker threads, see parse_preload_files()
+extern thread_local char	*Parse_text;
+extern thread_local char	*Parse_text_raw;
 extern char	*Mp;
 extern const char	*token_found;
 extern int fred_parse_flag;
@@ -339,6 +340,17 @@ extern int parse_modular_table(const char *name_check, void (*parse_callback)(co
 // to know that we are parsing a modular table
 extern bool Parsing_modular_table;
 
+// Reads and preprocesses the files on the worker threads. Until parse_free_preloaded_files() is called, read_file_text()
+// takes the text of these files from memory instead of reading them again. Every preloaded file is only used once.
+extern void parse_preload_files(const SCP_vector<SCP_string> &filenames, int mode);
+// Preloads all tables and modular tables if -mt_parse is enabled
+extern void parse_preload_tables();
+extern void parse_free_preloaded_files();
+
+// Enables or disables the vectorized scanning of the text and the line index which lets the skip_to_* functions jump
+// from line to line. Enabled by default, only meant for comparing both paths in tests and benchmarks.
+extern void parse_set_fast_scan(bool enable);
+
 //Karajorma - Parses mission and campaign ship loadouts.
 int stuff_loadout_list (int *ilp, int max_ints, int lookup_type);
 int get_string_or_variable (char *str);
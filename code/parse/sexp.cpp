@@ -75,6 +75,7 @@
 #include "network/multiutil.h"
 #include "object/objcollide.h"
 #include "object/objectdock.h"
+#include "object/objectspatial.h"
 #include "object/objectshield.h"
 #include "object/objectsnd.h"
 #include "object/waypoint.h"
@@ -1178,6 +1179,9 @@ int alloc_sexp(const char *text, int type, int subtype, int first, int rest)
 	Sexp_nodes[node].value = SEXP_UNKNOWN;
 	Sexp_nodes[node].flags = SNF_DEFAULT_VALUE;	// Goober5000
 	Sexp_nodes[node].op_index = NO_OPERATOR_INDEX_DEFINED;
+	Sexp_nodes[node].cached_number = 0;
+	Sexp_nodes[node].cached_value = SEXP_UNKNOWN;
+	Sexp_nodes[node].cached_ship = -1;
 
 	return node;
 }
@@ -1906,7 +1910,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					return SEXP_CHECK_TYPE_MISMATCH;
 				}
 
-				if (ship_name_lookup(CTEXT(node), 0) < 0)
+				if (sexp_ship_name_lookup(node, 0) < 0)
 				{
 					if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 					{
@@ -1924,7 +1928,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 
 				if (stricmp(CTEXT(node), SEXP_NONE_STRING) != 0)		// none is okay
 				{
-					if (ship_name_lookup(CTEXT(node), 1) < 0)
+					if (sexp_ship_name_lookup(node, 1) < 0)
 					{
 						if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 						{
@@ -1941,7 +1945,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					return SEXP_CHECK_TYPE_MISMATCH;
 				}
 
-				if (ship_name_lookup(CTEXT(node), 1) < 0) {
+				if (sexp_ship_name_lookup(node, 1) < 0) {
 					if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 					{
 						if (type == OPF_SHIP)
@@ -1989,7 +1993,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 				}
 
 				// all of these have ships and wings in common
-				if (ship_name_lookup(CTEXT(node), 1) >= 0 || wing_name_lookup(CTEXT(node), 1) >= 0) {
+				if (sexp_ship_name_lookup(node, 1) >= 0 || wing_name_lookup(CTEXT(node), 1) >= 0) {
 					break;
 				}
 				// also check arrival list if we're running the game
@@ -2277,7 +2281,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						valid = 1;
 					}
 
-					if (ship_name_lookup(CTEXT(node), 1) >= 0)
+					if (sexp_ship_name_lookup(node, 1) >= 0)
 					{
 						valid = 1;
 					}
@@ -2439,7 +2443,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						break;
 					}
 
-					ship_num = ship_name_lookup(CTEXT(Sexp_nodes[op_node].rest), 1);	// Goober5000 - include players
+					ship_num = sexp_ship_name_lookup(Sexp_nodes[op_node].rest, 1);	// Goober5000 - include players
 					if (ship_num < 0) {
 						w = wing_name_lookup(CTEXT(Sexp_nodes[op_node].rest));
 						if (w < 0) {
@@ -2469,7 +2473,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					}
 
 					if ((z == OP_AI_DOCK) && (Sexp_nodes[node].rest >= 0)) {
-						ship2 = ship_name_lookup(CTEXT(Sexp_nodes[node].rest), 1);	// Goober5000 - include players
+						ship2 = sexp_ship_name_lookup(Sexp_nodes[node].rest, 1);	// Goober5000 - include players
 						if ((ship_num < 0) || !ship_docking_valid(ship_num, ship2)){
 							return SEXP_CHECK_DOCKING_NOT_ALLOWED;
 						}
@@ -2675,7 +2679,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 					}
 
 					// look for the ship this goal is being assigned to
-					ship_num = ship_name_lookup(CTEXT(Sexp_nodes[z].rest), 1);
+					ship_num = sexp_ship_name_lookup(Sexp_nodes[z].rest, 1);
 					if (ship_num < 0) {
 						if (bad_node)
 							*bad_node = Sexp_nodes[z].rest;
@@ -2714,7 +2718,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 						ship_num = ship_name_lookup(Sexp_nodes[z].text, 1);
 					}
 					else {
-						ship_num = ship_name_lookup(CTEXT(Sexp_nodes[op_node].rest), 1);
+						ship_num = sexp_ship_name_lookup(Sexp_nodes[op_node].rest, 1);
 					}
 
 					if (ship_num < 0) {
@@ -2743,7 +2747,7 @@ int check_sexp_syntax(int node, int return_type, int recursive, int *bad_node, i
 				if (*CTEXT(node) != '#') {  // not a manual source?
 					if ( stricmp(CTEXT(node), "<any wingman>") != 0)  
 						if ( stricmp(CTEXT(node), "<none>") != 0 ) // not a special token?
-							if ((ship_name_lookup(CTEXT(node), TRUE) < 0) && (wing_name_lookup(CTEXT(node), 1) < 0))  // is it in the mission?
+							if ((sexp_ship_name_lookup(node, TRUE) < 0) && (wing_name_lookup(CTEXT(node), 1) < 0))  // is it in the mission?
 								if (Fred_running || !mission_parse_get_arrival_ship(CTEXT(node)))
 									return SEXP_CHECK_INVALID_MSG_SOURCE;
 				}
@@ -3983,7 +3987,7 @@ player * get_player_from_ship_node(int node, bool test_respawns)
 	
 	Assert (node != -1);
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 
 	// singleplayer
 	if (!(Game_mode & GM_MULTIPLAYER)){	
@@ -4026,7 +4030,7 @@ ship * sexp_get_ship_from_node(int node)
 	int sindex;
 	ship *shipp = NULL;
 
-	sindex = ship_name_lookup( CTEXT(node) );
+	sindex = sexp_ship_name_lookup( node );
 
 	if (sindex < 0) {
 		return shipp;
@@ -4403,6 +4407,7 @@ int rand_sexp(int n, bool multiple)
 		// set .value and .text so random number is generated only once.
 		Sexp_nodes[n].value = SEXP_NUM_EVAL;
 		sprintf(Sexp_nodes[n].text, "%d", rand_num);
+		Sexp_nodes[n].flags &= ~SNF_NUMBER_CACHED;
 	}
 	// if this is multiple with a nonzero seed provided
 	else if (seed > 0)
@@ -4410,6 +4415,7 @@ int rand_sexp(int n, bool multiple)
 		// Set the seed to a new seeded random value. This will ensure that the next time the method
 		// is called it will return a predictable but different number from the previous time. 
 		sprintf(Sexp_nodes[CDDR(n)].text, "%d", rand_internal(1, INT_MAX, seed));
+		Sexp_nodes[CDDR(n)].flags &= ~SNF_NUMBER_CACHED;
 	}
 
 	return rand_num;
@@ -9355,6 +9361,7 @@ void sexp_ingame_ship_change_iff(ship *shipp, int new_team)
 	Assert(shipp != NULL);
 
 	shipp->team = new_team;
+	obj_spatial_team_changed(shipp->objnum);
 }
 
 // Goober5000
@@ -9594,7 +9601,7 @@ int sexp_is_ship_class(int n)
 	while (n != -1)
 	{
 		// get ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_name_lookup(n);
 
 		// we can't do anything with ships that aren't present
 		if (ship_num < 0)
@@ -9627,7 +9634,7 @@ int sexp_is_ship_type(int n)
 	while (n != -1)
 	{
 		// get ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_name_lookup(n);
 
 		// we can't do anything with ships that aren't present
 		if (ship_num < 0)
@@ -9730,7 +9737,7 @@ void sexp_change_ai_class(int n)
 
 	// find ship
 	n = CDR(n);
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_name_lookup(n);
 	n = CDR(n);
 
 	// we can't do anything with ships that aren't present
@@ -10729,7 +10736,7 @@ void sexp_set_explosion_option(int node)
 	shockwave_create_info *sci;
 
 	// get ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_name_lookup(n);
 	if (ship_num < 0)
 		return;
 
@@ -11340,7 +11347,7 @@ void sexp_self_destruct(int node)
 
 	for (n = node; n != -1; n = CDR(n))	{
 		// get the ship
-		ship_num = ship_name_lookup(CTEXT(n));
+		ship_num = sexp_ship_name_lookup(n);
 
 		// if it still exists, destroy it
 		if (ship_num >= 0) {
@@ -11770,7 +11777,7 @@ void sexp_destroy_subsys_instantly(int n)
 	ship *shipp;
 	ship_subsys *ss;
 
-	shipnum = ship_name_lookup(CTEXT(n));
+	shipnum = sexp_ship_name_lookup(n);
 	// if no ship, then return immediately.
 	if (shipnum < 0)
 		return;
@@ -12200,7 +12207,7 @@ void sexp_jettison_cargo(int n, bool jettison_new)
 		for (; n != -1; n = CDR(n))
 		{
 			// make sure ship exists
-			ship_index = ship_name_lookup(CTEXT(n));
+			ship_index = sexp_ship_name_lookup(n);
 			if (ship_index < 0)
 				continue;
 
@@ -12699,7 +12706,7 @@ void sexp_change_player_score(int node)
 	node = CDR(node);
 
 	if(!(Game_mode & GM_MULTIPLAYER)){
-		if ( (sindex = ship_name_lookup(CTEXT(node))) == -1) {
+		if ( (sindex = sexp_ship_name_lookup(node)) == -1) {
 			Warning(LOCATION, "Invalid shipname '%s' passed to sexp_change_player_score!", CTEXT(node));
 			return;
 		}
@@ -13646,7 +13653,7 @@ void sexp_set_persona (int node)
 
 	// now loop through the list of ships
 	for ( ; node >= 0; node = CDR(node) ) {
-		sindex = ship_name_lookup( CTEXT(node) );
+		sindex = sexp_ship_name_lookup( node );
 
 		if (sindex < 0) {
 			continue;
@@ -14244,7 +14251,7 @@ void sexp_ships_visible(int n, bool visible)
 	// we also have to add any escort ships that were made visible
 	for (; n >= 0; n = CDR(n))
 	{
-		int shipnum = ship_name_lookup(CTEXT(n));
+		int shipnum = sexp_ship_name_lookup(n);
 		if (shipnum < 0)
 			continue;
 
@@ -14267,7 +14274,7 @@ void sexp_ships_stealthy(int n, bool stealthy)
 	{
 		for (; n >= 0; n = CDR(n))
 		{
-			int shipnum = ship_name_lookup(CTEXT(n));
+			int shipnum = sexp_ship_name_lookup(n);
 			if (shipnum < 0)
 				continue;
 
@@ -14287,7 +14294,7 @@ void sexp_friendly_stealth_invisible(int n, bool invisible)
 	{
 		for (; n >= 0; n = CDR(n))
 		{
-			int shipnum = ship_name_lookup(CTEXT(n));
+			int shipnum = sexp_ship_name_lookup(n);
 			if (shipnum < 0)
 				continue;
 
@@ -14413,7 +14420,7 @@ void sexp_ship_tag( int n, int tag )
 		return;
 
 	// get the ship num
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_name_lookup(n);
 	if ( ship_num < 0 )
 		return;
 
@@ -14683,7 +14690,7 @@ void sexp_weapon_create(int n)
 	parent_objnum = -1;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING) != 0)
 	{
-		int parent_ship = ship_name_lookup(CTEXT(n));
+		int parent_ship = sexp_ship_name_lookup(n);
 
 		if (parent_ship >= 0)
 			parent_objnum = Ships[parent_ship].objnum;
@@ -14735,7 +14742,7 @@ void sexp_weapon_create(int n)
 	target_objnum = -1;
 	if (n >= 0)
 	{
-		int target_ship = ship_name_lookup(CTEXT(n));
+		int target_ship = sexp_ship_name_lookup(n);
 
 		if (target_ship >= 0)
 			target_objnum = Ships[target_ship].objnum;
@@ -15068,7 +15075,7 @@ void sexp_ship_change_callsign(int node)
 
 	while ( node >= 0 )
 	{
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_name_lookup(node);
 		if (sindex >= 0) 
 		{
 			shipp = &Ships[sindex];
@@ -15219,7 +15226,7 @@ int sexp_targeted(int node)
 		return SEXP_CANT_EVAL;
 	}
 
-	z = ship_name_lookup(CTEXT(node), 1);
+	z = sexp_ship_name_lookup(node, 1);
 	if ((z < 0) || !Player_ai || (Ships[z].objnum != Players_target)){
 		return SEXP_FALSE;
 	}
@@ -15314,7 +15321,7 @@ int sexp_primaries_depleted(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15351,7 +15358,7 @@ int sexp_secondaries_depleted(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15647,7 +15654,7 @@ int sexp_shield_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15664,7 +15671,7 @@ int sexp_engine_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15681,7 +15688,7 @@ int sexp_weapon_recharge_pct(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15704,7 +15711,7 @@ int sexp_get_ets_value(int node)
 	ets_type = CTEXT(node);
 	node = CDR(node);
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) {
 		return SEXP_FALSE;
 	}
@@ -15745,7 +15752,7 @@ void sexp_set_ets_values(int node)
 
 	// apply ETS settings to specified ships
 	for ( ; node != -1; node = CDR(node)) {
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_name_lookup(node);
 
 		if (sindex >= 0 && validate_ship_ets_indxes(sindex, ets_idx)) {
 			Ships[sindex].engine_recharge_index = ets_idx[ENGINES];
@@ -15785,7 +15792,7 @@ int sexp_shield_quad_low(int node)
 	object *objp;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -15826,7 +15833,7 @@ int sexp_primary_ammo_pct(int node)
 	int ret = 0;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0)
 	{
 		return 0;
@@ -15897,7 +15904,7 @@ int sexp_secondary_ammo_pct(int node)
 	int ret = 0;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -15945,7 +15952,7 @@ int sexp_get_primary_ammo(int node)
 	int check;
 
 	// get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0)
 	{
 		return 0;
@@ -15999,7 +16006,7 @@ void sexp_set_primary_ammo (int node)
 	int rearm_limit = -1;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) 
 	{
 		return ;
@@ -16120,7 +16127,7 @@ int sexp_get_secondary_ammo (int node)
 	int check ;
 
 	// Get the ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) 
 	{
 		return 0;
@@ -16164,7 +16171,7 @@ void sexp_set_secondary_ammo (int node)
 	int rearm_limit = -1;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) 
 	{
 		return ;
@@ -16275,7 +16282,7 @@ void sexp_set_weapon(int node, bool primary)
 	Assert(node != -1);
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0)
 	{
 		return;
@@ -16479,7 +16486,7 @@ void sexp_change_subsystem_name(int node)
 	Assert (node != -1);
 
 	// Check that a ship has been supplied
-	ship_index = ship_name_lookup(CTEXT(node));
+	ship_index = sexp_ship_name_lookup(node);
 	if (ship_index < 0) {
 		return;
 	}
@@ -16554,7 +16561,7 @@ void sexp_change_ship_class(int n)
 	// all ships in the sexp
 	for ( ; n != -1; n = CDR(n))
 	{
-		ship_num = ship_name_lookup(CTEXT(n), 1);
+		ship_num = sexp_ship_name_lookup(n, 1);
 
 		// If the ship hasn't arrived we still want the ability to change its class.
 		if (ship_num == -1)
@@ -16739,7 +16746,7 @@ void sexp_ship_copy_damage(int node)
 	p_object *target_pobjp;
 
 	// source ship must be present
-	source_shipnum = ship_name_lookup(CTEXT(node));
+	source_shipnum = sexp_ship_name_lookup(node);
 	if (source_shipnum < 0)
 		return;
 
@@ -16747,7 +16754,7 @@ void sexp_ship_copy_damage(int node)
 	for (n = CDR(node); n != -1; n = CDR(n))
 	{
 		// maybe it's present in-mission
-		target_shipnum = ship_name_lookup(CTEXT(n));
+		target_shipnum = sexp_ship_name_lookup(n);
 		if (target_shipnum >= 0)
 		{
 			ship_copy_damage(&Ships[target_shipnum], &Ships[source_shipnum]);
@@ -16775,7 +16782,7 @@ void sexp_activate_deactivate_glow_points(int n, bool activate)
 
 	for ( ; n != -1; n = CDR(n))
 	{
-		sindex = ship_name_lookup(CTEXT(n), 1);
+		sindex = sexp_ship_name_lookup(n, 1);
 		if (sindex >= 0)
 		{
 			for (i = 0; i < Ships[sindex].glow_point_bank_active.size(); i++)
@@ -16789,7 +16796,7 @@ void sexp_activate_deactivate_glow_point_bank(int n, bool activate)
 {
 	int sindex, num;
 
-	sindex = ship_name_lookup(CTEXT(n), 1);
+	sindex = sexp_ship_name_lookup(n, 1);
 	if (sindex >= 0)
 	{
 		for ( n = CDR(n); n != -1; n = CDR(n))
@@ -16811,7 +16818,7 @@ void sexp_activate_deactivate_glow_maps(int n, int activate)
 
 	for ( ; n != -1; n = CDR(n))
 	{
-		sindex = ship_name_lookup(CTEXT(n), 1);
+		sindex = sexp_ship_name_lookup(n, 1);
 		if (sindex >= 0)
 		{
 			shipp = &Ships[sindex];
@@ -17010,7 +17017,7 @@ void sexp_beam_fire(int node, bool at_coords)
 	fire_info.accuracy = 0.000001f;							// this will guarantee a hit
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(n));
+	sindex = sexp_ship_name_lookup(n);
 	n = CDR(n);
 	if (sindex < 0) {
 		return;
@@ -17040,7 +17047,7 @@ void sexp_beam_fire(int node, bool at_coords)
 		fire_info.target_subsys = NULL;
 	} else {
 		// get the target
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_name_lookup(n);
 		n = CDR(n);
 		if (sindex < 0) {
 			return;
@@ -17137,7 +17144,7 @@ void sexp_beam_floating_fire(int n)
 	fire_info.shooter = NULL;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING) != 0)
 	{
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_name_lookup(n);
 
 		if (sindex >= 0)
 			fire_info.shooter = &Objects[Ships[sindex].objnum];
@@ -17160,7 +17167,7 @@ void sexp_beam_floating_fire(int n)
 	sindex = -1;
 	if (stricmp(CTEXT(n), SEXP_NONE_STRING) != 0)
 	{
-		sindex = ship_name_lookup(CTEXT(n));
+		sindex = sexp_ship_name_lookup(n);
 
 		if (sindex >= 0)
 			fire_info.target = &Objects[Ships[sindex].objnum];
@@ -17214,7 +17221,7 @@ void sexp_beam_free(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17245,7 +17252,7 @@ void sexp_set_thrusters(int node)
 	node = CDR(node);
 
 	for(; node >= 0; node = CDR(node)) {
-		int sindex = ship_name_lookup(CTEXT(node));
+		int sindex = sexp_ship_name_lookup(node);
 		
 		if (sindex < 0) {
 			continue;
@@ -17266,7 +17273,7 @@ void sexp_beam_free_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_name_lookup( n );
 
 		if (sindex < 0) {
 			continue;
@@ -17299,7 +17306,7 @@ void sexp_beam_lock(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17327,7 +17334,7 @@ void sexp_beam_lock_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_name_lookup( n );
 
 		if (sindex < 0) {
 			continue;
@@ -17358,7 +17365,7 @@ void sexp_turret_free(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17390,7 +17397,7 @@ void sexp_turret_free_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_name_lookup( n );
 
 		if (sindex < 0) {
 			continue;
@@ -17422,7 +17429,7 @@ void sexp_turret_lock(int node)
 	ship_subsys *turret = NULL;	
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17450,7 +17457,7 @@ void sexp_turret_lock_all(int node)
 
 	for (int n = node; n >= 0; n = CDR(n)) {
 		// get the firing ship
-		sindex = ship_name_lookup( CTEXT(n) );
+		sindex = sexp_ship_name_lookup( n );
 
 		if (sindex < 0) {
 			continue;
@@ -17481,7 +17488,7 @@ void sexp_turret_tagged_only_all(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17508,7 +17515,7 @@ void sexp_turret_tagged_clear_all(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17537,7 +17544,7 @@ void sexp_turret_change_weapon(int node)
 	ship_weapon *swp = NULL;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0 || Ships[sindex].objnum < 0){
 		return;
 	}
@@ -17628,7 +17635,7 @@ void sexp_set_armor_type(int node)
 	ship_info *sip = NULL;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0) {
 		return;
 	}
@@ -17778,7 +17785,7 @@ void sexp_ship_set_damage_type(int node)
 	while(node != -1)
 	{
 		// get the ship
-		sindex = ship_name_lookup(CTEXT(node));
+		sindex = sexp_ship_name_lookup(node);
 		if(sindex >= 0) 
 		{
 			shipp = &Ships[sindex];
@@ -17885,7 +17892,7 @@ void sexp_turret_set_target_order(int node)
 	int i;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17929,7 +17936,7 @@ void sexp_turret_set_direction_preference(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -17973,7 +17980,7 @@ void sexp_turret_set_rate_of_fire(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18012,7 +18019,7 @@ void sexp_turret_set_optimum_range(int node)
 	ship_subsys *turret = NULL;	
 	
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18053,7 +18060,7 @@ void sexp_turret_set_target_priorities(int node)
 	int j;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18109,7 +18116,7 @@ void sexp_ship_turret_target_order(int node)
 	int new_target_order[NUM_TURRET_ORDER_TYPES];
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18158,7 +18165,7 @@ int sexp_get_turret_primary_ammo(int node)
 	ship_weapon *swp;
 	int bank, check, ammo_left = 0;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) {
 		return 0;
 	}
@@ -18215,7 +18222,7 @@ void sexp_set_turret_primary_ammo(int node)
 	int requested_weapons;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0)
 	{
 		return;
@@ -18313,7 +18320,7 @@ int sexp_get_turret_secondary_ammo(int node)
 	ship_weapon *swp;
 	int bank, check, ammo_left = 0;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0) {
 		return 0;
 	}
@@ -18362,7 +18369,7 @@ void sexp_set_turret_secondary_ammo(int node)
 	int requested_weapons;
 
 	// Check that a ship has been supplied
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if (sindex < 0)
 	{
 		return;
@@ -18513,7 +18520,7 @@ void sexp_set_subsys_rotation_lock_free(int node, bool locked)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(node));
+	ship_num = sexp_ship_name_lookup(node);
 	if (ship_num < 0)
 		return;
 	
@@ -18558,7 +18565,7 @@ void sexp_reverse_rotating_subsystem(int node)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(node));
+	ship_num = sexp_ship_name_lookup(node);
 	if (ship_num < 0)
 		return;
 	
@@ -18590,7 +18597,7 @@ void sexp_rotating_subsys_set_turn_time(int node)
 	ship_subsys *rotate;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_name_lookup(n);
 	if (ship_num < 0)
 		return;
 	if (Ships[ship_num].objnum < 0)
@@ -18624,7 +18631,7 @@ void sexp_trigger_submodel_animation(int node)
 	bool instant;
 
 	// get the ship
-	ship_num = ship_name_lookup(CTEXT(n));
+	ship_num = sexp_ship_name_lookup(n);
 	if (ship_num < 0)
 		return;
 	if (Ships[ship_num].objnum < 0)
@@ -18685,7 +18692,7 @@ void sexp_turret_tagged_specific(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18712,7 +18719,7 @@ void sexp_turret_tagged_clear_specific(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18739,7 +18746,7 @@ void sexp_add_remove_escort(int node)
 	int flag;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -18810,7 +18817,7 @@ void sexp_damage_escort_list(int node)
 		if ( mission_log_get_time(LOG_SHIP_DEPARTED, CTEXT(n), NULL, NULL) || mission_log_get_time(LOG_SHIP_DESTROYED, CTEXT(n), NULL, NULL) || mission_log_get_time(LOG_SELF_DESTRUCTED, CTEXT(n), NULL, NULL) )
 			continue;
 
-		shipnum=ship_name_lookup(CTEXT(n));
+		shipnum=sexp_ship_name_lookup(n);
 		
 		//it may be dead
 		if (shipnum < 0)
@@ -19248,7 +19255,7 @@ void sexp_awacs_set_radius(int node)
 	ship_subsys *awacs;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -19708,7 +19715,7 @@ int sexp_is_tagged(int node)
 	int sindex;
 
 	// get the firing ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -19780,7 +19787,7 @@ int sexp_is_player (int node)
 	bool standard_check = is_sexp_true(node);
 
 	if (!(Game_mode & GM_MULTIPLAYER)){	
-		sindex = ship_name_lookup(CTEXT(CDR(node)));
+		sindex = sexp_ship_name_lookup(CDR(node));
 
 		// There can only be one player ship in singleplayer so if more than one ship is specifed the sexp is false
 		if (CDDR(node) < 0 ) {
@@ -19807,7 +19814,7 @@ int sexp_is_player (int node)
 			// reset the netplayer index
 			np_index = -1; 
 
-			sindex = ship_name_lookup(CTEXT(node));
+			sindex = sexp_ship_name_lookup(node);
 			if(sindex >= 0){
 				if(Ships[sindex].objnum >= 0) {
 					// try and find the player
@@ -19939,7 +19946,7 @@ int sexp_return_player_data(int node, int type)
 	player *p = NULL;
 	p_object *p_objp;
 
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 
 	if(Game_mode & GM_MULTIPLAYER){			
 		if(sindex >= 0){
@@ -20041,7 +20048,7 @@ int sexp_num_type_kills(int node)
 	player *p = NULL;
 
 	// get the ship we're interested in
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -20096,7 +20103,7 @@ int sexp_num_class_kills(int node)
 	player *p = NULL;
 
 	// get the ship we're interested in
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return 0;
 	}
@@ -20144,7 +20151,7 @@ void sexp_subsys_set_random(int node)
 	ship *shipp;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return;
 	}
@@ -20219,7 +20226,7 @@ int sexp_is_secondary_selected(int node)
 	ship *shipp;
 
 	// lookup ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -20250,7 +20257,7 @@ int sexp_is_primary_selected(int node)
 	ship *shipp;
 
 	// lookup ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 	if(sindex < 0){
 		return SEXP_FALSE;
 	}
@@ -22478,7 +22485,7 @@ void sexp_script_eval_multi(int node)
 				}
 				// otherwise notify the clients
 				else {
-					sindex = ship_name_lookup(CTEXT(node));
+					sindex = sexp_ship_name_lookup(node);
 					Current_sexp_network_packet.send_ship(sindex);
 				}
 			}
@@ -22533,7 +22540,7 @@ void sexp_force_glide(int node)
 	int sindex;
 
 	// get ship
-	sindex = ship_name_lookup(CTEXT(node));
+	sindex = sexp_ship_name_lookup(node);
 
 	if (sindex < 0) {
 		return;
@@ -22609,7 +22616,7 @@ int sexp_is_in_box(int n)
 	object* reference_ship_obj = NULL;
 	if (n != -1)
 	{
-		int sindex = ship_name_lookup(CTEXT(n));
+		int sindex = sexp_ship_name_lookup(n);
 
 		if (sindex < 0 || Ships[sindex].objnum < 0)
 			return SEXP_FALSE;
@@ -22641,7 +22648,7 @@ int sexp_is_in_box(int n)
 int sexp_is_in_mission(int node)
 {
 	for (int n = node; n != -1; n = CDR(n))
-		if (ship_name_lookup(CTEXT(n)) < 0)
+		if (sexp_ship_name_lookup(n) < 0)
 			return SEXP_FALSE;
 
 	return SEXP_TRUE;
@@ -22880,7 +22887,7 @@ void sexp_call_ssm_strike(int node) {
 		return;
 
 	for (int n = node; n != -1; n = CDR(n)) {
-		int ship_num = ship_name_lookup(CTEXT(n));
+		int ship_num = sexp_ship_name_lookup(n);
 		// don't do anything if the ship isn't there
 		if (ship_num >= 0) {
 			int obj_num = Ships[ship_num].objnum;
@@ -23206,6 +23213,12 @@ int eval_sexp(int cur_node, int referenced_node)
 		return SEXP_FALSE;
 	}
 
+	// constant operators were already evaluated by sexp_compile(), unless we need the event log
+	if ((Sexp_nodes[cur_node].flags & SNF_CONSTANT) && !Log_event) {
+		Sexp_nodes[cur_node].value = Sexp_nodes[cur_node].cached_value;
+		return Sexp_nodes[cur_node].cached_number;
+	}
+
 	if (Sexp_nodes[cur_node].first != -1) {
 		node = CAR(cur_node);
 		sexp_val = eval_sexp(node);
@@ -30033,10 +30046,137 @@ int eval_num(int n)
 
 	if (CAR(n) != -1)				// if argument is a sexp
 		return eval_sexp(CAR(n));
+	else if (Sexp_nodes[n].flags & SNF_NUMBER_CACHED)
+		return Sexp_nodes[n].cached_number;
 	else
 		return atoi(CTEXT(n));		// otherwise, just get the number
 }
 
+/**
+ * Operators which always return the same result for the same arguments and have no side effects
+ */
+static bool sexp_is_pure_operator(int op_num)
+{
+	switch (op_num) {
+		case OP_PLUS:
+		case OP_MINUS:
+		case OP_MUL:
+		case OP_DIV:
+		case OP_MOD:
+		case OP_ABS:
+		case OP_MIN:
+		case OP_MAX:
+		case OP_AVG:
+		case OP_POW:
+		case OP_SIGNUM:
+		case OP_SET_BIT:
+		case OP_UNSET_BIT:
+		case OP_IS_BIT_SET:
+		case OP_BITWISE_AND:
+		case OP_BITWISE_OR:
+		case OP_BITWISE_NOT:
+		case OP_BITWISE_XOR:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static bool sexp_is_constant_argument(int n)
+{
+	if (CAR(n) != -1)
+		return (Sexp_nodes[CAR(n)].flags & SNF_CONSTANT) != 0;
+
+	return (Sexp_nodes[n].flags & SNF_NUMBER_CACHED) != 0;
+}
+
+/**
+ * Resolves everything in a sexp that doesn't change while the mission is running
+ *
+ * Number atoms get their value cached so that eval_num() doesn't have to parse them again, string atoms remember which
+ * ship they were found at and pure operators whose arguments are all constant are evaluated once.  Variables and
+ * when-argument arguments are left alone since their text changes.
+ *
+ * @param node The operator at the top of the sexp
+ */
+void sexp_compile(int node)
+{
+	if (node < 0 || node == Locked_sexp_true || node == Locked_sexp_false) {
+		return;
+	}
+
+	// the operator itself and its arguments
+	for (int n = node; n != -1; n = CDR(n)) {
+		if (CAR(n) != -1) {
+			sexp_compile(CAR(n));
+			continue;
+		}
+
+		auto sn = &Sexp_nodes[n];
+
+		if (SEXP_NODE_TYPE(n) != SEXP_ATOM || (sn->type & SEXP_FLAG_VARIABLE) || !strcmp(sn->text, SEXP_ARGUMENT_STRING)) {
+			continue;
+		}
+
+		if (sn->subtype == SEXP_ATOM_NUMBER && can_construe_as_integer(sn->text)) {
+			sn->cached_number = atoi(sn->text);
+			sn->flags |= SNF_NUMBER_CACHED;
+		} else if (sn->subtype == SEXP_ATOM_STRING) {
+			sn->cached_ship = -1;
+			sn->flags |= SNF_SHIP_CACHED;
+		}
+	}
+
+	if (SEXP_NODE_TYPE(node) != SEXP_ATOM || Sexp_nodes[node].subtype != SEXP_ATOM_OPERATOR) {
+		return;
+	}
+
+	if (!sexp_is_pure_operator(get_operator_const(node)) || CDR(node) == -1) {
+		return;
+	}
+
+	for (int n = CDR(node); n != -1; n = CDR(n)) {
+		if (!sexp_is_constant_argument(n)) {
+			return;
+		}
+	}
+
+	// all arguments are known so the result is too
+	Sexp_nodes[node].cached_number = eval_sexp(node);
+	Sexp_nodes[node].cached_value = Sexp_nodes[node].value;
+	Sexp_nodes[node].flags |= SNF_CONSTANT;
+}
+
+/**
+ * Same as ship_name_lookup(CTEXT(node), inc_players) but remembers where the ship was found if the node was compiled
+ */
+int sexp_ship_name_lookup(int node, int inc_players)
+{
+	auto name = CTEXT(node);
+
+	if (!(Sexp_nodes[node].flags & SNF_SHIP_CACHED)) {
+		return ship_name_lookup(name, inc_players);
+	}
+
+	// the ship may have left or the node may have a different text by now, so check if it's still the right one
+	int shipnum = Sexp_nodes[node].cached_ship;
+	if (shipnum >= 0 && Ships[shipnum].objnum >= 0) {
+		int type = Objects[Ships[shipnum].objnum].type;
+
+		if ((type == OBJ_SHIP || (type == OBJ_START && inc_players)) && !stricmp(name, Ships[shipnum].ship_name)) {
+			return shipnum;
+		}
+	}
+
+	shipnum = ship_name_lookup(name, inc_players);
+	if (shipnum >= 0) {
+		Sexp_nodes[node].cached_ship = shipnum;
+	}
+
+	return shipnum;
+}
+
 // Goober5000
 int get_sexp_id(char *sexp_name)
 {
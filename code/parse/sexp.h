@@ -1061,6 +1061,11 @@ typedef struct sexp_node {
 	int	rest;						// index into Sexp_nodes of rest of parameters
 	int	value;					// known to be true, known to be false, or not known
 	int flags;					// Goober5000
+
+	// filled in by sexp_compile()
+	int cached_number;			// the number of a SNF_NUMBER_CACHED node or the result of a SNF_CONSTANT node
+	int cached_value;			// the value of a SNF_CONSTANT node after it was evaluated
+	int cached_ship;			// the index in Ships[] the text of a SNF_SHIP_CACHED node was last found at, or -1
 } sexp_node;
 
 // Goober5000
@@ -1068,6 +1073,11 @@ typedef struct sexp_node {
 #define SNF_ARGUMENT_SELECT		(1<<1)
 #define SNF_DEFAULT_VALUE		SNF_ARGUMENT_VALID
 
+// set by sexp_compile()
+#define SNF_NUMBER_CACHED		(1<<2)		// a number atom which is neither a variable nor an argument
+#define SNF_CONSTANT			(1<<3)		// an operator whose result only depends on constant arguments
+#define SNF_SHIP_CACHED			(1<<4)		// a string atom which remembers the ship it was found at
+
 typedef struct sexp_variable {
 	int		type;
 	char	text[TOKEN_LENGTH];
@@ -1162,6 +1172,8 @@ extern int run_sexp(const char* sexpression); // debug and lua sexps
 extern int stuff_sexp_variable_list();
 extern int eval_sexp(int cur_node, int referenced_node = -1);
 extern int eval_num(int n);
+extern void sexp_compile(int node);
+extern int sexp_ship_name_lookup(int node, int inc_players = 0);
 extern bool is_sexp_true(int cur_node, int referenced_node = -1);
 extern int query_operator_return_type(int op);
 extern int query_operator_argument_type(int op, int argnum);
@@ -0,0 +1,300 @@
+#include "parse/table_cache.h"
+
+#include "cfile/cfile.h"
+#include "debugconsole/console.h"
+#include "def_files/def_files.h"
+#include "globalincs/version.h"
+#include "io/timer.h"
+
+#include <md5.h>
+
+extern bool Cmdline_table_cache;
+
+namespace {
+
+const uint TABLE_CACHE_MAGIC = 0x43424c54; // "TLBC"
+const uint TABLE_CACHE_VERSION = 1;
+
+const size_t HASH_LENGTH = 32;
+
+const uint32_t CACHE_LOCATION = CF_LOCATION_ROOT_USER | CF_LOCATION_ROOT_GAME | CF_LOCATION_TYPE_ROOT;
+
+// The tables which went through table_cache_parse(), for the benchmark
+SCP_vector<table_cache_info> Cached_tables;
+
+SCP_string cache_file_name(const table_cache_info& info) { return SCP_string("tbl_cache-") + info.name + ".bin"; }
+
+bool hash_table_file(MD5& md5, const char* filename) {
+	auto cfp = cfopen(filename, "rb", CFILE_NORMAL, CF_TYPE_TABLES);
+	if (cfp == nullptr) {
+		return false;
+	}
+
+	md5.update(filename, (MD5::size_type)strlen(filename));
+
+	size_t length = 0;
+	auto view = cf_get_data_view(cfp, &length);
+	if (view != nullptr) {
+		md5.update(static_cast<const char*>(view), (MD5::size_type)length);
+	} else {
+		SCP_vector<char> buffer((size_t)cfilelength(cfp));
+		if (!buffer.empty() && cfread(buffer.data(), 1, (int)buffer.size(), cfp) != (int)buffer.size()) {
+			cfclose(cfp);
+			return false;
+		}
+		md5.update(buffer.data(), (MD5::size_type)buffer.size());
+	}
+
+	cfclose(cfp);
+	return true;
+}
+
+// Hashes all files which contribute to the parsed data, in the order they are parsed
+bool compute_hash(const table_cache_info& info, SCP_string& hash, SCP_vector<SCP_string>* files = nullptr) {
+	MD5 md5;
+
+	uint versions[] = {TABLE_CACHE_VERSION, info.version};
+	md5.update(reinterpret_cast<const char*>(versions), (MD5::size_type)sizeof(versions));
+
+	// Changes of the data layout within a version have to be caught by the table version and the size checks of the
+	// load function
+	auto engine_version = gameversion::get_version_string();
+	md5.update(engine_version.c_str(), (MD5::size_type)engine_version.size());
+
+	if (info.default_table != nullptr) {
+		auto def = defaults_get_file(info.default_table);
+		md5.update(static_cast<const char*>(def.data), (MD5::size_type)def.size);
+	}
+
+	if ((info.table != nullptr) && cf_exists_full(info.table, CF_TYPE_TABLES)) {
+		if (!hash_table_file(md5, info.table)) {
+			return false;
+		}
+
+		if (files != nullptr) {
+			files->push_back(info.table);
+		}
+	}
+
+	if (info.tbm_filter != nullptr) {
+		SCP_vector<SCP_string> tbl_file_names;
+		cf_get_file_list(tbl_file_names, CF_TYPE_TABLES, info.tbm_filter, CF_SORT_REVERSE);
+
+		for (auto& name : tbl_file_names) {
+			name += ".tbm";
+
+			if (!hash_table_file(md5, name.c_str())) {
+				return false;
+			}
+
+			if (files != nullptr) {
+				files->push_back(name);
+			}
+		}
+	}
+
+	md5.finalize();
+
+	hash = md5.hexdigest();
+	return hash.size() == HASH_LENGTH;
+}
+
+bool read_entry(const table_cache_info& info, const SCP_string& hash, SCP_vector<ubyte>& blob) {
+	auto cfp = cfopen(cache_file_name(info).c_str(), "rb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		return false;
+	}
+
+	char entry_hash[HASH_LENGTH];
+
+	auto magic = cfread_uint(cfp);
+	auto version = cfread_uint(cfp);
+	bool valid = (magic == TABLE_CACHE_MAGIC) && (version == TABLE_CACHE_VERSION) &&
+	             (cfread(entry_hash, 1, (int)HASH_LENGTH, cfp) == (int)HASH_LENGTH) &&
+	             (hash.compare(0, HASH_LENGTH, entry_hash, HASH_LENGTH) == 0);
+
+	if (valid) {
+		auto size = cfread_uint(cfp);
+
+		// A file which was only written halfway is caught by the size check
+		valid = (cfilelength(cfp) - cftell(cfp) == (int)size);
+
+		if (valid) {
+			blob.resize(size);
+			valid = (size == 0) || (cfread(blob.data(), 1, (int)size, cfp) == (int)size);
+		}
+	}
+
+	cfclose(cfp);
+
+	return valid;
+}
+
+void write_entry(const table_cache_info& info, const SCP_string& hash, const SCP_vector<ubyte>& blob) {
+	auto name = cache_file_name(info);
+
+	auto cfp = cfopen(name.c_str(), "wb", CFILE_NORMAL, CF_TYPE_CACHE, false, CACHE_LOCATION);
+	if (cfp == nullptr) {
+		mprintf(("Could not open table cache file %s!\n", name.c_str()));
+		return;
+	}
+
+	cfwrite_uint(TABLE_CACHE_MAGIC, cfp);
+	cfwrite_uint(TABLE_CACHE_VERSION, cfp);
+	cfwrite(hash.c_str(), 1, (int)HASH_LENGTH, cfp);
+	cfwrite_uint((uint)blob.size(), cfp);
+	auto written = blob.empty() ? 0 : cfwrite(blob.data(), 1, (int)blob.size(), cfp);
+
+	cfclose(cfp);
+
+	if (written != (int)blob.size()) {
+		mprintf(("Failed to write table cache file %s!\n", name.c_str()));
+		cf_delete(name.c_str(), CF_TYPE_CACHE, CACHE_LOCATION);
+	}
+}
+
+// Returns false if the table has to be parsed
+bool load_from_cache(const table_cache_info& info, const SCP_string& hash) {
+	SCP_vector<ubyte> blob;
+	if (!read_entry(info, hash, blob)) {
+		return false;
+	}
+
+	table_cache_reader reader(blob.data(), blob.size());
+	if (!info.load(reader) || !reader.at_end()) {
+		mprintf(("TABLES: Cached data of %s is invalid, parsing the tables again.\n", info.name));
+		return false;
+	}
+
+	return true;
+}
+
+void remember_table(const table_cache_info& info) {
+	for (auto& table : Cached_tables) {
+		if (!strcmp(table.name, info.name)) {
+			table = info;
+			return;
+		}
+	}
+
+	Cached_tables.push_back(info);
+}
+
+} // namespace
+
+void table_cache_writer::write_bytes(const void* data, size_t size) {
+	auto pos = _data.size();
+	_data.resize(pos + size);
+	memcpy(&_data[pos], static_cast<const ubyte*>(data), size);
+}
+
+bool table_cache_reader::read_bytes(void* data, size_t size) {
+	if (_size - _pos < size) {
+		return false;
+	}
+
+	memcpy(static_cast<ubyte*>(data), _data + _pos, size);
+	_pos += size;
+	return true;
+}
+
+bool table_cache_enabled() { return Cmdline_table_cache; }
+
+void table_cache_parse(const table_cache_info& info) {
+	SCP_string hash;
+	SCP_vector<SCP_string> files;
+
+	if (!table_cache_enabled() || !compute_hash(info, hash, &files)) {
+		info.parse();
+	} else {
+		remember_table(info);
+
+		if (load_from_cache(info, hash)) {
+			mprintf(("TABLES: Loaded %s from the table cache.\n", info.name));
+
+			if (info.loaded_file) {
+				for (auto& file : files) {
+					info.loaded_file(file.c_str());
+				}
+			}
+		} else {
+			info.parse();
+
+			table_cache_writer writer;
+			info.save(writer);
+			write_entry(info, hash, writer.data());
+		}
+	}
+
+	if (info.finish) {
+		info.finish();
+	}
+}
+
+DCF(table_cache_bench, "Compares parsing the cached tables with loading them from the cache (-table_cache)") {
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: table_cache_bench [rounds]\n");
+		dc_printf("Parses every table which supports the table cache and loads it from the cache [rounds] times (default 10)\n");
+		dc_printf("and prints the average time of both. The cached time includes hashing the table files.\n");
+		dc_printf("The tables are restored to their current state afterwards.\n");
+		return;
+	}
+
+	if (!table_cache_enabled()) {
+		dc_printf("Only available with -table_cache.\n");
+		return;
+	}
+
+	int rounds = 10;
+	dc_maybe_stuff_int(&rounds);
+	if (rounds <= 0) {
+		rounds = 10;
+	}
+
+	for (auto& info : Cached_tables) {
+		// The live data may have been changed since it was parsed (e.g. bitmap handles or the default AI profile) so
+		// the benchmark works on it and puts the current state back when it is done
+		table_cache_writer current;
+		info.save(current);
+
+		auto start = timer_get_microseconds();
+		for (int i = 0; i < rounds; ++i) {
+			info.parse();
+		}
+		auto parse_time = timer_get_microseconds() - start;
+
+		SCP_string hash;
+		table_cache_writer writer;
+		bool hashed = compute_hash(info, hash);
+		bool loaded = hashed;
+
+		std::uint64_t load_time = 0;
+		if (hashed) {
+			info.save(writer);
+			write_entry(info, hash, writer.data());
+
+			start = timer_get_microseconds();
+			for (int i = 0; i < rounds && loaded; ++i) {
+				loaded = compute_hash(info, hash) && load_from_cache(info, hash);
+			}
+			load_time = timer_get_microseconds() - start;
+		}
+
+		table_cache_reader reader(current.data().data(), current.data().size());
+		bool restored = info.load(reader) && reader.at_end();
+		if (restored && info.finish) {
+			info.finish();
+		}
+
+		Assertion(restored, "Could not restore the data of table %s after the benchmark!", info.name);
+
+		if (!hashed) {
+			dc_printf("%s: Could not hash the table files.\n", info.name);
+		} else if (!loaded) {
+			dc_printf("%s: Loading from the cache failed.\n", info.name);
+		} else {
+			dc_printf("%s: parsed in %.3f ms, cached in %.3f ms (%d bytes)\n", info.name,
+			          parse_time / (1000.0 * rounds), load_time / (1000.0 * rounds), (int)writer.data().size());
+		}
+	}
+}
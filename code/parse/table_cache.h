@@ -0,0 +1,110 @@
+#ifndef _TABLE_CACHE_H
+#define _TABLE_CACHE_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+#include <functional>
+
+/** @file
+ *  Binary cache for the parsed data of tables (enabled with -table_cache)
+ *
+ *  A table which supports the cache provides a function which parses the table and its modular tables and a pair of
+ *  functions which write the resulting data into a blob and read it back. The blob is stored in data/cache together
+ *  with the MD5 hash of all files which contributed to it. A later run which finds the same hash loads the blob
+ *  instead of parsing the tables again.
+ *
+ *  This only works for tables whose parsed data is self-contained, i.e. it does not contain pointers, handles of
+ *  bitmaps, models or sounds or indices into other tables which may change between runs.
+ *
+ *  Only ai_profiles.tbl and fireball.tbl use the cache so far. Most of the parsing time at startup goes into the ship,
+ *  weapon, species and IFF tables. Their data needs real serializers before it can be cached, until then the cache
+ *  saves next to nothing.
+ */
+
+/**
+ * @brief Writes the parsed data of a table into a blob
+ */
+class table_cache_writer {
+	SCP_vector<ubyte> _data;
+
+ public:
+	void write_bytes(const void* data, size_t size);
+
+	/**
+	 * @brief Writes a trivially copyable value
+	 */
+	template <typename T>
+	void write(const T& value)
+	{
+		auto pos = _data.size();
+		_data.resize(pos + sizeof(T));
+		memcpy(&_data[pos], &value, sizeof(T));
+	}
+
+	const SCP_vector<ubyte>& data() const { return _data; }
+};
+
+/**
+ * @brief Reads the parsed data of a table from a blob
+ *
+ * Reading past the end of the blob fails and leaves the value unchanged.
+ */
+class table_cache_reader {
+	const ubyte* _data;
+	size_t _size;
+	size_t _pos = 0;
+
+ public:
+	table_cache_reader(const ubyte* data, size_t size) : _data(data), _size(size) {}
+
+	bool read_bytes(void* data, size_t size);
+
+	/**
+	 * @brief Reads a trivially copyable value
+	 */
+	template <typename T>
+	bool read(T& value)
+	{
+		if (_size - _pos < sizeof(T)) {
+			return false;
+		}
+
+		memcpy(&value, _data + _pos, sizeof(T));
+		_pos += sizeof(T);
+		return true;
+	}
+
+	bool at_end() const { return _pos == _size; }
+};
+
+/**
+ * @brief Describes a table which can be cached
+ */
+struct table_cache_info {
+	const char* name;            //!< Name of the cache file
+	uint version;                //!< Increase this when the parsed data or the way it is written changes
+	const char* table;           //!< The main table file, may be nullptr
+	const char* default_table;   //!< The built-in table the parse function uses, may be nullptr
+	const char* tbm_filter;      //!< The modular tables as passed to parse_modular_table(), may be nullptr
+
+	std::function<void()> parse;                            //!< Parses the tables
+	std::function<void(table_cache_writer&)> save;          //!< Writes the parsed data
+	std::function<bool(table_cache_reader&)> load;          //!< Reads the parsed data, returns false on errors
+	std::function<void(const char*)> loaded_file;           //!< Called for every table file on a cache hit, may be empty
+	std::function<void()> finish;                           //!< Fixes up the data after it was parsed or loaded, may be empty
+};
+
+/**
+ * @brief Checks if the table cache is enabled
+ */
+bool table_cache_enabled();
+
+/**
+ * @brief Loads the parsed data of a table from the cache or parses the table and adds the data to the cache
+ *
+ * If the cache is disabled this just calls the parse function.
+ */
+void table_cache_parse(const table_cache_info& info);
+
+#endif // _TABLE_CACHE_H
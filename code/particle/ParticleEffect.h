@@ -100,6 +100,16 @@ class ParticleEffect {
 	 * @return The effect type.
 	 */
 	virtual EffectType getType() const { return EffectType::Invalid; }
+
+	/**
+	 * @brief Determines if the sources of this effect can be processed on a worker thread
+	 *
+	 * @note All sources of one effect are processed on the same thread so an implementation may use its own random
+	 * ranges. It may only create non-persistent particles and must not create sources or use other global state.
+	 *
+	 * @return @c true if the sources can be processed in parallel to the sources of other effects
+	 */
+	virtual bool canProcessInParallel() const { return false; }
 };
 
 /**
@@ -13,6 +13,9 @@
 #include "bmpman/bmpman.h"
 #include "globalincs/systemvars.h"
 #include "tracing/tracing.h"
+#include "utils/WorkerPool.h"
+
+extern bool Cmdline_mt_particles;
 
 /**
  * @defgroup particleSystems Particle System
@@ -118,6 +121,9 @@ void parseCallback(const char* fileName) {
 void parseConfigFiles() {
 	parse_modular_table("*-part.tbm", parseCallback);
 }
+
+// The number of sources which are allocated at once
+const size_t SOURCE_BLOCK_SIZE = 256;
 }
 
 namespace particle {
@@ -138,23 +144,35 @@ void ParticleManager::shutdown() {
 }
 
 ParticleSource* ParticleManager::createSource() {
-	ParticleSource* source;
+	if (m_freeSources.empty()) {
+		m_sourceBlocks.emplace_back(new ParticleSource[SOURCE_BLOCK_SIZE]);
+
+		auto block = m_sourceBlocks.back().get();
+		for (size_t i = SOURCE_BLOCK_SIZE; i > 0; --i) {
+			m_freeSources.push_back(&block[i - 1]);
+		}
+	}
+
+	ParticleSource* source = m_freeSources.back();
+	m_freeSources.pop_back();
+
+	*source = ParticleSource();
 
 	// If we are currently in the onFrame function, adding stuff to the vector would invalidate the iterator currently in use
 	if (m_processingSources) {
-		m_deferredSourceAdding.emplace_back();
-
-		source = &m_deferredSourceAdding.back();
+		m_deferredSourceAdding.push_back(source);
 	}
 	else {
-		m_sources.emplace_back();
-
-		source = &m_sources.back();
+		m_sources.push_back(source);
 	}
 
 	return source;
 }
 
+void ParticleManager::freeSource(ParticleSource* source) {
+	m_freeSources.push_back(source);
+}
+
 ParticleEffectHandle ParticleManager::getEffectByName(const SCP_string& name)
 {
 	if (name.empty()) {
@@ -174,37 +192,148 @@ ParticleEffectHandle ParticleManager::getEffectByName(const SCP_string& name)
 	return ParticleEffectHandle(distance(m_effects.begin(), foundIterator));
 }
 
+void ParticleManager::updateHostTransforms() {
+	m_hostTransforms.clear();
+	m_hostLookup.clear();
+	m_sourceHosts.assign(m_sources.size(), SIZE_MAX);
+
+	for (size_t i = 0; i < m_sources.size(); ++i) {
+		if (!m_sourceResults[i]) {
+			continue;
+		}
+
+		auto origin = m_sources[i]->getOrigin();
+
+		auto key = origin->getHostKey();
+		if (key == nullptr) {
+			continue;
+		}
+
+		auto iter = m_hostLookup.find(key);
+		if (iter != m_hostLookup.end()) {
+			m_sourceHosts[i] = iter->second;
+			continue;
+		}
+
+		SourceHostTransform transform;
+		origin->computeHostTransform(&transform);
+
+		m_hostTransforms.push_back(transform);
+		m_sourceHosts[i] = m_hostTransforms.size() - 1;
+		m_hostLookup.insert(std::make_pair(key, m_sourceHosts[i]));
+	}
+
+	// The vector doesn't change anymore so the pointers stay valid
+	for (size_t i = 0; i < m_sources.size(); ++i) {
+		if (m_sourceHosts[i] != SIZE_MAX) {
+			m_sources[i]->getOrigin()->setHostTransform(&m_hostTransforms[m_sourceHosts[i]]);
+		}
+	}
+}
+
+void ParticleManager::processSources() {
+	m_effectGroupLookup.clear();
+	for (auto& group : m_effectGroups) {
+		group.clear();
+	}
+	m_serialSources.clear();
+
+	size_t numGroups = 0;
+	for (size_t i = 0; i < m_sources.size(); ++i) {
+		if (!m_sourceResults[i]) {
+			continue;
+		}
+
+		auto effect = m_sources[i]->getEffect();
+		if (!Cmdline_mt_particles || !effect->canProcessInParallel()) {
+			m_serialSources.push_back(i);
+			continue;
+		}
+
+		// Groups are numbered in the order of the sources so the order in which the particles are created is fixed
+		auto iter = m_effectGroupLookup.find(effect);
+		if (iter == m_effectGroupLookup.end()) {
+			iter = m_effectGroupLookup.insert(std::make_pair(effect, numGroups)).first;
+			++numGroups;
+
+			if (m_effectGroups.size() < numGroups) {
+				m_effectGroups.resize(numGroups);
+				m_effectGroupParticles.resize(numGroups);
+			}
+		}
+
+		m_effectGroups[iter->second].push_back(i);
+	}
+
+	if (numGroups > 1) {
+		::util::get_worker_pool().parallelFor(numGroups, 1, [this](size_t begin, size_t end, size_t) {
+			for (auto group = begin; group < end; ++group) {
+				particle::set_create_buffer(&m_effectGroupParticles[group]);
+
+				for (auto index : m_effectGroups[group]) {
+					m_sourceResults[index] = m_sources[index]->process() ? 1 : 0;
+				}
+
+				particle::set_create_buffer(nullptr);
+			}
+		});
+
+		for (size_t group = 0; group < numGroups; ++group) {
+			particle::create_buffered(m_effectGroupParticles[group]);
+			m_effectGroupParticles[group].clear();
+		}
+	} else if (numGroups == 1) {
+		// Not worth the overhead of the worker threads
+		for (auto index : m_effectGroups[0]) {
+			m_sourceResults[index] = m_sources[index]->process() ? 1 : 0;
+		}
+	}
+
+	for (auto index : m_serialSources) {
+		m_sourceResults[index] = m_sources[index]->process() ? 1 : 0;
+	}
+}
+
 void ParticleManager::doFrame(float) {
 	if (Is_standalone) {
 		// Don't process sources for standalone server
-		m_sources.clear(); // Always clear the vector to free memory
+		clearSources(); // Always clear the sources to free memory
 	}
 	else {
 		TRACE_SCOPE(tracing::ProcessParticleEffects);
 
 		m_processingSources = true;
 
-		for (auto source = std::begin(m_sources); source != std::end(m_sources);) {
-			if (!source->isValid() || !source->process()) {
-				// if we're sitting on the very last source, popping-back will invalidate the iterator!
-				if (std::next(source) == m_sources.end()) {
-					m_sources.pop_back();
-					break;
-				}
+		m_sourceResults.resize(m_sources.size());
+		for (size_t i = 0; i < m_sources.size(); ++i) {
+			m_sourceResults[i] = m_sources[i]->isValid() ? 1 : 0;
+		}
+
+		updateHostTransforms();
+
+		processSources();
 
-				*source = std::move(m_sources.back());
+		for (size_t i = 0; i < m_sources.size();) {
+			m_sources[i]->getOrigin()->setHostTransform(nullptr);
+
+			if (!m_sourceResults[i]) {
+				freeSource(m_sources[i]);
+
+				m_sources[i] = m_sources.back();
+				m_sourceResults[i] = m_sourceResults.back();
 				m_sources.pop_back();
+				m_sourceResults.pop_back();
+
+				// The last source was moved here so this index has to be checked again
 				continue;
 			}
 
-			// source is only incremented here as elements would be skipped in
-			// the case that a source needs to be removed
-			++source;
+			++i;
 		}
 
 		m_processingSources = false;
 
-		for (auto& source : m_deferredSourceAdding) {
+		for (auto source : m_deferredSourceAdding) {
 			m_sources.push_back(source);
 		}
 		m_deferredSourceAdding.clear();
@@ -248,10 +377,6 @@ ParticleSourceWrapper ParticleManager::createSource(ParticleEffectHandle index)
 		auto composite = static_cast<effects::CompositeEffect*>(eff);
 		auto& childEffects = composite->getEffects();
 
-		// UGH, HACK! To implement the source wrapper we need constant pointers to all sources.
-		// To ensure this we reserve the number of sources we will need (current sources + sources being created)
-		m_sources.reserve(m_sources.size() + childEffects.size());
-
 		for (auto& effect : childEffects) {
 			ParticleSource* source = createSource();
 			source->setEffect(effect);
@@ -276,7 +401,15 @@ ParticleSourceWrapper ParticleManager::createSource(ParticleEffectHandle index)
 }
 
 void ParticleManager::clearSources() {
+	for (auto source : m_sources) {
+		freeSource(source);
+	}
 	m_sources.clear();
+
+	for (auto source : m_deferredSourceAdding) {
+		freeSource(source);
+	}
+	m_deferredSourceAdding.clear();
 }
 
 namespace util {
@@ -28,14 +28,32 @@ class ParticleManager {
  private:
 	SCP_vector<std::shared_ptr<ParticleEffect>> m_effects; //!< All parsed effects
 
-	SCP_vector<ParticleSource> m_sources; //!< The currently active sources
+	/**
+	 * The storage of the sources. The sources are allocated in blocks and never move so the pointers returned by
+	 * #createSource() stay valid. Sources which are not used anymore are kept in #m_freeSources for reuse.
+	 */
+	SCP_vector<std::unique_ptr<ParticleSource[]>> m_sourceBlocks;
+	SCP_vector<ParticleSource*> m_freeSources;
+
+	SCP_vector<ParticleSource*> m_sources; //!< The currently active sources
 
 	bool m_processingSources = false; //!< @c true if sources are currently being processed
 	/**
 	 * If the sources are currently being processed, no additional sources can be added. Instead, they are added to this
 	 * vector and then added to the main vector when processing is done.
 	 */
-	SCP_vector<ParticleSource> m_deferredSourceAdding;
+	SCP_vector<ParticleSource*> m_deferredSourceAdding;
+
+	// The data of one frame, it is kept between frames to avoid allocations
+	SCP_vector<SourceHostTransform> m_hostTransforms; //!< The transforms of all hosts of the active sources
+	SCP_unordered_map<const void*, size_t> m_hostLookup; //!< Maps the host keys to the transforms
+	SCP_vector<size_t> m_sourceHosts; //!< The index of the host transform of each source
+	SCP_vector<ubyte> m_sourceResults; //!< @c true if the source should be processed in the next frame
+
+	SCP_unordered_map<const ParticleEffect*, size_t> m_effectGroupLookup;
+	SCP_vector<SCP_vector<size_t>> m_effectGroups; //!< The sources which are processed in parallel, grouped by effect
+	SCP_vector<SCP_vector<particle_info>> m_effectGroupParticles; //!< The particles created by the effect groups
+	SCP_vector<size_t> m_serialSources; //!< The sources which have to be processed on the main thread
 
 	/**
 	 * The global paticle manager
@@ -47,10 +65,28 @@ class ParticleManager {
 	 *
 	 * This also handles the case when a source is created when current processing the sources
 	 *
-	 * @warning The pointer is temporary and only valid until the #m_sources is modified!
 	 * @return The source pointer
 	 */
 	ParticleSource* createSource();
+
+	/**
+	 * @brief Returns a source which is not used anymore to the pool
+	 */
+	void freeSource(ParticleSource* source);
+
+	/**
+	 * @brief Evaluates the hosts of the valid sources once and shares the transforms between sources on the same host
+	 */
+	void updateHostTransforms();
+
+	/**
+	 * @brief Processes the valid sources and stores if they should continue to be processed
+	 *
+	 * With -mt_particles the sources of effects which support it are processed on worker threads. The particles they
+	 * create are buffered per effect and created in a fixed order afterwards so the result does not depend on the
+	 * number of threads.
+	 */
+	void processSources();
  public:
 	ParticleManager() {}
 
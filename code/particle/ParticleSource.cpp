@@ -9,28 +9,70 @@ SourceOrigin::SourceOrigin() : m_originType(SourceOriginType::NONE),
 							   m_offset(vmd_zero_vector) {
 }
 
-void SourceOrigin::getGlobalPosition(vec3d* posOut) const {
-	Assertion(posOut != nullptr, "Invalid vector pointer passed!");
-	Assertion(m_originType != SourceOriginType::NONE, "Invalid origin type!");
+const void* SourceOrigin::getHostKey() const {
+	switch (m_originType) {
+		case SourceOriginType::OBJECT:
+			return m_origin.m_object.objp;
+		case SourceOriginType::PARTICLE:
+			// The particles don't move in memory while the sources are processed
+			return &m_origin.m_particle.pos();
+		default:
+			return nullptr;
+	}
+}
 
-	vec3d offset;
+void SourceOrigin::computeHostTransform(SourceHostTransform* transformOut) const {
 	switch (m_originType) {
 		case SourceOriginType::OBJECT: {
-			*posOut = m_origin.m_object.objp->pos;
-			vm_vec_unrotate(&offset, &m_offset, &m_origin.m_object.objp->orient);
+			auto objp = m_origin.m_object.objp;
+
+			transformOut->pos = objp->pos;
+			transformOut->orient = objp->orient;
+			transformOut->velocity = objp->phys_info.vel;
 			break;
 		}
 		case SourceOriginType::PARTICLE: {
-			*posOut = m_origin.m_particle.lock()->pos;
+			transformOut->pos = m_origin.m_particle.pos();
+			transformOut->velocity = m_origin.m_particle.velocity();
 
-			matrix m = vmd_identity_matrix;
-			vec3d dir = m_origin.m_particle.lock()->velocity;
+			vec3d dir = transformOut->velocity;
 
 			vm_vec_normalize_safe(&dir);
-			vm_vector_2_matrix_norm(&m, &dir);
+			transformOut->orient = vmd_identity_matrix;
+			vm_vector_2_matrix_norm(&transformOut->orient, &dir);
+			break;
+		}
+		case SourceOriginType::VECTOR: // Intentional fall-through, plain vectors have no host
+		default: {
+			transformOut->pos = vmd_zero_vector;
+			transformOut->orient = vmd_identity_matrix;
+			transformOut->velocity = vmd_zero_vector;
+			break;
+		}
+	}
+}
 
-			vm_vec_unrotate(&offset, &m_offset, &m);
+void SourceOrigin::getHostTransform(SourceHostTransform* transformOut) const {
+	if (m_hostTransform != nullptr) {
+		*transformOut = *m_hostTransform;
+	} else {
+		computeHostTransform(transformOut);
+	}
+}
+
+void SourceOrigin::getGlobalPosition(vec3d* posOut) const {
+	Assertion(posOut != nullptr, "Invalid vector pointer passed!");
+	Assertion(m_originType != SourceOriginType::NONE, "Invalid origin type!");
+
+	vec3d offset;
+	switch (m_originType) {
+		case SourceOriginType::OBJECT: // Intentional fall-through
+		case SourceOriginType::PARTICLE: {
+			SourceHostTransform host;
+			getHostTransform(&host);
 
+			*posOut = host.pos;
+			vm_vec_unrotate(&offset, &m_offset, &host.orient);
 			break;
 		}
 		case SourceOriginType::VECTOR: {
@@ -49,12 +91,14 @@ void SourceOrigin::getGlobalPosition(vec3d* posOut) const {
 }
 void SourceOrigin::getHostOrientation(matrix* matOut) const {
 	switch (m_originType) {
-	case SourceOriginType::OBJECT:
-		*matOut = m_origin.m_object.objp->orient;
-		break;
-	case SourceOriginType::PARTICLE:
-		vm_vector_2_matrix(matOut, &m_origin.m_particle.lock()->velocity, nullptr, nullptr);
+	case SourceOriginType::OBJECT: // Intentional fall-through
+	case SourceOriginType::PARTICLE: {
+		SourceHostTransform host;
+		getHostTransform(&host);
+
+		*matOut = host.orient;
 		break;
+	}
 	case SourceOriginType::VECTOR: // Intentional fall-through, plain vectors have no orientation
 	default:
 		*matOut = vmd_identity_matrix;
@@ -93,10 +137,13 @@ void SourceOrigin::applyToParticleInfo(particle_info& info, bool allowRelative)
 
 vec3d SourceOrigin::getVelocity() const {
 	switch (this->m_originType) {
-		case SourceOriginType::OBJECT:
-			return m_origin.m_object.objp->phys_info.vel;
-		case SourceOriginType::PARTICLE:
-			return m_origin.m_particle.lock()->velocity;
+		case SourceOriginType::OBJECT: // Intentional fall-through
+		case SourceOriginType::PARTICLE: {
+			SourceHostTransform host;
+			getHostTransform(&host);
+
+			return host.velocity;
+		}
 		default:
 			return vmd_zero_vector;
 	}
@@ -123,9 +170,9 @@ void SourceOrigin::moveToObject(object* objp, vec3d* offset) {
 	m_offset = *offset;
 }
 
-void SourceOrigin::moveToParticle(const WeakParticlePtr& weakParticlePtr) {
+void SourceOrigin::moveToParticle(const ParticleHandle& particleHandle) {
 	m_originType = SourceOriginType::PARTICLE;
-	m_origin.m_particle = weakParticlePtr;
+	m_origin.m_particle = particleHandle;
 }
 
 bool SourceOrigin::isValid() const {
@@ -155,7 +202,7 @@ bool SourceOrigin::isValid() const {
 			return wp->weapon_state == m_weaponState;
 		}
 		case SourceOriginType::PARTICLE:
-			return !m_origin.m_particle.expired();
+			return m_origin.m_particle.isValid();
 		case SourceOriginType::VECTOR:
 			return true;
 	}
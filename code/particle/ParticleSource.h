@@ -33,6 +33,17 @@ class ParticleSource;
 
 class ParticleEffect;
 
+/**
+ * @brief The position, orientation and velocity of the host of a source
+ *
+ * For a particle host the orientation points along the velocity of the particle.
+ */
+struct SourceHostTransform {
+	vec3d pos;
+	matrix orient;
+	vec3d velocity;
+};
+
 /**
  * @brief A source origin
  *
@@ -48,13 +59,17 @@ class SourceOrigin {
 
 		object_h m_object;
 
-		WeakParticlePtr m_particle;
+		ParticleHandle m_particle;
 	} m_origin;
 
 	WeaponState m_weaponState;
 
 	vec3d m_offset;
 
+	const SourceHostTransform* m_hostTransform = nullptr; //!< The cached transform of the host, may be @c nullptr
+
+	void getHostTransform(SourceHostTransform* transformOut) const;
+
  public:
 	/**
 	 * @brief Initializes the origin with default values
@@ -73,6 +88,30 @@ class SourceOrigin {
 
 	inline object* getObjectHost() const { return m_origin.m_object.objp; }
 
+	/**
+	 * @brief Gets a key which is the same for all origins on the same host
+	 *
+	 * The key of a particle host is only unique until the particles are modified.
+	 *
+	 * @return The key or @c nullptr if the origin has no host
+	 */
+	const void* getHostKey() const;
+
+	/**
+	 * @brief Computes the current transform of the host
+	 * @param transformOut The transform of the host
+	 */
+	void computeHostTransform(SourceHostTransform* transformOut) const;
+
+	/**
+	 * @brief Sets a precomputed transform of the host
+	 *
+	 * The transform is used instead of evaluating the host again until it is reset with @c nullptr.
+	 *
+	 * @param transform The transform, may be @c nullptr
+	 */
+	inline void setHostTransform(const SourceHostTransform* transform) { m_hostTransform = transform; }
+
 	/**
 	 * @brief Determines if the origin is valid
 	 *
@@ -119,9 +158,9 @@ class SourceOrigin {
 
 	/**
 	 * @brief Moves the source to the specified particle
-	 * @param weakParticlePtr The hosting particle
+	 * @param particleHandle The hosting particle
 	 */
-	void moveToParticle(const WeakParticlePtr& weakParticlePtr);
+	void moveToParticle(const ParticleHandle& particleHandle);
 
 	friend class ParticleSource;
 };
@@ -60,7 +60,7 @@ namespace particle
 		}
 	}
 
-	void ParticleSourceWrapper::moveToParticle(const WeakParticlePtr& ptr)
+	void ParticleSourceWrapper::moveToParticle(const ParticleHandle& ptr)
 	{
 		for (auto& source : m_sources)
 		{
@@ -176,6 +176,9 @@ class GenericShapeEffect : public ParticleEffect {
 
 	EffectType getType() const override { return m_shape.getType(); }
 
+	// A trail needs a persistent particle and a new source
+	bool canProcessInParallel() const override { return !m_particleTrail.isValid(); }
+
 	void pageIn() override {
 		m_particleProperties.pageIn();
 	}
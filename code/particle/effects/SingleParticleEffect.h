@@ -32,6 +32,8 @@ class SingleParticleEffect: public ParticleEffect {
 
 	EffectType getType() const override { return EffectType::Single; }
 
+	bool canProcessInParallel() const override { return true; }
+
 	util::ParticleProperties& getProperties() { return m_particleProperties; }
 
 	static SingleParticleEffect* createInstance(int effectID, float minSize, float maxSize,
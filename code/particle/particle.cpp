@@ -15,17 +15,204 @@
 #include "debugconsole/console.h"
 #include "globalincs/systemvars.h"
 #include "graphics/2d.h"
+#include "graphics/material.h"
 #include "render/3d.h"
 #include "render/batching.h"
 #include "tracing/tracing.h"
 #include "tracing/Monitor.h"
+#include "utils/WorkerPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_USE_SSE2
+#endif
+
+extern bool Cmdline_mt_particles;
 
 using namespace particle;
 
 namespace
 {
-	SCP_vector<::particle::particle> Particles;
-	SCP_vector<ParticlePtr> Persistent_particles;
+	// The data of a particle before it is added to the store
+	struct new_particle {
+		vec3d pos;
+		vec3d velocity;
+		float max_life;
+		float radius;
+		int type;
+		int optional_data;
+		int nframes;
+		int attached_objnum;
+		int attached_sig;
+		bool reverse;
+	};
+
+	/**
+	 * The particles are stored as a structure of arrays. move_all() only touches the position, velocity and age arrays
+	 * for the integration and the arrays are compacted by moving the last particle into the slot of a removed one.
+	 */
+	struct particle_store {
+		// Updated every frame
+		SCP_vector<vec3d> pos;
+		SCP_vector<vec3d> velocity;
+		SCP_vector<float> age;
+		SCP_vector<float> max_life;
+
+		// Only read by the expiry check and for rendering
+		SCP_vector<ubyte> looping;
+		SCP_vector<float> radius;
+		SCP_vector<int> type;
+		SCP_vector<int> optional_data;
+		SCP_vector<int> nframes;
+		SCP_vector<int> attached_objnum;
+		SCP_vector<int> attached_sig;
+		SCP_vector<ubyte> reverse;
+		SCP_vector<ubyte> orient_index; // which of the orientations of a volume bitmap is used
+		SCP_vector<int> slot;           // the handle slot of a persistent particle, -1 for other particles
+
+		// Set by move_all() for the particles which have to be removed
+		SCP_vector<ubyte> expired;
+
+		size_t size() const { return pos.size(); }
+
+		bool empty() const { return pos.empty(); }
+
+		void push_back(const new_particle& part, ubyte orient, int handle_slot)
+		{
+			pos.push_back(part.pos);
+			velocity.push_back(part.velocity);
+			age.push_back(0.0f);
+			max_life.push_back(part.max_life);
+
+			looping.push_back(0);
+			radius.push_back(part.radius);
+			type.push_back(part.type);
+			optional_data.push_back(part.optional_data);
+			nframes.push_back(part.nframes);
+			attached_objnum.push_back(part.attached_objnum);
+			attached_sig.push_back(part.attached_sig);
+			reverse.push_back(part.reverse ? 1 : 0);
+			orient_index.push_back(orient);
+			slot.push_back(handle_slot);
+
+			expired.push_back(0);
+		}
+
+		// Moves the last particle to the given index, returns the handle slot of the moved particle
+		int move_last_to(size_t index)
+		{
+			auto last = size() - 1;
+
+			pos[index] = pos[last];
+			velocity[index] = velocity[last];
+			age[index] = age[last];
+			max_life[index] = max_life[last];
+
+			looping[index] = looping[last];
+			radius[index] = radius[last];
+			type[index] = type[last];
+			optional_data[index] = optional_data[last];
+			nframes[index] = nframes[last];
+			attached_objnum[index] = attached_objnum[last];
+			attached_sig[index] = attached_sig[last];
+			reverse[index] = reverse[last];
+			orient_index[index] = orient_index[last];
+			slot[index] = slot[last];
+
+			expired[index] = expired[last];
+
+			return slot[index];
+		}
+
+		void pop_back()
+		{
+			pos.pop_back();
+			velocity.pop_back();
+			age.pop_back();
+			max_life.pop_back();
+
+			looping.pop_back();
+			radius.pop_back();
+			type.pop_back();
+			optional_data.pop_back();
+			nframes.pop_back();
+			attached_objnum.pop_back();
+			attached_sig.pop_back();
+			reverse.pop_back();
+			orient_index.pop_back();
+			slot.pop_back();
+
+			expired.pop_back();
+		}
+
+		void clear()
+		{
+			pos.clear();
+			velocity.clear();
+			age.clear();
+			max_life.clear();
+
+			looping.clear();
+			radius.clear();
+			type.clear();
+			optional_data.clear();
+			nframes.clear();
+			attached_objnum.clear();
+			attached_sig.clear();
+			reverse.clear();
+			orient_index.clear();
+			slot.clear();
+
+			expired.clear();
+		}
+	};
+
+	// Maps the handles of persistent particles to their index in the store
+	struct handle_slot {
+		uint32_t generation;
+		int index; // -1 if the slot is free
+	};
+
+	particle_store Particles;
+
+	SCP_vector<handle_slot> Handle_slots;
+	SCP_vector<uint32_t> Free_handle_slots;
+
+	// Set while particles are created on a worker thread
+	thread_local SCP_vector<particle_info>* Create_buffer = nullptr;
+
+	// Particles per chunk of the multi-threaded update
+	const size_t MOVE_CHUNK_SIZE = 4096;
+
+	// A particle which passed the culling
+	struct render_item {
+		vertex pos;
+		int texture;
+		int orient;
+		float radius;
+		float alpha;
+	};
+
+	struct render_sort_entry {
+		uint64_t key;
+		uint32_t item;
+	};
+
+	// The render data is kept between frames to avoid allocations
+	SCP_vector<vec3d> Render_positions;
+	SCP_vector<uint32_t> Render_visible;
+	SCP_vector<render_item> Render_items;
+	SCP_vector<render_sort_entry> Render_sort;
+	SCP_vector<render_sort_entry> Render_sort_temp;
+
+	render_stats Render_stats;
+
+	MONITOR(NumParticlesSubmitted)
+	MONITOR(NumParticlesCulled)
+	MONITOR(NumParticleBatches)
+
+	// The base texture and the blend mode, the material only depends on the renderer so it's the same for all particles
+	const int RENDER_SORT_KEY_BITS = 40;
 
 	int Anim_bitmap_id_fire = -1;
 	int Anim_num_frames_fire = -1;
@@ -75,6 +262,203 @@ namespace
 		// based on value of 'count' (detail level)
 		return (50 + (25 * (count - 1)));
 	}
+
+	uint32_t allocate_handle_slot(size_t index)
+	{
+		uint32_t slot;
+		if (!Free_handle_slots.empty())
+		{
+			slot = Free_handle_slots.back();
+			Free_handle_slots.pop_back();
+		}
+		else
+		{
+			slot = (uint32_t) Handle_slots.size();
+			Handle_slots.push_back({1, -1});
+		}
+
+		Handle_slots[slot].index = (int) index;
+
+		return slot;
+	}
+
+	void free_handle_slot(int slot)
+	{
+		auto& handle = Handle_slots[slot];
+
+		// Invalidates all handles of the particle, generation 0 is reserved for invalid handles
+		++handle.generation;
+		if (handle.generation == 0)
+		{
+			handle.generation = 1;
+		}
+		handle.index = -1;
+
+		Free_handle_slots.push_back((uint32_t) slot);
+	}
+
+	size_t num_persistent_particles()
+	{
+		return Handle_slots.size() - Free_handle_slots.size();
+	}
+
+	// Removes a particle by moving the last particle into its place
+	void remove_particle(size_t index)
+	{
+		if (Particles.slot[index] >= 0)
+		{
+			free_handle_slot(Particles.slot[index]);
+		}
+
+		if (index + 1 < Particles.size())
+		{
+			auto moved_slot = Particles.move_last_to(index);
+			if (moved_slot >= 0)
+			{
+				Handle_slots[moved_slot].index = (int) index;
+			}
+		}
+
+		Particles.pop_back();
+	}
+
+	void remove_all_particles()
+	{
+		for (auto slot : Particles.slot)
+		{
+			if (slot >= 0)
+			{
+				free_handle_slot(slot);
+			}
+		}
+
+		Particles.clear();
+	}
+
+	// Ages the particles and moves them along their velocity
+	void integrate_particles(size_t begin, size_t end, float frametime)
+	{
+		// A particle which has just been created gets a tiny age so that it is rendered at least once
+		const float first_age = 0.00001f;
+
+		auto age = Particles.age.data();
+		auto i = begin;
+
+#ifdef PARTICLE_USE_SSE2
+		const __m128 zero4 = _mm_setzero_ps();
+		const __m128 first_age4 = _mm_set1_ps(first_age);
+		const __m128 frametime4 = _mm_set1_ps(frametime);
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(age + i);
+			__m128 is_new = _mm_cmpeq_ps(a, zero4);
+			__m128 aged = _mm_add_ps(a, frametime4);
+			_mm_storeu_ps(age + i, _mm_or_ps(_mm_and_ps(is_new, first_age4), _mm_andnot_ps(is_new, aged)));
+		}
+#endif
+		for (; i < end; ++i)
+		{
+			age[i] = (age[i] == 0.0f) ? first_age : (age[i] + frametime);
+		}
+
+		// The vectors are only three floats so the positions and velocities can be processed as flat float arrays
+		static_assert(sizeof(vec3d) == 3 * sizeof(float), "vec3d must not contain padding!");
+
+		auto pos = Particles.pos.data()->a1d;
+		auto vel = Particles.velocity.data()->a1d;
+		auto j = begin * 3;
+		auto end_j = end * 3;
+
+#ifdef PARTICLE_USE_SSE2
+		for (; j + 4 <= end_j; j += 4)
+		{
+			__m128 p = _mm_loadu_ps(pos + j);
+			__m128 v = _mm_loadu_ps(vel + j);
+			_mm_storeu_ps(pos + j, _mm_add_ps(p, _mm_mul_ps(v, frametime4)));
+		}
+#endif
+		for (; j < end_j; ++j)
+		{
+			pos[j] += vel[j] * frametime;
+		}
+	}
+
+	// Marks the particles which have to be removed
+	void check_expired_particles(size_t begin, size_t end, float frametime)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			bool remove = false;
+
+			// if its time expired, remove it. If the particle is looping then it will never be removed due to age
+			if (Particles.age[i] > Particles.max_life[i] && !Particles.looping[i])
+			{
+				// special case, if max_life is 0 then we want it to render at least once
+				if ((Particles.age[i] > frametime) || (Particles.max_life[i] > 0.0f))
+				{
+					remove = true;
+				}
+			}
+
+			// if the particle is attached to an object which has become invalid, kill it
+			auto objnum = Particles.attached_objnum[i];
+			if (objnum >= 0)
+			{
+				// if the signature has changed, or it's bogus, kill it
+				if ((objnum >= MAX_OBJECTS) || (Particles.attached_sig[i] != Objects[objnum].signature))
+				{
+					remove = true;
+				}
+			}
+
+			Particles.expired[i] = remove ? 1 : 0;
+		}
+	}
+
+	uint64_t render_sort_key(int texture)
+	{
+		auto base_tex = bm_get_base_frame(texture);
+		auto blend_mode = material_determine_blend_mode(texture, true);
+
+		return ((uint64_t) (uint32_t) base_tex << 8) | (uint8_t) blend_mode;
+	}
+
+	// Sorts the entries by the lowest key_bits bits of their keys, entries with equal keys keep their order
+	void radix_sort(SCP_vector<render_sort_entry>& entries, SCP_vector<render_sort_entry>& temp, int key_bits)
+	{
+		temp.resize(entries.size());
+
+		for (int shift = 0; shift < key_bits; shift += 8)
+		{
+			size_t offsets[256] = {};
+			for (auto& entry : entries)
+			{
+				++offsets[(entry.key >> shift) & 0xFF];
+			}
+
+			if (offsets[(entries.front().key >> shift) & 0xFF] == entries.size())
+			{
+				// All keys have the same digit
+				continue;
+			}
+
+			size_t offset = 0;
+			for (auto& count : offsets)
+			{
+				auto digit_count = count;
+				count = offset;
+				offset += digit_count;
+			}
+
+			for (auto& entry : entries)
+			{
+				temp[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+
+			entries.swap(temp);
+		}
+	}
 }
 
 namespace particle
@@ -104,8 +488,15 @@ namespace particle
 	// only call from game_shutdown()!!!
 	void close()
 	{
-		Persistent_particles.clear();
-		Particles.clear();
+		remove_all_particles();
+
+		Handle_slots.clear();
+		Free_handle_slots.clear();
+	}
+
+	size_t get_particle_count()
+	{
+		return Particles.size();
 	}
 
 	void page_in()
@@ -120,7 +511,78 @@ namespace particle
 	DCF_BOOL2(particles, Particles_enabled, "Turns particles on/off",
 			  "Usage: particles [bool]\nTurns particle system on/off.  If nothing passed, then toggles it.\n");
 
-	bool init_particle(particle* part, particle_info* info) {
+	ParticleHandle::ParticleHandle(uint32_t slot, uint32_t generation) : m_slot(slot), m_generation(generation) {}
+
+	bool ParticleHandle::isValid() const
+	{
+		if (m_slot >= Handle_slots.size())
+		{
+			return false;
+		}
+
+		auto& handle = Handle_slots[m_slot];
+		return handle.generation == m_generation && handle.index >= 0;
+	}
+
+	vec3d& ParticleHandle::pos() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.pos[Handle_slots[m_slot].index];
+	}
+
+	vec3d& ParticleHandle::velocity() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.velocity[Handle_slots[m_slot].index];
+	}
+
+	float& ParticleHandle::age() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.age[Handle_slots[m_slot].index];
+	}
+
+	float& ParticleHandle::max_life() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.max_life[Handle_slots[m_slot].index];
+	}
+
+	float& ParticleHandle::radius() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.radius[Handle_slots[m_slot].index];
+	}
+
+	int& ParticleHandle::attached_objnum() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.attached_objnum[Handle_slots[m_slot].index];
+	}
+
+	bool ParticleHandle::looping() const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		return Particles.looping[Handle_slots[m_slot].index] != 0;
+	}
+
+	void ParticleHandle::setLooping(bool looping) const
+	{
+		Assertion(isValid(), "Invalid particle handle used!");
+		Particles.looping[Handle_slots[m_slot].index] = looping ? 1 : 0;
+	}
+
+	bool ParticleHandle::operator==(const ParticleHandle& other) const
+	{
+		return m_slot == other.m_slot && m_generation == other.m_generation;
+	}
+
+	bool ParticleHandle::operator!=(const ParticleHandle& other) const
+	{
+		return !(*this == other);
+	}
+
+	static bool init_particle(new_particle* part, particle_info* info) {
 		if (!Particles_enabled)
 		{
 			return false;
@@ -130,7 +592,6 @@ namespace particle
 
 		part->pos = info->pos;
 		part->velocity = info->vel;
-		part->age = 0.0f;
 		part->max_life = info->lifetime;
 		part->radius = info->rad;
 		part->type = info->type;
@@ -138,8 +599,6 @@ namespace particle
 		part->attached_objnum = info->attached_objnum;
 		part->attached_sig = info->attached_sig;
 		part->reverse = info->reverse;
-		part->particle_index = (int) Persistent_particles.size();
-		part->looping = false;
 
 		switch (info->type)
 		{
@@ -207,26 +666,47 @@ namespace particle
 	}
 
 	void create(particle_info* pinfo) {
-		particle part;
+		if (Create_buffer != nullptr) {
+			Create_buffer->push_back(*pinfo);
+			return;
+		}
+
+		new_particle part;
 		if (!init_particle(&part, pinfo)) {
 			return;
 		}
 
-		Particles.push_back(part);
+		Particles.push_back(part, (ubyte) (num_persistent_particles() % 8), -1);
 	}
 
 	// Creates a single particle. See the PARTICLE_?? defines for types.
-	WeakParticlePtr createPersistent(particle_info* pinfo)
+	ParticleHandle createPersistent(particle_info* pinfo)
 	{
-		ParticlePtr new_particle = std::make_shared<particle>();
+		Assertion(Create_buffer == nullptr, "Persistent particles can't be created while particles are buffered!");
 
-		if (!init_particle(new_particle.get(), pinfo)) {
-			return WeakParticlePtr();
+		new_particle part;
+		if (!init_particle(&part, pinfo)) {
+			return ParticleHandle();
 		}
 
-		Persistent_particles.push_back(new_particle);
+		auto orient = (ubyte) (num_persistent_particles() % 8);
+		auto slot = allocate_handle_slot(Particles.size());
+
+		Particles.push_back(part, orient, (int) slot);
+
+		return ParticleHandle(slot, Handle_slots[slot].generation);
+	}
+
+	void set_create_buffer(SCP_vector<particle_info>* buffer)
+	{
+		Create_buffer = buffer;
+	}
 
-		return WeakParticlePtr(new_particle);
+	void create_buffered(const SCP_vector<particle_info>& buffer)
+	{
+		for (auto info : buffer) {
+			create(&info);
+		}
 	}
 
 	void create(vec3d* pos,
@@ -263,56 +743,6 @@ namespace particle
 		create(&pinfo);
 	}
 
-	/**
-	 * @brief Moves a single particle
-	 * @param frametime The length of the current frame
-	 * @param part The particle to process for movement
-	 * @return @c true if the particle has expired and should be removed, @c false otherwise
-	 */
-	static bool move_particle(float frametime, particle* part) {
-		if (part->age == 0.0f)
-		{
-			part->age = 0.00001f;
-		}
-		else
-		{
-			part->age += frametime;
-		}
-
-		bool remove_particle = false;
-
-		// if its time expired, remove it. If the particle is looping then it will never be removed due to age
-		if (part->age > part->max_life && !part->looping)
-		{
-			// special case, if max_life is 0 then we want it to render at least once
-			if ((part->age > frametime) || (part->max_life > 0.0f))
-			{
-				remove_particle = true;
-			}
-		}
-
-		// if the particle is attached to an object which has become invalid, kill it
-		if (part->attached_objnum >= 0)
-		{
-			// if the signature has changed, or it's bogus, kill it
-			if ((part->attached_objnum >= MAX_OBJECTS) ||
-				(part->attached_sig != Objects[part->attached_objnum].signature))
-			{
-				remove_particle = true;
-			}
-		}
-
-		if (remove_particle)
-		{
-			return true;
-		}
-
-		// move as a regular particle
-		vm_vec_scale_add2(&part->pos, &part->velocity, frametime);
-
-		return false;
-	}
-
 	void move_all(float frametime)
 	{
 		TRACE_SCOPE(tracing::ParticlesMoveAll);
@@ -320,48 +750,35 @@ namespace particle
 		if (!Particles_enabled)
 			return;
 
-		if (Persistent_particles.empty() && Particles.empty())
+		if (Particles.empty())
 			return;
 
-		for (auto p = Persistent_particles.begin(); p != Persistent_particles.end();)
-		{
-			ParticlePtr part = *p;
-			if (move_particle(frametime, part.get()))
-			{
-				// if we're sitting on the very last particle, popping-back will invalidate the iterator!
-				if (p + 1 == Persistent_particles.end())
-				{
-					Persistent_particles.pop_back();
-					break;
-				}
+		auto count = Particles.size();
 
-				*p = Persistent_particles.back();
-				Persistent_particles.pop_back();
-				continue;
-			}
-
-			// next particle
-			++p;
+		// The update of a particle only reads the object it is attached to so the chunks are independent
+		if (Cmdline_mt_particles && count > MOVE_CHUNK_SIZE)
+		{
+			::util::get_worker_pool().parallelFor(count, MOVE_CHUNK_SIZE, [frametime](size_t begin, size_t end, size_t) {
+				integrate_particles(begin, end, frametime);
+				check_expired_particles(begin, end, frametime);
+			});
+		}
+		else
+		{
+			integrate_particles(0, count, frametime);
+			check_expired_particles(0, count, frametime);
 		}
 
-		for (auto p = Particles.begin(); p != Particles.end();)
+		for (size_t i = 0; i < Particles.size();)
 		{
-			if (move_particle(frametime, &(*p)))
+			if (Particles.expired[i])
 			{
-				// if we're sitting on the very last particle, popping-back will invalidate the iterator!
-				if (p + 1 == Particles.end())
-				{
-					Particles.pop_back();
-					break;
-				}
-
-				*p = Particles.back();
-				Particles.pop_back();
+				// The last particle is moved here so this index has to be checked again
+				remove_particle(i);
 				continue;
 			}
 
-			// next particle
-			++p;
+			++i;
 		}
 	}
 
@@ -369,82 +786,114 @@ namespace particle
 	void kill_all()
 	{
 		// kill all active particles
-		Particles.clear();
-		Persistent_particles.clear();
+		remove_all_particles();
+	}
+
+	const render_stats& get_render_stats()
+	{
+		return Render_stats;
 	}
 
 	/**
-	 * @brief Renders a single particle
-	 * @param part The particle to render
-	 * @return @c true if the particle has been added to the rendering batch, @c false otherwise
+	 * @brief Rejects the particles which are behind the eye, transparent or off screen
+	 *
+	 * The world positions of all particles are computed first so the cheap back-facing check runs over a plain array.
+	 * The particles which pass all checks are added to #Render_items together with their sort key.
 	 */
-	static bool render_particle(particle* part) {
-		// skip back-facing particles (ripped from fullneb code)
+	static void cull_particles() {
+		auto count = Particles.size();
+
 		// Wanderer - add support for attached particles
-		vec3d p_pos;
-		if (part->attached_objnum >= 0)
-		{
-			vm_vec_unrotate(&p_pos, &part->pos, &Objects[part->attached_objnum].orient);
-			vm_vec_add2(&p_pos, &Objects[part->attached_objnum].pos);
-		}
-		else
+		Render_positions.resize(count);
+		for (size_t i = 0; i < count; ++i)
 		{
-			p_pos = part->pos;
+			auto attached_objnum = Particles.attached_objnum[i];
+			if (attached_objnum >= 0)
+			{
+				vm_vec_unrotate(&Render_positions[i], &Particles.pos[i], &Objects[attached_objnum].orient);
+				vm_vec_add2(&Render_positions[i], &Objects[attached_objnum].pos);
+			}
+			else
+			{
+				Render_positions[i] = Particles.pos[i];
+			}
 		}
 
-		if (vm_vec_dot_to_point(&Eye_matrix.vec.fvec, &Eye_position, &p_pos) <= 0.0f)
+		// skip back-facing particles (ripped from fullneb code)
+		Render_visible.clear();
+		for (size_t i = 0; i < count; ++i)
 		{
-			return false;
+			if (vm_vec_dot_to_point(&Eye_matrix.vec.fvec, &Eye_position, &Render_positions[i]) > 0.0f)
+			{
+				Render_visible.push_back((uint32_t) i);
+			}
 		}
 
-		// calculate the alpha to draw at
-		auto alpha = get_current_alpha(&p_pos);
+		Render_stats.culled = count - Render_visible.size();
 
-		// if it's transparent then just skip it
-		if (alpha <= 0.0f)
+		for (auto index : Render_visible)
 		{
-			return false;
-		}
+			auto p_pos = &Render_positions[index];
 
-		vertex pos;
-		auto flags = g3_rotate_vertex(&pos, &p_pos);
+			// calculate the alpha to draw at
+			auto alpha = get_current_alpha(p_pos);
 
-		if (flags)
-		{
-			return false;
-		}
+			// if it's transparent then just skip it
+			if (alpha <= 0.0f)
+			{
+				++Render_stats.culled;
+				continue;
+			}
 
-		g3_transfer_vertex(&pos, &p_pos);
+			vertex pos;
+			auto flags = g3_rotate_vertex(&pos, p_pos);
 
-		// figure out which frame we should be using
-		int framenum;
-		int cur_frame;
-		if (part->nframes > 1) {
-			framenum = bm_get_anim_frame(part->optional_data, part->age, part->max_life, part->looping);
-			cur_frame = part->reverse ? (part->nframes - framenum - 1) : framenum;
-		}
-		else
-		{
-			cur_frame = 0;
-		}
+			if (flags)
+			{
+				++Render_stats.culled;
+				continue;
+			}
 
-		if (part->type == PARTICLE_DEBUG)
-		{
-			gr_set_color(255, 0, 0);
-			g3_draw_sphere_ez(&p_pos, part->radius);
-		}
-		else
-		{
-			framenum = part->optional_data;
+			g3_transfer_vertex(&pos, p_pos);
+
+			if (Particles.type[index] == PARTICLE_DEBUG)
+			{
+				gr_set_color(255, 0, 0);
+				g3_draw_sphere_ez(p_pos, Particles.radius[index]);
+				continue;
+			}
 
-			Assert( cur_frame < part->nframes );
+			// figure out which frame we should be using
+			int cur_frame;
+			auto nframes = Particles.nframes[index];
+			if (nframes > 1) {
+				int framenum = bm_get_anim_frame(Particles.optional_data[index], Particles.age[index],
+					Particles.max_life[index], Particles.looping[index] != 0);
+				cur_frame = Particles.reverse[index] ? (nframes - framenum - 1) : framenum;
+			}
+			else
+			{
+				cur_frame = 0;
+			}
 
-			batching_add_volume_bitmap(framenum + cur_frame, &pos, part->particle_index % 8, part->radius, alpha);
+			Assert( cur_frame < nframes );
 
-			return true;
-		}
+			render_item item;
+			item.pos = pos;
+			item.texture = Particles.optional_data[index] + cur_frame;
+			item.orient = Particles.orient_index[index];
+			item.radius = Particles.radius[index];
+			item.alpha = alpha;
+
+			if (item.texture < 0)
+			{
+				Int3();
+				continue;
+			}
 
-		return false;
+			Render_sort.push_back({render_sort_key(item.texture), (uint32_t) Render_items.size()});
+			Render_items.push_back(item);
+		}
 	}
 
 	void render_all()
@@ -452,30 +901,44 @@ namespace particle
 		GR_DEBUG_SCOPE("Render Particles");
 		TRACE_SCOPE(tracing::ParticlesRenderAll);
 
-		bool render_batch = false;
+		Render_stats = render_stats();
+		Render_items.clear();
+		Render_sort.clear();
 
-		if (!Particles_enabled)
-			return;
+		if (Particles_enabled && !Particles.empty())
+		{
+			cull_particles();
+		}
 
-		if (Persistent_particles.empty() && Particles.empty())
-			return;
+		if (!Render_sort.empty())
+		{
+			radix_sort(Render_sort, Render_sort_temp, RENDER_SORT_KEY_BITS);
 
-		for (auto& part : Persistent_particles) {
-			if (render_particle(part.get())) {
-				render_batch = true;
-			}
-		}
+			// Every run of equal keys goes into the same batch so the batch only has to be looked up once per run
+			primitive_batch* batch = nullptr;
+			uint64_t batch_key = 0;
+			for (auto& entry : Render_sort)
+			{
+				auto& item = Render_items[entry.item];
+
+				if (batch == nullptr || entry.key != batch_key)
+				{
+					batch = batching_find_volume_batch(item.texture);
+					batch_key = entry.key;
+					++Render_stats.batches;
+				}
 
-		for (auto& part : Particles) {
-			if (render_particle(&part)) {
-				render_batch = true;
+				batching_add_volume_bitmap_to_batch(batch, item.texture, &item.pos, item.orient, item.radius, item.alpha);
 			}
-		}
 
-		if (render_batch)
-		{
+			Render_stats.submitted = Render_sort.size();
+
 			batching_render_all();
 		}
+
+		mon_NumParticlesSubmitted = (int) Render_stats.submitted;
+		mon_NumParticlesCulled = (int) Render_stats.culled;
+		mon_NumParticleBatches = (int) Render_stats.batches;
 	}
 
 	//============================================================================
@@ -38,6 +38,21 @@ namespace particle
 	// kill all active particles
 	void kill_all();
 
+	// number of active particles, persistent ones included
+	size_t get_particle_count();
+
+	/**
+	 * @brief Statistics of the last call of render_all()
+	 */
+	struct render_stats {
+		size_t submitted = 0; //!< Particles which were added to the batches
+		size_t culled = 0;    //!< Particles which were behind the eye, transparent or off screen
+		size_t batches = 0;   //!< Runs of particles with the same texture and blend mode
+	};
+
+	// statistics of the last rendered frame
+	const render_stats& get_render_stats();
+
 
 	//============================================================================
 	//=============== LOW-LEVEL SINGLE PARTICLE CREATION CODE ====================
@@ -76,27 +91,43 @@ namespace particle
 		bool lifetime_from_animation = true;	// if the particle plays an animation then use the anim length for the particle life
 	} particle_info;
 
-	typedef struct particle {
-		// old style data
-		vec3d	pos;				// position
-		vec3d	velocity;			// velocity
-		float	age;				// How long it's been alive
-		float	max_life;			// How much life we had
-		bool    looping;            // If the particle will loop its animation at the end of its life instead of expiring
-		float	radius;				// radius
-		int		type;				// type										// -1 = None
-		int		optional_data;		// depends on type
-		int		nframes;			// If an ani, how many frames?	
-
-		// new style data
-		int		attached_objnum;	// if this is set, pos is relative to the attached object. velocity is ignored
-		int		attached_sig;		// to check for dead/nonexistent objects
-		bool	reverse;			// play any animations in reverse
-		int		particle_index;		// used to keep particle offset in dynamic array for orient usage
-	} particle;
-
-	typedef std::weak_ptr<particle> WeakParticlePtr;
-	typedef std::shared_ptr<particle> ParticlePtr;
+	/**
+	 * @brief A handle of a persistent particle
+	 *
+	 * The particles are stored as a structure of arrays which is compacted every frame so a particle does not have a
+	 * stable address. A handle refers to a slot which tracks where the particle currently is. When the particle is
+	 * removed the generation of its slot is increased which invalidates all handles of the particle, even if the slot
+	 * is reused for a new particle later.
+	 *
+	 * The references returned by the accessors are only valid until the next particle is created or the particles are
+	 * moved. The accessors must only be used if isValid() returns @c true.
+	 */
+	class ParticleHandle {
+		uint32_t m_slot = 0;
+		uint32_t m_generation = 0; // Generation 0 is never used by a slot so a default constructed handle is invalid
+
+	 public:
+		ParticleHandle() = default;
+		ParticleHandle(uint32_t slot, uint32_t generation);
+
+		/**
+		 * @brief Checks if the particle still exists
+		 */
+		bool isValid() const;
+
+		vec3d& pos() const;
+		vec3d& velocity() const;
+		float& age() const;
+		float& max_life() const;
+		float& radius() const;
+		int& attached_objnum() const;
+
+		bool looping() const;
+		void setLooping(bool looping) const;
+
+		bool operator==(const ParticleHandle& other) const;
+		bool operator!=(const ParticleHandle& other) const;
+	};
 
 	/**
 	 * @brief Creates a non-persistent particle
@@ -128,14 +159,32 @@ namespace particle
 	/**
 	 * @brief Creates a persistent particle
 	 *
-	 * A persistent particle is handled differently from a standard particle. It is possible to hold a weak or strong
-	 * reference to a persistent particle which allows to track where the particle is and also allows to change particle
-	 * properties after it has been created.
+	 * A persistent particle is handled differently from a standard particle. It is possible to hold a handle of a
+	 * persistent particle which allows to track where the particle is and also allows to change particle properties
+	 * after it has been created.
 	 *
 	 * @param pinfo A structure containg information about how the particle should be created
-	 * @return A weak reference to the particle
+	 * @return A handle of the particle, invalid if the particle could not be created
+	 */
+	ParticleHandle createPersistent(particle_info* pinfo);
+
+	/**
+	 * @brief Makes create() store the particles created on the current thread in a buffer
+	 *
+	 * This allows creating non-persistent particles on worker threads. The buffered particles are added with
+	 * create_buffered() on the main thread afterwards. Passing @c nullptr makes create() add the particles directly
+	 * again.
+	 *
+	 * @param buffer The buffer for the particles of the current thread, may be @c nullptr
+	 */
+	void set_create_buffer(SCP_vector<particle_info>* buffer);
+
+	/**
+	 * @brief Creates the particles which were stored by set_create_buffer()
+	 *
+	 * @param buffer The buffered particles
 	 */
-    WeakParticlePtr createPersistent(particle_info* pinfo);
+	void create_buffered(const SCP_vector<particle_info>& buffer);
 
 	//============================================================================
 	//============== HIGH-LEVEL PARTICLE SYSTEM CREATION CODE ====================
@@ -42,15 +42,15 @@ void ParticleProperties::createParticle(particle_info& info) {
 	create(&info);
 }
 
-WeakParticlePtr ParticleProperties::createPersistentParticle(particle_info& info) {
+ParticleHandle ParticleProperties::createPersistentParticle(particle_info& info) {
 	info.optional_data = m_bitmap;
 	info.type = PARTICLE_BITMAP;
 	info.rad = m_radius.next();
 
 	auto p = createPersistent(&info);
 
-	if (m_hasLifetime && !p.expired()) {
-		p.lock()->max_life = m_lifetime.next();
+	if (m_hasLifetime && p.isValid()) {
+		p.max_life() = m_lifetime.next();
 	}
 
 	return p;
@@ -40,7 +40,7 @@ class ParticleProperties {
 	 * @param info The base values of the particle. Some values will be overwritten by this function
 	 * @return The created particle
 	 */
-	WeakParticlePtr createPersistentParticle(particle_info& info);
+	ParticleHandle createPersistentParticle(particle_info& info);
 
 	void pageIn();
 };
@@ -0,0 +1,408 @@
+#include "physics/physics_batch.h"
+#include "debugconsole/console.h"
+#include "io/timer.h"
+#include "math/staticrand.h"
+
+#include <cmath>
+
+// These have to match physics.cpp
+#define	REDUCED_DAMP_FACTOR	10
+#define	REDUCED_DAMP_TIME		2000
+
+// apply_physics() doesn't damp at all below this
+#define	MIN_DAMPING			0.0001f
+
+namespace {
+
+// Same as the damping part of physics_sim_vel()
+void compute_damping(physics_info *pi, vec3d *damp)
+{
+	if ((pi->flags & PF_REDUCED_DAMP) && (timestamp_elapsed(pi->reduced_damp_decay))) {
+		pi->flags &= ~PF_REDUCED_DAMP;
+	}
+
+	if (pi->flags & PF_DEAD_DAMP) {
+		vm_vec_make( damp, pi->side_slip_time_const, pi->side_slip_time_const, pi->side_slip_time_const );
+	} else if (pi->flags & PF_REDUCED_DAMP) {
+		if ( timestamp_elapsed(pi->reduced_damp_decay) ) {
+			vm_vec_make( damp, pi->side_slip_time_const, pi->side_slip_time_const, 0.0f );
+		} else {
+			float reduced_damp_fraction_time_left = timestamp_until( pi->reduced_damp_decay ) / (float) REDUCED_DAMP_TIME;
+			damp->xyz.x = pi->side_slip_time_const * ( 1 + (REDUCED_DAMP_FACTOR-1) * reduced_damp_fraction_time_left );
+			damp->xyz.y = pi->side_slip_time_const * ( 1 + (REDUCED_DAMP_FACTOR-1) * reduced_damp_fraction_time_left );
+			damp->xyz.z = pi->side_slip_time_const * reduced_damp_fraction_time_left * REDUCED_DAMP_FACTOR;
+		}
+	} else {
+		if (pi->use_newtonian_damp) {
+			vm_vec_make( damp, pi->side_slip_time_const, pi->side_slip_time_const, pi->side_slip_time_const );
+		} else {
+			vm_vec_make( damp, pi->side_slip_time_const, pi->side_slip_time_const, 0.0f );
+		}
+	}
+}
+
+// The exponential part of apply_physics(). exp() can't be vectorized without changing the results so it gets its own
+// loop.
+void compute_exp_factors(const float *damping, float *exp_factor, float sim_time, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		exp_factor[i] = (damping[i] < MIN_DAMPING) ? 0.0f : (float)exp( -sim_time/damping[i] );
+	}
+}
+
+// The rest of apply_physics()
+void apply_physics_batch(const float *damping, const float *exp_factor, const float *desired_vel, const float *initial_vel,
+	float sim_time, float *new_vel, float *delta_pos, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		float dv = initial_vel[i] - desired_vel[i];
+		float e = exp_factor[i];
+
+		bool undamped = damping[i] < MIN_DAMPING;
+
+		if (delta_pos) {
+			delta_pos[i] = undamped ? desired_vel[i]*sim_time : (1.0f - e)*dv*damping[i] + desired_vel[i]*sim_time;
+		}
+		new_vel[i] = undamped ? desired_vel[i] : dv*e + desired_vel[i];
+	}
+}
+
+// Same as vm_vec_rotate() if transpose is false or vm_vec_unrotate() if it is true
+void rotate_batch(SCP_vector<float> *orient, const float *x, const float *y, const float *z, float *out_x, float *out_y,
+	float *out_z, bool transpose, size_t count)
+{
+	// Either the rows or the columns of the matrix
+	const float *m[9];
+	for (int row = 0; row < 3; ++row) {
+		for (int col = 0; col < 3; ++col) {
+			m[row * 3 + col] = transpose ? orient[col * 3 + row].data() : orient[row * 3 + col].data();
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		float vx = x[i];
+		float vy = y[i];
+		float vz = z[i];
+
+		out_x[i] = (vx*m[0][i])+(vy*m[1][i])+(vz*m[2][i]);
+		out_y[i] = (vx*m[3][i])+(vy*m[4][i])+(vz*m[5][i]);
+		out_z[i] = (vx*m[6][i])+(vy*m[7][i])+(vz*m[8][i]);
+	}
+}
+
+void resize_arrays(SCP_vector<float> *arrays, int num, size_t count)
+{
+	for (int i = 0; i < num; ++i) {
+		arrays[i].resize(count);
+	}
+}
+
+// Same as physics_sim_vel() without the special warp handling
+void sim_vel_batch(physics_batch *batch, float sim_time)
+{
+	size_t count = batch->infos.size();
+
+	resize_arrays(batch->local_vel, 3, count);
+	resize_arrays(batch->local_desired_vel, 3, count);
+	resize_arrays(batch->exp_factor, 3, count);
+
+	rotate_batch(batch->orient, batch->vel[0].data(), batch->vel[1].data(), batch->vel[2].data(),
+		batch->local_vel[0].data(), batch->local_vel[1].data(), batch->local_vel[2].data(), false, count);
+	rotate_batch(batch->orient, batch->desired_vel[0].data(), batch->desired_vel[1].data(), batch->desired_vel[2].data(),
+		batch->local_desired_vel[0].data(), batch->local_desired_vel[1].data(), batch->local_desired_vel[2].data(), false, count);
+
+	// The local desired velocity isn't needed anymore so it's used for the displacement. The local velocity is updated in
+	// place.
+	for (int axis = 0; axis < 3; ++axis) {
+		compute_exp_factors(batch->damp[axis].data(), batch->exp_factor[axis].data(), sim_time, count);
+		apply_physics_batch(batch->damp[axis].data(), batch->exp_factor[axis].data(), batch->local_desired_vel[axis].data(),
+			batch->local_vel[axis].data(), sim_time, batch->local_vel[axis].data(), batch->local_desired_vel[axis].data(), count);
+	}
+
+	// The world displacement goes into the exp factors which aren't needed anymore either
+	auto disp = batch->exp_factor;
+	rotate_batch(batch->orient, batch->local_desired_vel[0].data(), batch->local_desired_vel[1].data(), batch->local_desired_vel[2].data(),
+		disp[0].data(), disp[1].data(), disp[2].data(), true, count);
+
+	for (int axis = 0; axis < 3; ++axis) {
+		float *pos = batch->pos[axis].data();
+		const float *delta = disp[axis].data();
+
+		for (size_t i = 0; i < count; ++i) {
+			pos[i] += delta[i];
+		}
+	}
+
+	rotate_batch(batch->orient, batch->local_vel[0].data(), batch->local_vel[1].data(), batch->local_vel[2].data(),
+		batch->vel[0].data(), batch->vel[1].data(), batch->vel[2].data(), true, count);
+}
+
+// Same as physics_sim_rot() without the shockwave handling and the final vm_orthogonalize_matrix()
+void sim_rot_batch(physics_batch *batch, float sim_time)
+{
+	size_t count = batch->infos.size();
+
+	resize_arrays(batch->exp_factor, 1, count);
+	resize_arrays(batch->sin_angle, 3, count);
+	resize_arrays(batch->cos_angle, 3, count);
+	resize_arrays(batch->rotmat, 9, count);
+
+	compute_exp_factors(batch->rotdamp.data(), batch->exp_factor[0].data(), sim_time, count);
+	for (int axis = 0; axis < 3; ++axis) {
+		apply_physics_batch(batch->rotdamp.data(), batch->exp_factor[0].data(), batch->desired_rotvel[axis].data(),
+			batch->rotvel[axis].data(), sim_time, batch->rotvel[axis].data(), nullptr, count);
+	}
+
+	// The rotation velocities x, y and z become the angles p, h and b
+	for (int axis = 0; axis < 3; ++axis) {
+		const float *rotvel = batch->rotvel[axis].data();
+		float *sin_angle = batch->sin_angle[axis].data();
+		float *cos_angle = batch->cos_angle[axis].data();
+
+		for (size_t i = 0; i < count; ++i) {
+			float angle = rotvel[i]*sim_time;
+			sin_angle[i] = sinf(angle);
+			cos_angle[i] = cosf(angle);
+		}
+	}
+
+	const float *sinp = batch->sin_angle[0].data();
+	const float *sinh = batch->sin_angle[1].data();
+	const float *sinb = batch->sin_angle[2].data();
+	const float *cosp = batch->cos_angle[0].data();
+	const float *cosh = batch->cos_angle[1].data();
+	const float *cosb = batch->cos_angle[2].data();
+
+	float *r[9];
+	float *o[9];
+	for (int i = 0; i < 9; ++i) {
+		r[i] = batch->rotmat[i].data();
+		o[i] = batch->orient[i].data();
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		// Same as sincos_2_matrix() in vecmat.cpp
+		float sbsh = sinb[i]*sinh[i];
+		float cbch = cosb[i]*cosh[i];
+		float cbsh = cosb[i]*sinh[i];
+		float sbch = sinb[i]*cosh[i];
+
+		float m[9];
+		m[0] = cbch + sinp[i]*sbsh;
+		m[1] = sinb[i]*cosp[i];
+		m[2] = sinp[i]*sbch - cbsh;
+		m[3] = sinp[i]*cbsh - sbch;
+		m[4] = cosb[i]*cosp[i];
+		m[5] = sbsh + sinp[i]*cbch;
+		m[6] = sinh[i]*cosp[i];
+		m[7] = -sinp[i];
+		m[8] = cosh[i]*cosp[i];
+
+		// Same as vm_matrix_x_matrix(), column c of the result is the orientation times column c of the rotation
+		float src[9];
+		for (int j = 0; j < 9; ++j) {
+			src[j] = o[j][i];
+			r[j][i] = m[j];
+		}
+
+		for (int row = 0; row < 3; ++row) {
+			for (int col = 0; col < 3; ++col) {
+				o[row * 3 + col][i] = (src[col]*m[row * 3 + 0])+(src[3 + col]*m[row * 3 + 1])+(src[6 + col]*m[row * 3 + 2]);
+			}
+		}
+	}
+}
+
+}
+
+bool physics_batch_supported(const physics_info *pi)
+{
+	return !(pi->flags & (PF_CONST_VEL | PF_IN_SHOCKWAVE | PF_SPECIAL_WARP_IN | PF_SPECIAL_WARP_OUT));
+}
+
+void physics_batch_clear(physics_batch *batch)
+{
+	batch->positions.clear();
+	batch->orients.clear();
+	batch->infos.clear();
+
+	for (int i = 0; i < 3; ++i) {
+		batch->pos[i].clear();
+		batch->vel[i].clear();
+		batch->desired_vel[i].clear();
+		batch->rotvel[i].clear();
+		batch->desired_rotvel[i].clear();
+		batch->damp[i].clear();
+	}
+	for (auto& component : batch->orient) {
+		component.clear();
+	}
+	batch->rotdamp.clear();
+}
+
+void physics_batch_add(physics_batch *batch, vec3d *position, matrix *orient, physics_info *pi)
+{
+	Assertion(physics_batch_supported(pi), "Physics state with flags %x cannot be simulated in a batch!", pi->flags);
+	Assert(is_valid_matrix(orient));
+	Assert(is_valid_vec(&pi->rotvel));
+	Assert(is_valid_vec(&pi->desired_rotvel));
+
+	vec3d damp;
+	compute_damping(pi, &damp);
+
+	batch->positions.push_back(position);
+	batch->orients.push_back(orient);
+	batch->infos.push_back(pi);
+
+	for (int i = 0; i < 3; ++i) {
+		batch->pos[i].push_back(position->a1d[i]);
+		batch->vel[i].push_back(pi->vel.a1d[i]);
+		batch->desired_vel[i].push_back(pi->desired_vel.a1d[i]);
+		batch->rotvel[i].push_back(pi->rotvel.a1d[i]);
+		batch->desired_rotvel[i].push_back(pi->desired_rotvel.a1d[i]);
+		batch->damp[i].push_back(damp.a1d[i]);
+	}
+	for (int i = 0; i < 9; ++i) {
+		batch->orient[i].push_back(orient->a1d[i]);
+	}
+	batch->rotdamp.push_back(pi->rotdamp);
+}
+
+void physics_batch_sim(physics_batch *batch, float sim_time)
+{
+	size_t count = batch->infos.size();
+
+	if (count == 0) {
+		return;
+	}
+
+	sim_vel_batch(batch, sim_time);
+	sim_rot_batch(batch, sim_time);
+
+	for (size_t i = 0; i < count; ++i) {
+		vec3d *position = batch->positions[i];
+		matrix *orient = batch->orients[i];
+		physics_info *pi = batch->infos[i];
+
+		for (int j = 0; j < 3; ++j) {
+			position->a1d[j] = batch->pos[j][i];
+			pi->vel.a1d[j] = batch->vel[j][i];
+			pi->rotvel.a1d[j] = batch->rotvel[j][i];
+		}
+		for (int j = 0; j < 9; ++j) {
+			orient->a1d[j] = batch->orient[j][i];
+			pi->last_rotmat.a1d[j] = batch->rotmat[j][i];
+		}
+
+		vm_orthogonalize_matrix(orient);
+
+		pi->speed = vm_vec_mag(&pi->vel);
+		pi->fspeed = vm_vec_dot(&orient->vec.fvec, &pi->vel);
+	}
+}
+
+DCF(physics_batch_bench, "Compares the speed of physics_sim() and the batched physics")
+{
+	int num_objects = 3000;
+	const int num_steps = 100;
+	const float sim_time = 1.0f / 60.0f;
+
+	if (dc_optional_string_either("help", "--help")) {
+		dc_printf("Usage: physics_batch_bench [objects]\n");
+		dc_printf("Simulates [objects] random objects (default 3000) for %d frames, once with physics_sim() and once\n", num_steps);
+		dc_printf("with the batched physics, and prints the time per frame and the largest difference in the results.\n");
+		return;
+	}
+
+	dc_maybe_stuff_int(&num_objects);
+
+	if (num_objects <= 0) {
+		dc_printf("The number of objects must be greater than zero.\n");
+		return;
+	}
+
+	SCP_vector<vec3d> positions[2];
+	SCP_vector<matrix> orients[2];
+	SCP_vector<physics_info> infos[2];
+
+	for (int pass = 0; pass < 2; ++pass) {
+		positions[pass].resize(num_objects);
+		orients[pass].resize(num_objects);
+		infos[pass].resize(num_objects);
+	}
+
+	for (int i = 0; i < num_objects; ++i) {
+		physics_info *pi = &infos[0][i];
+		physics_init(pi);
+
+		static_randvec(i * 11, &positions[0][i]);
+		vm_vec_scale(&positions[0][i], static_randf_range(i * 11 + 1, 0.0f, 5000.0f));
+
+		vec3d fvec;
+		static_randvec(i * 11 + 2, &fvec);
+		vm_vector_2_matrix(&orients[0][i], &fvec, nullptr, nullptr);
+
+		pi->side_slip_time_const = static_randf_range(i * 11 + 3, 0.0f, 2.0f);
+		pi->rotdamp = static_randf_range(i * 11 + 4, 0.05f, 0.5f);
+		pi->use_newtonian_damp = (i % 4) == 0;
+
+		static_randvec(i * 11 + 5, &pi->vel);
+		vm_vec_scale(&pi->vel, static_randf_range(i * 11 + 6, 0.0f, 100.0f));
+		static_randvec(i * 11 + 7, &pi->desired_vel);
+		vm_vec_scale(&pi->desired_vel, static_randf_range(i * 11 + 8, 0.0f, 100.0f));
+		static_randvec(i * 11 + 9, &pi->desired_rotvel);
+		vm_vec_scale(&pi->desired_rotvel, static_randf_range(i * 11 + 10, 0.0f, 2.0f));
+	}
+
+	positions[1] = positions[0];
+	orients[1] = orients[0];
+	infos[1] = infos[0];
+
+	std::uint64_t time[2];
+	physics_batch batch;
+
+	// Pass 0 uses physics_sim(), pass 1 the batched physics
+	for (int pass = 0; pass < 2; ++pass) {
+		auto start = timer_get_microseconds();
+
+		for (int step = 0; step < num_steps; ++step) {
+			if (pass == 0) {
+				for (int i = 0; i < num_objects; ++i) {
+					physics_sim(&positions[0][i], &orients[0][i], &infos[0][i], sim_time);
+				}
+			} else {
+				physics_batch_clear(&batch);
+				for (int i = 0; i < num_objects; ++i) {
+					physics_batch_add(&batch, &positions[1][i], &orients[1][i], &infos[1][i]);
+				}
+				physics_batch_sim(&batch, sim_time);
+			}
+		}
+
+		time[pass] = timer_get_microseconds() - start;
+	}
+
+	float max_pos_diff = 0.0f;
+	float max_orient_diff = 0.0f;
+	int num_different = 0;
+
+	for (int i = 0; i < num_objects; ++i) {
+		float pos_diff = vm_vec_dist(&positions[0][i], &positions[1][i]);
+		float orient_diff = 0.0f;
+		for (int j = 0; j < 9; ++j) {
+			orient_diff = MAX(orient_diff, fl_abs(orients[0][i].a1d[j] - orients[1][i].a1d[j]));
+		}
+
+		if (pos_diff != 0.0f || orient_diff != 0.0f) {
+			++num_different;
+		}
+
+		max_pos_diff = MAX(max_pos_diff, pos_diff);
+		max_orient_diff = MAX(max_orient_diff, orient_diff);
+	}
+
+	dc_printf("%d objects, %d frames: %.1f us per frame with physics_sim(), %.1f us per frame batched\n", num_objects,
+		num_steps, time[0] / (double) num_steps, time[1] / (double) num_steps);
+	dc_printf("%d objects differ, largest position difference %g, largest orientation difference %g\n", num_different,
+		max_pos_diff, max_orient_diff);
+}
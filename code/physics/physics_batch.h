@@ -0,0 +1,71 @@
+#ifndef _PHYSICS_BATCH_H
+#define _PHYSICS_BATCH_H
+#pragma once
+
+#include "globalincs/pstypes.h"
+#include "physics/physics.h"
+
+/** @file
+ *  Batched version of physics_sim()
+ *
+ *  The state of all objects in a batch is copied into separate arrays for every component, the objects are integrated
+ *  together in loops which the compiler can vectorize and the results are copied back. The loops do exactly the same
+ *  floating point operations in the same order as physics_sim() so the results are identical to the scalar path as
+ *  long as both are compiled with the same floating point settings. If the compiler contracts multiplications and
+ *  additions differently in the two paths, the results may differ by a few units in the last place.
+ */
+
+/**
+ * @brief The state of the objects in a batch, one array per component
+ */
+typedef struct physics_batch {
+	// Where the results go
+	SCP_vector<vec3d*> positions;
+	SCP_vector<matrix*> orients;
+	SCP_vector<physics_info*> infos;
+
+	SCP_vector<float> pos[3];
+	SCP_vector<float> orient[9];		// rvec, uvec, fvec
+	SCP_vector<float> vel[3];
+	SCP_vector<float> desired_vel[3];
+	SCP_vector<float> rotvel[3];
+	SCP_vector<float> desired_rotvel[3];
+	SCP_vector<float> damp[3];
+	SCP_vector<float> rotdamp;
+
+	// Intermediate results
+	SCP_vector<float> local_vel[3];
+	SCP_vector<float> local_desired_vel[3];
+	SCP_vector<float> exp_factor[3];
+	SCP_vector<float> sin_angle[3];	// p, h, b
+	SCP_vector<float> cos_angle[3];
+	SCP_vector<float> rotmat[9];
+} physics_batch;
+
+/**
+ * @brief Checks if physics_batch_add() can handle an object with this physics state
+ *
+ * Objects which need one of the special cases of physics_sim() (constant velocity, special warp effects and shockwaves)
+ * need to be simulated with physics_sim().
+ */
+bool physics_batch_supported(const physics_info *pi);
+
+/**
+ * @brief Removes all objects from the batch
+ */
+void physics_batch_clear(physics_batch *batch);
+
+/**
+ * @brief Adds an object to the batch
+ *
+ * The object state is read when it is added and written back by physics_batch_sim(). It must not be changed in
+ * between.
+ */
+void physics_batch_add(physics_batch *batch, vec3d *position, matrix *orient, physics_info *pi);
+
+/**
+ * @brief Simulates all objects in the batch, same as calling physics_sim() for each of them
+ */
+void physics_batch_sim(physics_batch *batch, float sim_time);
+
+#endif // _PHYSICS_BATCH_H
@@ -718,27 +718,35 @@ void batching_add_bitmap_rotated(int texture, vertex *pnt, float angle, float ra
 	batching_add_bitmap_rotated_internal(batch, texture, pnt, angle, rad, &clr, depth);
 }
 
-void batching_add_volume_bitmap(int texture, vertex *pnt, int orient, float rad, float alpha, float depth)
+primitive_batch* batching_find_volume_batch(int texture)
 {
-	if (texture < 0) {
-		Int3();
-		return;
-	}
-
-	primitive_batch *batch;
-	
 	if ( gr_is_capable(CAPABILITY_SOFT_PARTICLES) ) {
-		batch = batching_find_batch(texture, batch_info::VOLUME_EMISSIVE);
+		return batching_find_batch(texture, batch_info::VOLUME_EMISSIVE);
 	} else {
-		batch = batching_find_batch(texture, batch_info::FLAT_EMISSIVE);
+		return batching_find_batch(texture, batch_info::FLAT_EMISSIVE);
 	}
+}
 
+void batching_add_volume_bitmap_to_batch(primitive_batch *batch, int texture, vertex *pnt, int orient, float rad, float alpha, float depth)
+{
 	color clr;
 	batching_determine_blend_color(&clr, texture, alpha);
 
 	batching_add_bitmap_internal(batch, texture, pnt, orient, rad, &clr, depth);
 }
 
+void batching_add_volume_bitmap(int texture, vertex *pnt, int orient, float rad, float alpha, float depth)
+{
+	if (texture < 0) {
+		Int3();
+		return;
+	}
+
+	primitive_batch *batch = batching_find_volume_batch(texture);
+
+	batching_add_volume_bitmap_to_batch(batch, texture, pnt, orient, rad, alpha, depth);
+}
+
 void batching_add_volume_bitmap_rotated(int texture, vertex *pnt, float angle, float rad, float alpha, float depth)
 {
 	if ( texture < 0 ) {
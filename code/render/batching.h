@@ -116,6 +116,10 @@ primitive_batch* batching_find_batch(int texture, batch_info::material_type mate
 void batching_add_bitmap(int texture, vertex *pnt, int orient, float rad, float alpha = 1.0f, float depth = 0.0f);
 void batching_add_bitmap_rotated(int texture, vertex *pnt, float angle, float rad, float alpha = 1.0f, float depth = 0.0f);
 void batching_add_volume_bitmap(int texture, vertex *pnt, int orient, float rad, float alpha = 1.0f, float depth = 0.0f);
+
+// For adding many volume bitmaps which share a batch, the batch is only looked up once
+primitive_batch* batching_find_volume_batch(int texture);
+void batching_add_volume_bitmap_to_batch(primitive_batch *batch, int texture, vertex *pnt, int orient, float rad, float alpha = 1.0f, float depth = 0.0f);
 void batching_add_volume_bitmap_rotated(int texture, vertex *pnt, float angle, float rad, float alpha = 1.0f, float depth = 0.0f);
 void batching_add_distortion_bitmap_rotated(int texture, vertex *pnt, float angle, float rad, float alpha = 1.0f, float depth = 0.0f);
 void batching_add_distortion_beam(int texture, vec3d *start, vec3d *end, float width, float intensity, float offset);
@@ -118,9 +118,9 @@ ADE_FUNC(createParticle, l_Testing, "vector Position, vector Velocity, number Li
 		pi.attached_sig = objh->objp->signature;
 	}
 
-	particle::WeakParticlePtr p = particle::createPersistent(&pi);
+	particle::ParticleHandle p = particle::createPersistent(&pi);
 
-	if (!p.expired())
+	if (p.isValid())
 		return ade_set_args(L, "o", l_Particle.Set(particle_h(p)));
 	else
 		return ADE_RETURN_NIL;
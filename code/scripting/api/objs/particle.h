@@ -9,13 +9,13 @@ namespace api {
 class particle_h
 {
  protected:
-	particle::WeakParticlePtr part;
+	particle::ParticleHandle part;
  public:
 	particle_h();
 
-	explicit particle_h(const particle::WeakParticlePtr& part_p);
+	explicit particle_h(const particle::ParticleHandle& part_p);
 
-	particle::WeakParticlePtr Get();
+	particle::ParticleHandle Get();
 
 	bool isValid();
 };
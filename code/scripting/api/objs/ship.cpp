@@ -23,6 +23,7 @@
 #include "ship/shipfx.h"
 #include "hud/hudets.h"
 #include "object/object.h"
+#include "object/objectspatial.h"
 #include "model/model.h"
 #include "ship/ship.h"
 #include "parse/parselo.h"
@@ -688,6 +689,7 @@ ADE_VIRTVAR(Team, l_Ship, "team", "Ship's team", "team", "Ship team, or invalid
 
 	if(ADE_SETTING_VAR && nt > -1) {
 		shipp->team = nt;
+		obj_spatial_team_changed(OBJ_INDEX(oh->objp));
 	}
 
 	return ade_set_args(L, "o", l_Team.Set(shipp->team));
@@ -10,6 +10,7 @@
 #include "team.h"
 #include "mc_info.h"
 #include "iff_defs/iff_defs.h"
+#include "object/objectspatial.h"
 
 namespace scripting {
 namespace api {
@@ -288,6 +289,7 @@ ADE_VIRTVAR(Team, l_Weapon, "team", "Weapon's team", "team", "Weapon team, or in
 
 	if(ADE_SETTING_VAR && nt > -1 && nt < Num_iffs) {
 		wp->team = nt;
+		obj_spatial_team_changed(OBJ_INDEX(oh->objp));
 	}
 
 	return ade_set_args(L, "o", l_Team.Set(wp->team));
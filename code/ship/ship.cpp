@@ -61,6 +61,7 @@
 #include "object/objectdock.h"
 #include "object/objectshield.h"
 #include "object/objectsnd.h"
+#include "object/objectspatial.h"
 #include "object/waypoint.h"
 #include "parse/parselo.h"
 #include "scripting/scripting.h"
@@ -617,6 +618,8 @@ static int ship_obj_list_add(int objnum)
 	list_append(&Ship_obj_list, &Ship_objs[i]);
 	Ship_objs[i].flags |= SHIP_OBJ_USED;
 
+	obj_spatial_add(objnum);
+
 	return i;
 }
 
@@ -7743,27 +7746,22 @@ static void ship_blow_up_area_apply_blast( object *exp_objp)
 		sci.rot_angles.h = frand_range(0.0f, MAX_SHOCK_ANGLE_RANGE);
 		shipfx_do_shockwave_stuff(shipp, &sci);
 	} else {
-		object *objp;
 		float blast = 0.0f;
 		float damage = 0.0f;
-		for ( objp = GET_FIRST(&obj_used_list); objp !=END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp) ) {
-			if ( (objp->type != OBJ_SHIP) && (objp->type != OBJ_ASTEROID) ) {
-				continue;
-			}
-		
+		obj_for_each_of_types({OBJ_SHIP, OBJ_ASTEROID}, [&](object *objp) {
 			if ( objp == exp_objp ){
-				continue;
+				return;
 			}
 
 			// don't blast navbuoys
 			if ( objp->type == OBJ_SHIP ) {
 				if ( ship_get_SIF(objp->instance)[Ship::Info_Flags::Navbuoy] ) {
-					continue;
+					return;
 				}
 			}
 
 			if ( ship_explode_area_calc_damage( &exp_objp->pos, &objp->pos, inner_rad, outer_rad, max_damage, max_blast, &damage, &blast ) == -1 ){
-				continue;
+				return;
 			}
 
 			switch ( objp->type ) {
@@ -7782,7 +7780,7 @@ static void ship_blow_up_area_apply_blast( object *exp_objp)
 				Int3();
 				break;
 			}
-		}	// end for
+		});
 	}
 }
 
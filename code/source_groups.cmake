@@ -45,6 +45,8 @@ add_file_folder("Autopilot"
 # Bmpman files
 add_file_folder("Bmpman"
 	bmpman/bm_internal.h
+	bmpman/bm_texture_cache.cpp
+	bmpman/bm_texture_cache.h
 	bmpman/bmpman.cpp
 	bmpman/bmpman.h
 )
@@ -720,6 +722,8 @@ add_file_folder("Model"
 	model/model.h
 	model/modelanim.cpp
 	model/modelanim.h
+	model/modelcache.cpp
+	model/modelcache.h
 	model/modelcollide.cpp
 	model/modelinterp.cpp
 	model/modeloctant.cpp
@@ -826,6 +830,8 @@ add_file_folder("Object"
 	object/deadobjectdock.h
 	object/objcollide.cpp
 	object/objcollide.h
+	object/objcollidegrid.cpp
+	object/objcollidegrid.h
 	object/object.cpp
 	object/object.h
 	object/objectdock.cpp
@@ -835,6 +841,8 @@ add_file_folder("Object"
 	object/objectsnd.cpp
 	object/objectsnd.h
 	object/objectsort.cpp
+	object/objectspatial.cpp
+	object/objectspatial.h
 	object/parseobjectdock.cpp
 	object/parseobjectdock.h
 	object/waypoint.cpp
@@ -872,6 +880,8 @@ add_file_folder("Parse"
 	parse/parselo.h
 	parse/sexp.cpp
 	parse/sexp.h
+	parse/table_cache.cpp
+	parse/table_cache.h
 )
 
 add_file_folder("Parse\\\\SEXP"
@@ -927,6 +937,8 @@ add_file_folder("PcxUtils"
 add_file_folder("Physics"
 	physics/physics.cpp
 	physics/physics.h
+	physics/physics_batch.cpp
+	physics/physics_batch.h
 )
 
 # PilotFile files
@@ -1263,6 +1275,8 @@ add_file_folder("Tracing"
 	tracing/FrameProfiler.cpp
 	tracing/MainFrameTimer.h
 	tracing/MainFrameTimer.cpp
+	tracing/MissionProfiler.h
+	tracing/MissionProfiler.cpp
 	tracing/Monitor.h
 	tracing/Monitor.cpp
 	tracing/scopes.cpp
@@ -1307,6 +1321,8 @@ add_file_folder("Utils"
 	utils/strings.h
     utils/unicode.cpp
     utils/unicode.h
+	utils/WorkerPool.cpp
+	utils/WorkerPool.h
 )
 
 # Utils files
@@ -0,0 +1,371 @@
+#include "tracing/MissionProfiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+
+namespace {
+using namespace tracing;
+
+struct value_stats {
+	uint64_t min = 0;
+	uint64_t avg = 0;
+	uint64_t p95 = 0;
+	uint64_t p99 = 0;
+	uint64_t max = 0;
+};
+
+// Nearest rank percentile of sorted values
+uint64_t percentile(const SCP_vector<uint64_t>& sorted, double p) {
+	// The epsilon keeps rounding errors from skipping to the next rank
+	auto rank = (size_t)std::ceil(p * sorted.size() - 1e-9);
+	return sorted[std::max(rank, (size_t)1) - 1];
+}
+
+value_stats compute_stats(SCP_vector<uint64_t>& values) {
+	value_stats stats;
+
+	if (values.empty()) {
+		return stats;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	uint64_t sum = 0;
+	for (auto value : values) {
+		sum += value;
+	}
+
+	stats.min = values.front();
+	stats.avg = sum / values.size();
+	stats.p95 = percentile(values, 0.95);
+	stats.p99 = percentile(values, 0.99);
+	stats.max = values.back();
+
+	return stats;
+}
+
+void write_json_string(std::ostream& out, const SCP_string& str) {
+	out << '"';
+	for (auto c : str) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if ((unsigned char)c < 0x20) {
+			out << ' ';
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+void write_json_stats(std::ostream& out, const value_stats& stats) {
+	out << "\"min\": " << stats.min << ", \"avg\": " << stats.avg << ", \"p95\": " << stats.p95
+	    << ", \"p99\": " << stats.p99 << ", \"max\": " << stats.max;
+}
+
+void write_json_frame(std::ostream& out, size_t index, const mission_profile_frame& frame) {
+	out << "{\"frame\": " << index << ", \"mission_time\": " << frame.mission_time
+	    << ", \"frame_time\": " << frame.frame_time << ", \"ships\": " << frame.ships
+	    << ", \"weapons\": " << frame.weapons << ", \"particles\": " << frame.particles << "}";
+}
+
+// Only keeps characters which are safe in file names
+SCP_string file_name_part(const SCP_string& str) {
+	SCP_string result;
+	for (auto c : str) {
+		if (c == '.') {
+			// Strip the extension
+			break;
+		}
+
+		result += (isalnum((unsigned char)c) || c == '-' || c == '_') ? c : '_';
+	}
+
+	return result.empty() ? SCP_string("unknown") : result;
+}
+}
+
+namespace tracing {
+
+int MissionProfiler::getNode(int parent, const Category* category) {
+	auto key = std::make_pair(parent, category);
+
+	auto iter = _nodeLookup.find(key);
+	if (iter != _nodeLookup.end()) {
+		return iter->second;
+	}
+
+	node new_node;
+	new_node.category = category;
+	new_node.parent = parent;
+	new_node.depth = parent < 0 ? 0 : _nodes[parent].depth + 1;
+	new_node.path = parent < 0 ? SCP_string() : _nodes[parent].path + ">";
+	new_node.path += category->getName();
+	new_node.calls = 0;
+	new_node.frame_time = 0;
+	new_node.frame_calls = 0;
+
+	_nodes.push_back(new_node);
+
+	auto index = (int)_nodes.size() - 1;
+	_nodeLookup.insert(std::make_pair(key, index));
+
+	return index;
+}
+
+void MissionProfiler::processEvent(const trace_event* event) {
+	if (event->type != EventType::Complete) {
+		// Only process complete events
+		return;
+	}
+
+	if (event->pid == GPU_PID) {
+		// GPU events arrive frames later and can't be matched to the frame they belong to
+		return;
+	}
+
+	if (event->duration == 0 || event->category == &MainFrame) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> vectorGuard(_eventsMutex);
+
+	if (_active) {
+		_bufferedEvents.push_back(*event);
+	}
+}
+
+void MissionProfiler::beginMission(const SCP_string& mission) {
+	std::lock_guard<std::mutex> vectorGuard(_eventsMutex);
+
+	_mission = mission;
+	_active = true;
+	_started = false;
+
+	_bufferedEvents.clear();
+	_nodes.clear();
+	_nodeLookup.clear();
+	_frames.clear();
+}
+
+void MissionProfiler::processFrame(const mission_profile_frame& frame) {
+	SCP_vector<trace_event> events;
+	{
+		std::lock_guard<std::mutex> vectorGuard(_eventsMutex);
+
+		if (!_active) {
+			return;
+		}
+
+		events.swap(_bufferedEvents);
+	}
+
+	if (!_started) {
+		_started = true;
+		return;
+	}
+
+	auto frame_index = (uint32_t)_frames.size();
+	_frames.push_back(frame);
+
+	// Parents start before their children or at the same time but last longer
+	std::sort(events.begin(), events.end(), [](const trace_event& left, const trace_event& right) {
+		if (left.tid != right.tid) {
+			return left.tid < right.tid;
+		}
+		if (left.timestamp != right.timestamp) {
+			return left.timestamp < right.timestamp;
+		}
+		return left.duration > right.duration;
+	});
+
+	struct open_scope {
+		uint64_t end;
+		int node;
+	};
+	SCP_vector<open_scope> open_scopes;
+	SCP_vector<int> touched;
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		auto& evt = events[i];
+
+		if (i > 0 && events[i - 1].tid != evt.tid) {
+			// Every thread has its own tree
+			open_scopes.clear();
+		}
+
+		while (!open_scopes.empty() && open_scopes.back().end <= evt.timestamp) {
+			open_scopes.pop_back();
+		}
+
+		auto index = getNode(open_scopes.empty() ? -1 : open_scopes.back().node, evt.category);
+		auto& current = _nodes[index];
+
+		if (current.frame_calls == 0) {
+			touched.push_back(index);
+		}
+		current.frame_time += evt.duration;
+		++current.frame_calls;
+
+		open_scopes.push_back({evt.timestamp + evt.duration, index});
+	}
+
+	for (auto index : touched) {
+		auto& current = _nodes[index];
+
+		auto micro_sec = std::min(current.frame_time / 1000, (uint64_t)UINT32_MAX);
+		current.samples.push_back({frame_index, (uint32_t)micro_sec});
+		current.calls += current.frame_calls;
+
+		current.frame_time = 0;
+		current.frame_calls = 0;
+	}
+}
+
+void MissionProfiler::endMission() {
+	{
+		std::lock_guard<std::mutex> vectorGuard(_eventsMutex);
+
+		if (!_active) {
+			return;
+		}
+
+		_active = false;
+		_bufferedEvents.clear();
+	}
+
+	if (!_frames.empty()) {
+		writeFiles();
+	}
+}
+
+SCP_vector<mission_profile_node_stats> MissionProfiler::getStatistics() const {
+	SCP_vector<mission_profile_node_stats> result;
+	SCP_vector<uint64_t> values;
+
+	for (auto& current : _nodes) {
+		mission_profile_node_stats stats;
+		stats.path = current.path;
+		stats.name = current.category->getName();
+		stats.parent = current.parent;
+		stats.depth = current.depth;
+		stats.calls = current.calls;
+		stats.frames = current.samples.size();
+
+		values.clear();
+		uint32_t max_value = 0;
+		for (auto& s : current.samples) {
+			values.push_back(s.micro_sec);
+
+			if (s.micro_sec >= max_value) {
+				max_value = s.micro_sec;
+				stats.max_frame = s.frame;
+			}
+		}
+
+		auto value_stats = compute_stats(values);
+		stats.min = value_stats.min;
+		stats.avg = value_stats.avg;
+		stats.p95 = value_stats.p95;
+		stats.p99 = value_stats.p99;
+		stats.max = value_stats.max;
+
+		result.push_back(stats);
+	}
+
+	return result;
+}
+
+void MissionProfiler::writeJSON(std::ostream& out) const {
+	SCP_vector<uint64_t> frame_times;
+	for (auto& frame : _frames) {
+		frame_times.push_back((uint64_t)(frame.frame_time * 1000000.0f));
+	}
+
+	out << "{\n\"mission\": ";
+	write_json_string(out, _mission);
+	out << ",\n\"units\": {\"statistics\": \"microseconds\", \"mission_time\": \"seconds\", \"frame_time\": \"seconds\"}";
+	out << ",\n\"frame_time\": {";
+	write_json_stats(out, compute_stats(frame_times));
+	out << "},\n\"nodes\": [";
+
+	auto stats = getStatistics();
+	for (size_t i = 0; i < stats.size(); ++i) {
+		auto& node_stats = stats[i];
+
+		out << (i == 0 ? "\n" : ",\n") << "{\"path\": ";
+		write_json_string(out, node_stats.path);
+		out << ", \"name\": ";
+		write_json_string(out, node_stats.name);
+		out << ", \"parent\": " << node_stats.parent << ", \"depth\": " << node_stats.depth
+		    << ", \"calls\": " << node_stats.calls << ", \"frames\": " << node_stats.frames << ", ";
+
+		value_stats values;
+		values.min = node_stats.min;
+		values.avg = node_stats.avg;
+		values.p95 = node_stats.p95;
+		values.p99 = node_stats.p99;
+		values.max = node_stats.max;
+		write_json_stats(out, values);
+
+		out << ", \"max_frame\": ";
+		write_json_frame(out, node_stats.max_frame, _frames[node_stats.max_frame]);
+		out << "}";
+	}
+
+	out << "\n],\n\"frames\": [";
+	for (size_t i = 0; i < _frames.size(); ++i) {
+		out << (i == 0 ? "\n" : ",\n");
+		write_json_frame(out, i, _frames[i]);
+	}
+	out << "\n]\n}\n";
+}
+
+void MissionProfiler::writeCSV(std::ostream& out) const {
+	out << "path,depth,calls,frames,min_us,avg_us,p95_us,p99_us,max_us,max_mission_time,max_ships,max_weapons,"
+	       "max_particles\n";
+
+	for (auto& stats : getStatistics()) {
+		auto& frame = _frames[stats.max_frame];
+
+		// The category names don't contain quotes
+		out << "\"" << stats.path << "\"," << stats.depth << "," << stats.calls << "," << stats.frames << ","
+		    << stats.min << "," << stats.avg << "," << stats.p95 << "," << stats.p99 << "," << stats.max << ","
+		    << frame.mission_time << "," << frame.ships << "," << frame.weapons << "," << frame.particles << "\n";
+	}
+}
+
+void MissionProfiler::writeFramesCSV(std::ostream& out) const {
+	out << "frame,mission_time,frame_time,ships,weapons,particles\n";
+
+	for (size_t i = 0; i < _frames.size(); ++i) {
+		auto& frame = _frames[i];
+
+		out << i << "," << frame.mission_time << "," << frame.frame_time << "," << frame.ships << ","
+		    << frame.weapons << "," << frame.particles << "\n";
+	}
+}
+
+void MissionProfiler::writeFiles() {
+	char time_str[32];
+	auto now = std::time(nullptr);
+	std::strftime(time_str, sizeof(time_str), "%Y%m%d-%H%M%S", std::localtime(&now));
+
+	auto base_name = "mission_profile-" + file_name_part(_mission) + "-" + time_str;
+
+	std::ofstream json(base_name + ".json");
+	writeJSON(json);
+
+	std::ofstream csv(base_name + ".csv");
+	writeCSV(csv);
+
+	std::ofstream frames_csv(base_name + "-frames.csv");
+	writeFramesCSV(frames_csv);
+
+	mprintf(("Wrote mission profile of %d frames to %s.json/.csv\n", (int)_frames.size(), base_name.c_str()));
+}
+
+}
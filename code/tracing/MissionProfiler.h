@@ -0,0 +1,115 @@
+#pragma once
+
+#include "globalincs/pstypes.h"
+#include "tracing/tracing.h"
+
+#include <mutex>
+#include <ostream>
+
+/** @file
+ *  @ingroup tracing
+ */
+
+namespace tracing {
+
+/**
+ * @brief The statistics of one node of the profile tree
+ *
+ * A node is a category together with the path of categories it was nested in. All times are in microseconds and
+ * contain the time of the child nodes, the root nodes are the rollups of the subsystems.
+ */
+struct mission_profile_node_stats {
+	SCP_string path;    //!< The names of the parent categories and of the category separated by '>'
+	SCP_string name;
+	int parent = -1;    //!< Index of the parent node or -1
+	int depth = 0;
+
+	size_t calls = 0;   //!< How often the category was entered
+	size_t frames = 0;  //!< In how many frames the category was entered
+
+	uint64_t min = 0;
+	uint64_t avg = 0;
+	uint64_t p95 = 0;
+	uint64_t p99 = 0;
+	uint64_t max = 0;
+
+	size_t max_frame = 0; //!< The frame of the maximum, an index into the frames of the profiler
+};
+
+/**
+ * @brief Aggregates the trace events of a whole mission
+ *
+ * Every frame the time each node of the profile tree took is recorded. At the end of the mission the minimum,
+ * average, 95th and 99th percentile and the maximum over all frames in which the node was entered are computed and
+ * written as JSON and CSV together with the tags of every frame. This does not need any user interaction so it works
+ * for automated runs.
+ */
+class MissionProfiler {
+	struct sample {
+		uint32_t frame;
+		uint32_t micro_sec;
+	};
+
+	struct node {
+		const Category* category;
+		int parent;
+		int depth;
+		SCP_string path;
+
+		SCP_vector<sample> samples;
+		size_t calls;
+
+		uint64_t frame_time; // in nanoseconds
+		uint32_t frame_calls;
+	};
+
+	std::mutex _eventsMutex;
+	SCP_vector<trace_event> _bufferedEvents;
+
+	SCP_string _mission;
+	bool _active = false;
+	bool _started = false;
+
+	SCP_vector<node> _nodes;
+	SCP_map<std::pair<int, const Category*>, int> _nodeLookup;
+	SCP_vector<mission_profile_frame> _frames;
+
+	int getNode(int parent, const Category* category);
+
+	void writeFiles();
+
+ public:
+	void processEvent(const trace_event* event);
+
+	/**
+	 * @brief Discards the data of the last mission and starts collecting events
+	 */
+	void beginMission(const SCP_string& mission);
+
+	/**
+	 * @brief Adds the events of the last frame to the statistics
+	 *
+	 * The first call after beginMission() only marks the start of the first frame, the events before it belong to
+	 * loading the mission and are dropped.
+	 */
+	void processFrame(const mission_profile_frame& frame);
+
+	/**
+	 * @brief Writes the statistics of the mission to files and stops collecting events
+	 */
+	void endMission();
+
+	bool isActive() const { return _active; }
+
+	const SCP_vector<mission_profile_frame>& getFrames() const { return _frames; }
+
+	SCP_vector<mission_profile_node_stats> getStatistics() const;
+
+	void writeJSON(std::ostream& out) const;
+
+	void writeCSV(std::ostream& out) const;
+
+	void writeFramesCSV(std::ostream& out) const;
+};
+
+}
@@ -35,6 +35,13 @@ Category LoadBatchingBuffers("Load batching buffers", true);
 Category SortColliders("Sort Colliders", false);
 Category FindOverlapColliders("Find overlap colliders", false);
 Category CollidePair("Collide Pair", false);
+Category CollisionGridUpdate("Collision grid update", false);
+Category PrefetchShipWeaponCollisions("Prefetch ship weapon collisions", false);
+
+Category SpatialIndexBuild("Spatial index build", false);
+
+Category AIEnemySearch("AI enemy search", false);
+Category AIProcess("AI process", false);
 
 Category WeaponPostMove("Weapon post move", false);
 Category ShipPostMove("Ship post move", false);
@@ -112,9 +119,7 @@ Category LoadPostMissionLoad("Mission load post processing", false);
 Category LoadModelFile("Load model file", false);
 Category ReadModelFile("Read model file", false);
 Category ModelCreateVertexBuffers("Create model vertex buffers", false);
-Category ModelCreateOctants("Create model octants", false);
-Category ModelParseAllBSPTrees("Parse all BSP trees", false);
-Category ModelParseBSPTree("Parse BSP tree", false);
+Category ModelBuildSubmodelData("Build submodel data", false);
 Category ModelConfigureVertexBuffers("Model configure vertex buffers", false);
 Category ModelCreateTransparencyIndexBuffer("Model create transparency buffer", false);
 Category ModelCreateDetailIndexBuffers("Model create detail index buffers", false);
@@ -125,6 +130,8 @@ Category LoadSound("Load Sound", false);
 Category LevelPageIn("Level page in", false);
 Category PageInStop("Finish page in", false);
 Category PageInSingleBitmap("Page in single bitmap", false);
+Category PageInDecode("Page in decode batch", false);
+Category ParsePreload("Preload parse files", false);
 Category ShipPageIn("Ship page in", false);
 Category WeaponPageIn("Weapon page in", false);
 
@@ -47,6 +47,13 @@ extern Category LoadBatchingBuffers;
 extern Category SortColliders;
 extern Category FindOverlapColliders;
 extern Category CollidePair;
+extern Category CollisionGridUpdate;
+extern Category PrefetchShipWeaponCollisions;
+
+extern Category SpatialIndexBuild;
+
+extern Category AIEnemySearch;
+extern Category AIProcess;
 
 extern Category WeaponPostMove;
 extern Category ShipPostMove;
@@ -125,9 +132,7 @@ extern Category LoadPostMissionLoad;
 extern Category LoadModelFile;
 extern Category ReadModelFile;
 extern Category ModelCreateVertexBuffers;
-extern Category ModelCreateOctants;
-extern Category ModelParseAllBSPTrees;
-extern Category ModelParseBSPTree;
+extern Category ModelBuildSubmodelData;
 extern Category ModelConfigureVertexBuffers;
 extern Category ModelCreateTransparencyIndexBuffer;
 extern Category ModelCreateDetailIndexBuffers;
@@ -138,6 +143,8 @@ extern Category LoadSound;
 extern Category LevelPageIn;
 extern Category PageInStop;
 extern Category PageInSingleBitmap;
+extern Category PageInDecode;
+extern Category ParsePreload;
 extern Category ShipPageIn;
 extern Category WeaponPageIn;
 
@@ -7,6 +7,7 @@
 #include "TraceEventWriter.h"
 #include "MainFrameTimer.h"
 #include "FrameProfiler.h"
+#include "MissionProfiler.h"
 
 #include <cinttypes>
 #include <fstream>
@@ -55,6 +56,7 @@ using namespace tracing;
 std::unique_ptr<ThreadedTraceEventWriter> traceEventWriter;
 std::unique_ptr<ThreadedMainFrameTimer> mainFrameTimer;
 std::unique_ptr<FrameProfiler> frameProfiler;
+std::unique_ptr<MissionProfiler> missionProfiler;
 
 SCP_vector<int> query_objects;
 // The GPU timestamp queries use an internal free list to reduce the number of graphics API calls
@@ -127,6 +129,10 @@ void submit_event(trace_event* evt) {
 	if (frameProfiler) {
 		frameProfiler->processEvent(evt);
 	}
+
+	if (missionProfiler) {
+		missionProfiler->processEvent(evt);
+	}
 }
 
 void process_gpu_events() {
@@ -229,6 +235,10 @@ void init() {
 		frameProfiler.reset(new FrameProfiler());
 		do_trace_events = true;
 	}
+	if (Cmdline_mission_profile) {
+		missionProfiler.reset(new MissionProfiler());
+		do_trace_events = true;
+	}
 
 	do_gpu_queries = gr_is_capable(CAPABILITY_TIMESTAMP_QUERY);
 
@@ -260,6 +270,28 @@ SCP_string get_frame_profile_output() {
 	return frameProfiler->getContent();
 }
 
+bool mission_profile_enabled() {
+	return missionProfiler != nullptr;
+}
+
+void mission_profile_begin(const char* mission) {
+	if (missionProfiler) {
+		missionProfiler->beginMission(mission);
+	}
+}
+
+void mission_profile_process_frame(const mission_profile_frame& frame) {
+	if (missionProfiler) {
+		missionProfiler->processFrame(frame);
+	}
+}
+
+void mission_profile_end() {
+	if (missionProfiler) {
+		missionProfiler->endMission();
+	}
+}
+
 void shutdown() {
 	while (!gpu_events.empty()) {
 		process_events();
@@ -276,6 +308,12 @@ void shutdown() {
 	mainFrameTimer = nullptr;
 	traceEventWriter = nullptr;
 
+	if (missionProfiler) {
+		// Quitting in the middle of a mission still writes the profile
+		missionProfiler->endMission();
+		missionProfiler = nullptr;
+	}
+
 	initialized = false;
 }
 
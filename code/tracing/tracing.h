@@ -74,6 +74,39 @@ void frame_profile_process_frame();
  */
 SCP_string get_frame_profile_output();
 
+/**
+ * @brief The tags of a frame of the mission profiler
+ */
+struct mission_profile_frame {
+	float mission_time = 0.f;
+	float frame_time = 0.f; //!< The real frame time in seconds
+	int ships = 0;
+	int weapons = 0;
+	int particles = 0;
+};
+
+/**
+ * @brief Checks if the mission profiler is enabled (-profile_mission)
+ */
+bool mission_profile_enabled();
+
+/**
+ * @brief Starts profiling a mission
+ * @param mission The name of the mission, used for the output files
+ */
+void mission_profile_begin(const char* mission);
+
+/**
+ * @brief Adds the trace events of the last frame to the mission profile
+ * @param frame The tags of the frame
+ */
+void mission_profile_process_frame(const mission_profile_frame& frame);
+
+/**
+ * @brief Writes the mission profile to files
+ */
+void mission_profile_end();
+
 /**
  * @brief Deinitializes the tracing subsystem
  */
@@ -0,0 +1,137 @@
+#include "utils/WorkerPool.h"
+
+#include "cmdline/cmdline.h"
+
+namespace {
+
+// Upper limit for the automatically chosen number of worker threads
+const size_t MAX_AUTO_WORKERS = 7;
+
+thread_local bool Is_worker_thread = false;
+
+std::unique_ptr<util::WorkerPool> Global_pool;
+
+}
+
+namespace util {
+
+WorkerPool::WorkerPool(size_t num_workers) : _next_item(0) {
+	_threads.reserve(num_workers);
+	for (size_t i = 0; i < num_workers; ++i) {
+		// Thread index 0 is reserved for the thread calling parallelFor
+		_threads.emplace_back(&WorkerPool::workerThread, this, i + 1);
+	}
+}
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> guard(_mutex);
+		_shutdown = true;
+	}
+	_work_available.notify_all();
+
+	for (auto& thread : _threads) {
+		thread.join();
+	}
+}
+size_t WorkerPool::getNumThreads() const {
+	return _threads.size() + 1;
+}
+void WorkerPool::processChunks(size_t thread_index) {
+	while (true) {
+		auto begin = _next_item.fetch_add(_chunk_size);
+
+		if (begin >= _count) {
+			break;
+		}
+
+		(*_function)(begin, std::min(begin + _chunk_size, _count), thread_index);
+	}
+}
+void WorkerPool::workerThread(size_t thread_index) {
+	Is_worker_thread = true;
+
+	uint64_t last_generation = 0;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_work_available.wait(lock, [this, last_generation]() { return _shutdown || _generation != last_generation; });
+
+		if (_shutdown) {
+			return;
+		}
+
+		last_generation = _generation;
+		++_active_workers;
+
+		lock.unlock();
+		processChunks(thread_index);
+		lock.lock();
+
+		--_active_workers;
+		if (_active_workers == 0) {
+			_work_done.notify_all();
+		}
+	}
+}
+void WorkerPool::parallelFor(size_t count, size_t min_chunk_size, const RangeFunction& func) {
+	Assertion(!Is_worker_thread, "Nested parallel loops are not supported!");
+
+	if (count == 0) {
+		return;
+	}
+
+	min_chunk_size = std::max(min_chunk_size, (size_t) 1);
+
+	if (_threads.empty() || count <= min_chunk_size) {
+		func(0, count, 0);
+		return;
+	}
+
+	// Use a few chunks per thread so that uneven items still balance out
+	auto chunk_size = std::max(min_chunk_size, count / (getNumThreads() * 4));
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		// A worker may still be finishing up the previous loop if it woke up late
+		_work_done.wait(lock, [this]() { return _active_workers == 0; });
+
+		_function = &func;
+		_count = count;
+		_chunk_size = chunk_size;
+		_next_item = 0;
+		++_generation;
+	}
+	_work_available.notify_all();
+
+	processChunks(0);
+
+	// Wait until every worker that picked up this loop is finished with it. Workers that wake up after all chunks were
+	// taken will not find any work so they do not need to be waited for here.
+	std::unique_lock<std::mutex> lock(_mutex);
+	_work_done.wait(lock, [this]() { return _active_workers == 0; });
+}
+
+WorkerPool& get_worker_pool() {
+	if (!Global_pool) {
+		size_t num_workers;
+
+		if (Cmdline_worker_threads >= 0) {
+			num_workers = (size_t) Cmdline_worker_threads;
+		} else {
+			auto cores = std::thread::hardware_concurrency();
+			num_workers = (cores > 1) ? std::min((size_t) (cores - 1), MAX_AUTO_WORKERS) : 0;
+		}
+
+		mprintf(("Creating worker pool with %d worker threads\n", (int) num_workers));
+		Global_pool.reset(new WorkerPool(num_workers));
+	}
+
+	return *Global_pool;
+}
+
+bool is_worker_thread() {
+	return Is_worker_thread;
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "globalincs/pstypes.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace util {
+
+/**
+ * @brief A small pool of worker threads for data-parallel loops
+ *
+ * The pool is meant for splitting a loop over independent items across multiple threads. The thread which submits the
+ * work also processes items so a pool with zero worker threads simply runs the loop on the calling thread.
+ *
+ * Code running on a worker thread must not use any engine system that is not thread safe. That includes the tracing
+ * system, the graphics API, scripting and anything that allocates or frees game objects.
+ */
+class WorkerPool {
+ public:
+	/**
+	 * @brief The function that processes a range of items
+	 *
+	 * The parameters are the first item, one past the last item and the index of the thread processing the range. The
+	 * thread index is in the range [0, getNumThreads()) and may be used for indexing per-thread data.
+	 */
+	typedef std::function<void(size_t begin, size_t end, size_t thread_index)> RangeFunction;
+
+ private:
+	SCP_vector<std::thread> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _work_available;
+	std::condition_variable _work_done;
+
+	bool _shutdown = false;
+	uint64_t _generation = 0;	// Incremented every time a new loop is submitted
+
+	// The currently running loop, only valid while _active_workers is not 0
+	const RangeFunction* _function = nullptr;
+	size_t _count = 0;
+	size_t _chunk_size = 0;
+	std::atomic<size_t> _next_item;
+	size_t _active_workers = 0;
+
+	void workerThread(size_t thread_index);
+
+	void processChunks(size_t thread_index);
+
+ public:
+	/**
+	 * @brief Creates a pool with the specified number of additional threads
+	 * @param num_workers The number of threads to create. The calling thread is not included in this number.
+	 */
+	explicit WorkerPool(size_t num_workers);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/**
+	 * @brief The number of threads which may process items, including the calling thread
+	 */
+	size_t getNumThreads() const;
+
+	/**
+	 * @brief Processes the items [0, count) in parallel and waits until all of them have been processed
+	 *
+	 * The items are split into chunks of at least @c min_chunk_size items. Which thread processes which chunk is not
+	 * deterministic so the function must not depend on the order in which the items are processed.
+	 *
+	 * @param count The number of items
+	 * @param min_chunk_size The minimum number of items per chunk. Use larger values for very cheap items.
+	 * @param func The function that processes a range of items
+	 */
+	void parallelFor(size_t count, size_t min_chunk_size, const RangeFunction& func);
+};
+
+/**
+ * @brief Gets the global worker pool
+ *
+ * The pool is created on first use. The number of threads depends on the number of available CPU cores and can be
+ * overridden with the -worker_threads command line option.
+ */
+WorkerPool& get_worker_pool();
+
+/**
+ * @brief Determines if the calling thread is one of the worker threads of a WorkerPool
+ */
+bool is_worker_thread();
+
+}
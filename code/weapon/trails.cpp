@@ -9,6 +9,11 @@
 
 
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRAILS_USE_SSE2
+#endif
+
 #include "cmdline/cmdline.h"
 #include "globalincs/systemvars.h"
 #include "graphics/2d.h"
@@ -18,28 +23,68 @@
 #include "tracing/tracing.h"
 #include "weapon/trails.h"
 
+#include <memory>
+
 int Num_trails;
 trail Trails;
 
+// Trails are allocated in blocks so the pointers the weapons and ships hold stay valid
+static const int TRAIL_BLOCK_SIZE = 64;
+
+static SCP_vector<std::unique_ptr<trail[]>> Trail_blocks;
+static SCP_vector<trail*> Free_trails;
+
+// The ring buffers of all trails, every trail owns NUM_TRAIL_SECTIONS consecutive entries
+static SCP_vector<vec3d> Trail_pos;		// positions of trail points
+static SCP_vector<float> Trail_val;		// for each point, a value that tells how much to fade out
+
+static void trail_free_all()
+{
+	Free_trails.clear();
+
+	for (auto& block : Trail_blocks) {
+		for (int i = TRAIL_BLOCK_SIZE - 1; i >= 0; --i) {
+			Free_trails.push_back(&block[i]);
+		}
+	}
+}
+
+static void trail_allocate_block()
+{
+	auto first_section = (int)Trail_pos.size();
+
+	Trail_blocks.emplace_back(new trail[TRAIL_BLOCK_SIZE]);
+	Trail_pos.resize(Trail_pos.size() + TRAIL_BLOCK_SIZE * NUM_TRAIL_SECTIONS, vmd_zero_vector);
+	Trail_val.resize(Trail_val.size() + TRAIL_BLOCK_SIZE * NUM_TRAIL_SECTIONS, 0.0f);
+
+	auto block = Trail_blocks.back().get();
+	for (int i = TRAIL_BLOCK_SIZE - 1; i >= 0; --i) {
+		block[i].first_section = first_section + i * NUM_TRAIL_SECTIONS;
+		Free_trails.push_back(&block[i]);
+	}
+}
+
 // Reset everything between levels
 void trail_level_init()
 {
 	Num_trails = 0;
 	Trails.next = &Trails;
+
+	trail_free_all();
 }
 
 void trail_level_close()
 {
-	trail *nextp;
-	for(trail *trailp = Trails.next; trailp != &Trails; trailp = nextp)
-	{
-		nextp = trailp->next;
+	Trail_blocks.clear();
+	Free_trails.clear();
 
-		//Now we can delete it
-		delete trailp;
-	}
+	Trail_pos.clear();
+	Trail_pos.shrink_to_fit();
+	Trail_val.clear();
+	Trail_val.shrink_to_fit();
 
 	Num_trails=0;
+	Trails.next = &Trails;
 }
 
 //returns the number of a free trail
@@ -52,7 +97,12 @@ trail *trail_create(trail_info *info)
 		return NULL;
 
 	// Make a new trail
-	trail *trailp = new trail;
+	if (Free_trails.empty()) {
+		trail_allocate_block();
+	}
+
+	trail *trailp = Free_trails.back();
+	Free_trails.pop_back();
 
 	// increment counter
 	Num_trails++;
@@ -72,26 +122,6 @@ trail *trail_create(trail_info *info)
 	return trailp;
 }
 
-// output top and bottom vectors
-// fvec == forward vector (eye viewpoint basically. in world coords)
-// pos == world coordinate of the point we're calculating "around"
-// w == width of the diff between top and bottom around pos
-void trail_calc_facing_pts( vec3d *top, vec3d *bot, vec3d *fvec, vec3d *pos, float w )
-{
-	vec3d uvec, rvec;
-
-	vm_vec_sub( &rvec, &Eye_position, pos );
-	if (!IS_VEC_NULL(&rvec))
-		vm_vec_normalize( &rvec );
-
-	vm_vec_cross(&uvec,fvec,&rvec);
-	if (!IS_VEC_NULL(&uvec))
-		vm_vec_normalize(&uvec);
-
-	vm_vec_scale_add( top, pos, &uvec, w * 0.5f );
-	vm_vec_scale_add( bot, pos, &uvec, -w * 0.5f );
-}
-
 // trail is on ship
 int trail_is_on_ship(trail *trailp, ship *shipp)
 {
@@ -108,58 +138,64 @@ int trail_is_on_ship(trail *trailp, ship *shipp)
 	return 0;
 }
 
-// Render the trail behind a missile.
-// Basically a queue of points that face the viewer
-static vertex *Trail_v_list = NULL;
-static int Trail_verts_allocated = 0;
+// The sections of all trails drawn this frame, stored as separate components so the facing points of all of them
+// can be computed in one pass
+struct trail_sections {
+	SCP_vector<float> pos_x, pos_y, pos_z;
+	SCP_vector<float> fvec_x, fvec_y, fvec_z;	// direction to the previous section
+	SCP_vector<float> width;
+	SCP_vector<ubyte> alpha;
 
-static void deallocate_trail_verts()
-{
-	if (Trail_v_list != NULL) {
-		vm_free(Trail_v_list);
-		Trail_v_list = NULL;
-	}
-}
+	// Output of the facing pass, half of the vector from the bottom to the top point
+	SCP_vector<float> up_x, up_y, up_z;
 
-static void allocate_trail_verts(int num_verts)
-{
-	if (num_verts <= 0)
-		return;
-
-	if (num_verts <= Trail_verts_allocated)
-		return;
+	size_t size() const { return pos_x.size(); }
 
-	if (Trail_v_list != NULL) {
-		vm_free(Trail_v_list);
-		Trail_v_list = NULL;
+	void clear()
+	{
+		pos_x.clear();
+		pos_y.clear();
+		pos_z.clear();
+		fvec_x.clear();
+		fvec_y.clear();
+		fvec_z.clear();
+		width.clear();
+		alpha.clear();
 	}
 
-	Trail_v_list = (vertex*) vm_malloc( num_verts * sizeof(vertex) );
-
-	memset( Trail_v_list, 0, sizeof(vertex) * Trail_verts_allocated );
-
-	Trail_verts_allocated = num_verts;
-
-
-	static bool will_free_at_exit = false;
-
-	if ( !will_free_at_exit ) {
-		atexit(deallocate_trail_verts);
-		will_free_at_exit = true;
+	void push_back(const vec3d& pos, const vec3d& fvec, float w, ubyte l)
+	{
+		pos_x.push_back(pos.xyz.x);
+		pos_y.push_back(pos.xyz.y);
+		pos_z.push_back(pos.xyz.z);
+		fvec_x.push_back(fvec.xyz.x);
+		fvec_y.push_back(fvec.xyz.y);
+		fvec_z.push_back(fvec.xyz.z);
+		width.push_back(w);
+		alpha.push_back(l);
 	}
-}
-
-void trail_render( trail * trailp )
+};
+
+struct trail_batch {
+	trail *trailp;
+	size_t first_section;
+	int num_sections;
+	size_t first_vert;
+	int num_verts;
+};
+
+// Reused every frame so building the vertices doesn't allocate anything once the buffers are large enough
+static trail_sections Trail_sections;
+static SCP_vector<trail_batch> Trail_batches;
+static SCP_vector<vertex> Trail_verts;
+
+// Appends the sections of a trail which haven't faded out yet to the sections of this frame
+static void trail_gather_sections( trail * trailp )
 {
 	int sections[NUM_TRAIL_SECTIONS];
 	int num_sections = 0;
 	int i;
-	vec3d topv, botv, *fvec, last_pos, tmp_fvec;
-	vertex  top, bot;
-	int nv = 0;
-	float w;
-	ubyte l;
-	vec3d centerv;
+	vec3d fvec;
 
 	if (trailp->tail == trailp->head)
 		return;
@@ -172,6 +208,8 @@ void trail_render( trail * trailp )
 	}
 
 	trail_info *ti	= &trailp->info;
+	vec3d *pos = &Trail_pos[trailp->first_section];
+	float *val = &Trail_val[trailp->first_section];
 
 	int n = trailp->tail;
 
@@ -181,7 +219,7 @@ void trail_render( trail * trailp )
 		if (n < 0)
 			n = NUM_TRAIL_SECTIONS-1;
 
-		if (trailp->val[n] > 1.0f)
+		if (val[n] > 1.0f)
 			break;
 
 		sections[num_sections++] = n;
@@ -192,11 +230,13 @@ void trail_render( trail * trailp )
 
 	Assertion(ti->texture.bitmap_id != -1, "Weapon trail %s could not be loaded", ti->texture.filename); // We can leave this as an assert, but tell them how to fix it. --Chief
 
-	memset( &top, 0, sizeof(vertex) );
-	memset( &bot, 0, sizeof(vertex) );
-
-	// it's a tristrip, so allocate for 2+1
-	allocate_trail_verts((num_sections * 2) + 1);
+	trail_batch batch;
+	batch.trailp = trailp;
+	batch.first_section = Trail_sections.size();
+	batch.num_sections = num_sections;
+	batch.first_vert = 0;
+	batch.num_verts = 0;
+	Trail_batches.push_back(batch);
 
 	float w_size = (ti->w_end - ti->w_start);
 	float a_size = (ti->a_end - ti->a_start);
@@ -205,36 +245,161 @@ void trail_render( trail * trailp )
 	for (i = 0; i < num_sections; i++) {
 		n = sections[i];
 		float init_fade_out = 1.0f;
+		float w;
+		ubyte l;
 
 		if ((num_faded_sections > 0) && (i < num_faded_sections)) {
 			init_fade_out = ((float) i) / (float) num_faded_sections;
 		}
 
-		w = trailp->val[n] * w_size + ti->w_start;
+		w = val[n] * w_size + ti->w_start;
 		if (init_fade_out != 1.0f) {
-			l = (ubyte)fl2i((trailp->val[n] * a_size + ti->a_start) * 255.0f * init_fade_out * init_fade_out);
+			l = (ubyte)fl2i((val[n] * a_size + ti->a_start) * 255.0f * init_fade_out * init_fade_out);
 		} else {
-			l = (ubyte)fl2i((trailp->val[n] * a_size + ti->a_start) * 255.0f);
+			l = (ubyte)fl2i((val[n] * a_size + ti->a_start) * 255.0f);
 		}
 
 		if ( i == 0 )	{
 			if ( num_sections > 1 )	{
-				vm_vec_sub(&tmp_fvec, &trailp->pos[n], &trailp->pos[sections[i+1]] );
-				vm_vec_normalize_safe(&tmp_fvec);
-				fvec = &tmp_fvec;
+				vm_vec_sub(&fvec, &pos[n], &pos[sections[i+1]] );
+				vm_vec_normalize_safe(&fvec);
 			} else {
-				fvec = &tmp_fvec;
-				fvec->xyz.x = 0.0f;
-				fvec->xyz.y = 0.0f;
-				fvec->xyz.z = 1.0f;
+				fvec.xyz.x = 0.0f;
+				fvec.xyz.y = 0.0f;
+				fvec.xyz.z = 1.0f;
 			}
 		} else {
-			vm_vec_sub(&tmp_fvec, &last_pos, &trailp->pos[n] );
-			vm_vec_normalize_safe(&tmp_fvec);
-			fvec = &tmp_fvec;
+			vm_vec_sub(&fvec, &pos[sections[i-1]], &pos[n] );
+			vm_vec_normalize_safe(&fvec);
 		}
 
-		trail_calc_facing_pts( &topv, &botv, fvec, &trailp->pos[n], w );
+		Trail_sections.push_back(pos[n], fvec, w, l);
+	}
+}
+
+// Computes the up vector of one section, scaled to half of the width
+// fvec == forward vector (eye viewpoint basically. in world coords)
+// pos == world coordinate of the point we're calculating "around"
+// w == width of the diff between top and bottom around pos
+static void trail_calc_facing_offset( vec3d *up, const vec3d *fvec, const vec3d *pos, float w )
+{
+	vec3d uvec, rvec;
+
+	vm_vec_sub( &rvec, &Eye_position, pos );
+	if (!IS_VEC_NULL(&rvec))
+		vm_vec_normalize( &rvec );
+
+	vm_vec_cross(&uvec,fvec,&rvec);
+	if (!IS_VEC_NULL(&uvec))
+		vm_vec_normalize(&uvec);
+
+	vm_vec_copy_scale( up, &uvec, w * 0.5f );
+}
+
+#ifdef TRAILS_USE_SSE2
+// Scales the vectors to unit length, null vectors are left alone
+static inline void trail_normalize_sse2(__m128& x, __m128& y, __m128& z)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 epsilon = _mm_set1_ps(1e-36f);
+
+	__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+
+	__m128 not_null = _mm_or_ps(_mm_or_ps(_mm_cmpge_ps(_mm_andnot_ps(sign, x), epsilon),
+		_mm_cmpge_ps(_mm_andnot_ps(sign, y), epsilon)), _mm_cmpge_ps(_mm_andnot_ps(sign, z), epsilon));
+	not_null = _mm_and_ps(not_null, _mm_cmpgt_ps(len2, _mm_setzero_ps()));
+
+	__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+	__m128 scale = _mm_or_ps(_mm_and_ps(not_null, inv), _mm_andnot_ps(not_null, one));
+
+	x = _mm_mul_ps(x, scale);
+	y = _mm_mul_ps(y, scale);
+	z = _mm_mul_ps(z, scale);
+}
+#endif
+
+// Computes the facing points of all sections of this frame
+static void trail_calc_all_facing_offsets()
+{
+	auto count = Trail_sections.size();
+	auto& s = Trail_sections;
+
+	s.up_x.resize(count);
+	s.up_y.resize(count);
+	s.up_z.resize(count);
+
+	size_t i = 0;
+
+#ifdef TRAILS_USE_SSE2
+	const __m128 eye_x = _mm_set1_ps(Eye_position.xyz.x);
+	const __m128 eye_y = _mm_set1_ps(Eye_position.xyz.y);
+	const __m128 eye_z = _mm_set1_ps(Eye_position.xyz.z);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 rx = _mm_sub_ps(eye_x, _mm_loadu_ps(&s.pos_x[i]));
+		__m128 ry = _mm_sub_ps(eye_y, _mm_loadu_ps(&s.pos_y[i]));
+		__m128 rz = _mm_sub_ps(eye_z, _mm_loadu_ps(&s.pos_z[i]));
+		trail_normalize_sse2(rx, ry, rz);
+
+		__m128 fx = _mm_loadu_ps(&s.fvec_x[i]);
+		__m128 fy = _mm_loadu_ps(&s.fvec_y[i]);
+		__m128 fz = _mm_loadu_ps(&s.fvec_z[i]);
+
+		__m128 ux = _mm_sub_ps(_mm_mul_ps(fy, rz), _mm_mul_ps(fz, ry));
+		__m128 uy = _mm_sub_ps(_mm_mul_ps(fz, rx), _mm_mul_ps(fx, rz));
+		__m128 uz = _mm_sub_ps(_mm_mul_ps(fx, ry), _mm_mul_ps(fy, rx));
+		trail_normalize_sse2(ux, uy, uz);
+
+		__m128 half_width = _mm_mul_ps(_mm_loadu_ps(&s.width[i]), half);
+		_mm_storeu_ps(&s.up_x[i], _mm_mul_ps(ux, half_width));
+		_mm_storeu_ps(&s.up_y[i], _mm_mul_ps(uy, half_width));
+		_mm_storeu_ps(&s.up_z[i], _mm_mul_ps(uz, half_width));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		vec3d pos, fvec, up;
+		vm_vec_make(&pos, s.pos_x[i], s.pos_y[i], s.pos_z[i]);
+		vm_vec_make(&fvec, s.fvec_x[i], s.fvec_y[i], s.fvec_z[i]);
+
+		trail_calc_facing_offset(&up, &fvec, &pos, s.width[i]);
+
+		s.up_x[i] = up.xyz.x;
+		s.up_y[i] = up.xyz.y;
+		s.up_z[i] = up.xyz.z;
+	}
+}
+
+// Builds the vertices of a trail in the shared vertex list
+// Basically a queue of points that face the viewer
+static void trail_build_verts( trail_batch *batch )
+{
+	int i;
+	vec3d topv, botv, pos, up;
+	vertex  top, bot;
+	int nv = 0;
+	ubyte l;
+	vec3d centerv;
+
+	auto& s = Trail_sections;
+	vertex *verts = &Trail_verts[batch->first_vert];
+
+	memset( &top, 0, sizeof(vertex) );
+	memset( &bot, 0, sizeof(vertex) );
+
+	// it's a tristrip, so allocate for 2+1
+	memset( verts, 0, sizeof(vertex) * ((batch->num_sections * 2) + 1) );
+
+	for (i = 0; i < batch->num_sections; i++) {
+		auto n = batch->first_section + i;
+
+		vm_vec_make(&pos, s.pos_x[n], s.pos_y[n], s.pos_z[n]);
+		vm_vec_make(&up, s.up_x[n], s.up_y[n], s.up_z[n]);
+		vm_vec_add( &topv, &pos, &up );
+		vm_vec_sub( &botv, &pos, &up );
+		l = s.alpha[n];
 
 		g3_transfer_vertex( &top, &topv );
 		g3_transfer_vertex( &bot, &botv );
@@ -244,46 +409,47 @@ void trail_render( trail * trailp )
 		if (i > 0) {
 			float U = i2fl(i);
 
-			if (i == num_sections-1) {
+			if (i == batch->num_sections-1) {
 				// Last one...
 				vm_vec_avg( &centerv, &topv, &botv );
 
-				g3_transfer_vertex( &Trail_v_list[nv+2], &centerv );
+				g3_transfer_vertex( &verts[nv+2], &centerv );
 
-				Trail_v_list[nv].a = l;	
+				verts[nv].a = l;	
 
-				Trail_v_list[nv].texture_position.u = U;
-				Trail_v_list[nv].texture_position.v = 1.0f; 
-				Trail_v_list[nv].r = Trail_v_list[nv].g = Trail_v_list[nv].b = l;
+				verts[nv].texture_position.u = U;
+				verts[nv].texture_position.v = 1.0f; 
+				verts[nv].r = verts[nv].g = verts[nv].b = l;
 				nv++;
 
-				Trail_v_list[nv].texture_position.u = U;
-				Trail_v_list[nv].texture_position.v = 0.0f; 
-				Trail_v_list[nv].r = Trail_v_list[nv].g = Trail_v_list[nv].b = l;
+				verts[nv].texture_position.u = U;
+				verts[nv].texture_position.v = 0.0f; 
+				verts[nv].r = verts[nv].g = verts[nv].b = l;
 				nv++;
 
-				Trail_v_list[nv].texture_position.u = U + 1.0f;
-				Trail_v_list[nv].texture_position.v = 0.5f;
-				Trail_v_list[nv].r = Trail_v_list[nv].g = Trail_v_list[nv].b = 0;
+				verts[nv].texture_position.u = U + 1.0f;
+				verts[nv].texture_position.v = 0.5f;
+				verts[nv].r = verts[nv].g = verts[nv].b = 0;
 				nv++;
 			} else {
-				Trail_v_list[nv].texture_position.u = U;
-				Trail_v_list[nv].texture_position.v = 1.0f; 
-				Trail_v_list[nv].r = Trail_v_list[nv].g = Trail_v_list[nv].b = l;
+				verts[nv].texture_position.u = U;
+				verts[nv].texture_position.v = 1.0f; 
+				verts[nv].r = verts[nv].g = verts[nv].b = l;
 				nv++;
 
-				Trail_v_list[nv].texture_position.u = U;
-				Trail_v_list[nv].texture_position.v = 0.0f; 
-				Trail_v_list[nv].r = Trail_v_list[nv].g = Trail_v_list[nv].b = l;
+				verts[nv].texture_position.u = U;
+				verts[nv].texture_position.v = 0.0f; 
+				verts[nv].r = verts[nv].g = verts[nv].b = l;
 				nv++;
 			}
 		}
 
-		last_pos = trailp->pos[n];
-		Trail_v_list[nv] = top;
-		Trail_v_list[nv+1] = bot;
+		verts[nv] = top;
+		verts[nv+1] = bot;
 	}
 
+	batch->num_verts = nv;
+
 	if ( !nv )
 		return;
 
@@ -293,14 +459,20 @@ void trail_render( trail * trailp )
 	// there should always be three verts in the last section and 2 everyware else, therefore there should always be an odd number of verts
 	if ( (nv % 2) != 1 )
 		Warning( LOCATION, "even number of verts in trail render\n" );
+}
+
+static void trail_render_batch( trail_batch *batch )
+{
+	if ( !batch->num_verts )
+		return;
+
+	trail_info *ti = &batch->trailp->info;
 
 	TRACE_SCOPE(tracing::TrailDraw);
-	//gr_set_bitmap( ti->texture.bitmap_id, GR_ALPHABLEND_FILTER, GR_BITBLT_MODE_NORMAL, 1.0f );
-	//gr_render(nv, Trail_v_list, TMAP_FLAG_TEXTURED | TMAP_FLAG_ALPHA | TMAP_FLAG_GOURAUD | TMAP_FLAG_RGB | TMAP_HTL_3D_UNLIT | TMAP_FLAG_TRISTRIP);
 
 	material material_def;
 	material_set_unlit(&material_def, ti->texture.bitmap_id, 1.0f, true, true);
-	g3_render_primitives_colored_textured(&material_def, Trail_v_list, nv, PRIM_TYPE_TRISTRIP, false);
+	g3_render_primitives_colored_textured(&material_def, &Trail_verts[batch->first_vert], batch->num_verts, PRIM_TYPE_TRISTRIP, false);
 }
 
 void trail_add_segment( trail *trailp, vec3d *pos )
@@ -317,8 +489,8 @@ void trail_add_segment( trail *trailp, vec3d *pos )
 			trailp->head = 0;
 	}
 	
-	trailp->pos[next] = *pos;
-	trailp->val[next] = 0.0f;
+	Trail_pos[trailp->first_section + next] = *pos;
+	Trail_val[trailp->first_section + next] = 0.0f;
 }		
 
 void trail_set_segment( trail *trailp, vec3d *pos )
@@ -328,43 +500,57 @@ void trail_set_segment( trail *trailp, vec3d *pos )
 		next = NUM_TRAIL_SECTIONS-1;
 	}
 	
-	trailp->pos[next] = *pos;
+	Trail_pos[trailp->first_section + next] = *pos;
+}
+
+// Ages the whole ring of a trail, the unused entries are reset when a segment is added
+static void trail_age_sections( float *val, float time_delta )
+{
+	int i = 0;
+
+#ifdef TRAILS_USE_SSE2
+	const __m128 delta = _mm_set1_ps(time_delta);
+
+	for (; i + 4 <= NUM_TRAIL_SECTIONS; i += 4) {
+		_mm_storeu_ps(&val[i], _mm_add_ps(_mm_loadu_ps(&val[i]), delta));
+	}
+#endif
+
+	for (; i < NUM_TRAIL_SECTIONS; i++) {
+		val[i] += time_delta;
+	}
 }
 
 void trail_move_all(float frametime)
 {
 	TRACE_SCOPE(tracing::TrailsMoveAll);
 
-	int num_alive_segments,n;
-	float time_delta;
+	bool alive;
 	trail *next_trail;
 	trail *prev_trail = &Trails;
 
 	for (trail *trailp = Trails.next; trailp != &Trails; trailp = next_trail) {
 		next_trail = trailp->next;
 
-		num_alive_segments = 0;
+		alive = false;
 
 		if ( trailp->tail != trailp->head )	{
-			n = trailp->tail;			
-			time_delta = frametime / trailp->info.max_life;
-			do	{
-				n--;
-				if ( n < 0 ) n = NUM_TRAIL_SECTIONS-1;
+			float *val = &Trail_val[trailp->first_section];
 
-				trailp->val[n] += time_delta;
+			trail_age_sections( val, frametime / trailp->info.max_life );
 
-				if ( trailp->val[n] <= 1.0f ) {
-					num_alive_segments++;	// Record how many still alive.
-				}
+			// All segments age at the same rate so the newest one is the last to fade out
+			int newest = trailp->tail - 1;
+			if ( newest < 0 )
+				newest = NUM_TRAIL_SECTIONS-1;
 
-			} while ( n != trailp->head );
+			alive = val[newest] <= 1.0f;
 		}		
 	
-		if ( (num_alive_segments < 1) && trailp->object_died)
+		if ( !alive && trailp->object_died)
 		{
 			prev_trail->next = trailp->next;
-			delete trailp;
+			Free_trails.push_back(trailp);
 
 			// decrement counter
 			Num_trails--;
@@ -390,15 +576,37 @@ void trail_render_all()
 	if ( !Detail.weapon_extras )
 		return;
 
+	Trail_sections.clear();
+	Trail_batches.clear();
+
 	for(trail *trailp = Trails.next; trailp!=&Trails; trailp = trailp->next )
 	{
-		//trail_add_batch(trailp);
-		trail_render(trailp);
+		trail_gather_sections(trailp);
 	}
 
-	//profile_begin("Batch Render Trails");
-	//batch_render_all(Trail_buffer_object);
-	//profile_end("Batch Render Trails");
+	if (Trail_batches.empty())
+		return;
+
+	trail_calc_all_facing_offsets();
+
+	// All trails share one vertex list, there are 2 vertices per section and one for the tip
+	size_t num_verts = 0;
+	for (auto& batch : Trail_batches) {
+		batch.first_vert = num_verts;
+		num_verts += (batch.num_sections * 2) + 1;
+	}
+
+	if (Trail_verts.size() < num_verts) {
+		Trail_verts.resize(num_verts);
+	}
+
+	for (auto& batch : Trail_batches) {
+		trail_build_verts(&batch);
+	}
+
+	for (auto& batch : Trail_batches) {
+		trail_render_batch(&batch);
+	}
 }
 int trail_stamp_elapsed(trail *trailp)
 {
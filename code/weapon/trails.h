@@ -31,10 +31,10 @@ typedef struct trail_info {
 	int n_fade_out_sections;// number of initial sections used for fading out start 'edge' of the effect
 } trail_info;
 
+// The points of all trails are stored in one arena, every trail owns a ring of NUM_TRAIL_SECTIONS points in it
 typedef struct trail {
 	int		head, tail;						// pointers into the queue for the trail points
-	vec3d	pos[NUM_TRAIL_SECTIONS];	// positions of trail points
-	float	val[NUM_TRAIL_SECTIONS];	// for each point, a value that tells how much to fade out	
+	int		first_section;					// index of the first point of this trail in the arena
 	bool	object_died;					// set to zero as long as object	
 	int		trail_stamp;					// trail timestamp	
 
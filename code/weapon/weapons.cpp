@@ -29,6 +29,7 @@
 #include "network/multimsgs.h"
 #include "network/multiutil.h"
 #include "object/objcollide.h"
+#include "object/objectspatial.h"
 #include "scripting/scripting.h"
 #include "particle/particle.h"
 #include "playerman/player.h"
@@ -486,6 +487,8 @@ int missile_obj_list_add(int objnum)
 	list_append(&Missile_obj_list, &Missile_objs[i]);
 	Missile_objs[i].flags |= MISSILE_OBJ_USED;
 
+	obj_spatial_add(objnum);
+
 	return i;
 }
 
@@ -3727,7 +3730,7 @@ void detonate_nearby_missiles(object* killer_objp, object* missile_objp)
  */
 void find_homing_object(object *weapon_objp, int num)
 {
-	object      *objp, *old_homing_objp;
+	object      *old_homing_objp;
 	weapon_info *wip;
 	weapon      *wp;
     ship        *sp;
@@ -3752,18 +3755,18 @@ void find_homing_object(object *weapon_objp, int num)
 	wp->homing_object = &obj_used_list;
 
 	//	Scan all objects, find a weapon to home on.
-	for ( objp = GET_FIRST(&obj_used_list); objp !=END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp) ) {
+	obj_for_each_of_types({OBJ_SHIP, OBJ_WEAPON}, [&](object *objp) {
 		if ((objp->type == OBJ_SHIP) || ((objp->type == OBJ_WEAPON) && (Weapon_info[Weapons[objp->instance].weapon_info_index].wi_flags[Weapon::Info_Flags::Cmeasure])))
 		{
 			//WMC - Spawn weapons shouldn't go for protected ships
 			// ditto for untargeted heat seekers - niffiwan
 			if ( (objp->flags[Object::Object_Flags::Protected]) &&
 				((wp->weapon_flags[Weapon::Weapon_Flags::Spawned]) || (wip->wi_flags[Weapon::Info_Flags::Untargeted_heat_seeker])) )
-				continue;
+				return;
 
 			// Spawned weapons should never home in on their parent - even in multiplayer dogfights where they would pass the iff test below
 			if ((wp->weapon_flags[Weapon::Weapon_Flags::Spawned]) && (objp == &Objects[weapon_objp->parent]))
-				continue; 
+				return; 
 
 			homing_object_team = obj_team(objp);
 			if (iff_x_attacks_y(wp->team, homing_object_team))
@@ -3778,18 +3781,18 @@ void find_homing_object(object *weapon_objp, int num)
                     if ((wip->wi_flags[Weapon::Info_Flags::Huge]) &&
                         (sip->is_small_ship() || !sip->is_flyable() || sip->is_harmless()))
                     {
-                        continue;
+                        return;
                     }
 
 					// AL 2-17-98: If ship is immune to sensors, can't home on it (Sandeep says so)!
 					if ( sp->flags[Ship::Ship_Flags::Hidden_from_sensors] ) {
-						continue;
+						return;
 					}
 
 					// Goober5000: if missiles can't home on sensor-ghosted ships,
 					// they definitely shouldn't home on stealth ships
 					if ( sp->flags[Ship::Ship_Flags::Stealth] && (The_mission.ai_profile->flags[AI::Profile_Flags::Fix_heat_seeker_stealth_bug]) ) {
-						continue;
+						return;
 					}
 
                     if (wip->wi_flags[Weapon::Info_Flags::Homing_javelin])
@@ -3797,7 +3800,7 @@ void find_homing_object(object *weapon_objp, int num)
                         target_engines = ship_get_closest_subsys_in_sight(sp, SUBSYSTEM_ENGINE, &weapon_objp->pos);
 
                         if (!target_engines)
-                            continue;
+                            return;
                     }
 
 					//	MK, 9/4/99.
@@ -3807,18 +3810,18 @@ void find_homing_object(object *weapon_objp, int num)
 					if (!( Game_mode & GM_MULTIPLAYER )) {
 						int	num_homers = compute_num_homing_objects(objp);
 						if (The_mission.ai_profile->max_allowed_player_homers[Game_skill_level] < num_homers)
-							continue;
+							return;
 					}
 				}
                 else if (objp->type == OBJ_WEAPON)
 				{
                     //don't attempt to home on weapons if the weapon is a huge weapon or is a javelin homing weapon.
                     if (wip->wi_flags[Weapon::Info_Flags::Huge, Weapon::Info_Flags::Homing_javelin])
-                        continue;
+                        return;
                     
                     //don't look for local ssms that are gone for the time being
 					if (Weapons[objp->instance].lssm_stage == 3)
-						continue;
+						return;
 				}
 
 				dist = vm_vec_normalized_dir(&vec_to_object, &objp->pos, &weapon_objp->pos);
@@ -3841,7 +3844,7 @@ void find_homing_object(object *weapon_objp, int num)
 				}
 			}
 		}
-	}
+	});
 
 	if (wp->homing_object == Player_obj)
 		weapon_maybe_play_warning(wp);
@@ -3857,8 +3860,9 @@ void find_homing_object(object *weapon_objp, int num)
  */
 void find_homing_object_cmeasures(const SCP_vector<object*> &cmeasure_list)
 {
-	for (object *weapon_objp = GET_FIRST(&obj_used_list); weapon_objp != END_OF_LIST(&obj_used_list); weapon_objp = GET_NEXT(weapon_objp) ) {
-		if (weapon_objp->type == OBJ_WEAPON) {
+	for (auto weapon_objnum : obj_get_type_list(OBJ_WEAPON)) {
+		if (weapon_objnum >= 0) {
+			object *weapon_objp = &Objects[weapon_objnum];
 			weapon *wp = &Weapons[weapon_objp->instance];
 			weapon_info	*wip = &Weapon_info[wp->weapon_info_index];
 
@@ -5974,36 +5978,31 @@ void weapon_area_apply_blast(vec3d * /*force_apply_pos*/, object *ship_objp, vec
 void weapon_do_area_effect(object *wobjp, shockwave_create_info *sci, vec3d *pos, object *other_obj)
 {
 	weapon_info	*wip;
-	object		*objp;
 	float			damage, blast;
 
 	wip = &Weapon_info[Weapons[wobjp->instance].weapon_info_index];	
 
 	// only blast ships and asteroids
 	// And (some) weapons
-	for ( objp = GET_FIRST(&obj_used_list); objp !=END_OF_LIST(&obj_used_list); objp = GET_NEXT(objp) ) {
-		if ( (objp->type != OBJ_SHIP) && (objp->type != OBJ_ASTEROID) && (objp->type != OBJ_WEAPON) ) {
-			continue;
-		}
-	
+	obj_for_each_of_types({OBJ_SHIP, OBJ_ASTEROID, OBJ_WEAPON}, [&](object *objp) {
 		if (objp->type == OBJ_WEAPON) {
 			// only apply to missiles with hitpoints
 			weapon_info* wip2 = &Weapon_info[Weapons[objp->instance].weapon_info_index];
 			if (wip2->weapon_hitpoints <= 0)
-				continue;
+				return;
 			if (!((wip2->wi_flags[Weapon::Info_Flags::Takes_blast_damage]) || (wip->wi_flags[Weapon::Info_Flags::Ciws])))
-				continue;
+				return;
 		}
 
 		if ( objp->type == OBJ_SHIP ) {
 			// don't blast navbuoys
 			if ( ship_get_SIF(objp->instance)[Ship::Info_Flags::Navbuoy] ) {
-				continue;
+				return;
 			}
 		}
 
 		if ( weapon_area_calc_damage(objp, pos, sci->inner_rad, sci->outer_rad, sci->blast, sci->damage, &blast, &damage, sci->outer_rad) == -1 ){
-			continue;
+			return;
 		}
 
 		// scale damage
@@ -6040,7 +6039,7 @@ void weapon_do_area_effect(object *wobjp, shockwave_create_info *sci, vec3d *pos
 			break;
 		} 	
 
-	}	// end for
+	});
 
 
 }
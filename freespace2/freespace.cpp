@@ -35,6 +35,7 @@
 #include "autopilot/autopilot.h"
 #include "bmpman/bmpman.h"
 #include "cfile/cfile.h"
+#include "cfile/cfilesystem.h"
 #include "cmdline/cmdline.h"
 #include "cmeasure/cmeasure.h"
 #include "cutscene/cutscenes.h"
@@ -887,6 +888,8 @@ void game_flash_diminish(float frametime)
 
 void game_level_close()
 {
+	tracing::mission_profile_end();
+
 	//WMC - this is actually pretty damn dangerous, but I don't want a modder
 	//to accidentally use an override here without realizing it.
 	if(!Script_system.IsConditionOverride(CHA_MISSIONEND))
@@ -1405,6 +1408,8 @@ int game_start_mission()
 
 	int s1 __UNUSED = timer_get_milliseconds();
 
+	cf_reset_lookup_stats();
+
 	// clear post processing settings
 	gr_post_process_set_defaults();
 
@@ -1463,6 +1468,11 @@ int game_start_mission()
 	int e1 __UNUSED = timer_get_milliseconds();
 
 	mprintf(("Level load took %f seconds.\n", (e1 - s1) / 1000.0f ));
+
+	auto lookup_stats = cf_get_lookup_stats();
+	mprintf(("Level load looked up %llu files in %f seconds.\n", (unsigned long long)lookup_stats.lookups, lookup_stats.time_us / 1000000.0f));
+
+	tracing::mission_profile_begin(Game_current_mission_filename);
 	return 1;
 }
 
@@ -1847,6 +1857,9 @@ void game_init()
 	ptr = os_config_read_string(NULL, NOX("GammaD3D"), NOX("1.0"));
 	FreeSpace_gamma = (float)atof(ptr);
 
+	// read all tables on the worker threads before they are parsed one after another
+	parse_preload_tables();
+
 	script_init();			//WMC
 
 	font::init();					// loads up all fonts
@@ -2004,6 +2017,8 @@ void game_init()
 	// Initialize dynamic SEXPs
 	sexp::dynamic_sexp_init();
 
+	parse_free_preloaded_files();
+
 	// This needs to be done after the dynamic SEXP init so that our documentation contains the dynamic sexps
 	if (Cmdline_output_sexp_info) {
 		output_sexps("sexps.html");
@@ -4262,6 +4277,17 @@ void game_frame(bool paused)
 		tracing::frame_profile_process_frame();
 	}
 
+	if (tracing::mission_profile_enabled()) {
+		tracing::mission_profile_frame profile_frame;
+		profile_frame.mission_time = f2fl(Missiontime);
+		profile_frame.frame_time = flRealframetime;
+		profile_frame.ships = ship_get_num_ships();
+		profile_frame.weapons = Num_weapons;
+		profile_frame.particles = (int)particle::get_particle_count();
+
+		tracing::mission_profile_process_frame(profile_frame);
+	}
+
 	DEBUG_GET_TIME( total_time2 )
 
 #ifndef NDEBUG
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include "bmpman/bm_texture_cache.h"
+#include "cfile/cfile.h"
+#include "cmdline/cmdline.h"
+
+#include "util/FSTestFixture.h"
+
+#include <chrono>
+#include <thread>
+
+class TextureCacheTest : public test::FSTestFixture {
+ public:
+	TextureCacheTest() : test::FSTestFixture(INIT_CFILE) {
+		pushModDir("bmpman");
+		addCommandlineArg("-texture_cache");
+	}
+
+ protected:
+	void TearDown() override {
+		bm_texture_cache_purge();
+		bm_texture_cache_set_budget((size_t)1024 * 1024 * 1024);
+
+		FSTestFixture::TearDown();
+
+		Cmdline_texture_cache = false;
+	}
+};
+
+TEST_F(TextureCacheTest, texture_cache) {
+	const int w = 4;
+	const int h = 2;
+	SCP_vector<ubyte> pixels(w * h * 3);
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		pixels[i] = (ubyte)(i * 7);
+	}
+
+	ASSERT_TRUE(bm_texture_cache_enabled());
+
+	int decode_calls = 0;
+	auto decode = [&](ubyte* data, int* bpp) {
+		++decode_calls;
+		memcpy(data, pixels.data(), pixels.size());
+		*bpp = 24;
+		return true;
+	};
+
+	SCP_vector<ubyte> data(pixels.size(), 0);
+	int bpp = 32;
+	ASSERT_TRUE(bm_texture_cache_load("cache_test", ".tga", CF_TYPE_EFFECTS, w, h, data.data(), data.size(), &bpp,
+	                                  [&](int* out_bpp) { return decode(data.data(), out_bpp); }));
+	ASSERT_EQ(1, decode_calls);
+	ASSERT_EQ(24, bpp);
+
+	// The second load has to come from the cache and restore the bits per pixel of the decoder
+	SCP_vector<ubyte> cached(pixels.size(), 0);
+	bpp = 32;
+	ASSERT_TRUE(bm_texture_cache_load("cache_test", ".tga", CF_TYPE_EFFECTS, w, h, cached.data(), cached.size(), &bpp,
+	                                  [&](int* out_bpp) { return decode(cached.data(), out_bpp); }));
+	ASSERT_EQ(1, decode_calls);
+	ASSERT_EQ(24, bpp);
+	ASSERT_EQ(pixels, cached);
+
+	// A different output format is a different entry
+	SCP_vector<ubyte> other(w * h * 4, 0);
+	bpp = 32;
+	ASSERT_TRUE(bm_texture_cache_load("cache_test", ".tga", CF_TYPE_EFFECTS, w, h, other.data(), other.size(), &bpp,
+	                                  [&](int* /*out_bpp*/) {
+		                                  ++decode_calls;
+		                                  return true;
+	                                  }));
+	ASSERT_EQ(2, decode_calls);
+
+	ASSERT_EQ(2, bm_texture_cache_purge());
+
+	// Failed decodes are not cached
+	bpp = 32;
+	ASSERT_FALSE(bm_texture_cache_load("cache_test", ".tga", CF_TYPE_EFFECTS, w, h, data.data(), data.size(), &bpp,
+	                                   [](int* /*out_bpp*/) { return false; }));
+	ASSERT_EQ(0, bm_texture_cache_purge());
+}
+
+TEST_F(TextureCacheTest, evicts_least_recently_used) {
+	const int w = 4;
+	const int h = 2;
+
+	int decode_calls = 0;
+	auto load = [&](int bytes_per_pixel) {
+		SCP_vector<ubyte> data(w * h * bytes_per_pixel, 0);
+		int bpp = 32;
+		return bm_texture_cache_load("cache_test", ".tga", CF_TYPE_EFFECTS, w, h, data.data(), data.size(), &bpp,
+		                             [&](int* out_bpp) {
+			                             ++decode_calls;
+			                             *out_bpp = bytes_per_pixel * 8;
+			                             return true;
+		                             });
+	};
+
+	// Two entries, the one which was written first is used again afterwards
+	ASSERT_TRUE(load(3));
+	ASSERT_TRUE(load(4));
+	ASSERT_EQ(2, decode_calls);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+	ASSERT_TRUE(load(3));
+	ASSERT_EQ(2, decode_calls);
+
+	// Only leave room for one entry, that has to be the one which was used last even though it is the older file
+	bm_texture_cache_set_budget(64);
+	bm_texture_cache_evict();
+
+	ASSERT_TRUE(load(3));
+	ASSERT_EQ(2, decode_calls);
+
+	ASSERT_TRUE(load(4));
+	ASSERT_EQ(3, decode_calls);
+}
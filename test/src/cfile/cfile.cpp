@@ -1,5 +1,6 @@
 
 #include <cfile/cfilesystem.h>
+#include <cmdline/cmdline.h>
 #include <graphics/font.h>
 #include <gtest/gtest.h>
 
@@ -152,3 +153,118 @@ TEST_F(CFileTest, test_get_path_type)
 	ASSERT_EQ(CF_TYPE_INTERFACE_MARKUP, cfile_get_path_type("data/interface/markup\\\\\\"));
 	ASSERT_EQ(CF_TYPE_INTERFACE_MARKUP, cfile_get_path_type("////data/interface/markup\\\\\\"));
 }
+
+TEST_F(CFileTest, find_file_location) {
+	cf_reset_lookup_stats();
+
+	// Lookups in the file list ignore the case of the name
+	auto location = cf_find_file_location("index_test.tbl", CF_TYPE_TABLES);
+	ASSERT_TRUE(location.found);
+	ASSERT_EQ((size_t)18, location.size);
+
+	ASSERT_FALSE(cf_find_file_location("index_test.tbl", CF_TYPE_MODELS).found);
+	ASSERT_FALSE(cf_find_file_location("missing.tbl", CF_TYPE_TABLES).found);
+
+	// Files which are only in memory are found as well
+	location = cf_find_file_location("controlconfigdefaults.tbl", CF_TYPE_ANY);
+	ASSERT_TRUE(location.found);
+	ASSERT_TRUE(location.data_ptr != nullptr);
+
+	const char *ext_list[] = { ".tbm", ".tbl" };
+	auto ext_location = cf_find_file_location_ext("INDEX_TEST", 2, ext_list, CF_TYPE_TABLES);
+	ASSERT_TRUE(ext_location.found);
+	ASSERT_EQ(1, ext_location.extension_index);
+
+	ASSERT_EQ((std::uint64_t)5, cf_get_lookup_stats().lookups);
+}
+
+class CFileMappedTest : public test::FSTestFixture {
+ public:
+	CFileMappedTest() : test::FSTestFixture(INIT_CFILE) {
+		pushModDir("cfile");
+		addCommandlineArg("-mmap_vps");
+	}
+
+ protected:
+	void TearDown() override {
+		test::FSTestFixture::TearDown();
+
+		Cmdline_mmap_vps = false;
+	}
+};
+
+static const char Mapped_table_text[] = "#Mapped Table\n\n#End\n";
+
+TEST_F(CFileMappedTest, read_mapped_vp) {
+	auto location = cf_find_file_location("mapped.tbl", CF_TYPE_TABLES);
+	ASSERT_TRUE(location.found);
+	ASSERT_TRUE(location.data_ptr != nullptr);
+	ASSERT_NE((size_t)0, location.offset);
+
+	auto fp = cfopen("mapped.tbl", "rb", CFILE_NORMAL, CF_TYPE_TABLES);
+	ASSERT_TRUE(fp != nullptr);
+
+	// The whole file can be accessed without reading it
+	size_t size;
+	auto data = reinterpret_cast<const char*>(cf_get_data_view(fp, &size));
+	ASSERT_TRUE(data != nullptr);
+	ASSERT_EQ(strlen(Mapped_table_text), size);
+	ASSERT_EQ(0, memcmp(Mapped_table_text, data, size));
+
+	// Views advance the read position like cfread()
+	char buffer[4];
+	ASSERT_EQ(1, cfread(buffer, sizeof(buffer), 1, fp));
+	ASSERT_EQ(0, memcmp(Mapped_table_text, buffer, sizeof(buffer)));
+
+	auto view = reinterpret_cast<const char*>(cfread_view(9, fp));
+	ASSERT_EQ(data + 4, view);
+	ASSERT_EQ(13, cftell(fp));
+
+	// Reading past the end fails without moving the read position
+	ASSERT_TRUE(cfread_view(size, fp) == nullptr);
+	ASSERT_EQ(13, cftell(fp));
+
+	// Checksums are computed straight from the mapping
+	uint chksum;
+	ASSERT_EQ(1, cf_chksum_long(fp, &chksum));
+	ASSERT_EQ(cf_add_chksum_long(0, reinterpret_cast<const ubyte*>(Mapped_table_text), size), chksum);
+
+	cfclose(fp);
+
+	// Memory mapped opens don't need to map the file again
+	fp = cfopen("mapped.tbl", "rb", CFILE_MEMORY_MAPPED, CF_TYPE_TABLES);
+	ASSERT_TRUE(fp != nullptr);
+	ASSERT_EQ(data, cf_returndata(fp));
+
+	cfclose(fp);
+}
+
+TEST_F(CFileMappedTest, refresh_mapped_vp) {
+	cfile_refresh();
+
+	// The pack file is mapped again after the refresh
+	auto location = cf_find_file_location("mapped.tbl", CF_TYPE_TABLES);
+	ASSERT_TRUE(location.found);
+	ASSERT_TRUE(location.data_ptr != nullptr);
+	ASSERT_EQ(0, memcmp(Mapped_table_text, location.data_ptr, strlen(Mapped_table_text)));
+}
+
+TEST_F(CFileTest, read_unmapped_vp) {
+	auto location = cf_find_file_location("mapped.tbl", CF_TYPE_TABLES);
+	ASSERT_TRUE(location.found);
+	ASSERT_TRUE(location.data_ptr == nullptr);
+
+	auto fp = cfopen("mapped.tbl", "rb", CFILE_NORMAL, CF_TYPE_TABLES);
+	ASSERT_TRUE(fp != nullptr);
+
+	size_t size;
+	ASSERT_TRUE(cf_get_data_view(fp, &size) == nullptr);
+	ASSERT_EQ((size_t)0, size);
+	ASSERT_TRUE(cfread_view(4, fp) == nullptr);
+
+	char buffer[sizeof(Mapped_table_text)] = {};
+	ASSERT_EQ(1, cfread(buffer, cfilelength(fp), 1, fp));
+	ASSERT_STREQ(Mapped_table_text, buffer);
+
+	cfclose(fp);
+}
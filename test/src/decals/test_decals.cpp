@@ -0,0 +1,19 @@
+
+#include <gtest/gtest.h>
+
+#include "decals/decals.h"
+
+TEST(Decals, culls_hosts_which_were_not_rendered)
+{
+	object host;
+	host.type = OBJ_SHIP;
+	host.flags.set(Object::Object_Flags::Renders);
+
+	// obj_render_queue_all() clears the flag for objects which are not drawn
+	host.flags.remove(Object::Object_Flags::Was_rendered);
+	ASSERT_FALSE(decals::isHostVisible(&host));
+
+	// and sets it for all objects which are drawn, including ships with a shader effect
+	host.flags.set(Object::Object_Flags::Was_rendered);
+	ASSERT_TRUE(decals::isHostVisible(&host));
+}
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+
+#include "cfile/cfile.h"
+#include "cmdline/cmdline.h"
+#include "math/vecmat.h"
+#include "model/model.h"
+#include "model/modelcache.h"
+
+#include "util/FSTestFixture.h"
+
+class ModelCacheTest : public test::FSTestFixture {
+ public:
+	ModelCacheTest() : test::FSTestFixture(INIT_CFILE) {
+		pushModDir("model");
+		addCommandlineArg("-model_cache");
+	}
+
+ protected:
+	void TearDown() override {
+		model_cache_purge();
+
+		FSTestFixture::TearDown();
+
+		Cmdline_model_cache = false;
+	}
+};
+
+namespace {
+const int BSP_DATA_SIZE = 64;
+
+// A model with two submodels, the first one has a collision tree and contains the octant vertices
+void init_test_model(polymodel* pm, ubyte* bsp_data) {
+	strcpy_s(pm->filename, "cache_test.pof");
+	pm->version = 2117;
+	pm->n_models = 2;
+	pm->n_detail_levels = 1;
+	pm->detail[0] = 0;
+
+	pm->submodel = new bsp_info[2];
+	pm->submodel[0].bsp_data = bsp_data;
+	pm->submodel[0].bsp_data_size = BSP_DATA_SIZE;
+	pm->submodel[0].collision_tree_index = model_create_bsp_collision_tree();
+}
+
+template <typename T>
+T* alloc_array(int count) {
+	auto array = (T*)vm_malloc(sizeof(T) * count);
+	memset(array, 0, sizeof(T) * count);
+	return array;
+}
+
+void fill_test_model(polymodel* pm) {
+	auto tree = model_get_bsp_collision_tree(pm->submodel[0].collision_tree_index);
+
+	tree->n_nodes = 1;
+	tree->node_list = alloc_array<bsp_collision_node>(1);
+	vm_vec_make(&tree->node_list[0].min, -1.0f, -2.0f, -3.0f);
+	vm_vec_make(&tree->node_list[0].max, 1.0f, 2.0f, 3.0f);
+	tree->node_list[0].back = -1;
+	tree->node_list[0].front = -1;
+	tree->node_list[0].n_tri_blocks = 1;
+
+	tree->n_tri_blocks = 1;
+	tree->tri_block_list = alloc_array<bsp_collision_tri_block>(1);
+	tree->tri_block_list[0].plane_norm[2][0] = 1.0f;
+	tree->tri_block_list[0].leaf[0] = 0;
+	tree->tri_block_list[0].leaf[1] = -1;
+
+	tree->n_leaves = 1;
+	tree->leaf_list = alloc_array<bsp_collision_leaf>(1);
+	vm_vec_make(&tree->leaf_list[0].plane_norm, 0.0f, 0.0f, 1.0f);
+	tree->leaf_list[0].face_rad = 2.5f;
+	tree->leaf_list[0].num_verts = 3;
+	tree->leaf_list[0].tmap_num = 1;
+	tree->leaf_list[0].next = -1;
+
+	tree->n_verts = 3;
+	tree->point_list = alloc_array<vec3d>(3);
+	tree->vert_list = alloc_array<model_tmap_vert>(3);
+	for (int i = 0; i < 3; ++i) {
+		vm_vec_make(&tree->point_list[i], (float)i, 0.0f, 0.0f);
+		tree->vert_list[i].vertnum = (ushort)i;
+		tree->vert_list[i].u = 0.5f * i;
+	}
+
+	// The second submodel only has vertex data
+	auto model_list = new poly_list;
+	model_list->allocate(3);
+	for (int i = 0; i < 3; ++i) {
+		memset(&model_list->vert[i], 0, sizeof(vertex));
+		vm_vec_make(&model_list->vert[i].world, (float)i, 1.0f, 2.0f);
+		model_list->vert[i].texture_position.u = 0.25f * i;
+		vm_vec_make(&model_list->norm[i], 0.0f, 1.0f, 0.0f);
+		if (model_list->tsb != nullptr) {
+			memset(&model_list->tsb[i], 0, sizeof(tsb_t));
+		}
+		model_list->submodels[i] = 1;
+	}
+	model_list->n_verts = 3;
+	pm->submodel[1].buffer.model_list = model_list;
+	pm->submodel[1].buffer.flags = VB_FLAG_POSITION | VB_FLAG_NORMAL;
+
+	buffer_data indices(3);
+	for (int i = 0; i < 3; ++i) {
+		indices.assign((size_t)i, (uint)(2 - i));
+	}
+	indices.texture = 2;
+	pm->submodel[1].buffer.tex_buf.push_back(indices);
+
+	vm_vec_make(&pm->octants[3].min, 0.0f, 0.0f, 0.0f);
+	vm_vec_make(&pm->octants[3].max, 4.0f, 4.0f, 4.0f);
+	pm->octants[3].nverts = 2;
+	pm->octants[3].verts = alloc_array<vec3d*>(2);
+	pm->octants[3].verts[0] = reinterpret_cast<vec3d*>(pm->submodel[0].bsp_data + 20);
+	pm->octants[3].verts[1] = reinterpret_cast<vec3d*>(pm->submodel[0].bsp_data + 44);
+}
+
+void free_test_model(polymodel* pm) {
+	model_remove_bsp_collision_tree(pm->submodel[0].collision_tree_index);
+
+	for (auto& oct : pm->octants) {
+		vm_free(oct.verts);
+		vm_free(oct.shield_tris);
+	}
+
+	delete[] pm->submodel;
+}
+}
+
+TEST_F(ModelCacheTest, model_cache) {
+	ASSERT_TRUE(model_cache_enabled());
+
+	ubyte bsp_data[BSP_DATA_SIZE];
+	for (int i = 0; i < BSP_DATA_SIZE; ++i) {
+		bsp_data[i] = (ubyte)i;
+	}
+
+	// The loading model has its own copy of the BSP data like a second load of the same file
+	ubyte loaded_bsp_data[BSP_DATA_SIZE];
+	memcpy(loaded_bsp_data, bsp_data, sizeof(bsp_data));
+
+	polymodel original;
+	init_test_model(&original, bsp_data);
+	fill_test_model(&original);
+
+	// Nothing was cached yet
+	SCP_string key;
+	polymodel loaded;
+	init_test_model(&loaded, loaded_bsp_data);
+	ASSERT_FALSE(model_cache_load(&loaded, key));
+	ASSERT_FALSE(key.empty());
+
+	model_cache_save(&original, key);
+
+	SCP_string loaded_key;
+	ASSERT_TRUE(model_cache_load(&loaded, loaded_key));
+	ASSERT_EQ(key, loaded_key);
+
+	auto tree = model_get_bsp_collision_tree(original.submodel[0].collision_tree_index);
+	auto loaded_tree = model_get_bsp_collision_tree(loaded.submodel[0].collision_tree_index);
+
+	ASSERT_NE(tree, loaded_tree);
+	ASSERT_EQ(tree->n_nodes, loaded_tree->n_nodes);
+	ASSERT_EQ(0, memcmp(tree->node_list, loaded_tree->node_list, sizeof(bsp_collision_node)));
+	ASSERT_EQ(tree->n_tri_blocks, loaded_tree->n_tri_blocks);
+	ASSERT_EQ(0, memcmp(tree->tri_block_list, loaded_tree->tri_block_list, sizeof(bsp_collision_tri_block)));
+	ASSERT_EQ(tree->n_leaves, loaded_tree->n_leaves);
+	ASSERT_EQ(tree->leaf_list[0].face_rad, loaded_tree->leaf_list[0].face_rad);
+	ASSERT_EQ(tree->leaf_list[0].num_verts, loaded_tree->leaf_list[0].num_verts);
+	ASSERT_EQ(tree->leaf_list[0].next, loaded_tree->leaf_list[0].next);
+	ASSERT_EQ(tree->n_verts, loaded_tree->n_verts);
+	ASSERT_EQ(0, memcmp(tree->point_list, loaded_tree->point_list, sizeof(vec3d) * 3));
+	ASSERT_EQ(0, memcmp(tree->vert_list, loaded_tree->vert_list, sizeof(model_tmap_vert) * 3));
+
+	// The octant vertices have to point into the BSP data of the loading model at the same offsets
+	ASSERT_EQ(2, loaded.octants[3].nverts);
+	for (int i = 0; i < 2; ++i) {
+		auto offset = reinterpret_cast<const ubyte*>(original.octants[3].verts[i]) - bsp_data;
+		ASSERT_EQ(reinterpret_cast<vec3d*>(loaded_bsp_data + offset), loaded.octants[3].verts[i]);
+		ASSERT_EQ(0, memcmp(original.octants[3].verts[i], loaded.octants[3].verts[i], sizeof(vec3d)));
+	}
+	ASSERT_EQ(0, loaded.octants[0].nverts);
+	ASSERT_EQ(nullptr, loaded.octants[0].verts);
+
+	// The vertex data is a copy of the one of the original
+	auto model_list = original.submodel[1].buffer.model_list;
+	auto loaded_list = loaded.submodel[1].buffer.model_list;
+	ASSERT_EQ(nullptr, loaded.submodel[0].buffer.model_list);
+	ASSERT_NE(nullptr, loaded_list);
+	ASSERT_NE(model_list, loaded_list);
+	ASSERT_EQ(3, loaded_list->n_verts);
+	for (int i = 0; i < 3; ++i) {
+		ASSERT_EQ(0, memcmp(&model_list->vert[i].world, &loaded_list->vert[i].world, sizeof(vec3d)));
+		ASSERT_EQ(model_list->vert[i].texture_position.u, loaded_list->vert[i].texture_position.u);
+		ASSERT_EQ(0, memcmp(&model_list->norm[i], &loaded_list->norm[i], sizeof(vec3d)));
+		ASSERT_EQ(1, loaded_list->submodels[i]);
+	}
+	ASSERT_EQ(original.submodel[1].buffer.flags, loaded.submodel[1].buffer.flags);
+	ASSERT_EQ(1u, loaded.submodel[1].buffer.tex_buf.size());
+
+	auto& indices = original.submodel[1].buffer.tex_buf[0];
+	auto& loaded_indices = loaded.submodel[1].buffer.tex_buf[0];
+	ASSERT_EQ(indices.texture, loaded_indices.texture);
+	ASSERT_EQ(indices.n_verts, loaded_indices.n_verts);
+	ASSERT_EQ(indices.i_first, loaded_indices.i_first);
+	ASSERT_EQ(indices.i_last, loaded_indices.i_last);
+	ASSERT_NE(indices.get_index(), loaded_indices.get_index());
+	ASSERT_EQ(0, memcmp(indices.get_index(), loaded_indices.get_index(), sizeof(uint) * 3));
+
+	// A model which does not match the entry has to be computed
+	polymodel other;
+	init_test_model(&other, bsp_data);
+	other.submodel[0].bsp_data_size = BSP_DATA_SIZE - 4;
+	ASSERT_FALSE(model_cache_load(&other, key));
+
+	// Old models change their BSP data while the octants are created and are never cached
+	other.submodel[0].bsp_data_size = BSP_DATA_SIZE;
+	other.version = 2000;
+	ASSERT_FALSE(model_cache_load(&other, key));
+	ASSERT_TRUE(key.empty());
+
+	free_test_model(&other);
+	free_test_model(&loaded);
+	free_test_model(&original);
+}
+
+// Loads a complete POF file so the cached data is compared with what model_load() computes itself
+class ModelCacheLoadTest : public test::FSTestFixture {
+ public:
+	ModelCacheLoadTest() : test::FSTestFixture(INIT_CFILE | INIT_GRAPHICS) {
+		pushModDir("model");
+		addCommandlineArg("-model_cache");
+	}
+
+ protected:
+	void TearDown() override {
+		model_free_all();
+		model_cache_set_validating(false);
+		model_cache_purge();
+
+		FSTestFixture::TearDown();
+
+		Cmdline_model_cache = false;
+	}
+};
+
+// cache_cube.pof has a cube as detail0 which is split in two halves by a sortnorm and a smaller cube as its child
+TEST_F(ModelCacheLoadTest, cached_model_matches_fresh_load) {
+	ASSERT_TRUE(model_cache_enabled());
+
+	auto before = model_cache_get_stats();
+
+	// The first load computes everything and fills the cache
+	int fresh_num = model_load("cache_cube.pof", 0, nullptr, 1);
+	ASSERT_GE(fresh_num, 0);
+
+	auto stats = model_cache_get_stats();
+	ASSERT_EQ(before.misses + 1, stats.misses);
+	ASSERT_EQ(before.hits, stats.hits);
+
+	// A duplicate reads its own BSP data from the file and takes everything derived from it from the cache
+	int cached_num = model_load("cache_cube.pof", 0, nullptr, 1, 1);
+	ASSERT_GE(cached_num, 0);
+	ASSERT_NE(fresh_num, cached_num);
+
+	stats = model_cache_get_stats();
+	ASSERT_EQ(before.misses + 1, stats.misses);
+	ASSERT_EQ(before.hits + 1, stats.hits);
+
+	auto fresh = model_get(fresh_num);
+	auto cached = model_get(cached_num);
+	ASSERT_EQ(2, fresh->n_models);
+	ASSERT_EQ(fresh->n_models, cached->n_models);
+
+	for (int i = 0; i < fresh->n_models; ++i) {
+		auto& fresh_sm = fresh->submodel[i];
+		auto& cached_sm = cached->submodel[i];
+
+		ASSERT_NE(fresh_sm.bsp_data, cached_sm.bsp_data);
+		ASSERT_EQ(fresh_sm.bsp_data_size, cached_sm.bsp_data_size);
+
+		auto fresh_tree = model_get_bsp_collision_tree(fresh_sm.collision_tree_index);
+		auto cached_tree = model_get_bsp_collision_tree(cached_sm.collision_tree_index);
+		ASSERT_NE(fresh_tree, cached_tree);
+
+		ASSERT_EQ(i == 0 ? 3 : 1, fresh_tree->n_nodes);
+		ASSERT_EQ(fresh_tree->n_nodes, cached_tree->n_nodes);
+		ASSERT_EQ(0, memcmp(fresh_tree->node_list, cached_tree->node_list,
+		                    sizeof(bsp_collision_node) * fresh_tree->n_nodes));
+
+		ASSERT_EQ(6, fresh_tree->n_leaves);
+		ASSERT_EQ(fresh_tree->n_leaves, cached_tree->n_leaves);
+		for (int j = 0; j < fresh_tree->n_leaves; ++j) {
+			auto& fresh_leaf = fresh_tree->leaf_list[j];
+			auto& cached_leaf = cached_tree->leaf_list[j];
+
+			ASSERT_EQ(0, memcmp(&fresh_leaf.plane_pnt, &cached_leaf.plane_pnt, sizeof(vec3d)));
+			ASSERT_EQ(0, memcmp(&fresh_leaf.plane_norm, &cached_leaf.plane_norm, sizeof(vec3d)));
+			ASSERT_EQ(fresh_leaf.face_rad, cached_leaf.face_rad);
+			ASSERT_EQ(fresh_leaf.vert_start, cached_leaf.vert_start);
+			ASSERT_EQ(fresh_leaf.num_verts, cached_leaf.num_verts);
+			ASSERT_EQ(fresh_leaf.tmap_num, cached_leaf.tmap_num);
+			ASSERT_EQ(fresh_leaf.next, cached_leaf.next);
+		}
+
+		ASSERT_EQ(8, fresh_tree->n_verts);
+		ASSERT_EQ(fresh_tree->n_verts, cached_tree->n_verts);
+		ASSERT_EQ(0, memcmp(fresh_tree->point_list, cached_tree->point_list, sizeof(vec3d) * fresh_tree->n_verts));
+		ASSERT_EQ(0, memcmp(fresh_tree->vert_list, cached_tree->vert_list, sizeof(model_tmap_vert) * 24));
+
+		ASSERT_EQ(fresh_tree->n_tri_blocks, cached_tree->n_tri_blocks);
+		ASSERT_EQ(0, memcmp(fresh_tree->tri_block_list, cached_tree->tri_block_list,
+		                    sizeof(bsp_collision_tri_block) * fresh_tree->n_tri_blocks));
+	}
+
+	// The octants refer to the face centers in the BSP data of the model they belong to
+	auto fresh_bsp = fresh->submodel[fresh->detail[0]].bsp_data;
+	auto cached_bsp = cached->submodel[cached->detail[0]].bsp_data;
+	int total_verts = 0;
+	for (int i = 0; i < 8; ++i) {
+		auto& fresh_oct = fresh->octants[i];
+		auto& cached_oct = cached->octants[i];
+
+		ASSERT_EQ(0, memcmp(&fresh_oct.min, &cached_oct.min, sizeof(vec3d)));
+		ASSERT_EQ(0, memcmp(&fresh_oct.max, &cached_oct.max, sizeof(vec3d)));
+		ASSERT_EQ(fresh_oct.nverts, cached_oct.nverts);
+		ASSERT_EQ(fresh_oct.nshield_tris, cached_oct.nshield_tris);
+
+		for (int j = 0; j < fresh_oct.nverts; ++j) {
+			auto offset = reinterpret_cast<const ubyte*>(fresh_oct.verts[j]) - fresh_bsp;
+			ASSERT_EQ(reinterpret_cast<vec3d*>(cached_bsp + offset), cached_oct.verts[j]);
+		}
+
+		total_verts += fresh_oct.nverts;
+	}
+	ASSERT_GT(total_verts, 0);
+
+	// The vertex data is packed into the model buffers and released during the load, in validation mode the cached
+	// vertex data is compared with freshly generated data before that happens
+	model_cache_set_validating(true);
+
+	int validated_num = model_load("cache_cube.pof", 0, nullptr, 1, 1);
+	ASSERT_GE(validated_num, 0);
+
+	stats = model_cache_get_stats();
+	ASSERT_EQ(before.hits + 2, stats.hits);
+	ASSERT_EQ(before.mismatches, stats.mismatches);
+}
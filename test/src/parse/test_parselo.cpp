@@ -62,6 +62,114 @@ TEST_F(ParseloTest, utf8_with_bom) {
 	ASSERT_STREQ(content.c_str(), "Hello World");
 }
 
+TEST_F(ParseloTest, preload_files) {
+	read_file_text("test.tbl", CF_TYPE_TABLES);
+	SCP_string text = Parse_text;
+	SCP_string text_raw = Parse_text_raw;
+
+	parse_preload_files({"test.tbl", "missing.tbl"}, CF_TYPE_TABLES);
+
+	// The preloaded text must be exactly what reading the file produces
+	read_file_text("test.tbl", CF_TYPE_TABLES);
+	ASSERT_EQ(text, Parse_text);
+	ASSERT_EQ(text_raw, Parse_text_raw);
+
+	reset_parse();
+	required_string("#Start");
+
+	// Files which could not be preloaded are handled as usual
+	ASSERT_THROW(read_file_text("missing.tbl", CF_TYPE_TABLES), parse::ParseException);
+
+	parse_free_preloaded_files();
+
+	read_file_text("test.tbl", CF_TYPE_TABLES);
+	ASSERT_EQ(text, Parse_text);
+}
+
+TEST_F(ParseloTest, fast_scan) {
+	read_raw_file_text("fast_scan.tbl", CF_TYPE_TABLES);
+	SCP_string raw = Parse_text_raw;
+
+	struct scan_result {
+		SCP_string processed;
+		SCP_vector<ptrdiff_t> names;
+		SCP_vector<ptrdiff_t> skips;
+	};
+
+	auto scan = [&raw](bool fast) {
+		parse_set_fast_scan(fast);
+
+		SCP_vector<char> raw_text(raw.begin(), raw.end());
+		raw_text.push_back('\0');
+		SCP_vector<char> processed_text(raw.size() * 2 + 2, '\0');
+
+		process_raw_file_text(processed_text.data(), raw_text.data());
+
+		scan_result result;
+		result.processed = processed_text.data();
+
+		reset_parse(processed_text.data());
+		while (skip_to_string("$Name:") == 1) {
+			result.names.push_back(Mp - processed_text.data());
+		}
+
+		reset_parse(processed_text.data());
+		required_string("#Start");
+		result.skips.push_back(skip_to_start_of_string("$Value:", "#End"));
+		result.skips.push_back(Mp - processed_text.data());
+		result.skips.push_back(skip_to_string("$Nothing:", "$Name:"));
+		result.skips.push_back(Mp - processed_text.data());
+		result.skips.push_back(skip_to_start_of_string_either("$Nothing:", "$Also nothing:"));
+		result.skips.push_back(Mp - processed_text.data());
+
+		reset_parse();
+		return result;
+	};
+
+	auto scalar = scan(false);
+	auto fast = scan(true);
+
+	parse_set_fast_scan(true);
+
+	ASSERT_EQ(scalar.processed, fast.processed);
+	ASSERT_EQ(scalar.names, fast.names);
+	ASSERT_EQ(scalar.skips, fast.skips);
+
+	// Comments must be gone, quoted text and version tags of this version must stay
+	ASSERT_EQ(5u, fast.names.size());
+	ASSERT_EQ(1, fast.skips[0]);
+	ASSERT_EQ(-1, fast.skips[2]);
+	ASSERT_EQ(0, fast.skips[4]);
+	ASSERT_EQ(SCP_string::npos, fast.processed.find("Hidden"));
+	ASSERT_EQ(SCP_string::npos, fast.processed.find("Too new"));
+	ASSERT_NE(SCP_string::npos, fast.processed.find("with a semicolon /* and something"));
+	ASSERT_NE(SCP_string::npos, fast.processed.find("Versioned"));
+}
+
+TEST_F(ParseloTest, fast_scan_stale_index) {
+	parse_set_fast_scan(true);
+
+	char raw_text[] = "$Name: First line\n$Name: Second line\n";
+	char processed_text[sizeof(raw_text) * 2] = {};
+	process_raw_file_text(processed_text, raw_text);
+
+	// The text is cut short after it was indexed, the scan must not run past its end
+	processed_text[5] = '\0';
+
+	reset_parse(processed_text);
+	Mp = processed_text + 1;
+	advance_to_eoln(nullptr);
+	ASSERT_EQ(processed_text + 5, Mp);
+
+	// Parsing another text must not use the index of the old one
+	char other_text[] = "$Other\0\nhidden\n";
+	reset_parse(other_text);
+	advance_to_eoln(nullptr);
+	ASSERT_EQ(other_text + 6, Mp);
+
+	reset_parse();
+}
+
 TEST(ParseloUtilTest, drop_trailing_whitespace_cstr) {
 	char test_str[256];
 
@@ -0,0 +1,115 @@
+
+#include <gtest/gtest.h>
+
+#include <parse/parselo.h>
+#include <parse/sexp.h>
+
+#include "util/FSTestFixture.h"
+
+class SexpCompileTest : public test::FSTestFixture {
+ public:
+	SexpCompileTest() : test::FSTestFixture(INIT_NONE) {
+	}
+
+ protected:
+	void SetUp() override {
+		test::FSTestFixture::SetUp();
+
+		init_sexp();
+	}
+	void TearDown() override {
+		sexp_shutdown();
+
+		test::FSTestFixture::TearDown();
+	}
+
+	// Evaluates the formula a few times like an event would be and returns the results
+	SCP_vector<int> evaluate(const char* formula, bool compile) {
+		char buf[1024];
+		strcpy_s(buf, formula);
+
+		auto old_mp = Mp;
+		Mp = buf;
+		int node = get_sexp_main();
+		Mp = old_mp;
+
+		SCP_vector<int> results;
+		if (node < 0) {
+			ADD_FAILURE() << "Failed to parse " << formula;
+			return results;
+		}
+
+		if (compile) {
+			sexp_compile(node);
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			results.push_back(eval_sexp(node));
+			results.push_back(Sexp_nodes[node].value);
+		}
+
+		free_sexp2(node);
+
+		return results;
+	}
+};
+
+TEST_F(SexpCompileTest, same_results_as_interpreter) {
+	const char* formulas[] = {
+		"( + 1 2 3 )",
+		"( - 10 ( * 2 3 ) )",
+		"( / 7 2 )",
+		"( mod -7 3 )",
+		"( abs ( - 2 9 ) )",
+		"( max 4 ( min 9 2 ) 7 )",
+		"( avg 1 2 3 4 )",
+		"( pow 2 10 )",
+		"( signum -5 )",
+		"( bitwise-and 12 ( bitwise-or 2 8 ) )",
+		"( bitwise-xor 5 ( bitwise-not 1 ) )",
+		"( set-bit 0 3 )",
+		"( is-bit-set ( unset-bit 15 1 ) 1 )",
+		"( < 1 ( + 1 1 ) )",
+		"( > ( * 3 3 ) 10 )",
+		"( = ( - 5 ( abs -5 ) ) 0 )",
+		"( and ( true ) ( < ( / 9 3 ) 4 ) )",
+		"( or ( false ) ( = ( mod 9 4 ) 2 ) )",
+		"( not ( > ( max 1 2 ) 3 ) )",
+	};
+
+	for (auto formula : formulas) {
+		SCOPED_TRACE(formula);
+
+		auto interpreted = evaluate(formula, false);
+		auto compiled = evaluate(formula, true);
+
+		ASSERT_EQ(interpreted, compiled);
+	}
+}
+
+TEST_F(SexpCompileTest, constant_folding) {
+	char buf[] = "( < ( + 1 2 ) ( * 2 2 ) )";
+
+	auto old_mp = Mp;
+	Mp = buf;
+	int node = get_sexp_main();
+	Mp = old_mp;
+
+	ASSERT_GE(node, 0);
+
+	sexp_compile(node);
+
+	// the arguments of the comparison are constant...
+	int plus = CAR(CDR(node));
+	int mul = CAR(CDR(CDR(node)));
+	ASSERT_TRUE(Sexp_nodes[plus].flags & SNF_CONSTANT);
+	ASSERT_EQ(3, Sexp_nodes[plus].cached_number);
+	ASSERT_TRUE(Sexp_nodes[mul].flags & SNF_CONSTANT);
+	ASSERT_EQ(4, Sexp_nodes[mul].cached_number);
+
+	// ...but comparisons are not folded
+	ASSERT_FALSE(Sexp_nodes[node].flags & SNF_CONSTANT);
+	ASSERT_EQ(SEXP_TRUE, eval_sexp(node));
+
+	free_sexp2(node);
+}
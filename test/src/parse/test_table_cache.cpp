@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "cfile/cfile.h"
+#include "cmdline/cmdline.h"
+#include "parse/parselo.h"
+#include "parse/table_cache.h"
+
+#include "util/FSTestFixture.h"
+
+class TableCacheTest : public test::FSTestFixture {
+ public:
+	TableCacheTest() : test::FSTestFixture(INIT_CFILE) {
+		pushModDir("parse");
+		addCommandlineArg("-table_cache");
+	}
+
+ protected:
+	void TearDown() override {
+		cf_delete("tbl_cache-cache_test.bin", CF_TYPE_CACHE,
+		          CF_LOCATION_ROOT_USER | CF_LOCATION_ROOT_GAME | CF_LOCATION_TYPE_ROOT);
+
+		FSTestFixture::TearDown();
+
+		Cmdline_table_cache = false;
+	}
+};
+
+namespace {
+int Test_value_sum = 0;
+
+void parse_test_table(const char* filename) {
+	read_file_text(filename, CF_TYPE_TABLES);
+	reset_parse();
+
+	required_string("#Start");
+	required_string("$Value:");
+
+	int value;
+	stuff_int(&value);
+	Test_value_sum += value;
+
+	required_string("#End");
+}
+}
+
+TEST_F(TableCacheTest, table_cache) {
+	ASSERT_TRUE(table_cache_enabled());
+
+	int parse_calls = 0;
+	int finish_calls = 0;
+	SCP_vector<SCP_string> loaded_files;
+
+	table_cache_info info;
+	info.name = "cache_test";
+	info.version = 1;
+	info.table = "cache_test.tbl";
+	info.default_table = nullptr;
+	info.tbm_filter = "*-ctt.tbm";
+	info.parse = [&]() {
+		++parse_calls;
+		Test_value_sum = 0;
+		parse_test_table("cache_test.tbl");
+		parse_modular_table("*-ctt.tbm", parse_test_table);
+	};
+	info.save = [](table_cache_writer& writer) { writer.write(Test_value_sum); };
+	info.load = [](table_cache_reader& reader) { return reader.read(Test_value_sum); };
+	info.loaded_file = [&](const char* filename) { loaded_files.push_back(filename); };
+	info.finish = [&]() { ++finish_calls; };
+
+	// The first run parses the tables and writes the cache entry
+	table_cache_parse(info);
+	ASSERT_EQ(1, parse_calls);
+	ASSERT_EQ(1, finish_calls);
+	ASSERT_EQ(12, Test_value_sum);
+	ASSERT_TRUE(loaded_files.empty());
+
+	// The second one must load the value from the cache, the data still has to be fixed up
+	Test_value_sum = 0;
+	table_cache_parse(info);
+	ASSERT_EQ(1, parse_calls);
+	ASSERT_EQ(2, finish_calls);
+	ASSERT_EQ(12, Test_value_sum);
+	ASSERT_EQ(2u, loaded_files.size());
+
+	// A new version invalidates the entry
+	info.version = 2;
+	Test_value_sum = 0;
+	table_cache_parse(info);
+	ASSERT_EQ(2, parse_calls);
+	ASSERT_EQ(12, Test_value_sum);
+
+	// Data which does not match the blob is parsed again
+	info.load = [](table_cache_reader& reader) {
+		int value = 0;
+		long long extra = 0;
+		return reader.read(value) && reader.read(extra);
+	};
+	table_cache_parse(info);
+	ASSERT_EQ(3, parse_calls);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include "math/vecmat.h"
+#include "particle/particle.h"
+
+extern bool Cmdline_mt_particles;
+
+namespace {
+
+particle::particle_info make_info(int index, float lifetime)
+{
+	particle::particle_info info;
+
+	vm_vec_make(&info.pos, index * 10.0f, index * -2.0f, 1.0f);
+	vm_vec_make(&info.vel, 1.0f + index, index * 0.5f, -3.0f);
+	info.lifetime = lifetime;
+	info.rad = 1.0f;
+	info.type = particle::PARTICLE_DEBUG;
+
+	return info;
+}
+
+class ParticleStoreTest : public ::testing::Test {
+ protected:
+	void SetUp() override { particle::kill_all(); }
+
+	void TearDown() override
+	{
+		particle::kill_all();
+		Cmdline_mt_particles = false;
+	}
+};
+
+}
+
+TEST_F(ParticleStoreTest, default_handle_is_invalid)
+{
+	particle::ParticleHandle handle;
+
+	ASSERT_FALSE(handle.isValid());
+}
+
+TEST_F(ParticleStoreTest, first_frame_only_moves)
+{
+	auto info = make_info(1, 1.0f);
+	auto handle = particle::createPersistent(&info);
+	ASSERT_TRUE(handle.isValid());
+
+	particle::move_all(0.5f);
+
+	ASSERT_TRUE(handle.isValid());
+	ASSERT_FLOAT_EQ(0.00001f, handle.age());
+	ASSERT_FLOAT_EQ(11.0f, handle.pos().xyz.x);
+	ASSERT_FLOAT_EQ(-1.75f, handle.pos().xyz.y);
+	ASSERT_FLOAT_EQ(-0.5f, handle.pos().xyz.z);
+
+	particle::move_all(0.5f);
+
+	ASSERT_FLOAT_EQ(0.50001f, handle.age());
+}
+
+TEST_F(ParticleStoreTest, expired_particles_invalidate_handles)
+{
+	SCP_vector<particle::ParticleHandle> handles;
+	for (int i = 0; i < 10; ++i) {
+		auto info = make_info(i, (i % 2 == 0) ? 0.5f : 10.0f);
+		handles.push_back(particle::createPersistent(&info));
+
+		// Non-persistent particles are stored next to the persistent ones
+		info = make_info(i, 0.5f);
+		particle::create(&info);
+	}
+	ASSERT_EQ((size_t) 20, particle::get_particle_count());
+
+	particle::move_all(0.1f);
+	particle::move_all(1.0f);
+
+	ASSERT_EQ((size_t) 5, particle::get_particle_count());
+
+	for (int i = 0; i < 10; ++i) {
+		if (i % 2 == 0) {
+			ASSERT_FALSE(handles[i].isValid());
+			continue;
+		}
+
+		// The remaining particles have been moved around by the compaction so check that the handle still finds its own
+		ASSERT_TRUE(handles[i].isValid());
+		ASSERT_FLOAT_EQ(10.0f, handles[i].max_life());
+		ASSERT_NEAR(i * 10.0f + 1.1f * (1.0f + i), handles[i].pos().xyz.x, 0.001f);
+	}
+}
+
+TEST_F(ParticleStoreTest, reused_slot_does_not_revive_handle)
+{
+	auto info = make_info(0, 0.1f);
+	auto old_handle = particle::createPersistent(&info);
+
+	particle::move_all(0.1f);
+	particle::move_all(0.1f);
+	ASSERT_FALSE(old_handle.isValid());
+
+	info = make_info(1, 1.0f);
+	auto new_handle = particle::createPersistent(&info);
+
+	ASSERT_TRUE(new_handle.isValid());
+	ASSERT_FALSE(old_handle.isValid());
+	ASSERT_NE(old_handle, new_handle);
+}
+
+TEST_F(ParticleStoreTest, looping_particles_do_not_expire)
+{
+	auto info = make_info(0, 0.1f);
+	auto handle = particle::createPersistent(&info);
+	handle.setLooping(true);
+
+	particle::move_all(0.1f);
+	particle::move_all(1.0f);
+	ASSERT_TRUE(handle.isValid());
+
+	handle.setLooping(false);
+	particle::move_all(0.1f);
+	ASSERT_FALSE(handle.isValid());
+}
+
+TEST_F(ParticleStoreTest, kill_all_invalidates_handles)
+{
+	auto info = make_info(0, 1.0f);
+	auto handle = particle::createPersistent(&info);
+
+	particle::kill_all();
+
+	ASSERT_FALSE(handle.isValid());
+	ASSERT_EQ((size_t) 0, particle::get_particle_count());
+}
+
+TEST_F(ParticleStoreTest, multi_threaded_update_matches)
+{
+	// Enough particles for several chunks and a count which is not a multiple of the vector width
+	const int count = 10003;
+
+	Cmdline_mt_particles = true;
+
+	SCP_vector<particle::ParticleHandle> handles;
+	for (int i = 0; i < count; ++i) {
+		auto info = make_info(i, (i % 3 == 0) ? 0.5f : 10.0f);
+		handles.push_back(particle::createPersistent(&info));
+	}
+
+	particle::move_all(0.25f);
+	particle::move_all(0.5f);
+
+	for (int i = 0; i < count; ++i) {
+		if (i % 3 == 0) {
+			ASSERT_FALSE(handles[i].isValid());
+			continue;
+		}
+
+		ASSERT_TRUE(handles[i].isValid());
+		ASSERT_FLOAT_EQ(0.50001f, handles[i].age());
+		ASSERT_NEAR(i * -2.0f + 0.75f * (i * 0.5f), handles[i].pos().xyz.y, 0.01f);
+		ASSERT_FLOAT_EQ(1.0f - 0.75f * 3.0f, handles[i].pos().xyz.z);
+	}
+}
+
+TEST_F(ParticleStoreTest, buffered_particles_are_created_later)
+{
+	SCP_vector<particle::particle_info> buffer;
+
+	particle::set_create_buffer(&buffer);
+	for (int i = 0; i < 3; ++i) {
+		auto info = make_info(i, 1.0f);
+		particle::create(&info);
+	}
+	particle::set_create_buffer(nullptr);
+
+	ASSERT_EQ((size_t) 3, buffer.size());
+	ASSERT_EQ((size_t) 0, particle::get_particle_count());
+
+	particle::create_buffered(buffer);
+
+	ASSERT_EQ((size_t) 3, particle::get_particle_count());
+}
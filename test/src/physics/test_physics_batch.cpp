@@ -0,0 +1,181 @@
+
+#include <gtest/gtest.h>
+
+#include "physics/physics_batch.h"
+
+namespace {
+
+struct physics_state {
+	vec3d pos;
+	matrix orient;
+	physics_info pi;
+};
+
+physics_state make_state(int index)
+{
+	physics_state state;
+
+	physics_init(&state.pi);
+
+	vm_vec_make(&state.pos, index * 100.0f, index * -30.0f, index * 7.5f);
+
+	angles a;
+	a.p = index * 0.3f;
+	a.b = index * -0.7f;
+	a.h = index * 1.1f;
+	vm_angles_2_matrix(&state.orient, &a);
+
+	state.pi.side_slip_time_const = (index % 3) * 0.5f;
+	state.pi.rotdamp = 0.1f + (index % 5) * 0.1f;
+	state.pi.use_newtonian_damp = (index % 2) == 0;
+	if (index % 7 == 0) {
+		state.pi.flags |= PF_DEAD_DAMP;
+	}
+
+	vm_vec_make(&state.pi.vel, index * 3.0f, 10.0f - index, 50.0f);
+	vm_vec_make(&state.pi.desired_vel, -20.0f, index * 1.5f, 75.0f);
+	vm_vec_make(&state.pi.rotvel, 0.2f, -0.1f * index, 0.05f);
+	vm_vec_make(&state.pi.desired_rotvel, -0.3f, 0.4f, 0.01f * index);
+
+	return state;
+}
+
+void expect_vec_eq(const vec3d& expected, const vec3d& actual)
+{
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_FLOAT_EQ(expected.a1d[i], actual.a1d[i]);
+	}
+}
+
+void expect_matrix_eq(const matrix& expected, const matrix& actual)
+{
+	for (int i = 0; i < 9; ++i) {
+		EXPECT_FLOAT_EQ(expected.a1d[i], actual.a1d[i]);
+	}
+}
+
+}
+
+TEST(PhysicsBatch, supported)
+{
+	physics_info pi;
+	physics_init(&pi);
+
+	ASSERT_TRUE(physics_batch_supported(&pi));
+
+	pi.flags = PF_CONST_VEL;
+	ASSERT_FALSE(physics_batch_supported(&pi));
+
+	pi.flags = PF_IN_SHOCKWAVE;
+	ASSERT_FALSE(physics_batch_supported(&pi));
+
+	pi.flags = PF_SPECIAL_WARP_IN;
+	ASSERT_FALSE(physics_batch_supported(&pi));
+
+	pi.flags = PF_SPECIAL_WARP_OUT;
+	ASSERT_FALSE(physics_batch_supported(&pi));
+}
+
+TEST(PhysicsBatch, matches_physics_sim)
+{
+	const int num_objects = 50;
+	const float sim_time = 1.0f / 60.0f;
+
+	SCP_vector<physics_state> scalar;
+	for (int i = 0; i < num_objects; ++i) {
+		scalar.push_back(make_state(i));
+	}
+	auto batched = scalar;
+
+	physics_batch batch;
+
+	for (int step = 0; step < 10; ++step) {
+		physics_batch_clear(&batch);
+
+		for (auto& state : scalar) {
+			physics_sim(&state.pos, &state.orient, &state.pi, sim_time);
+		}
+		for (auto& state : batched) {
+			physics_batch_add(&batch, &state.pos, &state.orient, &state.pi);
+		}
+		physics_batch_sim(&batch, sim_time);
+	}
+
+	for (int i = 0; i < num_objects; ++i) {
+		SCOPED_TRACE(i);
+
+		expect_vec_eq(scalar[i].pos, batched[i].pos);
+		expect_vec_eq(scalar[i].pi.vel, batched[i].pi.vel);
+		expect_vec_eq(scalar[i].pi.rotvel, batched[i].pi.rotvel);
+		expect_matrix_eq(scalar[i].orient, batched[i].orient);
+		expect_matrix_eq(scalar[i].pi.last_rotmat, batched[i].pi.last_rotmat);
+
+		EXPECT_FLOAT_EQ(scalar[i].pi.speed, batched[i].pi.speed);
+		EXPECT_FLOAT_EQ(scalar[i].pi.fspeed, batched[i].pi.fspeed);
+	}
+}
+
+TEST(PhysicsBatch, matches_physics_sim_with_controls)
+{
+	const int num_objects = 50;
+	const float sim_time = 1.0f / 60.0f;
+
+	SCP_vector<physics_state> scalar;
+	for (int i = 0; i < num_objects; ++i) {
+		auto state = make_state(i);
+
+		vm_vec_make(&state.pi.max_vel, 30.0f, 30.0f, 80.0f + i);
+		vm_vec_make(&state.pi.max_rotvel, 1.5f, 1.0f, 2.0f);
+		state.pi.forward_accel_time_const = 1.0f;
+		state.pi.forward_decel_time_const = 1.5f;
+		state.pi.slide_accel_time_const = 0.5f;
+		state.pi.slide_decel_time_const = 0.5f;
+
+		scalar.push_back(state);
+	}
+	auto batched = scalar;
+
+	physics_batch batch;
+
+	for (int step = 0; step < 10; ++step) {
+		physics_batch_clear(&batch);
+
+		// Like obj_move_all(), the controls of every object are applied before the physics are simulated
+		for (int i = 0; i < num_objects; ++i) {
+			control_info ci;
+			memset(&ci, 0, sizeof(ci));
+			ci.pitch = ((i + step) % 5 - 2) * 0.5f;
+			ci.heading = ((i * 3 + step) % 7 - 3) / 3.0f;
+			ci.bank = (i % 2) ? 0.25f : -0.75f;
+			ci.forward = ((i + step) % 3) * 0.5f;
+			ci.sideways = (i % 4 == 0) ? 1.0f : 0.0f;
+
+			auto ci_copy = ci;
+			physics_read_flying_controls(&scalar[i].orient, &scalar[i].pi, &ci, sim_time);
+			physics_read_flying_controls(&batched[i].orient, &batched[i].pi, &ci_copy, sim_time);
+		}
+
+		for (auto& state : scalar) {
+			physics_sim(&state.pos, &state.orient, &state.pi, sim_time);
+		}
+		for (auto& state : batched) {
+			ASSERT_TRUE(physics_batch_supported(&state.pi));
+			physics_batch_add(&batch, &state.pos, &state.orient, &state.pi);
+		}
+		physics_batch_sim(&batch, sim_time);
+	}
+
+	for (int i = 0; i < num_objects; ++i) {
+		SCOPED_TRACE(i);
+
+		expect_vec_eq(scalar[i].pos, batched[i].pos);
+		expect_vec_eq(scalar[i].pi.vel, batched[i].pi.vel);
+		expect_vec_eq(scalar[i].pi.desired_vel, batched[i].pi.desired_vel);
+		expect_vec_eq(scalar[i].pi.rotvel, batched[i].pi.rotvel);
+		expect_vec_eq(scalar[i].pi.desired_rotvel, batched[i].pi.desired_rotvel);
+		expect_matrix_eq(scalar[i].orient, batched[i].orient);
+
+		EXPECT_FLOAT_EQ(scalar[i].pi.speed, batched[i].pi.speed);
+		EXPECT_FLOAT_EQ(scalar[i].pi.fspeed, batched[i].pi.fspeed);
+	}
+}
@@ -6,10 +6,18 @@ add_file_folder(""
     test_stubs.cpp
 )
 
+add_file_folder("Bmpman"
+    bmpman/test_texture_cache.cpp
+)
+
 add_file_folder("CFile"
     cfile/cfile.cpp
 )
 
+add_file_folder("Decals"
+    decals/test_decals.cpp
+)
+
 add_file_folder("Globalincs"
     globalincs/test_flagset.cpp
     globalincs/test_safe_strings.cpp
@@ -28,8 +36,22 @@ add_file_folder("mod"
     mod/test_mod_table.cpp
 )
 
+add_file_folder("Model"
+    model/test_model_cache.cpp
+)
+
 add_file_folder("Parse"
     parse/test_parselo.cpp
+    parse/test_sexp_compile.cpp
+    parse/test_table_cache.cpp
+)
+
+add_file_folder("Particle"
+    particle/test_particle_store.cpp
+)
+
+add_file_folder("Physics"
+    physics/test_physics_batch.cpp
 )
 
 add_file_folder("Pilotfile"
@@ -66,6 +88,11 @@ add_file_folder("Test Util"
     util/test_util.h
 )
 
+add_file_folder("Tracing"
+    tracing/test_mission_profiler.cpp
+    tracing/test_particle_counters.cpp
+)
+
 add_file_folder("Utils"
     utils/HeapAllocatorTest.cpp
 )
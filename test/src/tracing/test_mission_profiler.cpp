@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "tracing/MissionProfiler.h"
+
+#include <sstream>
+
+using namespace tracing;
+
+namespace {
+Category Test_outer("Outer", false);
+Category Test_inner("Inner", false);
+
+void submit(MissionProfiler& profiler, const Category& category, uint64_t start_us, uint64_t duration_us,
+            int64_t tid = 1) {
+	trace_event evt;
+	evt.category = &category;
+	evt.type = EventType::Complete;
+	evt.timestamp = start_us * 1000;
+	evt.duration = duration_us * 1000;
+	evt.tid = tid;
+	evt.pid = 1;
+
+	profiler.processEvent(&evt);
+}
+
+const mission_profile_node_stats* find_node(const SCP_vector<mission_profile_node_stats>& stats, const char* path) {
+	for (auto& node : stats) {
+		if (node.path == path) {
+			return &node;
+		}
+	}
+	return nullptr;
+}
+}
+
+TEST(MissionProfilerTest, statistics) {
+	MissionProfiler profiler;
+
+	// Nothing is recorded before a mission started
+	submit(profiler, Test_outer, 0, 10);
+	profiler.beginMission("test.fs2");
+	ASSERT_TRUE(profiler.isActive());
+
+	// The events of loading the mission are dropped
+	submit(profiler, Test_outer, 0, 500);
+	profiler.processFrame(mission_profile_frame());
+
+	// 100 frames, the outer scope takes i + 1 ms and contains two inner scopes
+	for (int i = 0; i < 100; ++i) {
+		uint64_t start = 1000000 * (i + 1);
+
+		submit(profiler, Test_inner, start + 10, 100);
+		submit(profiler, Test_inner, start + 200, 50);
+		submit(profiler, Test_outer, start, 1000 * (i + 1));
+
+		mission_profile_frame frame;
+		frame.mission_time = i * 0.1f;
+		frame.ships = i;
+		profiler.processFrame(frame);
+	}
+
+	// An inner scope on another thread is a root of its own
+	submit(profiler, Test_inner, 0, 20, 2);
+	profiler.processFrame(mission_profile_frame());
+
+	ASSERT_EQ(101u, profiler.getFrames().size());
+
+	auto stats = profiler.getStatistics();
+	ASSERT_EQ(3u, stats.size());
+
+	auto outer = find_node(stats, "Outer");
+	ASSERT_NE(nullptr, outer);
+	ASSERT_EQ(-1, outer->parent);
+	ASSERT_EQ(100u, outer->calls);
+	ASSERT_EQ(100u, outer->frames);
+	ASSERT_EQ(1000u, outer->min);
+	ASSERT_EQ(50500u, outer->avg);
+	ASSERT_EQ(95000u, outer->p95);
+	ASSERT_EQ(99000u, outer->p99);
+	ASSERT_EQ(100000u, outer->max);
+	ASSERT_EQ(99, profiler.getFrames()[outer->max_frame].ships);
+
+	auto inner = find_node(stats, "Outer>Inner");
+	ASSERT_NE(nullptr, inner);
+	ASSERT_EQ(1, inner->depth);
+	ASSERT_EQ(200u, inner->calls);
+	ASSERT_EQ(150u, inner->min);
+	ASSERT_EQ(150u, inner->max);
+
+	auto other_thread = find_node(stats, "Inner");
+	ASSERT_NE(nullptr, other_thread);
+	ASSERT_EQ(1u, other_thread->frames);
+	ASSERT_EQ(20u, other_thread->avg);
+
+	std::stringstream json;
+	profiler.writeJSON(json);
+	ASSERT_NE(SCP_string::npos, json.str().find("\"path\": \"Outer>Inner\""));
+	ASSERT_NE(SCP_string::npos, json.str().find("\"mission\": \"test.fs2\""));
+
+	std::stringstream csv;
+	profiler.writeCSV(csv);
+	ASSERT_NE(SCP_string::npos, csv.str().find("\"Outer>Inner\",1,200,100,150,150,150,150,150,"));
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "bmpman/bmpman.h"
+#include "math/vecmat.h"
+#include "particle/particle.h"
+#include "render/3d.h"
+
+#include "util/FSTestFixture.h"
+
+namespace {
+
+void create_particle(int bitmap, float x, float y, float z)
+{
+	particle::particle_info info;
+
+	vm_vec_make(&info.pos, x, y, z);
+	info.lifetime = 10.0f;
+	info.rad = 1.0f;
+	info.type = particle::PARTICLE_BITMAP;
+	info.optional_data = bitmap;
+
+	particle::create(&info);
+}
+
+const particle::render_stats& render_frame()
+{
+	g3_start_frame(1);
+	g3_set_view_matrix(&vmd_zero_vector, &vmd_identity_matrix, 1.0f);
+
+	particle::render_all();
+
+	g3_end_frame();
+
+	return particle::get_render_stats();
+}
+
+}
+
+class ParticleCountersTest : public test::FSTestFixture {
+ public:
+	ParticleCountersTest() : test::FSTestFixture(INIT_CFILE | INIT_GRAPHICS) {
+		pushModDir("tracing");
+	}
+
+ protected:
+	void SetUp() override {
+		test::FSTestFixture::SetUp();
+
+		particle::kill_all();
+	}
+	void TearDown() override {
+		particle::kill_all();
+
+		test::FSTestFixture::TearDown();
+	}
+};
+
+TEST_F(ParticleCountersTest, render_stats) {
+	auto bitmap_a = bm_load("particle_a");
+	auto bitmap_b = bm_load("particle_b");
+	ASSERT_GE(bitmap_a, 0);
+	ASSERT_GE(bitmap_b, 0);
+
+	// Nothing is counted without particles
+	auto& empty = render_frame();
+	ASSERT_EQ((size_t) 0, empty.submitted);
+	ASSERT_EQ((size_t) 0, empty.culled);
+	ASSERT_EQ((size_t) 0, empty.batches);
+
+	// The textures are interleaved so the sort has to bring them together for two batches
+	create_particle(bitmap_a, -5.0f, 0.0f, 100.0f);
+	create_particle(bitmap_b, 0.0f, 0.0f, 100.0f);
+	create_particle(bitmap_a, 5.0f, 0.0f, 100.0f);
+	create_particle(bitmap_b, 0.0f, 5.0f, 100.0f);
+
+	// Every check adds to the culled particles: behind the eye, too close to be visible and off screen
+	create_particle(bitmap_a, 0.0f, 0.0f, -100.0f);
+	create_particle(bitmap_a, 0.0f, 0.0f, 3.0f);
+	create_particle(bitmap_b, 10000.0f, 0.0f, 100.0f);
+
+	auto& stats = render_frame();
+	ASSERT_EQ((size_t) 4, stats.submitted);
+	ASSERT_EQ((size_t) 3, stats.culled);
+	ASSERT_EQ((size_t) 2, stats.batches);
+
+	// The counters only cover the last frame
+	particle::kill_all();
+	create_particle(bitmap_a, 0.0f, 0.0f, 100.0f);
+
+	auto& next = render_frame();
+	ASSERT_EQ((size_t) 1, next.submitted);
+	ASSERT_EQ((size_t) 0, next.culled);
+	ASSERT_EQ((size_t) 1, next.batches);
+
+	particle::kill_all();
+
+	auto& cleared = render_frame();
+	ASSERT_EQ((size_t) 0, cleared.submitted);
+	ASSERT_EQ((size_t) 0, cleared.culled);
+	ASSERT_EQ((size_t) 0, cleared.batches);
+}